@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+# Copyright (c) 2014 The ticoin Core developers
+# Distributed under the MIT/X11 software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+# Replay benchmark: connect the blk?????.dat files of another node's
+# blocks directory on a fresh, throwaway data directory, with networking
+# off, and print the validation speed report.
+#
+# Extra arguments are passed on to ticoind, so the same block files can
+# be replayed under different settings, e.g. -dbcache=1000 -par=4, or
+# -checkpoints=0 to verify scripts below the last checkpoint too.
+
+if [ $# -lt 2 ]; then
+        echo "Usage: $0 path_to_binaries path_to_blocks_dir [ticoind options]"
+        echo "e.g. $0 ../../src ~/.ticoin/blocks -dbcache=300"
+        exit 1
+fi
+
+set -f
+
+ticoinD=${1}/ticoind
+BLOCKS=$( cd "$2" && pwd )
+shift 2
+
+D=$(mktemp -d ${TMPDIR:-/tmp}/replay.XXXXX)
+trap "rm -rf $D" EXIT
+
+$ticoinD -datadir=$D -daemon=0 -server=0 -disablewallet -printtoconsole -replayblocks="$BLOCKS" "$@" | grep '^replayblocks:'
+exit ${PIPESTATUS[0]}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+# Copyright (c) 2014 The ticoin Core developers
+# Distributed under the MIT/X11 software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+# Exercise the REST interface (-rest)
+
+# Add python-ticoinrpc to module search path:
+import os
+import sys
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), "python-ticoinrpc"))
+
+import binascii
+import httplib
+import json
+import shutil
+import subprocess
+import tempfile
+import time
+import traceback
+
+from ticoinrpc.authproxy import AuthServiceProxy, JSONRPCException
+from util import *
+
+
+def http_get(node_num, uri):
+    """GET uri from the RPC port of a node, without authorization; returns (status, body)"""
+    conn = httplib.HTTPConnection("127.0.0.1", START_RPC_PORT+node_num)
+    conn.request("GET", uri)
+    response = conn.getresponse()
+    body = response.read()
+    conn.close()
+    return (response.status, body)
+
+def rest_get(node_num, uri, expected_status=200):
+    (status, body) = http_get(node_num, uri)
+    assert_equal(status, expected_status)
+    return body
+
+def run_test(nodes):
+    node = nodes[0]
+
+    # A block in each format; streamed blocks must be what getblock returns
+    blockhash = node.getbestblockhash()
+    block_hex = node.getblock(blockhash, False)
+    assert_equal(binascii.hexlify(rest_get(0, "/rest/block/"+blockhash+".bin")), block_hex)
+    assert_equal(rest_get(0, "/rest/block/"+blockhash+".hex"), block_hex+"\n")
+    block_json = json.loads(rest_get(0, "/rest/block/"+blockhash+".json"))
+    assert_equal(block_json["hash"], blockhash)
+    assert_equal(block_json["tx"][0]["txid"], node.getblock(blockhash)["tx"][0])
+
+    # Headers follow the active chain
+    tip_height = node.getblockcount()
+    first = node.getblockhash(tip_height-4)
+    headers = rest_get(0, "/rest/headers/10/"+first+".bin")
+    assert_equal(len(headers), 5*80)
+    assert_equal(binascii.hexlify(headers[-80:]), block_hex[:160])
+    assert_equal(rest_get(0, "/rest/headers/5/"+first+".hex"), binascii.hexlify(headers)+"\n")
+    headers_json = json.loads(rest_get(0, "/rest/headers/5/"+first+".json"))
+    assert_equal([ h["hash"] for h in headers_json ],
+                 [ node.getblockhash(h) for h in range(tip_height-4, tip_height+1) ])
+
+    # A confirmed transaction needs -txindex; one in the mempool does not
+    txid = node.getblock(blockhash)["tx"][0]
+    tx_hex = node.getrawtransaction(txid)
+    assert_equal(binascii.hexlify(rest_get(0, "/rest/tx/"+txid+".bin")), tx_hex)
+    assert_equal(rest_get(0, "/rest/tx/"+txid+".hex"), tx_hex+"\n")
+    assert_equal(json.loads(rest_get(0, "/rest/tx/"+txid+".json"))["txid"], txid)
+
+    mempool_txid = node.sendtoaddress(node.getnewaddress(), 1)
+    assert_equal(binascii.hexlify(rest_get(0, "/rest/tx/"+mempool_txid+".bin")),
+                 node.getrawtransaction(mempool_txid))
+
+    # The mempool, as txids
+    assert_equal(json.loads(rest_get(0, "/rest/mempool.json")), node.getrawmempool())
+    mempool_bin = rest_get(0, "/rest/mempool.bin")
+    assert_equal(len(mempool_bin), 1+32*len(node.getrawmempool()))
+    assert_equal(rest_get(0, "/rest/mempool.hex"), binascii.hexlify(mempool_bin)+"\n")
+
+    # Bad requests
+    rest_get(0, "/rest/block/"+blockhash+".txt", 404)
+    rest_get(0, "/rest/block/"+blockhash[1:]+".bin", 400)
+    rest_get(0, "/rest/block/"+"0"*64+".bin", 404)
+    rest_get(0, "/rest/headers/5abc/"+first+".bin", 400)
+    rest_get(0, "/rest/headers/0/"+first+".bin", 400)
+    rest_get(0, "/rest/headers/2001/"+first+".bin", 400)
+    rest_get(0, "/rest/tx/"+"0"*64+".json", 404)
+
+    # Without -rest, nothing is served unauthorized
+    (status, body) = http_get(1, "/rest/block/"+blockhash+".bin")
+    assert_equal(status, 401)
+
+def main():
+    import optparse
+
+    parser = optparse.OptionParser(usage="%prog [options]")
+    parser.add_option("--nocleanup", dest="nocleanup", default=False, action="store_true",
+                      help="Leave ticoinds and test.* datadir on exit or error")
+    parser.add_option("--srcdir", dest="srcdir", default="../../src",
+                      help="Source directory containing ticoind/ticoin-cli (default: %default%)")
+    parser.add_option("--tmpdir", dest="tmpdir", default=tempfile.mkdtemp(prefix="test"),
+                      help="Root directory for datadirs")
+    (options, args) = parser.parse_args()
+
+    os.environ['PATH'] = options.srcdir+":"+os.environ['PATH']
+
+    check_json_precision()
+
+    success = False
+    nodes = []
+    try:
+        print("Initializing test directory "+options.tmpdir)
+        if not os.path.isdir(options.tmpdir):
+            os.makedirs(options.tmpdir)
+        initialize_chain(options.tmpdir)
+
+        nodes = start_nodes(2, options.tmpdir, [ [ "-rest", "-txindex" ], [] ])
+        connect_nodes(nodes[1], 0)
+        sync_blocks(nodes)
+
+        # -txindex catches up in the background
+        while not nodes[0].getblockchaininfo()["txindex"]["synced"]:
+            time.sleep(1)
+
+        run_test(nodes)
+
+        success = True
+
+    except AssertionError as e:
+        print("Assertion failed: "+e.message)
+    except Exception as e:
+        print("Unexpected exception caught during testing: "+str(e))
+        traceback.print_tb(sys.exc_info()[2])
+
+    if not options.nocleanup:
+        print("Cleaning up")
+        stop_nodes(nodes)
+        wait_ticoinds()
+        shutil.rmtree(options.tmpdir)
+
+    if success:
+        print("Tests successful")
+        sys.exit(0)
+    else:
+        print("Failed")
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
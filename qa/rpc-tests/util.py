@@ -112,12 +112,14 @@ def initialize_chain(test_dir):
         to_dir = os.path.join(test_dir,  "node"+str(i))
         shutil.copytree(from_dir, to_dir)
 
-def start_nodes(num_nodes, dir):
+def start_nodes(num_nodes, dir, extra_args=None):
     # Start ticoinds, and wait for RPC interface to be up and running:
     devnull = open("/dev/null", "w+")
     for i in range(num_nodes):
         datadir = os.path.join(dir, "node"+str(i))
         args = [ "ticoind", "-datadir="+datadir ]
+        if extra_args is not None:
+            args.extend(extra_args[i])
         ticoind_processes.append(subprocess.Popen(args))
         subprocess.check_call([ "ticoin-cli", "-datadir="+datadir,
                                   "-rpcwait", "getblockcount"], stdout=devnull)
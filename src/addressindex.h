@@ -0,0 +1,145 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ticoin_ADDRESSINDEX_H
+#define ticoin_ADDRESSINDEX_H
+
+#include "script.h"
+#include "serialize.h"
+#include "uint256.h"
+
+#include <stdint.h>
+
+/** Kind of hash an address index entry is keyed by */
+enum AddressIndexType
+{
+    ADDRESSINDEX_NONE = 0,
+    ADDRESSINDEX_PUBKEYHASH = 1,  /**-5-10CKeyID; covers both pay-to-pubkey and pay-to-pubkey-hash outputs
+    ADDRESSINDEX_SCRIPTHASH = 2,  /**-5-10CScriptID of a pay-to-script-hash output
+};
+
+/**-5-10LevelDB compares keys bytewise, so the integer fields that define the
+/**-5-10iteration order are written big-endian.
+template<typename Stream>
+inline void WriteBE32(Stream& s, uint32_t n)
+{
+    unsigned char buf[4] = { (unsigned char)(n >> 24), (unsigned char)(n >> 16), (unsigned char)(n >> 8), (unsigned char)n };
+    s.write((char*)buf, 4);
+}
+
+template<typename Stream>
+inline uint32_t ReadBE32(Stream& s)
+{
+    unsigned char buf[4];
+    s.read((char*)buf, 4);
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+/** Key of an address history entry: one per output paying to, or input spending from, an address.
+ * Entries of one address are ordered by height and position in the block.
+ */
+struct CAddressIndexKey
+{
+    unsigned char nType;
+    uint160 hashBytes;
+    int nHeight;
+    unsigned int nTxPos;
+    uint256 txhash;
+    unsigned int nIndex;
+    bool fSpending;
+
+    CAddressIndexKey() : nType(ADDRESSINDEX_NONE), nHeight(0), nTxPos(0), nIndex(0), fSpending(false) {}
+    CAddressIndexKey(unsigned char nTypeIn, const uint160& hashIn, int nHeightIn, unsigned int nTxPosIn,
+                     const uint256& txhashIn, unsigned int nIndexIn, bool fSpendingIn) :
+        nType(nTypeIn), hashBytes(hashIn), nHeight(nHeightIn), nTxPos(nTxPosIn),
+        txhash(txhashIn), nIndex(nIndexIn), fSpending(fSpendingIn) {}
+
+    unsigned int GetSerializeSize(int nSerType, int nVersion) const
+    {
+        return 1 + 20 + 4 + 4 + 32 + 4 + 1;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nSerType, int nVersion) const
+    {
+        ::Serialize(s, nType, nSerType, nVersion);
+        hashBytes.Serialize(s, nSerType, nVersion);
+        WriteBE32(s, nHeight);
+        WriteBE32(s, nTxPos);
+        txhash.Serialize(s, nSerType, nVersion);
+        WriteBE32(s, nIndex);
+        ::Serialize(s, fSpending, nSerType, nVersion);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s, int nSerType, int nVersion)
+    {
+        ::Unserialize(s, nType, nSerType, nVersion);
+        hashBytes.Unserialize(s, nSerType, nVersion);
+        nHeight = ReadBE32(s);
+        nTxPos = ReadBE32(s);
+        txhash.Unserialize(s, nSerType, nVersion);
+        nIndex = ReadBE32(s);
+        ::Unserialize(s, fSpending, nSerType, nVersion);
+    }
+};
+
+/** Key of an unspent output paying to an address */
+struct CAddressUnspentKey
+{
+    unsigned char nType;
+    uint160 hashBytes;
+    uint256 txhash;
+    unsigned int nIndex;
+
+    CAddressUnspentKey() : nType(ADDRESSINDEX_NONE), nIndex(0) {}
+    CAddressUnspentKey(unsigned char nTypeIn, const uint160& hashIn, const uint256& txhashIn, unsigned int nIndexIn) :
+        nType(nTypeIn), hashBytes(hashIn), txhash(txhashIn), nIndex(nIndexIn) {}
+
+    unsigned int GetSerializeSize(int nSerType, int nVersion) const
+    {
+        return 1 + 20 + 32 + 4;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nSerType, int nVersion) const
+    {
+        ::Serialize(s, nType, nSerType, nVersion);
+        hashBytes.Serialize(s, nSerType, nVersion);
+        txhash.Serialize(s, nSerType, nVersion);
+        WriteBE32(s, nIndex);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s, int nSerType, int nVersion)
+    {
+        ::Unserialize(s, nType, nSerType, nVersion);
+        hashBytes.Unserialize(s, nSerType, nVersion);
+        txhash.Unserialize(s, nSerType, nVersion);
+        nIndex = ReadBE32(s);
+    }
+};
+
+/** Value of an unspent output entry. A null value in an update means the entry is erased. */
+struct CAddressUnspentValue
+{
+    int64_t nValue;
+    CScript script;
+    int nHeight;
+
+    CAddressUnspentValue() { SetNull(); }
+    CAddressUnspentValue(int64_t nValueIn, const CScript& scriptIn, int nHeightIn) :
+        nValue(nValueIn), script(scriptIn), nHeight(nHeightIn) {}
+
+    void SetNull() { nValue = -1; script.clear(); nHeight = 0; }
+    bool IsNull() const { return nValue == -1; }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(nValue);
+        READWRITE(script);
+        READWRITE(nHeight);
+    )
+};
+
+#endif /**-5-10ticoin_ADDRESSINDEX_H
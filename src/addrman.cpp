@@ -87,22 +87,39 @@ CAddrInfo* CAddrMan::Find(const CNetAddr& addr, int *pnId)
         return NULL;
     if (pnId)
         *pnId = (*it).second;
-    std::map<int, CAddrInfo>::iterator it2 = mapInfo.find((*it).second);
-    if (it2 != mapInfo.end())
-        return &(*it2).second;
-    return NULL;
+    return &vInfo[(*it).second];
 }
 
 CAddrInfo* CAddrMan::Create(const CAddress &addr, const CNetAddr &addrSource, int *pnId)
 {
-    int nId = nIdCount++;
-    mapInfo[nId] = CAddrInfo(addr, addrSource);
+    int nId;
+    if (vFreeIds.empty()) {
+        nId = vInfo.size();
+        vInfo.push_back(CAddrInfo(addr, addrSource));
+    } else {
+        nId = vFreeIds.back();
+        vFreeIds.pop_back();
+        vInfo[nId] = CAddrInfo(addr, addrSource);
+    }
     mapAddr[addr] = nId;
-    mapInfo[nId].nRandomPos = vRandom.size();
+    vInfo[nId].nRandomPos = vRandom.size();
     vRandom.push_back(nId);
     if (pnId)
         *pnId = nId;
-    return &mapInfo[nId];
+    return &vInfo[nId];
+}
+
+void CAddrMan::Delete(int nId)
+{
+    CAddrInfo &info = vInfo[nId];
+    assert(!info.fInTried && info.nRefCount == 0);
+
+    SwapRandom(info.nRandomPos, vRandom.size()-1);
+    vRandom.pop_back();
+    mapAddr.erase(info);
+    info = CAddrInfo();
+    vFreeIds.push_back(nId);
+    nNew--;
 }
 
 void CAddrMan::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2)
@@ -115,32 +132,46 @@ void CAddrMan::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2)
     int nId1 = vRandom[nRndPos1];
     int nId2 = vRandom[nRndPos2];
 
-    assert(mapInfo.count(nId1) == 1);
-    assert(mapInfo.count(nId2) == 1);
-
-    mapInfo[nId1].nRandomPos = nRndPos2;
-    mapInfo[nId2].nRandomPos = nRndPos1;
+    vInfo[nId1].nRandomPos = nRndPos2;
+    vInfo[nId2].nRandomPos = nRndPos1;
 
     vRandom[nRndPos1] = nId2;
     vRandom[nRndPos2] = nId1;
 }
 
+int CAddrMan::FindNew(int nUBucket, int nId) const
+{
+    const int *pBucket = vvNew[nUBucket];
+    for (int n = 0; n < vNewSize[nUBucket]; n++)
+        if (pBucket[n] == nId)
+            return n;
+    return -1;
+}
+
+void CAddrMan::EraseNew(int nUBucket, int nPos)
+{
+    assert(nPos >= 0 && nPos < vNewSize[nUBucket]);
+
+    //ticoin buckets are unordered, so fill the hole with the last element
+    vvNew[nUBucket][nPos] = vvNew[nUBucket][--vNewSize[nUBucket]];
+}
+
 int CAddrMan::SelectTried(int nKBucket)
 {
-    std::vector<int> &vTried = vvTried[nKBucket];
+    int *pTried = vvTried[nKBucket];
+    int nSize = vTriedSize[nKBucket];
 
     //ticoin random shuffle the first few elements (using the entire list)
     //ticoin find the least recently tried among them
     int64_t nOldest = -1;
     int nOldestPos = -1;
-    for (unsigned int i = 0; i < ADDRMAN_TRIED_ENTRIES_INSPECT_ON_EVICT && i < vTried.size(); i++)
+    for (int i = 0; i < ADDRMAN_TRIED_ENTRIES_INSPECT_ON_EVICT && i < nSize; i++)
     {
-        int nPos = GetRandInt(vTried.size() - i) + i;
-        int nTemp = vTried[nPos];
-        vTried[nPos] = vTried[i];
-        vTried[i] = nTemp;
-        assert(nOldest == -1 || mapInfo.count(nTemp) == 1);
-        if (nOldest == -1 || mapInfo[nTemp].nLastSuccess < mapInfo[nOldest].nLastSuccess) {
+        int nPos = GetRandInt(nSize - i) + i;
+        int nTemp = pTried[nPos];
+        pTried[nPos] = pTried[i];
+        pTried[i] = nTemp;
+        if (nOldest == -1 || vInfo[nTemp].nLastSuccess < vInfo[nOldest].nLastSuccess) {
            nOldest = nTemp;
            nOldestPos = nPos;
         }
@@ -151,67 +182,54 @@ int CAddrMan::SelectTried(int nKBucket)
 
 int CAddrMan::ShrinkNew(int nUBucket)
 {
-    assert(nUBucket >= 0 && (unsigned int)nUBucket < vvNew.size());
-    std::set<int> &vNew = vvNew[nUBucket];
+    assert(nUBucket >= 0 && nUBucket < ADDRMAN_NEW_BUCKET_COUNT);
+    int *pNew = vvNew[nUBucket];
+    int nSize = vNewSize[nUBucket];
 
     //ticoin first look for deletable items
-    for (std::set<int>::iterator it = vNew.begin(); it != vNew.end(); it++)
+    int64_t nNow = GetAdjustedTime();
+    for (int n = 0; n < nSize; n++)
     {
-        assert(mapInfo.count(*it));
-        CAddrInfo &info = mapInfo[*it];
-        if (info.IsTerrible())
+        int nId = pNew[n];
+        CAddrInfo &info = vInfo[nId];
+        if (info.IsTerrible(nNow))
         {
+            EraseNew(nUBucket, n);
             if (--info.nRefCount == 0)
-            {
-                SwapRandom(info.nRandomPos, vRandom.size()-1);
-                vRandom.pop_back();
-                mapAddr.erase(info);
-                mapInfo.erase(*it);
-                nNew--;
-            }
-            vNew.erase(it);
+                Delete(nId);
             return 0;
         }
     }
 
     //ticoin otherwise, select four randomly, and pick the oldest of those to replace
-    int n[4] = {GetRandInt(vNew.size()), GetRandInt(vNew.size()), GetRandInt(vNew.size()), GetRandInt(vNew.size())};
-    int nI = 0;
-    int nOldest = -1;
-    for (std::set<int>::iterator it = vNew.begin(); it != vNew.end(); it++)
-    {
-        if (nI == n[0] || nI == n[1] || nI == n[2] || nI == n[3])
-        {
-            assert(nOldest == -1 || mapInfo.count(*it) == 1);
-            if (nOldest == -1 || mapInfo[*it].nTime < mapInfo[nOldest].nTime)
-                nOldest = *it;
-        }
-        nI++;
-    }
-    assert(mapInfo.count(nOldest) == 1);
-    CAddrInfo &info = mapInfo[nOldest];
-    if (--info.nRefCount == 0)
+    int nOldestPos = -1;
+    for (int i = 0; i < 4; i++)
     {
-        SwapRandom(info.nRandomPos, vRandom.size()-1);
-        vRandom.pop_back();
-        mapAddr.erase(info);
-        mapInfo.erase(nOldest);
-        nNew--;
+        int nPos = GetRandInt(nSize);
+        if (nOldestPos == -1 || vInfo[pNew[nPos]].nTime < vInfo[pNew[nOldestPos]].nTime)
+            nOldestPos = nPos;
     }
-    vNew.erase(nOldest);
+    int nOldest = pNew[nOldestPos];
+    EraseNew(nUBucket, nOldestPos);
+    if (--vInfo[nOldest].nRefCount == 0)
+        Delete(nOldest);
 
     return 1;
 }
 
 void CAddrMan::MakeTried(CAddrInfo& info, int nId, int nOrigin)
 {
-    assert(vvNew[nOrigin].count(nId) == 1);
+    assert(FindNew(nOrigin, nId) != -1);
 
     //ticoin remove the entry from all new buckets
-    for (std::vector<std::set<int> >::iterator it = vvNew.begin(); it != vvNew.end(); it++)
+    for (int b = 0; b < ADDRMAN_NEW_BUCKET_COUNT && info.nRefCount > 0; b++)
     {
-        if ((*it).erase(nId))
+        int nPos = FindNew(b, nId);
+        if (nPos != -1)
+        {
+            EraseNew(b, nPos);
             info.nRefCount--;
+        }
     }
     nNew--;
 
@@ -219,12 +237,12 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId, int nOrigin)
 
     //ticoin what tried bucket to move the entry to
     int nKBucket = info.GetTriedBucket(nKey);
-    std::vector<int> &vTried = vvTried[nKBucket];
+    int *pTried = vvTried[nKBucket];
 
     //ticoin first check whether there is place to just add it
-    if (vTried.size() < ADDRMAN_TRIED_BUCKET_SIZE)
+    if (vTriedSize[nKBucket] < ADDRMAN_TRIED_BUCKET_SIZE)
     {
-        vTried.push_back(nId);
+        pTried[vTriedSize[nKBucket]++] = nId;
         nTried++;
         info.fInTried = true;
         return;
@@ -234,29 +252,23 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId, int nOrigin)
     int nPos = SelectTried(nKBucket);
 
     //ticoin find which new bucket it belongs to
-    assert(mapInfo.count(vTried[nPos]) == 1);
-    int nUBucket = mapInfo[vTried[nPos]].GetNewBucket(nKey);
-    std::set<int> &vNew = vvNew[nUBucket];
+    CAddrInfo& infoOld = vInfo[pTried[nPos]];
+    int nUBucket = infoOld.GetNewBucket(nKey);
 
     //ticoin remove the to-be-replaced tried entry from the tried set
-    CAddrInfo& infoOld = mapInfo[vTried[nPos]];
     infoOld.fInTried = false;
     infoOld.nRefCount = 1;
     //ticoin do not update nTried, as we are going to move something else there immediately
 
     //ticoin check whether there is place in that one,
-    if (vNew.size() < ADDRMAN_NEW_BUCKET_SIZE)
-    {
-        //ticoin if so, move it back there
-        vNew.insert(vTried[nPos]);
-    } else {
-        //ticoin otherwise, move it to the new bucket nId came from (there is certainly place there)
-        vvNew[nOrigin].insert(vTried[nPos]);
-    }
+    //ticoin otherwise, move it to the new bucket nId came from (there is certainly place there)
+    if (vNewSize[nUBucket] >= ADDRMAN_NEW_BUCKET_SIZE)
+        nUBucket = nOrigin;
+    vvNew[nUBucket][vNewSize[nUBucket]++] = pTried[nPos];
     nNew++;
 
-    vTried[nPos] = nId;
-    //ticoin we just overwrote an entry in vTried; no need to update nTried
+    pTried[nPos] = nId;
+    //ticoin we just overwrote an entry in vvTried; no need to update nTried
     info.fInTried = true;
     return;
 }
@@ -287,13 +299,12 @@ void CAddrMan::Good_(const CService &addr, int64_t nTime)
         return;
 
     //ticoin find a bucket it is in now
-    int nRnd = GetRandInt(vvNew.size());
+    int nRnd = GetRandInt(ADDRMAN_NEW_BUCKET_COUNT);
     int nUBucket = -1;
-    for (unsigned int n = 0; n < vvNew.size(); n++)
+    for (int n = 0; n < ADDRMAN_NEW_BUCKET_COUNT; n++)
     {
-        int nB = (n+nRnd) % vvNew.size();
-        std::set<int> &vNew = vvNew[nB];
-        if (vNew.count(nId))
+        int nB = (n+nRnd) % ADDRMAN_NEW_BUCKET_COUNT;
+        if (FindNew(nB, nId) != -1)
         {
             nUBucket = nB;
             break;
@@ -356,13 +367,12 @@ bool CAddrMan::Add_(const CAddress &addr, const CNetAddr& source, int64_t nTimeP
     }
 
     int nUBucket = pinfo->GetNewBucket(nKey, source);
-    std::set<int> &vNew = vvNew[nUBucket];
-    if (!vNew.count(nId))
+    if (FindNew(nUBucket, nId) == -1)
     {
         pinfo->nRefCount++;
-        if (vNew.size() == ADDRMAN_NEW_BUCKET_SIZE)
+        if (vNewSize[nUBucket] == ADDRMAN_NEW_BUCKET_SIZE)
             ShrinkNew(nUBucket);
-        vvNew[nUBucket].insert(nId);
+        vvNew[nUBucket][vNewSize[nUBucket]++] = nId;
     }
     return fNew;
 }
@@ -399,12 +409,10 @@ CAddress CAddrMan::Select_(int nUnkBias)
         double fChanceFactor = 1.0;
         while(1)
         {
-            int nKBucket = GetRandInt(vvTried.size());
-            std::vector<int> &vTried = vvTried[nKBucket];
-            if (vTried.size() == 0) continue;
-            int nPos = GetRandInt(vTried.size());
-            assert(mapInfo.count(vTried[nPos]) == 1);
-            CAddrInfo &info = mapInfo[vTried[nPos]];
+            int nKBucket = GetRandInt(ADDRMAN_TRIED_BUCKET_COUNT);
+            if (vTriedSize[nKBucket] == 0) continue;
+            int nPos = GetRandInt(vTriedSize[nKBucket]);
+            CAddrInfo &info = vInfo[vvTried[nKBucket][nPos]];
             if (GetRandInt(1<<30) < fChanceFactor*info.GetChance()*(1<<30))
                 return info;
             fChanceFactor *= 1.2;
@@ -414,15 +422,10 @@ CAddress CAddrMan::Select_(int nUnkBias)
         double fChanceFactor = 1.0;
         while(1)
         {
-            int nUBucket = GetRandInt(vvNew.size());
-            std::set<int> &vNew = vvNew[nUBucket];
-            if (vNew.size() == 0) continue;
-            int nPos = GetRandInt(vNew.size());
-            std::set<int>::iterator it = vNew.begin();
-            while (nPos--)
-                it++;
-            assert(mapInfo.count(*it) == 1);
-            CAddrInfo &info = mapInfo[*it];
+            int nUBucket = GetRandInt(ADDRMAN_NEW_BUCKET_COUNT);
+            if (vNewSize[nUBucket] == 0) continue;
+            int nPos = GetRandInt(vNewSize[nUBucket]);
+            CAddrInfo &info = vInfo[vvNew[nUBucket][nPos]];
             if (GetRandInt(1<<30) < fChanceFactor*info.GetChance()*(1<<30))
                 return info;
             fChanceFactor *= 1.2;
@@ -433,25 +436,36 @@ CAddress CAddrMan::Select_(int nUnkBias)
 #ifdef DEBUG_ADDRMAN
 int CAddrMan::Check_()
 {
-    std::set<int> setTried;
-    std::map<int, int> mapNew;
+    //ticoin how often each nId still has to be found in the buckets
+    std::vector<int> vTriedLeft(vInfo.size(), 0);
+    std::vector<int> vNewLeft(vInfo.size(), 0);
+    std::vector<bool> vFree(vInfo.size(), false);
+    int nTriedSeen = 0, nNewSeen = 0;
 
     if (vRandom.size() != nTried + nNew) return -7;
 
-    for (std::map<int, CAddrInfo>::iterator it = mapInfo.begin(); it != mapInfo.end(); it++)
+    for (unsigned int i = 0; i < vFreeIds.size(); i++)
+    {
+        if (vFreeIds[i] < 0 || vFreeIds[i] >= vInfo.size() || vFree[vFreeIds[i]]) return -16;
+        vFree[vFreeIds[i]] = true;
+    }
+
+    for (int n = 0; n < vInfo.size(); n++)
     {
-        int n = (*it).first;
-        CAddrInfo &info = (*it).second;
+        if (vFree[n]) continue;
+        CAddrInfo &info = vInfo[n];
         if (info.fInTried)
         {
 
             if (!info.nLastSuccess) return -1;
             if (info.nRefCount) return -2;
-            setTried.insert(n);
+            vTriedLeft[n] = 1;
+            nTriedSeen++;
         } else {
             if (info.nRefCount < 0 || info.nRefCount > ADDRMAN_NEW_BUCKETS_PER_ADDRESS) return -3;
             if (!info.nRefCount) return -4;
-            mapNew[n] = info.nRefCount;
+            vNewLeft[n] = info.nRefCount;
+            nNewSeen++;
         }
         if (mapAddr[info] != n) return -5;
         if (info.nRandomPos<0 || info.nRandomPos>=vRandom.size() || vRandom[info.nRandomPos] != n) return -14;
@@ -459,32 +473,33 @@ int CAddrMan::Check_()
         if (info.nLastSuccess < 0) return -8;
     }
 
-    if (setTried.size() != nTried) return -9;
-    if (mapNew.size() != nNew) return -10;
+    if (nTriedSeen != nTried) return -9;
+    if (nNewSeen != nNew) return -10;
 
-    for (int n=0; n<vvTried.size(); n++)
+    for (int b = 0; b < ADDRMAN_TRIED_BUCKET_COUNT; b++)
     {
-        std::vector<int> &vTried = vvTried[n];
-        for (std::vector<int>::iterator it = vTried.begin(); it != vTried.end(); it++)
+        for (int n = 0; n < vTriedSize[b]; n++)
         {
-            if (!setTried.count(*it)) return -11;
-            setTried.erase(*it);
+            int nId = vvTried[b][n];
+            if (nId < 0 || nId >= vInfo.size() || vTriedLeft[nId] != 1) return -11;
+            vTriedLeft[nId] = 0;
+            nTriedSeen--;
         }
     }
 
-    for (int n=0; n<vvNew.size(); n++)
+    for (int b = 0; b < ADDRMAN_NEW_BUCKET_COUNT; b++)
     {
-        std::set<int> &vNew = vvNew[n];
-        for (std::set<int>::iterator it = vNew.begin(); it != vNew.end(); it++)
+        for (int n = 0; n < vNewSize[b]; n++)
         {
-            if (!mapNew.count(*it)) return -12;
-            if (--mapNew[*it] == 0)
-                mapNew.erase(*it);
+            int nId = vvNew[b][n];
+            if (nId < 0 || nId >= vInfo.size() || vNewLeft[nId] == 0) return -12;
+            if (--vNewLeft[nId] == 0)
+                nNewSeen--;
         }
     }
 
-    if (setTried.size()) return -13;
-    if (mapNew.size()) return -15;
+    if (nTriedSeen) return -13;
+    if (nNewSeen) return -15;
 
     return 0;
 }
@@ -497,12 +512,12 @@ void CAddrMan::GetAddr_(std::vector<CAddress> &vAddr)
         nNodes = ADDRMAN_GETADDR_MAX;
 
     //ticoin perform a random shuffle over the first nNodes elements of vRandom (selecting from all)
+    vAddr.reserve(vAddr.size() + nNodes);
     for (int n = 0; n<nNodes; n++)
     {
         int nRndPos = GetRandInt(vRandom.size() - n) + n;
         SwapRandom(n, nRndPos);
-        assert(mapInfo.count(vRandom[n]) == 1);
-        vAddr.push_back(mapInfo[vRandom[n]]);
+        vAddr.push_back(vInfo[vRandom[n]]);
     }
 }
 
@@ -13,6 +13,7 @@
 #include <map>
 #include <set>
 #include <stdint.h>
+#include <string.h>
 #include <vector>
 
 #include <openssl/rand.h>
@@ -172,11 +173,11 @@ private:
     //ticoin secret key to randomize bucket select with
     std::vector<unsigned char> nKey;
 
-    //ticoin last used nId
-    int nIdCount;
+    //ticoin table with information about all nIds, indexed by nId
+    std::vector<CAddrInfo> vInfo;
 
-    //ticoin table with information about all nIds
-    std::map<int, CAddrInfo> mapInfo;
+    //ticoin nIds of deleted entries, reused before vInfo grows
+    std::vector<int> vFreeIds;
 
     //ticoin find an nId based on its network address
     std::map<CNetAddr, int> mapAddr;
@@ -187,14 +188,16 @@ private:
     //ticoin number of "tried" entries
     int nTried;
 
-    //ticoin list of "tried" buckets
-    std::vector<std::vector<int> > vvTried;
+    //ticoin "tried" buckets; only the first vTriedSize[n] entries of vvTried[n] are used
+    int vvTried[ADDRMAN_TRIED_BUCKET_COUNT][ADDRMAN_TRIED_BUCKET_SIZE];
+    int vTriedSize[ADDRMAN_TRIED_BUCKET_COUNT];
 
     //ticoin number of (unique) "new" entries
     int nNew;
 
-    //ticoin list of "new" buckets
-    std::vector<std::set<int> > vvNew;
+    //ticoin "new" buckets; only the first vNewSize[n] entries of vvNew[n] are used
+    int vvNew[ADDRMAN_NEW_BUCKET_COUNT][ADDRMAN_NEW_BUCKET_SIZE];
+    int vNewSize[ADDRMAN_NEW_BUCKET_COUNT];
 
 protected:
 
@@ -205,9 +208,18 @@ protected:
     //ticoin nTime and nServices of found node is updated, if necessary.
     CAddrInfo* Create(const CAddress &addr, const CNetAddr &addrSource, int *pnId = NULL);
 
+    //ticoin Delete an entry that is no longer in any bucket.
+    void Delete(int nId);
+
     //ticoin Swap two elements in vRandom.
     void SwapRandom(unsigned int nRandomPos1, unsigned int nRandomPos2);
 
+    //ticoin Return the position of nId in "new" bucket nUBucket, or -1.
+    int FindNew(int nUBucket, int nId) const;
+
+    //ticoin Remove the element at position nPos from "new" bucket nUBucket.
+    void EraseNew(int nUBucket, int nPos);
+
     //ticoin Return position in given bucket to replace.
     int SelectTried(int nKBucket);
 
@@ -217,7 +229,7 @@ protected:
     int ShrinkNew(int nUBucket);
 
     //ticoin Move an entry from the "new" table(s) to the "tried" table
-    //ticoin @pre vvUnkown[nOrigin].count(nId) != 0
+    //ticoin @pre FindNew(nOrigin, nId) != -1
     void MakeTried(CAddrInfo& info, int nId, int nOrigin);
 
     //ticoin Mark an entry "good", possibly moving it from "new" to "tried".
@@ -260,7 +272,7 @@ public:
         //ticoin   * number of elements
         //ticoin   * for each element: index
         //
-        //ticoin Notice that vvTried, mapAddr and vVector are never encoded explicitly;
+        //ticoin Notice that vvTried, mapAddr and vRandom are never encoded explicitly;
         //ticoin they are instead reconstructed from the other information.
         //
         //ticoin vvNew is serialized, but only used if ADDRMAN_UNKOWN_BUCKET_COUNT didn't change,
@@ -281,79 +293,82 @@ public:
             {
                 int nUBuckets = ADDRMAN_NEW_BUCKET_COUNT;
                 READWRITE(nUBuckets);
-                std::map<int, int> mapUnkIds;
+                std::vector<int> vUnkIds(am->vInfo.size(), -1);
                 int nIds = 0;
-                for (std::map<int, CAddrInfo>::iterator it = am->mapInfo.begin(); it != am->mapInfo.end(); it++)
+                for (unsigned int n = 0; n < am->vInfo.size(); n++)
                 {
                     if (nIds == nNew) break; //ticoin this means nNew was wrong, oh ow
-                    mapUnkIds[(*it).first] = nIds;
-                    CAddrInfo &info = (*it).second;
+                    CAddrInfo &info = am->vInfo[n];
                     if (info.nRefCount)
                     {
+                        vUnkIds[n] = nIds;
                         READWRITE(info);
                         nIds++;
                     }
                 }
                 nIds = 0;
-                for (std::map<int, CAddrInfo>::iterator it = am->mapInfo.begin(); it != am->mapInfo.end(); it++)
+                for (unsigned int n = 0; n < am->vInfo.size(); n++)
                 {
                     if (nIds == nTried) break; //ticoin this means nTried was wrong, oh ow
-                    CAddrInfo &info = (*it).second;
+                    CAddrInfo &info = am->vInfo[n];
                     if (info.fInTried)
                     {
                         READWRITE(info);
                         nIds++;
                     }
                 }
-                for (std::vector<std::set<int> >::iterator it = am->vvNew.begin(); it != am->vvNew.end(); it++)
+                for (int b = 0; b < ADDRMAN_NEW_BUCKET_COUNT; b++)
                 {
-                    const std::set<int> &vNew = (*it);
-                    int nSize = vNew.size();
+                    int nSize = am->vNewSize[b];
                     READWRITE(nSize);
-                    for (std::set<int>::iterator it2 = vNew.begin(); it2 != vNew.end(); it2++)
+                    for (int n = 0; n < nSize; n++)
                     {
-                        int nIndex = mapUnkIds[*it2];
+                        int nIndex = vUnkIds[am->vvNew[b][n]];
                         READWRITE(nIndex);
                     }
                 }
             } else {
                 int nUBuckets = 0;
                 READWRITE(nUBuckets);
-                am->nIdCount = 0;
-                am->mapInfo.clear();
+                am->vInfo.clear();
+                am->vFreeIds.clear();
                 am->mapAddr.clear();
                 am->vRandom.clear();
-                am->vvTried = std::vector<std::vector<int> >(ADDRMAN_TRIED_BUCKET_COUNT, std::vector<int>(0));
-                am->vvNew = std::vector<std::set<int> >(ADDRMAN_NEW_BUCKET_COUNT, std::set<int>());
+                memset(am->vTriedSize, 0, sizeof(am->vTriedSize));
+                memset(am->vNewSize, 0, sizeof(am->vNewSize));
                 for (int n = 0; n < am->nNew; n++)
                 {
-                    CAddrInfo &info = am->mapInfo[n];
+                    am->vInfo.push_back(CAddrInfo());
+                    CAddrInfo &info = am->vInfo.back();
                     READWRITE(info);
                     am->mapAddr[info] = n;
                     info.nRandomPos = vRandom.size();
                     am->vRandom.push_back(n);
                     if (nUBuckets != ADDRMAN_NEW_BUCKET_COUNT)
                     {
-                        am->vvNew[info.GetNewBucket(am->nKey)].insert(n);
-                        info.nRefCount++;
+                        int nUBucket = info.GetNewBucket(am->nKey);
+                        if (am->vNewSize[nUBucket] < ADDRMAN_NEW_BUCKET_SIZE)
+                        {
+                            am->vvNew[nUBucket][am->vNewSize[nUBucket]++] = n;
+                            info.nRefCount++;
+                        }
                     }
                 }
-                am->nIdCount = am->nNew;
                 int nLost = 0;
                 for (int n = 0; n < am->nTried; n++)
                 {
                     CAddrInfo info;
                     READWRITE(info);
-                    std::vector<int> &vTried = am->vvTried[info.GetTriedBucket(am->nKey)];
-                    if (vTried.size() < ADDRMAN_TRIED_BUCKET_SIZE)
+                    int nKBucket = info.GetTriedBucket(am->nKey);
+                    if (am->vTriedSize[nKBucket] < ADDRMAN_TRIED_BUCKET_SIZE)
                     {
+                        int nId = am->vInfo.size();
                         info.nRandomPos = vRandom.size();
                         info.fInTried = true;
-                        am->vRandom.push_back(am->nIdCount);
-                        am->mapInfo[am->nIdCount] = info;
-                        am->mapAddr[info] = am->nIdCount;
-                        vTried.push_back(am->nIdCount);
-                        am->nIdCount++;
+                        am->vRandom.push_back(nId);
+                        am->vInfo.push_back(info);
+                        am->mapAddr[info] = nId;
+                        am->vvTried[nKBucket][am->vTriedSize[nKBucket]++] = nId;
                     } else {
                         nLost++;
                     }
@@ -361,37 +376,49 @@ public:
                 am->nTried -= nLost;
                 for (int b = 0; b < nUBuckets; b++)
                 {
-                    std::set<int> &vNew = am->vvNew[b];
                     int nSize = 0;
                     READWRITE(nSize);
                     for (int n = 0; n < nSize; n++)
                     {
                         int nIndex = 0;
                         READWRITE(nIndex);
-                        CAddrInfo &info = am->mapInfo[nIndex];
-                        if (nUBuckets == ADDRMAN_NEW_BUCKET_COUNT && info.nRefCount < ADDRMAN_NEW_BUCKETS_PER_ADDRESS)
+                        if (nUBuckets != ADDRMAN_NEW_BUCKET_COUNT || nIndex < 0 || nIndex >= am->nNew)
+                            continue;
+                        CAddrInfo &info = am->vInfo[nIndex];
+                        if (info.nRefCount < ADDRMAN_NEW_BUCKETS_PER_ADDRESS &&
+                            am->vNewSize[b] < ADDRMAN_NEW_BUCKET_SIZE && am->FindNew(b, nIndex) == -1)
                         {
                             info.nRefCount++;
-                            vNew.insert(nIndex);
+                            am->vvNew[b][am->vNewSize[b]++] = nIndex;
                         }
                     }
                 }
+                //ticoin Drop "new" entries that ended up in no bucket (full buckets, or
+                //ticoin missing from the stored lists); they could never be selected, and
+                //ticoin would make nNew disagree with what is written back.
+                int nLoadedNew = am->nNew;
+                for (int n = 0; n < nLoadedNew; n++)
+                {
+                    if (am->vInfo[n].nRefCount == 0)
+                        am->Delete(n);
+                }
             }
         }
     });)
 
-    CAddrMan() : vRandom(0), vvTried(ADDRMAN_TRIED_BUCKET_COUNT, std::vector<int>(0)), vvNew(ADDRMAN_NEW_BUCKET_COUNT, std::set<int>())
+    CAddrMan() : vRandom(0)
     {
          nKey.resize(32);
          RAND_bytes(&nKey[0], 32);
 
-         nIdCount = 0;
          nTried = 0;
+         memset(vTriedSize, 0, sizeof(vTriedSize));
          nNew = 0;
+         memset(vNewSize, 0, sizeof(vNewSize));
     }
 
     //ticoin Return the number of (unique) addresses in all tables.
-    int size()
+    int size() const
     {
         return vRandom.size();
     }
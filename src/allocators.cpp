@@ -26,6 +26,8 @@
 
 LockedPageManager* LockedPageManager::_instance = NULL;
 boost::once_flag LockedPageManager::init_flag = BOOST_ONCE_INIT;
+CNetBufferPool* CNetBufferPool::_instance = NULL;
+boost::once_flag CNetBufferPool::init_flag = BOOST_ONCE_INIT;
 
 /** Determine system page size in bytes */
 static inline size_t GetSystemPageSize()
@@ -65,3 +67,73 @@ LockedPageManager::LockedPageManager() : LockedPageManagerBase<MemoryPageLocker>
 {
 }
 
+CNetBufferPool::CNetBufferPool() : nPooledBytes(0), nMaxPooledBytes(32 << 20), nHits(0), nMisses(0)
+{
+}
+
+void* CNetBufferPool::Allocate(size_t nSize)
+{
+    int nClass = GetClass(nSize);
+    if (nClass < 0)
+        return ::operator new(nSize);
+
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        if (!vFree[nClass].empty()) {
+            void* p = vFree[nClass].back();
+            vFree[nClass].pop_back();
+            nPooledBytes -= MIN_CLASS_SIZE << nClass;
+            nHits++;
+            return p;
+        }
+        nMisses++;
+    }
+    //ticoin Always allocate the full class size, so the buffer can serve any request of its class later
+    return ::operator new(MIN_CLASS_SIZE << nClass);
+}
+
+void CNetBufferPool::Deallocate(void* p, size_t nSize)
+{
+    int nClass = GetClass(nSize);
+    if (nClass >= 0) {
+        size_t nClassSize = MIN_CLASS_SIZE << nClass;
+        boost::mutex::scoped_lock lock(mutex);
+        if (nPooledBytes + nClassSize <= nMaxPooledBytes) {
+            vFree[nClass].push_back(p);
+            nPooledBytes += nClassSize;
+            return;
+        }
+    }
+    ::operator delete(p);
+}
+
+size_t CNetBufferPool::GetPooledBytes()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return nPooledBytes;
+}
+
+void CNetBufferPool::SetMaxPooledBytes(size_t nMax)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    nMaxPooledBytes = nMax;
+    for (int nClass = NUM_CLASSES - 1; nClass >= 0 && nPooledBytes > nMaxPooledBytes; nClass--) {
+        while (!vFree[nClass].empty() && nPooledBytes > nMaxPooledBytes) {
+            ::operator delete(vFree[nClass].back());
+            vFree[nClass].pop_back();
+            nPooledBytes -= MIN_CLASS_SIZE << nClass;
+        }
+    }
+}
+
+uint64_t CNetBufferPool::GetHits()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return nHits;
+}
+
+uint64_t CNetBufferPool::GetMisses()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return nMisses;
+}
@@ -7,8 +7,11 @@
 #define ticoin_ALLOCATORS_H
 
 #include <map>
+#include <new>
+#include <stdint.h>
 #include <string>
 #include <string.h>
+#include <vector>
 
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/once.hpp>
@@ -249,6 +252,106 @@ struct zero_after_free_allocator : public std::allocator<T>
     }
 };
 
+/**
+ * Singleton pool of recycled buffers for network message streams.
+ *
+ * Requests are rounded up to a power-of-two size class; freed buffers are kept
+ * on a per-class free list, up to a total of nMaxPooledBytes, and handed out
+ * again without being cleared. Requests larger than the biggest class bypass
+ * the pool.
+ *
+ * Buffers are recycled as-is, so only streams that never hold key material
+ * may use it. The instance is created on demand and intentionally never
+ * destroyed: nodes are freed during static deinitialization, possibly after
+ * a static pool would have been destroyed.
+ */
+class CNetBufferPool
+{
+public:
+    static const size_t MIN_CLASS_SIZE = 256;
+    static const int NUM_CLASSES = 16; //ticoin 256 bytes up to 8 MiB
+
+    static CNetBufferPool& Instance()
+    {
+        boost::call_once(CNetBufferPool::CreateInstance, CNetBufferPool::init_flag);
+        return *CNetBufferPool::_instance;
+    }
+
+    void* Allocate(size_t nSize);
+    void Deallocate(void* p, size_t nSize);
+
+    //ticoin Bytes kept on the free lists; by default at most 32 MiB
+    size_t GetPooledBytes();
+    void SetMaxPooledBytes(size_t nMax);
+    //ticoin Allocations served from a free list, and ones that had to go to the heap
+    uint64_t GetHits();
+    uint64_t GetMisses();
+
+    //ticoin Size class of a request, or -1 if it is too large to be pooled
+    static int GetClass(size_t nSize)
+    {
+        size_t nClassSize = MIN_CLASS_SIZE;
+        for (int nClass = 0; nClass < NUM_CLASSES; nClass++, nClassSize <<= 1)
+            if (nSize <= nClassSize)
+                return nClass;
+        return -1;
+    }
+
+private:
+    boost::mutex mutex;
+    std::vector<void*> vFree[NUM_CLASSES];
+    size_t nPooledBytes;
+    size_t nMaxPooledBytes;
+    uint64_t nHits;
+    uint64_t nMisses;
+
+    CNetBufferPool();
+
+    static void CreateInstance()
+    {
+        CNetBufferPool::_instance = new CNetBufferPool();
+    }
+
+    static CNetBufferPool* _instance;
+    static boost::once_flag init_flag;
+};
+
+//
+//ticoin Allocator that draws its memory from CNetBufferPool.
+//ticoin Memory is not cleared on deallocation.
+//
+template<typename T>
+struct pooled_allocator : public std::allocator<T>
+{
+    //ticoin MSVC8 default copy constructor is broken
+    typedef std::allocator<T> base;
+    typedef typename base::size_type size_type;
+    typedef typename base::difference_type  difference_type;
+    typedef typename base::pointer pointer;
+    typedef typename base::const_pointer const_pointer;
+    typedef typename base::reference reference;
+    typedef typename base::const_reference const_reference;
+    typedef typename base::value_type value_type;
+    pooled_allocator() throw() {}
+    pooled_allocator(const pooled_allocator& a) throw() : base(a) {}
+    template <typename U>
+    pooled_allocator(const pooled_allocator<U>& a) throw() : base(a) {}
+    ~pooled_allocator() throw() {}
+    template<typename _Other> struct rebind
+    { typedef pooled_allocator<_Other> other; };
+
+    T* allocate(std::size_t n, const void *hint = 0)
+    {
+        return static_cast<T*>(CNetBufferPool::Instance().Allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (p != NULL)
+            CNetBufferPool::Instance().Deallocate(p, sizeof(T) * n);
+    }
+};
+
 //ticoin This is exactly like std::string, but with a custom allocator.
 typedef std::basic_string<char, std::char_traits<char>, secure_allocator<char> > SecureString;
 
@@ -0,0 +1,208 @@
+/**-5-10Copyright (c) 2009-2010 Satoshi Nakamoto
+/**-5-10Copyright (c) 2009-2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "arith_uint256.h"
+
+#include "uint256.h"
+
+#include <assert.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <string.h>
+
+arith_uint256& arith_uint256::operator<<=(unsigned int shift)
+{
+    arith_uint256 a(*this);
+    for (int i = 0; i < WIDTH; i++)
+        pn[i] = 0;
+    int k = shift / 32;
+    shift = shift % 32;
+    for (int i = 0; i < WIDTH; i++)
+    {
+        if (i+k+1 < WIDTH && shift != 0)
+            pn[i+k+1] |= (a.pn[i] >> (32-shift));
+        if (i+k < WIDTH)
+            pn[i+k] |= (a.pn[i] << shift);
+    }
+    return *this;
+}
+
+arith_uint256& arith_uint256::operator>>=(unsigned int shift)
+{
+    arith_uint256 a(*this);
+    for (int i = 0; i < WIDTH; i++)
+        pn[i] = 0;
+    int k = shift / 32;
+    shift = shift % 32;
+    for (int i = 0; i < WIDTH; i++)
+    {
+        if (i-k-1 >= 0 && shift != 0)
+            pn[i-k-1] |= (a.pn[i] << (32-shift));
+        if (i-k >= 0)
+            pn[i-k] |= (a.pn[i] >> shift);
+    }
+    return *this;
+}
+
+arith_uint256& arith_uint256::operator*=(uint32_t b32)
+{
+    uint64_t carry = 0;
+    for (int i = 0; i < WIDTH; i++)
+    {
+        uint64_t n = carry + (uint64_t)b32 * pn[i];
+        pn[i] = n & 0xffffffff;
+        carry = n >> 32;
+    }
+    return *this;
+}
+
+arith_uint256& arith_uint256::operator*=(const arith_uint256& b)
+{
+    arith_uint256 a = *this;
+    *this = 0;
+    for (int j = 0; j < WIDTH; j++) {
+        uint64_t carry = 0;
+        for (int i = 0; i + j < WIDTH; i++) {
+            uint64_t n = carry + pn[i + j] + (uint64_t)a.pn[j] * b.pn[i];
+            pn[i + j] = n & 0xffffffff;
+            carry = n >> 32;
+        }
+    }
+    return *this;
+}
+
+arith_uint256& arith_uint256::operator/=(const arith_uint256& b)
+{
+    arith_uint256 div = b;     /**-5-10make a copy, so we can shift.
+    arith_uint256 num = *this; /**-5-10make a copy, so we can subtract.
+    *this = 0;                 /**-5-10the quotient.
+    int num_bits = num.bits();
+    int div_bits = div.bits();
+    if (div_bits == 0)
+        throw std::domain_error("arith_uint256::operator/= : division by zero");
+    if (div_bits > num_bits) /**-5-10the result is certainly 0.
+        return *this;
+    int shift = num_bits - div_bits;
+    div <<= shift; /**-5-10shift so that div and num align.
+    while (shift >= 0) {
+        if (num >= div) {
+            num -= div;
+            pn[shift / 32] |= (1U << (shift & 31)); /**-5-10set a bit of the result.
+        }
+        div >>= 1; /**-5-10shift back.
+        shift--;
+    }
+    /**-5-10num now contains the remainder of the division.
+    return *this;
+}
+
+int arith_uint256::CompareTo(const arith_uint256& b) const
+{
+    for (int i = WIDTH-1; i >= 0; i--)
+    {
+        if (pn[i] < b.pn[i])
+            return -1;
+        if (pn[i] > b.pn[i])
+            return 1;
+    }
+    return 0;
+}
+
+bool arith_uint256::EqualTo(uint64_t b) const
+{
+    for (int i = WIDTH-1; i >= 2; i--)
+    {
+        if (pn[i])
+            return false;
+    }
+    if (pn[1] != (b >> 32))
+        return false;
+    if (pn[0] != (b & 0xfffffffful))
+        return false;
+    return true;
+}
+
+unsigned int arith_uint256::bits() const
+{
+    for (int pos = WIDTH-1; pos >= 0; pos--)
+    {
+        if (pn[pos])
+        {
+            for (int bits = 31; bits > 0; bits--)
+            {
+                if (pn[pos] & 1U << bits)
+                    return 32*pos + bits + 1;
+            }
+            return 32*pos + 1;
+        }
+    }
+    return 0;
+}
+
+std::string arith_uint256::GetHex() const
+{
+    return ArithToUint256(*this).GetHex();
+}
+
+arith_uint256& arith_uint256::SetCompact(uint32_t nCompact, bool *pfNegative, bool *pfOverflow)
+{
+    int nSize = nCompact >> 24;
+    uint32_t nWord = nCompact & 0x007fffff;
+    if (nSize <= 3)
+    {
+        nWord >>= 8*(3-nSize);
+        *this = nWord;
+    }
+    else
+    {
+        *this = nWord;
+        *this <<= 8*(nSize-3);
+    }
+    if (pfNegative)
+        *pfNegative = nWord != 0 && (nCompact & 0x00800000) != 0;
+    if (pfOverflow)
+        *pfOverflow = nWord != 0 && ((nSize > 34) ||
+                                     (nWord > 0xff && nSize > 33) ||
+                                     (nWord > 0xffff && nSize > 32));
+    return *this;
+}
+
+uint32_t arith_uint256::GetCompact(bool fNegative) const
+{
+    int nSize = (bits() + 7) / 8;
+    uint32_t nCompact = 0;
+    if (nSize <= 3) {
+        nCompact = GetLow64() << 8 * (3 - nSize);
+    } else {
+        arith_uint256 bn = *this >> 8 * (nSize - 3);
+        nCompact = bn.GetLow64();
+    }
+    /**-5-10The 0x00800000 bit denotes the sign.
+    /**-5-10Thus, if it is already set, divide the mantissa by 256 and increase the exponent.
+    if (nCompact & 0x00800000) {
+        nCompact >>= 8;
+        nSize++;
+    }
+    assert((nCompact & ~0x007fffff) == 0);
+    assert(nSize < 256);
+    nCompact |= nSize << 24;
+    nCompact |= (fNegative && (nCompact & 0x007fffff) ? 0x00800000 : 0);
+    return nCompact;
+}
+
+uint256 ArithToUint256(const arith_uint256 &a)
+{
+    uint256 b;
+    /**-5-10both types store their words least significant first
+    memcpy(b.begin(), a.pn, sizeof(a.pn));
+    return b;
+}
+
+arith_uint256 UintToArith256(const uint256 &a)
+{
+    arith_uint256 b;
+    memcpy(b.pn, a.begin(), sizeof(b.pn));
+    return b;
+}
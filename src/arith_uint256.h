@@ -0,0 +1,183 @@
+/**-5-10Copyright (c) 2009-2010 Satoshi Nakamoto
+/**-5-10Copyright (c) 2009-2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ticoin_ARITH_UINT256_H
+#define ticoin_ARITH_UINT256_H
+
+#include <stdint.h>
+#include <string>
+
+class uint256;
+
+/** 256-bit unsigned integer with fixed-width arithmetic.
+ * Unlike CBigNum it never allocates, which makes it suitable for code that
+ * runs for every block header, such as the proof-of-work and chain work
+ * calculations. Overflowing operations wrap around modulo 2^256.
+ */
+class arith_uint256
+{
+protected:
+    enum { WIDTH=256/32 };
+    uint32_t pn[WIDTH];
+public:
+
+    arith_uint256()
+    {
+        for (int i = 0; i < WIDTH; i++)
+            pn[i] = 0;
+    }
+
+    arith_uint256(const arith_uint256& b)
+    {
+        for (int i = 0; i < WIDTH; i++)
+            pn[i] = b.pn[i];
+    }
+
+    arith_uint256& operator=(const arith_uint256& b)
+    {
+        for (int i = 0; i < WIDTH; i++)
+            pn[i] = b.pn[i];
+        return *this;
+    }
+
+    arith_uint256(uint64_t b)
+    {
+        pn[0] = (unsigned int)b;
+        pn[1] = (unsigned int)(b >> 32);
+        for (int i = 2; i < WIDTH; i++)
+            pn[i] = 0;
+    }
+
+    arith_uint256& operator=(uint64_t b)
+    {
+        pn[0] = (unsigned int)b;
+        pn[1] = (unsigned int)(b >> 32);
+        for (int i = 2; i < WIDTH; i++)
+            pn[i] = 0;
+        return *this;
+    }
+
+    bool operator!() const
+    {
+        for (int i = 0; i < WIDTH; i++)
+            if (pn[i] != 0)
+                return false;
+        return true;
+    }
+
+    const arith_uint256 operator~() const
+    {
+        arith_uint256 ret;
+        for (int i = 0; i < WIDTH; i++)
+            ret.pn[i] = ~pn[i];
+        return ret;
+    }
+
+    const arith_uint256 operator-() const
+    {
+        arith_uint256 ret;
+        for (int i = 0; i < WIDTH; i++)
+            ret.pn[i] = ~pn[i];
+        ++ret;
+        return ret;
+    }
+
+    arith_uint256& operator<<=(unsigned int shift);
+    arith_uint256& operator>>=(unsigned int shift);
+
+    arith_uint256& operator+=(const arith_uint256& b)
+    {
+        uint64_t carry = 0;
+        for (int i = 0; i < WIDTH; i++)
+        {
+            uint64_t n = carry + pn[i] + b.pn[i];
+            pn[i] = n & 0xffffffff;
+            carry = n >> 32;
+        }
+        return *this;
+    }
+
+    arith_uint256& operator-=(const arith_uint256& b)
+    {
+        *this += -b;
+        return *this;
+    }
+
+    arith_uint256& operator*=(uint32_t b32);
+    arith_uint256& operator*=(const arith_uint256& b);
+    arith_uint256& operator/=(const arith_uint256& b);
+
+    arith_uint256& operator++()
+    {
+        /**-5-10prefix operator
+        int i = 0;
+        while (++pn[i] == 0 && i < WIDTH-1)
+            i++;
+        return *this;
+    }
+
+    arith_uint256& operator--()
+    {
+        /**-5-10prefix operator
+        int i = 0;
+        while (--pn[i] == (uint32_t)-1 && i < WIDTH-1)
+            i++;
+        return *this;
+    }
+
+    /** Returns -1, 0 or 1 depending on whether this is smaller than, equal to or larger than b */
+    int CompareTo(const arith_uint256& b) const;
+    bool EqualTo(uint64_t b) const;
+
+    friend inline const arith_uint256 operator+(const arith_uint256& a, const arith_uint256& b) { return arith_uint256(a) += b; }
+    friend inline const arith_uint256 operator-(const arith_uint256& a, const arith_uint256& b) { return arith_uint256(a) -= b; }
+    friend inline const arith_uint256 operator/(const arith_uint256& a, const arith_uint256& b) { return arith_uint256(a) /= b; }
+    friend inline const arith_uint256 operator*(const arith_uint256& a, uint32_t b) { return arith_uint256(a) *= b; }
+    friend inline const arith_uint256 operator*(const arith_uint256& a, const arith_uint256& b) { return arith_uint256(a) *= b; }
+    friend inline const arith_uint256 operator<<(const arith_uint256& a, unsigned int shift) { return arith_uint256(a) <<= shift; }
+    friend inline const arith_uint256 operator>>(const arith_uint256& a, unsigned int shift) { return arith_uint256(a) >>= shift; }
+    friend inline bool operator==(const arith_uint256& a, const arith_uint256& b) { return a.CompareTo(b) == 0; }
+    friend inline bool operator!=(const arith_uint256& a, const arith_uint256& b) { return a.CompareTo(b) != 0; }
+    friend inline bool operator>(const arith_uint256& a, const arith_uint256& b) { return a.CompareTo(b) > 0; }
+    friend inline bool operator<(const arith_uint256& a, const arith_uint256& b) { return a.CompareTo(b) < 0; }
+    friend inline bool operator>=(const arith_uint256& a, const arith_uint256& b) { return a.CompareTo(b) >= 0; }
+    friend inline bool operator<=(const arith_uint256& a, const arith_uint256& b) { return a.CompareTo(b) <= 0; }
+    friend inline bool operator==(const arith_uint256& a, uint64_t b) { return a.EqualTo(b); }
+    friend inline bool operator!=(const arith_uint256& a, uint64_t b) { return !a.EqualTo(b); }
+
+    /** Returns the position of the highest bit set plus one, or zero if the value is zero */
+    unsigned int bits() const;
+
+    uint64_t GetLow64() const
+    {
+        return pn[0] | (uint64_t)pn[1] << 32;
+    }
+
+    std::string GetHex() const;
+
+    /**
+     * The "compact" format is a representation of a whole number N using an
+     * unsigned 32bit number similar to a floating point format.
+     * The most significant 8 bits are the unsigned exponent of base 256.
+     * This exponent can be thought of as "number of bytes of N".
+     * The lower 23 bits are the mantissa.
+     * Bit number 24 (0x800000) represents the sign of N.
+     * N = (-1^sign) * mantissa * 256^(exponent-3)
+     *
+     * Decoding matches CBigNum::SetCompact, except that instead of producing
+     * a negative or oversized number the flags pfNegative and pfOverflow are set.
+     * Encoding matches CBigNum::GetCompact; fNegative sets the sign bit.
+     */
+    arith_uint256& SetCompact(uint32_t nCompact, bool *pfNegative = NULL, bool *pfOverflow = NULL);
+    uint32_t GetCompact(bool fNegative = false) const;
+
+    friend uint256 ArithToUint256(const arith_uint256 &);
+    friend arith_uint256 UintToArith256(const uint256 &);
+};
+
+uint256 ArithToUint256(const arith_uint256 &);
+arith_uint256 UintToArith256(const uint256 &);
+
+#endif
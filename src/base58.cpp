@@ -17,6 +17,30 @@
 
 /* All alphanumeric characters except for "0", "I", "O", and "l" */
 static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+static const int8_t mapBase58[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6,  7, 8,-1,-1,-1,-1,-1,-1,
+    -1, 9,10,11,12,13,14,15, 16,-1,17,18,19,20,21,-1,
+    22,23,24,25,26,27,28,29, 30,31,32,-1,-1,-1,-1,-1,
+    -1,33,34,35,36,37,38,39, 40,41,42,43,-1,44,45,46,
+    47,48,49,50,51,52,53,54, 55,56,57,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+//ticoin The codec works on machine words instead of single digits: encoding
+//ticoin accumulates into limbs of 58^5, decoding into limbs of 2^32, and both
+//ticoin fold several input symbols into each pass over the limbs.
+static const uint32_t BASE58_LIMB = 656356768; //ticoin 58^5
+static const int BASE58_LIMB_DIGITS = 5;
 
 bool DecodeBase58(const char *psz, std::vector<unsigned char>& vch) {
     //ticoin Skip leading spaces.
@@ -28,72 +52,104 @@ bool DecodeBase58(const char *psz, std::vector<unsigned char>& vch) {
         zeroes++;
         psz++;
     }
-    //ticoin Allocate enough space in big-endian base256 representation.
-    std::vector<unsigned char> b256(strlen(psz) * 733 / 1000 + 1); //ticoin log(58) / log(256), rounded up.
-    //ticoin Process the characters.
+    //ticoin Allocate enough space in little-endian base 2^32 representation.
+    std::vector<uint32_t> vLimbs(strlen(psz) * 733 / 1000 / 4 + 1); //ticoin log(58) / log(256), rounded up.
+    size_t nLength = 0;
+    //ticoin Process the characters, up to five at a time.
     while (*psz && !isspace(*psz)) {
-        //ticoin Decode base58 character
-        const char *ch = strchr(pszBase58, *psz);
-        if (ch == NULL)
-            return false;
-        //ticoin Apply "b256 = b256 * 58 + ch".
-        int carry = ch - pszBase58;
-        for (std::vector<unsigned char>::reverse_iterator it = b256.rbegin(); it != b256.rend(); it++) {
-            carry += 58 * (*it);
-            *it = carry % 256;
-            carry /= 256;
+        uint64_t carry = 0;
+        uint32_t nMul = 1;
+        for (int i = 0; i < BASE58_LIMB_DIGITS && *psz && !isspace(*psz); i++, psz++) {
+            int digit = mapBase58[(uint8_t)*psz];
+            if (digit == -1)
+                return false;
+            carry = carry * 58 + digit;
+            nMul *= 58;
         }
-        assert(carry == 0);
-        psz++;
+        //ticoin Apply "limbs = limbs * 58^n + carry".
+        size_t i = 0;
+        for (; i < nLength || carry != 0; i++) {
+            assert(i < vLimbs.size());
+            carry += (uint64_t)vLimbs[i] * nMul;
+            vLimbs[i] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        nLength = i;
     }
     //ticoin Skip trailing spaces.
     while (isspace(*psz))
         psz++;
     if (*psz != 0)
         return false;
-    //ticoin Skip leading zeroes in b256.
-    std::vector<unsigned char>::iterator it = b256.begin();
-    while (it != b256.end() && *it == 0)
-        it++;
-    //ticoin Copy result into output vector.
-    vch.reserve(zeroes + (b256.end() - it));
+    //ticoin Copy result into output vector, skipping leading zeroes of the top limb.
+    vch.reserve(zeroes + nLength * 4);
     vch.assign(zeroes, 0x00);
-    while (it != b256.end())
-      vch.push_back(*(it++));
+    bool fLeading = true;
+    for (size_t i = nLength; i-- > 0; ) {
+        for (int nShift = 24; nShift >= 0; nShift -= 8) {
+            unsigned char c = (vLimbs[i] >> nShift) & 0xff;
+            if (fLeading && c == 0)
+                continue;
+            fLeading = false;
+            vch.push_back(c);
+        }
+    }
     return true;
 }
 
-std::string EncodeBase58(const unsigned char* pbegin, const unsigned char* pend) {
+//ticoin Append the base58 encoding of [pbegin, pend) to str, using vLimbs as scratch space.
+static void EncodeBase58Append(const unsigned char* pbegin, const unsigned char* pend, std::vector<uint32_t>& vLimbs, std::string& str) {
     //ticoin Skip & count leading zeroes.
     int zeroes = 0;
     while (pbegin != pend && *pbegin == 0) {
         pbegin++;
         zeroes++;
     }
-    //ticoin Allocate enough space in big-endian base58 representation.
-    std::vector<unsigned char> b58((pend - pbegin) * 138 / 100 + 1); //ticoin log(256) / log(58), rounded up.
-    //ticoin Process the bytes.
+    //ticoin Allocate enough space in little-endian base 58^5 representation.
+    vLimbs.assign((pend - pbegin) * 2732 / 10000 + 1, 0); //ticoin log(256) / log(58^5), rounded up.
+    size_t nLength = 0;
+    //ticoin Process the bytes, up to three at a time so that limb * 2^24 fits in 64 bits.
     while (pbegin != pend) {
-        int carry = *pbegin;
-        //ticoin Apply "b58 = b58 * 256 + ch".
-        for (std::vector<unsigned char>::reverse_iterator it = b58.rbegin(); it != b58.rend(); it++) {
-            carry += 256 * (*it);
-            *it = carry % 58;
-            carry /= 58;
+        uint64_t carry = 0;
+        uint32_t nMul = 1;
+        for (int i = 0; i < 3 && pbegin != pend; i++, pbegin++) {
+            carry = (carry << 8) | *pbegin;
+            nMul <<= 8;
         }
-        assert(carry == 0);
-        pbegin++;
+        //ticoin Apply "limbs = limbs * 256^n + carry".
+        size_t i = 0;
+        for (; i < nLength || carry != 0; i++) {
+            assert(i < vLimbs.size());
+            carry += (uint64_t)vLimbs[i] * nMul;
+            vLimbs[i] = carry % BASE58_LIMB;
+            carry /= BASE58_LIMB;
+        }
+        nLength = i;
     }
-    //ticoin Skip leading zeroes in base58 result.
-    std::vector<unsigned char>::iterator it = b58.begin();
-    while (it != b58.end() && *it == 0)
-        it++;
-    //ticoin Translate the result into a string.
+    //ticoin Translate the result into a string, skipping leading zeroes of the top limb.
+    str.reserve(str.size() + zeroes + nLength * BASE58_LIMB_DIGITS);
+    str.append(zeroes, '1');
+    bool fLeading = true;
+    for (size_t i = nLength; i-- > 0; ) {
+        unsigned char digits[BASE58_LIMB_DIGITS];
+        uint32_t n = vLimbs[i];
+        for (int j = BASE58_LIMB_DIGITS - 1; j >= 0; j--) {
+            digits[j] = n % 58;
+            n /= 58;
+        }
+        for (int j = 0; j < BASE58_LIMB_DIGITS; j++) {
+            if (fLeading && digits[j] == 0)
+                continue;
+            fLeading = false;
+            str += pszBase58[digits[j]];
+        }
+    }
+}
+
+std::string EncodeBase58(const unsigned char* pbegin, const unsigned char* pend) {
+    std::vector<uint32_t> vLimbs;
     std::string str;
-    str.reserve(zeroes + (b58.end() - it));
-    str.assign(zeroes, '1');
-    while (it != b58.end())
-        str += pszBase58[*(it++)];
+    EncodeBase58Append(pbegin, pend, vLimbs, str);
     return str;
 }
 
@@ -105,12 +161,20 @@ bool DecodeBase58(const std::string& str, std::vector<unsigned char>& vchRet) {
     return DecodeBase58(str.c_str(), vchRet);
 }
 
-std::string EncodeBase58Check(const std::vector<unsigned char>& vchIn) {
+//ticoin Append the base58check encoding of vch to str; vch is used as scratch and gets the checksum appended.
+static void EncodeBase58CheckAppend(std::vector<unsigned char>& vch, std::vector<uint32_t>& vLimbs, std::string& str) {
     //ticoin add 4-byte hash check to the end
-    std::vector<unsigned char> vch(vchIn);
     uint256 hash = Hash(vch.begin(), vch.end());
     vch.insert(vch.end(), (unsigned char*)&hash, (unsigned char*)&hash + 4);
-    return EncodeBase58(vch);
+    EncodeBase58Append(&vch[0], &vch[0] + vch.size(), vLimbs, str);
+}
+
+std::string EncodeBase58Check(const std::vector<unsigned char>& vchIn) {
+    std::vector<unsigned char> vch(vchIn);
+    std::vector<uint32_t> vLimbs;
+    std::string str;
+    EncodeBase58CheckAppend(vch, vLimbs, str);
+    return str;
 }
 
 bool DecodeBase58Check(const char* psz, std::vector<unsigned char>& vchRet) {
@@ -198,6 +262,37 @@ namespace {
     };
 };
 
+namespace {
+    //ticoin Writes the version prefix and hash of a destination, as CticoinAddress::Set would.
+    class CDestinationPayloadVisitor : public boost::static_visitor<void> {
+    private:
+        std::vector<unsigned char> &vch;
+    public:
+        CDestinationPayloadVisitor(std::vector<unsigned char> &vchIn) : vch(vchIn) { }
+
+        void operator()(const CKeyID &id) const {
+            vch = Params().Base58Prefix(CChainParams::PUBKEY_ADDRESS);
+            vch.insert(vch.end(), id.begin(), id.end());
+        }
+        void operator()(const CScriptID &id) const {
+            vch = Params().Base58Prefix(CChainParams::SCRIPT_ADDRESS);
+            vch.insert(vch.end(), id.begin(), id.end());
+        }
+        void operator()(const CNoDestination &no) const { vch.clear(); }
+    };
+};
+
+std::vector<std::string> EncodeDestinations(const std::vector<CTxDestination>& vDest) {
+    std::vector<std::string> vRet(vDest.size());
+    std::vector<unsigned char> vch;
+    std::vector<uint32_t> vLimbs;
+    for (unsigned int i = 0; i < vDest.size(); i++) {
+        boost::apply_visitor(CDestinationPayloadVisitor(vch), vDest[i]);
+        EncodeBase58CheckAppend(vch, vLimbs, vRet[i]);
+    }
+    return vRet;
+}
+
 bool CticoinAddress::Set(const CKeyID &id) {
     SetData(Params().Base58Prefix(CChainParams::PUBKEY_ADDRESS), &id, 20);
     return true;
@@ -115,6 +115,13 @@ public:
     bool IsScript() const;
 };
 
+/**
+ * Encode a batch of destinations as address strings, in order.
+ * The result is the same as CticoinAddress(dest).ToString() for each element,
+ * but the scratch buffers are shared across the batch instead of allocated per address.
+ */
+std::vector<std::string> EncodeDestinations(const std::vector<CTxDestination>& vDest);
+
 /**
  * A base58-encoded secret key
  */
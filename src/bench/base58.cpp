@@ -0,0 +1,158 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "base58.h"
+#include "bignum.h"
+#include "key.h"
+#include "script.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string>
+#include <vector>
+
+static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+/**-5-10The digit-at-a-time codec the word-based one replaced
+static std::string ReferenceEncodeBase58(const unsigned char* pbegin, const unsigned char* pend)
+{
+    int zeroes = 0;
+    while (pbegin != pend && *pbegin == 0) {
+        pbegin++;
+        zeroes++;
+    }
+    std::vector<unsigned char> b58((pend - pbegin) * 138 / 100 + 1);
+    while (pbegin != pend) {
+        int carry = *pbegin;
+        for (std::vector<unsigned char>::reverse_iterator it = b58.rbegin(); it != b58.rend(); it++) {
+            carry += 256 * (*it);
+            *it = carry % 58;
+            carry /= 58;
+        }
+        pbegin++;
+    }
+    std::vector<unsigned char>::iterator it = b58.begin();
+    while (it != b58.end() && *it == 0)
+        it++;
+    std::string str(zeroes, '1');
+    while (it != b58.end())
+        str += pszBase58[*(it++)];
+    return str;
+}
+
+/**-5-10The CBigNum codec before that, one BN_div per output digit
+static std::string BigNumEncodeBase58(const unsigned char* pbegin, const unsigned char* pend)
+{
+    CAutoBN_CTX pctx;
+    CBigNum bn58 = 58;
+    CBigNum bn0 = 0;
+
+    /**-5-10setvch takes little endian with a sign byte
+    std::vector<unsigned char> vchTmp(pend - pbegin + 1, 0);
+    std::reverse_copy(pbegin, pend, vchTmp.begin());
+    CBigNum bn;
+    bn.setvch(vchTmp);
+
+    std::string str;
+    str.reserve((pend - pbegin) * 138 / 100 + 1);
+    CBigNum dv, rem;
+    while (bn > bn0) {
+        if (!BN_div(&dv, &rem, &bn, &bn58, pctx))
+            throw bignum_error("BigNumEncodeBase58 : BN_div failed");
+        bn = dv;
+        str += pszBase58[rem.getulong()];
+    }
+    for (const unsigned char* p = pbegin; p < pend && *p == 0; p++)
+        str += pszBase58[0];
+    std::reverse(str.begin(), str.end());
+    return str;
+}
+
+/**-5-10A version byte, a 20 byte hash and a 4 byte checksum, the size of an address
+static void Base58Encode(benchmark::State& state)
+{
+    std::vector<unsigned char> vch(25);
+    for (unsigned int i = 0; i < vch.size(); i++)
+        vch[i] = i * 11;
+    std::string str;
+    while (state.KeepRunning())
+        str = EncodeBase58(vch);
+}
+
+static void Base58EncodeReference(benchmark::State& state)
+{
+    std::vector<unsigned char> vch(25);
+    for (unsigned int i = 0; i < vch.size(); i++)
+        vch[i] = i * 11;
+    std::string str;
+    while (state.KeepRunning())
+        str = ReferenceEncodeBase58(&vch[0], &vch[0] + vch.size());
+}
+
+static void Base58EncodeBigNum(benchmark::State& state)
+{
+    std::vector<unsigned char> vch(25);
+    for (unsigned int i = 0; i < vch.size(); i++)
+        vch[i] = i * 11;
+    std::string str;
+    while (state.KeepRunning())
+        str = BigNumEncodeBase58(&vch[0], &vch[0] + vch.size());
+}
+
+static void Base58Decode(benchmark::State& state)
+{
+    const char* psz = "17VZNX1SN5NtKa8UQFxwQbFeFc3iqRYhem";
+    std::vector<unsigned char> vch;
+    bool fValid = true;
+    while (state.KeepRunning())
+        fValid &= DecodeBase58(psz, vch);
+    assert(fValid);
+}
+
+static void Base58CheckEncode(benchmark::State& state)
+{
+    std::vector<unsigned char> vch(21);
+    for (unsigned int i = 0; i < vch.size(); i++)
+        vch[i] = i * 11;
+    std::string str;
+    while (state.KeepRunning())
+        str = EncodeBase58Check(vch);
+}
+
+/**-5-10100 key hash addresses, as dumpwallet encodes them
+static std::vector<CTxDestination> CreateDestinations()
+{
+    std::vector<CTxDestination> vDest;
+    for (int n = 0; n < 100; n++)
+        vDest.push_back(CKeyID(uint160(n * 0x10001 + 1)));
+    return vDest;
+}
+
+static void Base58EncodeDestinations(benchmark::State& state)
+{
+    std::vector<CTxDestination> vDest = CreateDestinations();
+    std::vector<std::string> vstr;
+    while (state.KeepRunning())
+        vstr = EncodeDestinations(vDest);
+}
+
+/**-5-10The same addresses one at a time, for comparison with the batch
+static void Base58EncodeAddresses(benchmark::State& state)
+{
+    std::vector<CTxDestination> vDest = CreateDestinations();
+    std::vector<std::string> vstr(vDest.size());
+    while (state.KeepRunning())
+        for (unsigned int i = 0; i < vDest.size(); i++)
+            vstr[i] = CticoinAddress(vDest[i]).ToString();
+}
+
+BENCHMARK(Base58Encode);
+BENCHMARK(Base58EncodeReference);
+BENCHMARK(Base58EncodeBigNum);
+BENCHMARK(Base58Decode);
+BENCHMARK(Base58CheckEncode);
+BENCHMARK(Base58EncodeDestinations);
+BENCHMARK(Base58EncodeAddresses);
@@ -0,0 +1,82 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace benchmark;
+
+State::State(int nSamplesIn, int64_t nSampleMicrosIn) :
+    nSamples(nSamplesIn), nSampleMicros(nSampleMicrosIn),
+    nLeft(0), nBatchSize(0), nBatchStart(0), nPaused(0), nPauseStart(0)
+{
+}
+
+bool State::NextBatch()
+{
+    if (nBatchSize == 0) {
+        nBatchSize = 1;
+    } else {
+        int64_t nElapsed = GetTimeMicros() - nBatchStart - nPaused;
+        if (vSamples.empty() && nElapsed < nSampleMicros && nBatchSize < (1LL << 40)) {
+            /**-5-10Still calibrating: too short to measure reliably
+            nBatchSize *= 2;
+        } else {
+            vSamples.push_back(nElapsed * 1000.0 / nBatchSize);
+            if ((int)vSamples.size() >= nSamples) {
+                std::sort(vSamples.begin(), vSamples.end());
+                return false;
+            }
+        }
+    }
+    nLeft = nBatchSize - 1;
+    nPaused = 0;
+    nBatchStart = GetTimeMicros();
+    return true;
+}
+
+void State::PauseTiming()
+{
+    nPauseStart = GetTimeMicros();
+}
+
+void State::ResumeTiming()
+{
+    nPaused += GetTimeMicros() - nPauseStart;
+}
+
+BenchRunner::BenchmarkMap& BenchRunner::benchmarks()
+{
+    static BenchmarkMap benchmarks_map;
+    return benchmarks_map;
+}
+
+BenchRunner::BenchRunner(const std::string& name, BenchFunction func)
+{
+    benchmarks().insert(std::make_pair(name, func));
+}
+
+void BenchRunner::RunAll(const std::string& strFilter, int nSamples, int64_t nSampleMicros)
+{
+    std::cout << "# Benchmark, samples, iterations/sample, min ns/op, median ns/op, max ns/op" << std::endl;
+    for (BenchmarkMap::iterator it = benchmarks().begin(); it != benchmarks().end(); ++it) {
+        if (it->first.find(strFilter) == std::string::npos)
+            continue;
+        State state(nSamples, nSampleMicros);
+        it->second(state);
+        const std::vector<double>& vSamples = state.GetSamples();
+        if (vSamples.empty()) {
+            std::cout << strprintf("%s, 0, 0, -, -, -", it->first) << std::endl;
+            continue;
+        }
+        size_t nMid = vSamples.size() / 2;
+        double dMedian = vSamples.size() % 2 ? vSamples[nMid] : (vSamples[nMid - 1] + vSamples[nMid]) / 2;
+        std::cout << strprintf("%s, %d, %d, %.1f, %.1f, %.1f", it->first, vSamples.size(), state.GetBatchSize(),
+                               vSamples.front(), dMedian, vSamples.back()) << std::endl;
+    }
+}
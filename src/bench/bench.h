@@ -0,0 +1,95 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ticoin_BENCH_BENCH_H
+#define ticoin_BENCH_BENCH_H
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+/** Minimal microbenchmark framework.
+ *
+ * A benchmark is a function that runs the measured code in a loop:
+ *
+ *     static void CodeToTime(benchmark::State& state)
+ *     {
+ *         ... setup ...
+ *         while (state.KeepRunning()) {
+ *             ... code to time ...
+ *         }
+ *     }
+ *     BENCHMARK(CodeToTime);
+ *
+ * The loop runs in batches. The batch size doubles until a batch takes at
+ * least the sample time, and then a fixed number of samples is taken with
+ * that batch size. The report gives the minimum, median and maximum time per
+ * iteration over the samples.
+ */
+namespace benchmark {
+
+class State
+{
+private:
+    const int nSamples;
+    const int64_t nSampleMicros;
+
+    int64_t nLeft;
+    int64_t nBatchSize;
+    int64_t nBatchStart;
+    int64_t nPaused;
+    int64_t nPauseStart;
+    std::vector<double> vSamples;
+
+    bool NextBatch();
+
+public:
+    State(int nSamplesIn, int64_t nSampleMicrosIn);
+
+    bool KeepRunning()
+    {
+        if (nLeft > 0) {
+            --nLeft;
+            return true;
+        }
+        return NextBatch();
+    }
+
+    /** Exclude per-iteration setup from the measurement. Pausing costs far
+     * more than a cheap operation, so prefer setting up outside the loop. */
+    void PauseTiming();
+    void ResumeTiming();
+
+    int64_t GetBatchSize() const { return nBatchSize; }
+
+    /** Nanoseconds per iteration of every sample, sorted */
+    const std::vector<double>& GetSamples() const { return vSamples; }
+};
+
+typedef boost::function<void(State&)> BenchFunction;
+
+class BenchRunner
+{
+    typedef std::map<std::string, BenchFunction> BenchmarkMap;
+    static BenchmarkMap& benchmarks();
+
+public:
+    BenchRunner(const std::string& name, BenchFunction func);
+
+    /** Run all benchmarks whose name contains strFilter and print one line per benchmark */
+    static void RunAll(const std::string& strFilter, int nSamples, int64_t nSampleMicros);
+};
+
+}
+
+/**-5-10BENCHMARK(foo) registers the function foo under the name "foo"
+#define BENCHMARK(n) \
+    benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n);
+
+#endif /**-5-10ticoin_BENCH_BENCH_H
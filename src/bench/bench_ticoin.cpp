@@ -0,0 +1,29 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "util.h"
+
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+    SetupEnvironment();
+    ParseParameters(argc, argv);
+    fPrintToDebugLog = false;
+
+    if (mapArgs.count("-?") || mapArgs.count("-help")) {
+        std::cout << "Usage: bench_ticoin [options]\n\n"
+                  << "  -filter=<str>        Only run benchmarks whose name contains <str>\n"
+                  << "  -samples=<n>         Samples per benchmark (default: 5)\n"
+                  << "  -sample-time=<ms>    Minimum duration of one sample (default: 100)\n";
+        return 0;
+    }
+
+    int nSamples = std::max((int64_t)1, GetArg("-samples", 5));
+    int64_t nSampleMicros = std::max((int64_t)1, GetArg("-sample-time", 100)) * 1000;
+    benchmark::BenchRunner::RunAll(GetArg("-filter", ""), nSamples, nSampleMicros);
+    return 0;
+}
@@ -0,0 +1,67 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "core.h"
+#include "serialize.h"
+#include "version.h"
+
+#include <vector>
+
+/**-5-10A block of 2000 two-in two-out pay-to-pubkey-hash transactions, about 750 kB
+static CBlock CreateBlock()
+{
+    CBlock block;
+    block.nVersion = 2;
+    block.nTime = 1400000000;
+    block.nBits = 0x1d00ffff;
+    for (int n = 0; n < 2000; n++) {
+        CTransaction tx;
+        tx.vin.resize(2);
+        tx.vout.resize(2);
+        for (unsigned int i = 0; i < tx.vin.size(); i++) {
+            tx.vin[i].prevout = COutPoint(n * 2 + i + 1, i);
+            tx.vin[i].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+        }
+        for (unsigned int i = 0; i < tx.vout.size(); i++) {
+            tx.vout[i].nValue = 1000 * (n + 1);
+            tx.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, n) << OP_EQUALVERIFY << OP_CHECKSIG;
+        }
+        block.vtx.push_back(tx);
+    }
+    return block;
+}
+
+static void BuildMerkleTree(benchmark::State& state)
+{
+    CBlock block = CreateBlock();
+    uint256 root;
+    while (state.KeepRunning())
+        root = block.BuildMerkleTree();
+}
+
+static void SerializeBlock(benchmark::State& state)
+{
+    CBlock block = CreateBlock();
+    while (state.KeepRunning()) {
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block;
+    }
+}
+
+static void DeserializeBlock(benchmark::State& state)
+{
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+    ssBlock << CreateBlock();
+    while (state.KeepRunning()) {
+        CDataStream ss(ssBlock.begin(), ssBlock.end(), SER_NETWORK, PROTOCOL_VERSION);
+        CBlock block;
+        ss >> block;
+    }
+}
+
+BENCHMARK(BuildMerkleTree);
+BENCHMARK(SerializeBlock);
+BENCHMARK(DeserializeBlock);
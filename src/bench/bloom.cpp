@@ -0,0 +1,64 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "bloom.h"
+#include "core.h"
+
+#include <vector>
+
+static void BloomInsert(benchmark::State& state)
+{
+    CBloomFilter filter(10000, 0.0001, 0, BLOOM_UPDATE_ALL);
+    std::vector<unsigned char> vch(20, 0);
+    unsigned int n = 0;
+    while (state.KeepRunning()) {
+        memcpy(&vch[0], &n, sizeof(n));
+        n++;
+        filter.insert(vch);
+    }
+}
+
+static void BloomContains(benchmark::State& state)
+{
+    CBloomFilter filter(10000, 0.0001, 0, BLOOM_UPDATE_ALL);
+    std::vector<unsigned char> vch(20, 0);
+    for (unsigned int n = 0; n < 10000; n++) {
+        memcpy(&vch[0], &n, sizeof(n));
+        filter.insert(vch);
+    }
+    unsigned int n = 0;
+    while (state.KeepRunning()) {
+        memcpy(&vch[0], &n, sizeof(n));
+        n++;
+        filter.contains(vch);
+    }
+}
+
+/**-5-10Matching a two-in two-out transaction that the filter does not care about
+static void BloomIsRelevantAndUpdate(benchmark::State& state)
+{
+    CBloomFilter filter(10000, 0.0001, 0, BLOOM_UPDATE_ALL);
+    for (unsigned int n = 0; n < 1000; n++)
+        filter.insert(uint256(n + 1000000));
+    CTransaction tx;
+    tx.vin.resize(2);
+    tx.vout.resize(2);
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        tx.vin[i].prevout = COutPoint(i + 1, i);
+        tx.vin[i].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+    }
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        tx.vout[i].nValue = 1000;
+        tx.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, i) << OP_EQUALVERIFY << OP_CHECKSIG;
+    }
+    uint256 hash = tx.GetHash();
+    while (state.KeepRunning())
+        filter.IsRelevantAndUpdate(tx, hash);
+}
+
+BENCHMARK(BloomInsert);
+BENCHMARK(BloomContains);
+BENCHMARK(BloomIsRelevantAndUpdate);
@@ -0,0 +1,64 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "coins.h"
+#include "core.h"
+
+#include <assert.h>
+#include <vector>
+
+/**-5-10A cache over an empty view, holding nCoins single-output coins
+static void FillCache(CCoinsViewCache& cache, std::vector<uint256>& vTxid, unsigned int nCoins)
+{
+    CTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1000;
+    tx.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 1) << OP_EQUALVERIFY << OP_CHECKSIG;
+    for (unsigned int i = 0; i < nCoins; i++) {
+        tx.vin[0].prevout = COutPoint(i + 1, 0);
+        vTxid.push_back(tx.GetHash());
+        cache.SetCoins(vTxid.back(), CCoins(tx, 100000));
+    }
+}
+
+/**-5-10Fetching 100 coins into an empty child cache from its parent
+static void CoinsCacheFetch100(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache cacheParent(viewDummy);
+    std::vector<uint256> vTxid;
+    FillCache(cacheParent, vTxid, 10000);
+    unsigned int n = 0;
+    bool fAvailable = true;
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(cacheParent, true);
+        for (int i = 0; i < 100; i++)
+            fAvailable &= cache.GetCoins(vTxid[n++ % vTxid.size()]).IsAvailable(0);
+    }
+    assert(fAvailable);
+}
+
+/**-5-10Spending 100 fetched coins and flushing the result to the parent cache
+static void CoinsCacheFlush100(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache cacheParent(viewDummy);
+    std::vector<uint256> vTxid;
+    FillCache(cacheParent, vTxid, 10000);
+    unsigned int n = 0;
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(cacheParent, true);
+        for (int i = 0; i < 100; i++) {
+            CCoins& coins = cache.GetCoins(vTxid[n++ % vTxid.size()]);
+            coins.nHeight++;
+        }
+        cache.Flush();
+    }
+}
+
+BENCHMARK(CoinsCacheFetch100);
+BENCHMARK(CoinsCacheFlush100);
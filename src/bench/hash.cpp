@@ -0,0 +1,53 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "core.h"
+#include "hash.h"
+
+#include <vector>
+
+/**-5-10Double SHA256 of a 64 byte buffer, as in a merkle tree node
+static void HashMerkleNode(benchmark::State& state)
+{
+    uint256 left = 1, right = 2;
+    while (state.KeepRunning())
+        left = Hash(BEGIN(left), END(left), BEGIN(right), END(right));
+}
+
+/**-5-10Double SHA256 of 1 MB, the maximum block size
+static void Hash1MB(benchmark::State& state)
+{
+    std::vector<unsigned char> vch(1000000, 0x5a);
+    uint256 hash;
+    while (state.KeepRunning())
+        hash = Hash(vch.begin(), vch.end());
+}
+
+/**-5-10Transaction id through CHashWriter, which hashes while serializing
+static void HashWriterTransaction(benchmark::State& state)
+{
+    CTransaction tx;
+    tx.vin.resize(2);
+    tx.vout.resize(2);
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        tx.vin[i].prevout = COutPoint(i + 1, i);
+        tx.vin[i].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+    }
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        tx.vout[i].nValue = 1000 * (i + 1);
+        tx.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, i) << OP_EQUALVERIFY << OP_CHECKSIG;
+    }
+    uint256 hash;
+    while (state.KeepRunning()) {
+        CHashWriter ss(SER_GETHASH, 0);
+        ss << tx;
+        hash = ss.GetHash();
+    }
+}
+
+BENCHMARK(HashMerkleNode);
+BENCHMARK(Hash1MB);
+BENCHMARK(HashWriterTransaction);
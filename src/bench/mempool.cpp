@@ -0,0 +1,41 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "core.h"
+#include "txmempool.h"
+
+#include <list>
+#include <vector>
+
+/**-5-10Adding 100 unrelated transactions to the pool and removing them again
+static void MempoolAddRemove100(benchmark::State& state)
+{
+    std::vector<CTransaction> vtx(100);
+    for (unsigned int n = 0; n < vtx.size(); n++) {
+        CTransaction& tx = vtx[n];
+        tx.vin.resize(2);
+        tx.vout.resize(2);
+        for (unsigned int i = 0; i < tx.vin.size(); i++) {
+            tx.vin[i].prevout = COutPoint(n * 2 + i + 1, i);
+            tx.vin[i].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+        }
+        for (unsigned int i = 0; i < tx.vout.size(); i++) {
+            tx.vout[i].nValue = 1000;
+            tx.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, n) << OP_EQUALVERIFY << OP_CHECKSIG;
+        }
+    }
+    CTxMemPool pool;
+    std::list<CTransaction> removed;
+    while (state.KeepRunning()) {
+        for (unsigned int n = 0; n < vtx.size(); n++)
+            pool.addUnchecked(vtx[n].GetHash(), CTxMemPoolEntry(vtx[n], 10000, 0, 0.0, 1));
+        for (unsigned int n = 0; n < vtx.size(); n++)
+            pool.remove(vtx[n], removed);
+        removed.clear();
+    }
+}
+
+BENCHMARK(MempoolAddRemove100);
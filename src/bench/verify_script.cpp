@@ -0,0 +1,115 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "core.h"
+#include "key.h"
+#include "script.h"
+
+#include <assert.h>
+#include <vector>
+
+extern uint256 SignatureHash(const CScript &scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType);
+
+/**-5-10The signature cache is queried but never filled, so every signature is checked
+static const unsigned int nFlags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_NOCACHE;
+
+/**-5-10A transaction with nInputs inputs, each spending a pay-to-pubkey-hash output of key
+static CTransaction CreateSpend(const CKey& key, const CScript& scriptPubKey, unsigned int nInputs)
+{
+    CTransaction tx;
+    tx.vin.resize(nInputs);
+    for (unsigned int i = 0; i < nInputs; i++)
+        tx.vin[i].prevout = COutPoint(i + 1, 0);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1000;
+    tx.vout[0].scriptPubKey = scriptPubKey;
+
+    for (unsigned int i = 0; i < nInputs; i++) {
+        std::vector<unsigned char> vchSig;
+        key.Sign(SignatureHash(scriptPubKey, tx, i, SIGHASH_ALL), vchSig);
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[i].scriptSig = CScript() << vchSig << ToByteVector(key.GetPubKey());
+    }
+    return tx;
+}
+
+static CScript GetScriptForKey(const CKey& key)
+{
+    return CScript() << OP_DUP << OP_HASH160 << ToByteVector(key.GetPubKey().GetID()) << OP_EQUALVERIFY << OP_CHECKSIG;
+}
+
+static void VerifyECDSA(benchmark::State& state)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CPubKey pubkey = key.GetPubKey();
+    uint256 hash = 1;
+    std::vector<unsigned char> vchSig;
+    key.Sign(hash, vchSig);
+    bool fValid = true;
+    while (state.KeepRunning())
+        fValid &= pubkey.Verify(hash, vchSig);
+    assert(fValid);
+}
+
+/**-5-10Both halves of a pay-to-pubkey-hash spend through the generic interpreter
+static void EvalScriptP2PKH(benchmark::State& state)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CScript scriptPubKey = GetScriptForKey(key);
+    CTransaction tx = CreateSpend(key, scriptPubKey, 1);
+    bool fValid = true;
+    while (state.KeepRunning()) {
+        std::vector<std::vector<unsigned char> > stack;
+        fValid &= EvalScript(stack, tx.vin[0].scriptSig, tx, 0, nFlags, 0);
+        fValid &= EvalScript(stack, scriptPubKey, tx, 0, nFlags, 0);
+    }
+    assert(fValid);
+}
+
+static void VerifyScriptP2PKH(benchmark::State& state)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CScript scriptPubKey = GetScriptForKey(key);
+    CTransaction tx = CreateSpend(key, scriptPubKey, 1);
+    bool fValid = true;
+    while (state.KeepRunning())
+        fValid &= VerifyScript(tx.vin[0].scriptSig, scriptPubKey, tx, 0, nFlags, 0);
+    assert(fValid);
+}
+
+/**-5-10Signature hash of the middle input of a 100 input transaction
+static void SignatureHash100Inputs(benchmark::State& state)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CScript scriptPubKey = GetScriptForKey(key);
+    CTransaction tx = CreateSpend(key, scriptPubKey, 100);
+    uint256 hash;
+    while (state.KeepRunning())
+        hash = SignatureHash(scriptPubKey, tx, 50, SIGHASH_ALL);
+}
+
+/**-5-10The same, from a context that is built once per transaction
+static void SignatureHashContext100Inputs(benchmark::State& state)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CScript scriptPubKey = GetScriptForKey(key);
+    CTransaction tx = CreateSpend(key, scriptPubKey, 100);
+    CSigHashContext context(tx);
+    uint256 hash;
+    while (state.KeepRunning())
+        hash = context.SignatureHash(scriptPubKey, 50, SIGHASH_ALL);
+}
+
+BENCHMARK(VerifyECDSA);
+BENCHMARK(EvalScriptP2PKH);
+BENCHMARK(VerifyScriptP2PKH);
+BENCHMARK(SignatureHash100Inputs);
+BENCHMARK(SignatureHashContext100Inputs);
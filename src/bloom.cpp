@@ -6,6 +6,7 @@
 
 #include "core.h"
 #include "script.h"
+#include "txview.h"
 
 #include <math.h>
 #include <stdlib.h>
@@ -99,7 +100,28 @@ bool CBloomFilter::IsWithinSizeConstraints() const
     return vData.size() <= MAX_BLOOM_FILTER_SIZE && nHashFuncs <= MAX_HASH_FUNCS;
 }
 
-bool CBloomFilter::IsRelevantAndUpdate(const CTransaction& tx, const uint256& hash)
+//ticoin Match if the filter contains any arbitrary data element pushed by the script
+template<typename Script>
+bool CBloomFilter::ContainsScriptData(const Script& script) const
+{
+    typename Script::const_iterator pc = script.begin();
+    vector<unsigned char> data;
+    while (pc < script.end())
+    {
+        opcodetype opcode;
+        if (!script.GetOp(pc, opcode, data))
+            break;
+        if (data.size() != 0 && contains(data))
+            return true;
+    }
+    return false;
+}
+
+static const CScript& ToScript(const CScript& script) { return script; }
+static CScript ToScript(const CScriptView& script) { return script.ToScript(); }
+
+template<typename Transaction>
+bool CBloomFilter::IsRelevantAndUpdateImpl(const Transaction& tx, const uint256& hash)
 {
     bool fFound = false;
     //ticoin Match if the filter contains the hash of tx
@@ -113,32 +135,22 @@ bool CBloomFilter::IsRelevantAndUpdate(const CTransaction& tx, const uint256& ha
 
     for (unsigned int i = 0; i < tx.vout.size(); i++)
     {
-        const CTxOut& txout = tx.vout[i];
         //ticoin Match if the filter contains any arbitrary script data element in any scriptPubKey in tx
         //ticoin If this matches, also add the specific output that was matched.
         //ticoin This means clients don't have to update the filter themselves when a new relevant tx 
         //ticoin is discovered in order to find spending transactions, which avoids round-tripping and race conditions.
-        CScript::const_iterator pc = txout.scriptPubKey.begin();
-        vector<unsigned char> data;
-        while (pc < txout.scriptPubKey.end())
+        if (ContainsScriptData(tx.vout[i].scriptPubKey))
         {
-            opcodetype opcode;
-            if (!txout.scriptPubKey.GetOp(pc, opcode, data))
-                break;
-            if (data.size() != 0 && contains(data))
+            fFound = true;
+            if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_ALL)
+                insert(COutPoint(hash, i));
+            else if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_P2PUBKEY_ONLY)
             {
-                fFound = true;
-                if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_ALL)
+                txnouttype type;
+                vector<vector<unsigned char> > vSolutions;
+                if (Solver(ToScript(tx.vout[i].scriptPubKey), type, vSolutions) &&
+                        (type == TX_PUBKEY || type == TX_MULTISIG))
                     insert(COutPoint(hash, i));
-                else if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_P2PUBKEY_ONLY)
-                {
-                    txnouttype type;
-                    vector<vector<unsigned char> > vSolutions;
-                    if (Solver(txout.scriptPubKey, type, vSolutions) &&
-                            (type == TX_PUBKEY || type == TX_MULTISIG))
-                        insert(COutPoint(hash, i));
-                }
-                break;
             }
         }
     }
@@ -146,28 +158,30 @@ bool CBloomFilter::IsRelevantAndUpdate(const CTransaction& tx, const uint256& ha
     if (fFound)
         return true;
 
-    BOOST_FOREACH(const CTxIn& txin, tx.vin)
+    for (unsigned int i = 0; i < tx.vin.size(); i++)
     {
         //ticoin Match if the filter contains an outpoint tx spends
-        if (contains(txin.prevout))
+        if (contains(tx.vin[i].prevout))
             return true;
 
         //ticoin Match if the filter contains any arbitrary script data element in any scriptSig in tx
-        CScript::const_iterator pc = txin.scriptSig.begin();
-        vector<unsigned char> data;
-        while (pc < txin.scriptSig.end())
-        {
-            opcodetype opcode;
-            if (!txin.scriptSig.GetOp(pc, opcode, data))
-                break;
-            if (data.size() != 0 && contains(data))
-                return true;
-        }
+        if (ContainsScriptData(tx.vin[i].scriptSig))
+            return true;
     }
 
     return false;
 }
 
+bool CBloomFilter::IsRelevantAndUpdate(const CTransaction& tx, const uint256& hash)
+{
+    return IsRelevantAndUpdateImpl(tx, hash);
+}
+
+bool CBloomFilter::IsRelevantAndUpdate(const CTransactionView& tx, const uint256& hash)
+{
+    return IsRelevantAndUpdateImpl(tx, hash);
+}
+
 void CBloomFilter::UpdateEmptyFull()
 {
     bool full = true;
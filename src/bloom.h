@@ -11,6 +11,7 @@
 
 class COutPoint;
 class CTransaction;
+class CTransactionView;
 class uint256;
 
 //ticoin 20,000 items with fp rate < 0.1% or 10,000 items and <0.0001%
@@ -51,6 +52,11 @@ private:
 
     unsigned int Hash(unsigned int nHashNum, const std::vector<unsigned char>& vDataToHash) const;
 
+    template<typename Script>
+    bool ContainsScriptData(const Script& script) const;
+    template<typename Transaction>
+    bool IsRelevantAndUpdateImpl(const Transaction& tx, const uint256& hash);
+
 public:
     //ticoin Creates a new bloom filter which will provide the given fp rate when filled with the given number of elements
     //ticoin Note that if the given parameters will result in a filter outside the bounds of the protocol limits,
@@ -84,6 +90,7 @@ public:
 
     //ticoin Also adds any outputs which match the filter to the filter (to match their spending txes)
     bool IsRelevantAndUpdate(const CTransaction& tx, const uint256& hash);
+    bool IsRelevantAndUpdate(const CTransactionView& tx, const uint256& hash);
 
     //ticoin Checks for empty and full filters to avoid wasting cpu
     void UpdateEmptyFull();
@@ -5,6 +5,8 @@
 #ifndef CHECKQUEUE_H
 #define CHECKQUEUE_H
 
+#include "util.h"
+
 #include <algorithm>
 #include <vector>
 
@@ -59,12 +61,17 @@ private:
     //ticoin The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    //ticoin Number of verifications run so far, and the time spent running them, in microseconds
+    uint64_t nChecksRun;
+    int64_t nBusyMicros;
+
     //ticoin Internal function that does bulk of the verification work.
     bool Loop(bool fMaster = false) {
         boost::condition_variable &cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
         unsigned int nNow = 0;
+        int64_t nBatchMicros = 0;
         bool fOk = true;
         do {
             {
@@ -73,6 +80,8 @@ private:
                 if (nNow) {
                     fAllOk &= fOk;
                     nTodo -= nNow;
+                    nChecksRun += nNow;
+                    nBusyMicros += nBatchMicros;
                     if (nTodo == 0 && !fMaster)
                         //ticoin We processed the last element; inform the master he can exit and return the result
                         condMaster.notify_one();
@@ -112,17 +121,19 @@ private:
                 fOk = fAllOk;
             }
             //ticoin execute work
+            int64_t nStart = GetTimeMicros();
             BOOST_FOREACH(T &check, vChecks)
                 if (fOk)
                     fOk = check();
             vChecks.clear();
+            nBatchMicros = GetTimeMicros() - nStart;
         } while(true);
     }
 
 public:
     //ticoin Create a new check queue
     CCheckQueue(unsigned int nBatchSizeIn) :
-        nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
+        nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn), nChecksRun(0), nBusyMicros(0) {}
 
     //ticoin Worker thread
     void Thread() {
@@ -148,6 +159,13 @@ public:
             condWorker.notify_all();
     }
 
+    //ticoin Number of verifications run, and microseconds all threads together spent running them
+    void GetStats(uint64_t &nChecksRunOut, int64_t &nBusyMicrosOut) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nChecksRunOut = nChecksRun;
+        nBusyMicrosOut = nBusyMicros;
+    }
+
     ~CCheckQueue() {
     }
 
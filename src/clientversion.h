@@ -11,7 +11,7 @@
 //ticoin These need to be macros, as version.cpp's and ticoin-qt.rc's voodoo requires it
 #define CLIENT_VERSION_MAJOR       0
 #define CLIENT_VERSION_MINOR       9
-#define CLIENT_VERSION_REVISION    5
+#define CLIENT_VERSION_REVISION    6
 #define CLIENT_VERSION_BUILD       0
 
 //ticoin Set to true for release, false for prerelease or test build
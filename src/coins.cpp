@@ -69,13 +69,15 @@ void CCoinsViewBacked::SetBackend(CCoinsView &viewIn) { base = &viewIn; }
 bool CCoinsViewBacked::BatchWrite(const std::map<uint256, CCoins> &mapCoins, const uint256 &hashBlock) { return base->BatchWrite(mapCoins, hashBlock); }
 bool CCoinsViewBacked::GetStats(CCoinsStats &stats) { return base->GetStats(stats); }
 
-CCoinsViewCache::CCoinsViewCache(CCoinsView &baseIn, bool fDummy) : CCoinsViewBacked(baseIn), hashBlock(0) { }
+CCoinsViewCache::CCoinsViewCache(CCoinsView &baseIn, bool fDummy) : CCoinsViewBacked(baseIn), hashBlock(0), nCacheHits(0), nCacheMisses(0) { }
 
 bool CCoinsViewCache::GetCoins(const uint256 &txid, CCoins &coins) {
     if (cacheCoins.count(txid)) {
+        nCacheHits++;
         coins = cacheCoins[txid];
         return true;
     }
+    nCacheMisses++;
     if (base->GetCoins(txid, coins)) {
         cacheCoins[txid] = coins;
         return true;
@@ -85,8 +87,11 @@ bool CCoinsViewCache::GetCoins(const uint256 &txid, CCoins &coins) {
 
 std::map<uint256,CCoins>::iterator CCoinsViewCache::FetchCoins(const uint256 &txid) {
     std::map<uint256,CCoins>::iterator it = cacheCoins.lower_bound(txid);
-    if (it != cacheCoins.end() && it->first == txid)
+    if (it != cacheCoins.end() && it->first == txid) {
+        nCacheHits++;
         return it;
+    }
+    nCacheMisses++;
     CCoins tmp;
     if (!base->GetCoins(txid,tmp))
         return cacheCoins.end();
@@ -139,6 +144,11 @@ unsigned int CCoinsViewCache::GetCacheSize() {
     return cacheCoins.size();
 }
 
+void CCoinsViewCache::GetCacheStats(uint64_t &nHits, uint64_t &nMisses) const {
+    nHits = nCacheHits;
+    nMisses = nCacheMisses;
+}
+
 const CTxOut &CCoinsViewCache::GetOutputFor(const CTxIn& input)
 {
     const CCoins &coins = GetCoins(input.prevout.hash);
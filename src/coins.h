@@ -310,6 +310,8 @@ class CCoinsViewCache : public CCoinsViewBacked
 protected:
     uint256 hashBlock;
     std::map<uint256,CCoins> cacheCoins;
+    uint64_t nCacheHits;
+    uint64_t nCacheMisses;
 
 public:
     CCoinsViewCache(CCoinsView &baseIn, bool fDummy = false);
@@ -334,6 +336,9 @@ public:
     //ticoin Calculate the size of the cache (in number of transactions)
     unsigned int GetCacheSize();
 
+    //ticoin Number of lookups answered from this cache, and of those that went to its base
+    void GetCacheStats(uint64_t &nHits, uint64_t &nMisses) const;
+
     /** Amount of ticoins coming in to a transaction
         Note that lightweight clients may not know anything besides the hash of previous transactions,
         so may not be able to calculate this.
@@ -13,10 +13,13 @@
 #include "checkpoints.h"
 #include "key.h"
 #include "main.h"
+#include "metrics.h"
 #include "miner.h"
 #include "net.h"
+#include "pubsub.h"
 #include "rpcserver.h"
 #include "txdb.h"
+#include "txindex.h"
 #include "ui_interface.h"
 #include "util.h"
 #ifdef ENABLE_WALLET
@@ -103,8 +106,6 @@ bool ShutdownRequested()
     return fRequestShutdown;
 }
 
-static CCoinsViewDB *pcoinsdbview;
-
 void Shutdown()
 {
     LogPrintf("Shutdown : In progress...\n");
@@ -123,6 +124,7 @@ void Shutdown()
 #endif
     StopNode();
     UnregisterNodeSignals(GetNodeSignals());
+    StopPubSub();
     {
         LOCK(cs_main);
 #ifdef ENABLE_WALLET
@@ -133,6 +135,10 @@ void Shutdown()
             pblocktree->Flush();
         if (pcoinsTip)
             pcoinsTip->Flush();
+        if (ptxindex) {
+            UnregisterIndex(ptxindex);
+            delete ptxindex; ptxindex = NULL;
+        }
         delete pcoinsTip; pcoinsTip = NULL;
         delete pcoinsdbview; pcoinsdbview = NULL;
         delete pblocktree; pblocktree = NULL;
@@ -192,6 +198,7 @@ std::string HelpMessage(HelpMessageMode hmm)
 {
     string strUsage = _("Options:") + "\n";
     strUsage += "  -?                     " + _("This help message") + "\n";
+    strUsage += "  -addressindex          " + _("Maintain an index of outputs and transactions by address, for getaddressutxos and getaddresstxids (default: 0)") + "\n";
     strUsage += "  -alertnotify=<cmd>     " + _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)") + "\n";
     strUsage += "  -blocknotify=<cmd>     " + _("Execute command when the best block changes (%s in cmd is replaced by block hash)") + "\n";
     strUsage += "  -checkblocks=<n>       " + _("How many blocks to check at startup (default: 288, 0 = all)") + "\n";
@@ -205,13 +212,29 @@ std::string HelpMessage(HelpMessageMode hmm)
     }
     strUsage += "  -datadir=<dir>         " + _("Specify data directory") + "\n";
     strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache) + "\n";
+    strUsage += "  -dbprofile=<profile>   " + _("Tune the databases for steady state (default), initial block download (ibd) or low memory use (lowmem)") + "\n";
+    strUsage += "  -dbcompression=<n>     " + _("Compress database tables (0 or 1, default: set by -dbprofile)") + "\n";
+    strUsage += "  -dbmaxopenfiles=<n>    " + strprintf(_("Keep at most <n> database table files open (default: %d, lowmem: 64)"), nDefaultDbMaxOpenFiles) + "\n";
+    strUsage += "  -dbwritebuffer=<n>     " + _("Size of a database write buffer in megabytes (default: part of -dbcache set by -dbprofile)") + "\n";
+    strUsage += "                         " + _("The four options above can be limited to the chainstate or blockindex database, e.g. -dbprofile=chainstate:ibd") + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
+    strUsage += "  -replayblocks=<dir>    " + _("Benchmark: connect the blk?????.dat files in <dir> without networking, report validation speed and shut down") + "\n";
+    strUsage += "  -loadutxosnapshot=<file> " + _("Bootstrap an empty data directory from a dumptxoutset file instead of validating the block chain up to it; requires -utxosnapshothash") + "\n";
     strUsage += "  -maxorphanblocks=<n>   " + strprintf(_("Keep at most <n> unconnectable blocks in memory (default: %u)"), DEFAULT_MAX_ORPHAN_BLOCKS) + "\n";
     strUsage += "  -maxorphantx=<n>       " + strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS) + "\n";
     strUsage += "  -par=<n>               " + strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), -(int)boost::thread::hardware_concurrency(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS) + "\n";
     strUsage += "  -pid=<file>            " + _("Specify pid file (default: ticoind.pid)") + "\n";
+    strUsage += "  -prune=<n>             " + strprintf(_("Reduce storage requirements by deleting old block and undo files, keeping them under <n> MiB. "
+                                                           "The node then no longer serves old blocks, and rescans and -txindex are not available (default: 0 = disabled, >%u = target size in MiB)"),
+                                                         MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024) + "\n";
+    strUsage += "  -pubhashblock=<address> " + _("Publish the hashes of blocks connected to the best chain on <address> (tcp://<ip>:<port> or unix:<path>)") + "\n";
+    strUsage += "  -pubhashtx=<address>   " + _("Publish the hashes of transactions on <address>") + "\n";
+    strUsage += "  -pubrawblock=<address> " + _("Publish blocks connected to the best chain on <address>") + "\n";
+    strUsage += "  -pubrawtx=<address>    " + _("Publish transactions on <address>") + "\n";
+    strUsage += "  -pubhwm=<n>            " + strprintf(_("Queue at most <n> messages for a notification subscriber, then drop them (default: %u)"), DEFAULT_PUB_HWM) + "\n";
     strUsage += "  -reindex               " + _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup") + "\n";
-    strUsage += "  -txindex               " + _("Maintain a full transaction index (default: 0)") + "\n";
+    strUsage += "  -txindex               " + _("Maintain a full transaction index, built in the background when first enabled (default: 0)") + "\n";
+    strUsage += "  -utxosnapshothash=<hex> " + _("Expected hash_serialized (as reported by gettxoutsetinfo) of the -loadutxosnapshot file") + "\n";
 
     strUsage += "\n" + _("Connection options:") + "\n";
     strUsage += "  -addnode=<ip>          " + _("Add a node to connect to and attempt to keep the connection open") + "\n";
@@ -252,6 +275,7 @@ std::string HelpMessage(HelpMessageMode hmm)
     strUsage += "  -salvagewallet         " + _("Attempt to recover private keys from a corrupt wallet.dat") + " " + _("on startup") + "\n";
     strUsage += "  -spendzeroconfchange   " + _("Spend unconfirmed change when sending transactions (default: 1)") + "\n";
     strUsage += "  -upgradewallet         " + _("Upgrade wallet to latest format") + " " + _("on startup") + "\n";
+    strUsage += "  -usehd                 " + _("Derive keys from a single seed (hierarchical deterministic wallet); only used when the wallet is created (default: 0)") + "\n";
     strUsage += "  -wallet=<file>         " + _("Specify wallet file (within data directory)") + " " + _("(default: wallet.dat)") + "\n";
     strUsage += "  -walletnotify=<cmd>    " + _("Execute command when a wallet transaction changes (%s in cmd is replaced by TxID)") + "\n";
     strUsage += "  -zapwallettxes         " + _("Clear list of wallet transactions (diagnostic tool; implies -rescan)") + "\n";
@@ -282,6 +306,10 @@ std::string HelpMessage(HelpMessageMode hmm)
 #endif
     strUsage += "  -help-debug            " + _("Show all debugging options (usage: --help -help-debug)") + "\n";
     strUsage += "  -logtimestamps         " + _("Prepend debug output with timestamp (default: 1)") + "\n";
+    strUsage += "  -logasync              " + _("Write debug.log from a separate thread, fatal errors are still written immediately (default: 1)") + "\n";
+    strUsage += "  -logjson               " + _("Write debug.log as one JSON object per message (default: 0)") + "\n";
+    strUsage += "  -lograte=<n>           " + _("Log at most <n> messages per second in each debug category, 0 = unlimited (default: 0)") + "\n";
+    strUsage += "  -lockprofile           " + _("Record wait and hold times of every lock site, see getlockstats (default: 0)") + "\n";
     if (GetBoolArg("-help-debug", false))
     {
         strUsage += "  -limitfreerelay=<n>    " + _("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:15)") + "\n";
@@ -315,6 +343,8 @@ std::string HelpMessage(HelpMessageMode hmm)
     strUsage += "  -rpcport=<port>        " + _("Listen for JSON-RPC connections on <port> (default: 8332 or testnet: 18332)") + "\n";
     strUsage += "  -rpcallowip=<ip>       " + _("Allow JSON-RPC connections from specified IP address") + "\n";
     strUsage += "  -rpcthreads=<n>        " + _("Set the number of threads to service RPC calls (default: 4)") + "\n";
+    strUsage += "  -rest                  " + _("Serve blocks, transactions, headers and the mempool read-only and without authorization under /rest/ on the JSON-RPC port (default: 0)") + "\n";
+    strUsage += "  -metrics               " + _("Serve metrics in the Prometheus text format at /metrics on the JSON-RPC port (default: 0)") + "\n";
 
     strUsage += "\n" + _("RPC SSL options: (see the ticoin Wiki for SSL setup instructions)") + "\n";
     strUsage += "  -rpcssl                                  " + _("Use OpenSSL (https) for JSON-RPC connections") + "\n";
@@ -338,6 +368,84 @@ struct CImportingNow
     }
 };
 
+//ticoin Rate of n events in nMicros microseconds, per second
+static double PerSecond(uint64_t n, int64_t nMicros)
+{
+    return nMicros > 0 ? n * 1000000.0 / nMicros : 0.0;
+}
+
+//ticoin Share of hits among hits and misses, in percent
+static double HitRate(uint64_t nHits, uint64_t nMisses)
+{
+    return nHits + nMisses > 0 ? 100.0 * nHits / (nHits + nMisses) : 0.0;
+}
+
+//ticoin -replayblocks=: connect the block files of another node in order, as an initial
+//ticoin block download from disk would, and log how fast each part of validation went.
+void static ReplayBlockFiles(const boost::filesystem::path &pathDir)
+{
+    uint64_t nSigChecksStart, nSigCacheHitsStart, nCoinsHitsStart, nCoinsMissesStart;
+    {
+        LOCK(cs_main);
+        if (chainActive.Height() > 0)
+            LogPrintf("Warning: -replayblocks on a data directory that already holds %d blocks; only the rest is replayed\n", chainActive.Height());
+        validationStats.SetNull();
+        pcoinsTip->GetCacheStats(nCoinsHitsStart, nCoinsMissesStart);
+    }
+    GetSigCheckStats(nSigChecksStart, nSigCacheHitsStart);
+
+    int64_t nStart = GetTimeMicros();
+    unsigned int nFile = 0;
+    for (; !ShutdownRequested(); nFile++) {
+        filesystem::path path = pathDir / strprintf("blk%05u.dat", nFile);
+        FILE *file = fopen(path.string().c_str(), "rb");
+        if (!file)
+            break;
+        CImportingNow imp;
+        LogPrintf("Replaying blocks file %s...\n", path.string());
+        LoadExternalBlockFile(file);
+    }
+    if (nFile == 0)
+        LogPrintf("Warning: -replayblocks found no blk00000.dat in %s\n", pathDir.string());
+
+    //ticoin Write out what is still cached, as the end of a real download would
+    CValidationStats stats;
+    uint64_t nCoinsHits, nCoinsMisses;
+    int nHeight;
+    {
+        LOCK(cs_main);
+        int64_t nStartFlush = GetTimeMicros();
+        pblocktree->Sync();
+        if (!pcoinsTip->Flush())
+            LogPrintf("Warning: -replayblocks failed to write to the coin database\n");
+        validationStats.nTimeFlushDisk += GetTimeMicros() - nStartFlush;
+        validationStats.nFlushes++;
+        stats = validationStats;
+        pcoinsTip->GetCacheStats(nCoinsHits, nCoinsMisses);
+        nHeight = chainActive.Height();
+    }
+    int64_t nTime = GetTimeMicros() - nStart;
+    uint64_t nSigChecks, nSigCacheHits;
+    GetSigCheckStats(nSigChecks, nSigCacheHits);
+    nSigChecks -= nSigChecksStart;
+    nSigCacheHits -= nSigCacheHitsStart;
+    nCoinsHits -= nCoinsHitsStart;
+    nCoinsMisses -= nCoinsMissesStart;
+
+    LogPrintf("replayblocks: files=%u height=%d blocks=%u transactions=%u inputs=%u sigchecks=%u time=%.3fs\n",
+        nFile, nHeight, stats.nBlocks, stats.nTransactions, stats.nInputs, nSigChecks, nTime * 0.000001);
+    LogPrintf("replayblocks: blocks/s=%.2f tx/s=%.2f inputs/s=%.2f sigchecks/s=%.2f\n",
+        PerSecond(stats.nBlocks, nTime), PerSecond(stats.nTransactions, nTime),
+        PerSecond(stats.nInputs, nTime), PerSecond(nSigChecks, nTime));
+    LogPrintf("replayblocks: sigcache_hits=%.2f%% coinscache_hits=%.2f%%\n",
+        HitRate(nSigCacheHits, nSigChecks - nSigCacheHits), HitRate(nCoinsHits, nCoinsMisses));
+    LogPrintf("replayblocks: read_block=%.3fs connect=%.3fs verify=%.3fs write_index=%.3fs flush_view=%.3fs flush_disk=%.3fs flushes=%u\n",
+        stats.nTimeReadBlock * 0.000001, stats.nTimeConnect * 0.000001, stats.nTimeVerify * 0.000001,
+        stats.nTimeWriteIndex * 0.000001, stats.nTimeFlushView * 0.000001, stats.nTimeFlushDisk * 0.000001, stats.nFlushes);
+
+    StartShutdown();
+}
+
 void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
 {
     RenameThread("ticoin-loadblk");
@@ -345,16 +453,8 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
     //ticoin -reindex
     if (fReindex) {
         CImportingNow imp;
-        int nFile = 0;
-        while (true) {
-            CDiskBlockPos pos(nFile, 0);
-            FILE *file = OpenBlockFile(pos, true);
-            if (!file)
-                break;
-            LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            LoadExternalBlockFile(file, &pos);
-            nFile++;
-        }
+        LogPrintf("Reindexing block files...\n");
+        ReindexBlockFiles();
         pblocktree->WriteReindexing(false);
         fReindex = false;
         LogPrintf("Reindexing finished\n");
@@ -388,6 +488,10 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
             LogPrintf("Warning: Could not open blocks file %s\n", path.string());
         }
     }
+
+    //ticoin -replayblocks=
+    if (mapArgs.count("-replayblocks"))
+        ReplayBlockFiles(GetArg("-replayblocks", ""));
 }
 
 /** Sanity checks
@@ -484,6 +588,14 @@ bool AppInit2(boost::thread_group& threadGroup)
             LogPrintf("AppInit2 : parameter interaction: -connect set -> setting -listen=0\n");
     }
 
+    if (mapArgs.count("-replayblocks")) {
+        //ticoin a replay benchmark measures validation alone, so keep the network out of it
+        if (SoftSetBoolArg("-dnsseed", false))
+            LogPrintf("AppInit2 : parameter interaction: -replayblocks set -> setting -dnsseed=0\n");
+        if (SoftSetBoolArg("-listen", false))
+            LogPrintf("AppInit2 : parameter interaction: -replayblocks set -> setting -listen=0\n");
+    }
+
     if (mapArgs.count("-proxy")) {
         //ticoin to protect privacy, do not listen by default if a default proxy server is specified
         if (SoftSetBoolArg("-listen", false))
@@ -520,11 +632,13 @@ bool AppInit2(boost::thread_group& threadGroup)
     int nBind = std::max((int)mapArgs.count("-bind"), 1);
     nMaxConnections = GetArg("-maxconnections", 125);
     nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
-    int nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS);
-    if (nFD < MIN_CORE_FILEDESCRIPTORS)
-        return InitError(_("Not enough file descriptors available."));
-    if (nFD - MIN_CORE_FILEDESCRIPTORS < nMaxConnections)
-        nMaxConnections = nFD - MIN_CORE_FILEDESCRIPTORS;
+    //ticoin The databases' table files don't count towards FD_SETSIZE, but do towards the process limit
+    int nDbFD = GetLevelDBFileDescriptors();
+    int nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS + nDbFD);
+    if (nFD < MIN_CORE_FILEDESCRIPTORS + nDbFD)
+        return InitError(strprintf(_("Not enough file descriptors available: the databases may keep %d open, lower -dbmaxopenfiles."), nDbFD));
+    if (nFD - MIN_CORE_FILEDESCRIPTORS - nDbFD < nMaxConnections)
+        nMaxConnections = nFD - MIN_CORE_FILEDESCRIPTORS - nDbFD;
 
     //ticoin ********************************************************* Step 3: parameter-to-internal-flags
 
@@ -539,6 +653,7 @@ bool AppInit2(boost::thread_group& threadGroup)
         InitWarning(_("Warning: Deprecated argument -debugnet ignored, use -debug=net"));
 
     fBenchmark = GetBoolArg("-benchmark", false);
+    fLockProfiling = GetBoolArg("-lockprofile", false);
     mempool.setSanityCheck(GetBoolArg("-checkmempool", RegTest()));
     Checkpoints::fEnabled = GetBoolArg("-checkpoints", true);
 
@@ -551,9 +666,43 @@ bool AppInit2(boost::thread_group& threadGroup)
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
 
+    //ticoin -prune sets a target for the disk space used by block and undo files
+    int64_t nPruneArg = GetArg("-prune", 0);
+    if (nPruneArg < 0)
+        return InitError(_("Prune cannot be configured with a negative value."));
+    nPruneTarget = (uint64_t)nPruneArg * 1024 * 1024;
+    if (nPruneArg) {
+        if (nPruneTarget < MIN_DISK_SPACE_FOR_BLOCK_FILES)
+            return InitError(strprintf(_("Prune configured below the minimum of %d MiB.  Please use a higher number."), MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024));
+        if (GetBoolArg("-txindex", false))
+            return InitError(_("Prune mode is incompatible with -txindex."));
+        fPruneMode = true;
+        //ticoin Old blocks cannot be served any more, so stop advertising them
+        nLocalServices &= ~NODE_NETWORK;
+        LogPrintf("Prune configured to target %uMiB on disk for block and undo files.\n", nPruneTarget / 1024 / 1024);
+    }
+
+    //ticoin -dbprofile=[<database>:]<profile> and the other [<database>:]<value> options
+    std::string strDbError;
+    if (!CheckLevelDBArgs(strDbError))
+        return InitError(strDbError);
+
+    //ticoin -loadutxosnapshot only takes a snapshot whose hash the operator vouches for
+    if (mapArgs.count("-loadutxosnapshot")) {
+        std::string strHash = GetArg("-utxosnapshothash", "");
+        if (strHash.size() != 64 || !IsHex(strHash))
+            return InitError(_("-loadutxosnapshot requires the snapshot's hash to be given with -utxosnapshothash"));
+        if (GetBoolArg("-reindex", false))
+            return InitError(_("-loadutxosnapshot is incompatible with -reindex."));
+        if (GetBoolArg("-txindex", false) || GetBoolArg("-addressindex", false))
+            return InitError(_("A UTXO snapshot contains no block history, so -txindex and -addressindex cannot be built from it."));
+    }
+
     fServer = GetBoolArg("-server", false);
     fPrintToConsole = GetBoolArg("-printtoconsole", false);
     fLogTimestamps = GetBoolArg("-logtimestamps", true);
+    fLogJSON = GetBoolArg("-logjson", false);
+    nLogRateLimit = GetArg("-lograte", 0);
     setvbuf(stdout, NULL, _IOLBF, 0);
 #ifdef ENABLE_WALLET
     bool fDisableWallet = GetBoolArg("-disablewallet", false);
@@ -628,6 +777,8 @@ bool AppInit2(boost::thread_group& threadGroup)
 
     if (GetBoolArg("-shrinkdebugfile", !fDebug))
         ShrinkDebugFile();
+    if (GetBoolArg("-logasync", true) && !fPrintToConsole)
+        threadGroup.create_thread(&ThreadLogWriter);
     LogPrintf("\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n");
     LogPrintf("ticoin version %s (%s)\n", FormatFullVersion(), CLIENT_DATE);
     LogPrintf("Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
@@ -638,7 +789,7 @@ bool AppInit2(boost::thread_group& threadGroup)
         LogPrintf("Startup time: %s\n", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime()));
     LogPrintf("Default data directory %s\n", GetDefaultDataDir().string());
     LogPrintf("Using data directory %s\n", strDataDir);
-    LogPrintf("Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
+    LogPrintf("Using at most %i connections (%i file descriptors available, %i reserved for the databases)\n", nMaxConnections, nFD, nDbFD);
     std::ostringstream strErrors;
 
     if (nScriptCheckThreads) {
@@ -822,6 +973,18 @@ bool AppInit2(boost::thread_group& threadGroup)
         }
     }
 
+    //ticoin A pruned node cannot rebuild its index from the few block files it has left,
+    //ticoin so -reindex in prune mode starts over and downloads the chain again.
+    if (fReindex && fPruneMode) {
+        LogPrintf("Removing block and undo files to reindex in prune mode\n");
+        for (filesystem::directory_iterator it(blocksDir); it != filesystem::directory_iterator(); it++) {
+            std::string strName = it->path().filename().string();
+            if (filesystem::is_regular_file(it->status()) && strName.size() == 12 && strName.substr(8) == ".dat" &&
+                (strName.substr(0, 3) == "blk" || strName.substr(0, 3) == "rev"))
+                filesystem::remove(it->path());
+        }
+    }
+
     //ticoin cache size calculations
     size_t nTotalCache = (GetArg("-dbcache", nDefaultDbCache) << 20);
     if (nTotalCache < (nMinDbCache << 20))
@@ -829,7 +992,7 @@ bool AppInit2(boost::thread_group& threadGroup)
     else if (nTotalCache > (nMaxDbCache << 20))
         nTotalCache = (nMaxDbCache << 20); //ticoin total cache cannot be greater than nMaxDbCache
     size_t nBlockTreeDBCache = nTotalCache / 8;
-    if (nBlockTreeDBCache > (1 << 21) && !GetBoolArg("-txindex", false))
+    if (nBlockTreeDBCache > (1 << 21) && !GetBoolArg("-txindex", false) && !GetBoolArg("-addressindex", false))
         nBlockTreeDBCache = (1 << 21); //ticoin block tree db cache shouldn't be larger than 2 MiB
     nTotalCache -= nBlockTreeDBCache;
     size_t nCoinDBCache = nTotalCache / 2; //ticoin use half of the remaining cache for coindb cache
@@ -863,6 +1026,18 @@ bool AppInit2(boost::thread_group& threadGroup)
                     break;
                 }
 
+                //ticoin Bootstrap an empty chain state from a UTXO snapshot (no-op once it is loaded)
+                if (mapArgs.count("-loadutxosnapshot") && mapBlockIndex.empty()) {
+                    uiInterface.InitMessage(_("Loading UTXO snapshot..."));
+                    if (!LoadUtxoSnapshot(*pcoinsdbview, GetArg("-loadutxosnapshot", ""), uint256(GetArg("-utxosnapshothash", ""))))
+                        return InitError(_("Error loading UTXO snapshot. See debug.log for details."));
+                    UnloadBlockIndex();
+                    if (!LoadBlockIndex()) {
+                        strLoadError = _("Error loading block database");
+                        break;
+                    }
+                }
+
                 //ticoin If the loaded chain has a wrong genesis, bail out immediately
                 //ticoin (we're likely using a testnet datadir, or the other way around).
                 if (!mapBlockIndex.empty() && chainActive.Genesis() == NULL)
@@ -874,9 +1049,15 @@ bool AppInit2(boost::thread_group& threadGroup)
                     break;
                 }
 
-                //ticoin Check for changed -txindex state
-                if (fTxIndex != GetBoolArg("-txindex", false)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -txindex");
+                //ticoin Pruned block files cannot be restored without downloading them again
+                if (fHavePruned && !fPruneMode && !fSnapshotChainstate) {
+                    strLoadError = _("You need to rebuild the database using -reindex to go back to unpruned mode. This will redownload the entire blockchain");
+                    break;
+                }
+
+                //ticoin Check for changed -addressindex state
+                if (fAddressIndex != GetBoolArg("-addressindex", false)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -addressindex");
                     break;
                 }
 
@@ -914,6 +1095,10 @@ bool AppInit2(boost::thread_group& threadGroup)
         }
     }
 
+    //ticoin A node bootstrapped from a snapshot never had the blocks below it
+    if (fSnapshotChainstate)
+        nLocalServices &= ~NODE_NETWORK;
+
     //ticoin As LoadBlockIndex can take several minutes, it's possible the user
     //ticoin requested to kill the GUI during the last operation. If so, exit.
     //ticoin As the program has not fully started yet, Shutdown() is possibly overkill.
@@ -934,7 +1119,7 @@ bool AppInit2(boost::thread_group& threadGroup)
     {
         string strMatch = mapArgs["-printblock"];
         int nFound = 0;
-        for (map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi)
+        for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi)
         {
             uint256 hash = (*mi).first;
             if (strncmp(hash.ToString().c_str(), strMatch.c_str(), strMatch.size()) == 0)
@@ -1022,6 +1207,13 @@ bool AppInit2(boost::thread_group& threadGroup)
             //ticoin Create new keyUser and set as default key
             RandAddSeedPerfmon();
 
+            if (GetBoolArg("-usehd", false))
+            {
+                LOCK(pwalletMain->cs_wallet);
+                if (!pwalletMain->GenerateHDMasterKey())
+                    strErrors << _("Cannot create HD seed") << "\n";
+            }
+
             CPubKey newDefaultKey;
             if (pwalletMain->GetKeyFromPool(newDefaultKey)) {
                 pwalletMain->SetDefaultKey(newDefaultKey);
@@ -1051,6 +1243,9 @@ bool AppInit2(boost::thread_group& threadGroup)
         }
         if (chainActive.Tip() && chainActive.Tip() != pindexRescan)
         {
+            if (!HaveBlockDataFrom(pindexRescan))
+                return InitError(_("Prune: last wallet synchronisation goes beyond pruned data. You need to -reindex (download the whole blockchain again in case of pruned node)"));
+
             uiInterface.InitMessage(_("Rescanning..."));
             LogPrintf("Rescanning last %i blocks (from block %i)...\n", chainActive.Height() - pindexRescan->nHeight, pindexRescan->nHeight);
             nStart = GetTimeMillis();
@@ -1065,6 +1260,11 @@ bool AppInit2(boost::thread_group& threadGroup)
 #endif //ticoin !ENABLE_WALLET
     //ticoin ********************************************************* Step 9: import blocks
 
+    //ticoin Publish notifications from the first block connected on
+    std::string strPubSubError;
+    if (!StartPubSub(strPubSubError))
+        return InitError(strPubSubError);
+
     //ticoin scan for better chains in the block chain database, that are not yet connected in the active best chain
     CValidationState state;
     if (!ActivateBestChain(state))
@@ -1078,6 +1278,15 @@ bool AppInit2(boost::thread_group& threadGroup)
     }
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
+    //ticoin The transaction index catches up with the chain in the background, so it can be
+    //ticoin turned on or off without -reindex
+    fTxIndex = GetBoolArg("-txindex", false);
+    if (fTxIndex) {
+        ptxindex = new CTxIndex();
+        RegisterIndex(ptxindex);
+        threadGroup.create_thread(&ThreadTxIndex);
+    }
+
     //ticoin ********************************************************* Step 10: load peers
 
     uiInterface.InitMessage(_("Loading addresses..."));
@@ -1112,9 +1321,12 @@ bool AppInit2(boost::thread_group& threadGroup)
     LogPrintf("mapAddressBook.size() = %u\n",  pwalletMain ? pwalletMain->mapAddressBook.size() : 0);
 #endif
 
-    StartNode(threadGroup);
+    //ticoin a -replayblocks run only feeds blocks from disk, and never connects to peers
+    if (!mapArgs.count("-replayblocks"))
+        StartNode(threadGroup);
     //ticoin InitRPCMining is needed here so getwork/getblocktemplate in the GUI debug console works properly.
     InitRPCMining();
+    metrics.AddCollector(CollectMainMetrics);
     if (fServer)
         StartRPCThreads();
 
@@ -271,6 +271,9 @@ public:
     bool Load(CPrivKey &privkey, CPubKey &vchPubKey, bool fSkipCheck);
 };
 
+//ticoin Child indexes from here on are hardened: derived from the parent private key only
+static const unsigned int BIP32_HARDENED_KEY_LIMIT = 0x80000000;
+
 struct CExtPubKey {
     unsigned char nDepth;
     unsigned char vchFingerprint[4];
@@ -4,9 +4,14 @@
 
 #include "leveldbwrapper.h"
 
+#include "ui_interface.h"
 #include "util.h"
 
+#include <stdio.h>
+#include <sstream>
+
 #include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
 #include <leveldb/filter_policy.h>
@@ -25,23 +30,119 @@ void HandleError(const leveldb::Status &status) throw(leveldb_error) {
     throw leveldb_error("Unknown database error");
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize) {
+//ticoin Databases opened with GetLevelDBOptions
+static const char *const pszDbNames[] = { "chainstate", "blockindex" };
+//ticoin Options accepting a <name>: prefix
+static const char *const pszDbArgs[] = { "-dbprofile", "-dbcompression", "-dbmaxopenfiles", "-dbwritebuffer" };
+
+bool IsValidLevelDBProfile(const std::string &strProfile) {
+    return strProfile == "default" || strProfile == "ibd" || strProfile == "lowmem";
+}
+
+CLevelDBOptions GetLevelDBProfile(const std::string &strProfile, size_t nCacheSize) {
+    CLevelDBOptions dboptions;
+    dboptions.strProfile = strProfile;
+    if (strProfile == "ibd") {
+        //ticoin Mostly writes: large write buffers give fewer, larger level-0 files and less compaction
+        dboptions.nBlockCacheSize = nCacheSize / 4;
+        dboptions.nWriteBufferSize = nCacheSize * 3 / 8;
+        dboptions.fVerifyChecksums = false;
+    } else if (strProfile == "lowmem") {
+        dboptions.nBlockCacheSize = nCacheSize / 4;
+        dboptions.nWriteBufferSize = nCacheSize / 8;
+        dboptions.nMaxOpenFiles = 64;
+        dboptions.fCompression = true;
+    } else {
+        dboptions.strProfile = "default";
+        dboptions.nBlockCacheSize = nCacheSize / 2;
+        dboptions.nWriteBufferSize = nCacheSize / 4; //ticoin up to two write buffers may be held in memory simultaneously
+    }
+    return dboptions;
+}
+
+//ticoin Value of -arg for database strName: "<name>:<value>" for this database wins over a plain "<value>"
+static std::string GetDBArg(const std::string &strArg, const std::string &strName, const std::string &strDefault) {
+    std::string strValue = strDefault;
+    if (!mapMultiArgs.count(strArg))
+        return strValue;
+    bool fSpecific = false;
+    BOOST_FOREACH(const std::string &str, mapMultiArgs[strArg]) {
+        size_t nColon = str.find(':');
+        if (nColon == std::string::npos) {
+            if (!fSpecific)
+                strValue = str;
+        } else if (str.substr(0, nColon) == strName) {
+            strValue = str.substr(nColon + 1);
+            fSpecific = true;
+        }
+    }
+    return strValue;
+}
+
+CLevelDBOptions GetLevelDBOptions(const std::string &strName, size_t nCacheSize) {
+    CLevelDBOptions dboptions = GetLevelDBProfile(GetDBArg("-dbprofile", strName, "default"), nCacheSize);
+    std::string strValue = GetDBArg("-dbcompression", strName, "");
+    if (!strValue.empty())
+        dboptions.fCompression = atoi(strValue) != 0;
+    int nMaxOpenFiles = atoi(GetDBArg("-dbmaxopenfiles", strName, "0"));
+    if (nMaxOpenFiles > 0)
+        dboptions.nMaxOpenFiles = nMaxOpenFiles;
+    int64_t nWriteBuffer = atoi64(GetDBArg("-dbwritebuffer", strName, "0"));
+    if (nWriteBuffer > 0)
+        dboptions.nWriteBufferSize = nWriteBuffer << 20;
+    return dboptions;
+}
+
+bool CheckLevelDBArgs(std::string &strError) {
+    for (unsigned int i = 0; i < ARRAYLEN(pszDbArgs); i++) {
+        if (!mapMultiArgs.count(pszDbArgs[i]))
+            continue;
+        BOOST_FOREACH(const std::string &str, mapMultiArgs[pszDbArgs[i]]) {
+            size_t nColon = str.find(':');
+            if (nColon != std::string::npos) {
+                std::string strName = str.substr(0, nColon);
+                bool fKnown = false;
+                for (unsigned int j = 0; j < ARRAYLEN(pszDbNames); j++)
+                    fKnown |= strName == pszDbNames[j];
+                if (!fKnown) {
+                    strError = strprintf(_("Unknown database in %s: '%s' (use chainstate or blockindex)"), pszDbArgs[i], str);
+                    return false;
+                }
+            }
+            if (i == 0 && !IsValidLevelDBProfile(str.substr(nColon == std::string::npos ? 0 : nColon + 1))) {
+                strError = strprintf(_("Unknown -dbprofile: '%s'"), str);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int GetLevelDBFileDescriptors() {
+    //ticoin LevelDB raises max_open_files to at least 64 tables plus the other files
+    int nTables = 0;
+    for (unsigned int i = 0; i < ARRAYLEN(pszDbNames); i++)
+        nTables += std::max(GetLevelDBOptions(pszDbNames[i], 0).nMaxOpenFiles - nDbNonTableFiles, 64);
+    return std::max(nTables - nDbMmapFiles, 0) + (int)ARRAYLEN(pszDbNames) * nDbNonTableFiles;
+}
+
+static leveldb::Options CreateOptions(const CLevelDBOptions &dboptions) {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; //ticoin up to two write buffers may be held in memory simultaneously
+    options.block_cache = leveldb::NewLRUCache(dboptions.nBlockCacheSize);
+    options.write_buffer_size = dboptions.nWriteBufferSize;
     options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
-    options.max_open_files = 64;
+    options.compression = dboptions.fCompression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+    options.max_open_files = dboptions.nMaxOpenFiles;
     return options;
 }
 
-CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory, bool fWipe) {
+CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path &path, const CLevelDBOptions &dboptionsIn, bool fMemory, bool fWipe) : dboptions(dboptionsIn) {
     penv = NULL;
-    readoptions.verify_checksums = true;
-    iteroptions.verify_checksums = true;
+    readoptions.verify_checksums = dboptions.fVerifyChecksums;
+    iteroptions.verify_checksums = dboptions.fVerifyChecksums;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = CreateOptions(dboptions);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -52,7 +153,8 @@ CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path &path, size_t nCa
             leveldb::DestroyDB(path.string(), options);
         }
         TryCreateDirectory(path);
-        LogPrintf("Opening LevelDB in %s\n", path.string());
+        LogPrintf("Opening LevelDB in %s (profile %s, compression %s, %d open files, %d MiB write buffer)\n", path.string(),
+            dboptions.strProfile, dboptions.fCompression ? "on" : "off", dboptions.nMaxOpenFiles, dboptions.nWriteBufferSize >> 20);
     }
     leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
     HandleError(status);
@@ -71,7 +173,45 @@ CLevelDBWrapper::~CLevelDBWrapper() {
 }
 
 bool CLevelDBWrapper::WriteBatch(CLevelDBBatch &batch, bool fSync) throw(leveldb_error) {
+    int64_t nStart = GetTimeMicros();
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
+    int64_t nTime = GetTimeMicros() - nStart;
+    {
+        LOCK(cs_stats);
+        writestats.nWrites++;
+        writestats.nWriteMicros += nTime;
+        //ticoin Without fsync a write only appends to the log and the memtable; anything slow waited for compaction
+        if (!fSync && nTime >= nDbWriteStallMicros) {
+            writestats.nWriteStalls++;
+            writestats.nWriteStallMicros += nTime;
+        }
+    }
     HandleError(status);
     return true;
 }
+
+CLevelDBStats CLevelDBWrapper::GetStats() {
+    CLevelDBStats stats;
+    {
+        LOCK(cs_stats);
+        stats = writestats;
+    }
+    std::string strStats;
+    if (pdb->GetProperty("leveldb.stats", &strStats)) {
+        std::istringstream ssStats(strStats);
+        std::string strLine;
+        while (std::getline(ssStats, strLine)) {
+            //ticoin Level  Files Size(MB) Time(sec) Read(MB) Write(MB); the header lines do not parse
+            CLevelDBLevelStats level;
+            if (sscanf(strLine.c_str(), "%d %d %lf %lf %lf %lf", &level.nLevel, &level.nFiles, &level.dSizeMB,
+                       &level.dCompactionSeconds, &level.dCompactionReadMB, &level.dCompactionWriteMB) != 6)
+                continue;
+            stats.vLevels.push_back(level);
+            if (level.nLevel == 0)
+                stats.nReadAmplification += level.nFiles;
+            else if (level.nFiles > 0)
+                stats.nReadAmplification++;
+        }
+    }
+    return stats;
+}
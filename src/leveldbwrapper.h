@@ -6,9 +6,13 @@
 #define ticoin_LEVELDBWRAPPER_H
 
 #include "serialize.h"
+#include "sync.h"
 #include "util.h"
 #include "version.h"
 
+#include <string>
+#include <vector>
+
 #include <boost/filesystem/path.hpp>
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
@@ -21,6 +25,67 @@ public:
 
 void HandleError(const leveldb::Status &status) throw(leveldb_error);
 
+//ticoin Table files LevelDB memory-maps instead of keeping their descriptors open. The budget is
+//ticoin shared by every database in the process; tables opened beyond it each hold a descriptor.
+#if defined(WIN32)
+static const int nDbMmapFiles = 0;
+#else
+static const int nDbMmapFiles = sizeof(void*) > 4 ? 1000 : 0;
+#endif
+//ticoin Files a database keeps open besides its tables: log, manifest, lock and info log
+static const int nDbNonTableFiles = 10;
+//ticoin -dbmaxopenfiles default: the chainstate and blockindex databases split the mmap budget
+static const int nDefaultDbMaxOpenFiles = nDbMmapFiles > 0 ? nDbMmapFiles / 2 : 64;
+//ticoin A write taking longer than this is counted as stalled by compaction
+static const int64_t nDbWriteStallMicros = 1000;
+
+//ticoin Tuning of one database, from a -dbprofile and the per-database overrides
+struct CLevelDBOptions
+{
+    std::string strProfile;
+    size_t nBlockCacheSize;
+    size_t nWriteBufferSize;
+    int nMaxOpenFiles;
+    bool fCompression;
+    bool fVerifyChecksums;
+
+    CLevelDBOptions() : nBlockCacheSize(0), nWriteBufferSize(0), nMaxOpenFiles(nDefaultDbMaxOpenFiles), fCompression(false), fVerifyChecksums(true) {}
+};
+
+//ticoin Files and compaction work of one LevelDB level, as reported by leveldb.stats
+struct CLevelDBLevelStats
+{
+    int nLevel;
+    int nFiles;
+    double dSizeMB;
+    double dCompactionSeconds;
+    double dCompactionReadMB;
+    double dCompactionWriteMB;
+};
+
+struct CLevelDBStats
+{
+    std::vector<CLevelDBLevelStats> vLevels;
+    int nReadAmplification; //ticoin sorted runs a lookup may have to search: every level-0 file plus each deeper non-empty level
+    uint64_t nWrites;
+    int64_t nWriteMicros;
+    uint64_t nWriteStalls;
+    int64_t nWriteStallMicros;
+
+    CLevelDBStats() : nReadAmplification(0), nWrites(0), nWriteMicros(0), nWriteStalls(0), nWriteStallMicros(0) {}
+};
+
+//ticoin Names accepted by -dbprofile: "default" (steady state), "ibd" and "lowmem"
+bool IsValidLevelDBProfile(const std::string &strProfile);
+CLevelDBOptions GetLevelDBProfile(const std::string &strProfile, size_t nCacheSize);
+//ticoin Options of the database strName ("chainstate" or "blockindex") given its share of -dbcache. The -dbprofile,
+//ticoin -dbcompression, -dbmaxopenfiles and -dbwritebuffer values apply to all databases, or to just one when given as <name>:<value>.
+CLevelDBOptions GetLevelDBOptions(const std::string &strName, size_t nCacheSize);
+//ticoin Check that every <name>: prefix of the -db* options names a database and every -dbprofile a profile
+bool CheckLevelDBArgs(std::string &strError);
+//ticoin Descriptors the databases may hold open with the options in effect, at most
+int GetLevelDBFileDescriptors();
+
 //ticoin Batch of changes queued to be written to a CLevelDBWrapper
 class CLevelDBBatch
 {
@@ -60,6 +125,9 @@ private:
     //ticoin custom environment this database is using (may be NULL in case of default environment)
     leveldb::Env *penv;
 
+    //ticoin tuning the database options were built from
+    CLevelDBOptions dboptions;
+
     //ticoin database options used
     leveldb::Options options;
 
@@ -78,8 +146,12 @@ private:
     //ticoin the database itself
     leveldb::DB *pdb;
 
+    //ticoin write counters reported by GetStats
+    CCriticalSection cs_stats;
+    CLevelDBStats writestats;
+
 public:
-    CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    CLevelDBWrapper(const boost::filesystem::path &path, const CLevelDBOptions &dboptionsIn, bool fMemory = false, bool fWipe = false);
     ~CLevelDBWrapper();
 
     template<typename K, typename V> bool Read(const K& key, V& value) throw(leveldb_error) {
@@ -150,6 +222,17 @@ public:
     leveldb::Iterator *NewIterator() {
         return pdb->NewIterator(iteroptions);
     }
+
+    const CLevelDBOptions &GetOptions() const {
+        return dboptions;
+    }
+
+    CLevelDBStats GetStats();
+
+    //ticoin compact the whole key range; blocks until done, while reads and writes continue
+    void Compact() {
+        pdb->CompactRange(NULL, NULL);
+    }
 };
 
 #endif //ticoin ticoin_LEVELDBWRAPPER_H
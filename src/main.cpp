@@ -11,9 +11,12 @@
 #include "checkpoints.h"
 #include "checkqueue.h"
 #include "init.h"
+#include "metrics.h"
 #include "net.h"
 #include "txdb.h"
+#include "txindex.h"
 #include "txmempool.h"
+#include "txview.h"
 #include "ui_interface.h"
 #include "util.h"
 
@@ -38,7 +41,7 @@ CCriticalSection cs_main;
 
 CTxMemPool mempool;
 
-map<uint256, CBlockIndex*> mapBlockIndex;
+BlockMap mapBlockIndex;
 CChain chainActive;
 CChain chainMostWork;
 int64_t nTimeBestReceived = 0;
@@ -46,7 +49,13 @@ int nScriptCheckThreads = 0;
 bool fImporting = false;
 bool fReindex = false;
 bool fBenchmark = false;
+CValidationStats validationStats;
 bool fTxIndex = false;
+bool fAddressIndex = false;
+bool fPruneMode = false;
+bool fHavePruned = false;
+bool fSnapshotChainstate = false;
+uint64_t nPruneTarget = 0;
 unsigned int nCoinCacheSize = 5000;
 
 /** Fees smaller than this (in satoshi) are considered zero fee (for transaction creation) */
@@ -106,6 +115,13 @@ namespace {
     CBlockFileInfo infoLastBlockFile;
     int nLastBlockFile = 0;
 
+    //ticoin Pruning state, protected by cs_LastBlockFile: the combined size of all block and
+    //ticoin undo files, the first file that may still hold data, and whether a new block
+    //ticoin file was started since the last pruning pass.
+    uint64_t nBlockFilesUsage = 0;
+    int nFirstUnprunedFile = 0;
+    bool fCheckForPruning = false;
+
     //ticoin Every received block is assigned a unique and increasing identifier, so we
     //ticoin know which one to give priority in case of a fork.
     CCriticalSection cs_nBlockSequenceId;
@@ -125,6 +141,22 @@ namespace {
     };
     map<uint256, pair<NodeId, list<QueuedBlock>::iterator> > mapBlocksInFlight;
     map<uint256, pair<NodeId, list<uint256>::iterator> > mapBlocksToDownload;
+
+    //ticoin Block index entries are carved out of contiguous slabs instead of being
+    //ticoin heap allocated one by one. Entries are never freed individually, only all
+    //ticoin at once on shutdown. Protected by cs_main.
+    const unsigned int BLOCKINDEX_SLAB_SIZE = 4096;
+    vector<CBlockIndex*> vBlockIndexSlabs;
+    unsigned int nBlockIndexSlabUsed = BLOCKINDEX_SLAB_SIZE;
+}
+
+static CBlockIndex* AllocateBlockIndex()
+{
+    if (nBlockIndexSlabUsed == BLOCKINDEX_SLAB_SIZE) {
+        vBlockIndexSlabs.push_back(new CBlockIndex[BLOCKINDEX_SLAB_SIZE]);
+        nBlockIndexSlabUsed = 0;
+    }
+    return &vBlockIndexSlabs.back()[nBlockIndexSlabUsed++];
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -148,6 +180,10 @@ struct CMainSignals {
     boost::signals2::signal<void (const uint256 &)> Inventory;
     //ticoin Tells listeners to broadcast their data.
     boost::signals2::signal<void ()> Broadcast;
+    //ticoin Notifies indexes of a block connected to the active chain.
+    boost::signals2::signal<void (const CBlock &, const CBlockIndex *)> BlockConnected;
+    //ticoin Notifies indexes of a block disconnected from the active chain.
+    boost::signals2::signal<void (const CBlock &, const CBlockIndex *)> BlockDisconnected;
 } g_signals;
 }
 
@@ -182,6 +218,16 @@ void SyncWithWallets(const uint256 &hash, const CTransaction &tx, const CBlock *
     g_signals.SyncTransaction(hash, tx, pblock);
 }
 
+void RegisterIndex(CIndexInterface* pindexIn) {
+    g_signals.BlockConnected.connect(boost::bind(&CIndexInterface::BlockConnected, pindexIn, _1, _2));
+    g_signals.BlockDisconnected.connect(boost::bind(&CIndexInterface::BlockDisconnected, pindexIn, _1, _2));
+}
+
+void UnregisterIndex(CIndexInterface* pindexIn) {
+    g_signals.BlockDisconnected.disconnect(boost::bind(&CIndexInterface::BlockDisconnected, pindexIn, _1, _2));
+    g_signals.BlockConnected.disconnect(boost::bind(&CIndexInterface::BlockConnected, pindexIn, _1, _2));
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //
 //ticoin Registration of network node signals.
@@ -393,7 +439,7 @@ CBlockLocator CChain::GetLocator(const CBlockIndex *pindex) const {
 CBlockIndex *CChain::FindFork(const CBlockLocator &locator) const {
     //ticoin Find the first block the caller has in the main chain
     BOOST_FOREACH(const uint256& hash, locator.vHave) {
-        std::map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.find(hash);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
         if (mi != mapBlockIndex.end())
         {
             CBlockIndex* pindex = (*mi).second;
@@ -405,6 +451,7 @@ CBlockIndex *CChain::FindFork(const CBlockLocator &locator) const {
 }
 
 CCoinsViewCache *pcoinsTip = NULL;
+CCoinsViewDB *pcoinsdbview = NULL;
 CBlockTreeDB *pblocktree = NULL;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -735,7 +782,7 @@ int CMerkleTx::SetMerkleBranch(const CBlock* pblock)
     }
 
     //ticoin Is the tx in a block that's in the main chain
-    map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.find(hashBlock);
+    BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
     if (mi == mapBlockIndex.end())
         return 0;
     CBlockIndex* pindex = (*mi).second;
@@ -995,7 +1042,7 @@ int CMerkleTx::GetDepthInMainChainINTERNAL(CBlockIndex* &pindexRet) const
     AssertLockHeld(cs_main);
 
     //ticoin Find the block it claims to be in
-    map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.find(hashBlock);
+    BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
     if (mi == mapBlockIndex.end())
         return 0;
     CBlockIndex* pindex = (*mi).second;
@@ -1052,24 +1099,9 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, uint256 &hashBlock
             }
         }
 
-        if (fTxIndex) {
-            CDiskTxPos postx;
-            if (pblocktree->ReadTxIndex(hash, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-                CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file, postx.nTxOffset, SEEK_CUR);
-                    file >> txOut;
-                } catch (std::exception &e) {
-                    return error("%s : Deserialize or I/O error - %s", __func__, e.what());
-                }
-                hashBlock = header.GetHash();
-                if (txOut.GetHash() != hash)
-                    return error("%s : txid mismatch", __func__);
-                return true;
-            }
-        }
+        //ticoin While the index is still being built, the slow path below may find it
+        if (ptxindex && ptxindex->FindTx(hash, txOut, hashBlock))
+            return true;
 
         if (fAllowSlow) { //ticoin use coin database to locate block that contains transaction, and scan it
             int nHeight = -1;
@@ -1085,11 +1117,13 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, uint256 &hashBlock
     }
 
     if (pindexSlow) {
-        CBlock block;
-        if (ReadBlockFromDisk(block, pindexSlow)) {
-            BOOST_FOREACH(const CTransaction &tx, block.vtx) {
+        //ticoin Only the transaction we are looking for gets deserialized
+        std::vector<unsigned char> vchBlock;
+        CBlockView block;
+        if (ReadRawBlockFromDisk(vchBlock, pindexSlow) && block.Parse(&vchBlock[0], &vchBlock[0] + vchBlock.size())) {
+            BOOST_FOREACH(const CTransactionView &tx, block.vtx) {
                 if (tx.GetHash() == hash) {
-                    txOut = tx;
+                    txOut = tx.ToTransaction();
                     hashBlock = pindexSlow->GetBlockHash();
                     return true;
                 }
@@ -1100,6 +1134,32 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, uint256 &hashBlock
     return false;
 }
 
+namespace {
+    class CAddressIndexVisitor : public boost::static_visitor<bool> {
+    private:
+        unsigned char &nType;
+        uint160 &hashBytes;
+    public:
+        CAddressIndexVisitor(unsigned char &nTypeIn, uint160 &hashIn) : nType(nTypeIn), hashBytes(hashIn) { }
+
+        bool operator()(const CKeyID &id) const { nType = ADDRESSINDEX_PUBKEYHASH; hashBytes = id; return true; }
+        bool operator()(const CScriptID &id) const { nType = ADDRESSINDEX_SCRIPTHASH; hashBytes = id; return true; }
+        bool operator()(const CNoDestination &no) const { return false; }
+    };
+}
+
+bool GetAddressIndexHash(const CTxDestination &dest, unsigned char &nType, uint160 &hashBytes)
+{
+    return boost::apply_visitor(CAddressIndexVisitor(nType, hashBytes), dest);
+}
+
+//ticoin Address index type and hash of an output script, if it pays to a single address
+static bool GetAddressIndexHash(const CScript &scriptPubKey, unsigned char &nType, uint160 &hashBytes)
+{
+    CTxDestination dest;
+    return ExtractDestination(scriptPubKey, dest) && GetAddressIndexHash(dest, nType, hashBytes);
+}
+
 
 
 
@@ -1169,6 +1229,36 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<unsigned char>& vchBlock, const CBlockIndex* pindex)
+{
+    //ticoin Blocks are stored after their size
+    CDiskBlockPos pos = pindex->GetBlockPos();
+    if (pos.nPos < 4)
+        return error("%s : invalid block position", __func__);
+    pos.nPos -= 4;
+
+    CAutoFile filein = CAutoFile(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return error("%s : OpenBlockFile failed", __func__);
+
+    try {
+        unsigned int nSize;
+        filein >> nSize;
+        if (nSize < 80 || nSize > MAX_BLOCK_SIZE)
+            return error("%s : invalid block size %u", __func__, nSize);
+        vchBlock.resize(nSize);
+        filein.read((char*)&vchBlock[0], nSize);
+    }
+    catch (std::exception &e) {
+        return error("%s : I/O error - %s", __func__, e.what());
+    }
+
+    //ticoin The hash of the leading header identifies the block
+    if (Hash(vchBlock.begin(), vchBlock.begin() + 80) != pindex->GetBlockHash())
+        return error("%s : block hash doesn't match index", __func__);
+    return true;
+}
+
 uint256 static GetOrphanRoot(const uint256& hash)
 {
     map<uint256, COrphanBlock*>::iterator it = mapOrphanBlocks.find(hash);
@@ -1234,18 +1324,22 @@ static const int64_t nInterval = nTargetTimespan / nTargetSpacing;
 //
 unsigned int ComputeMinWork(unsigned int nBase, int64_t nTime)
 {
-    const CBigNum &bnLimit = Params().ProofOfWorkLimit();
+    const arith_uint256 bnLimit = UintToArith256(Params().ProofOfWorkLimit());
     //ticoin Testnet has min-difficulty blocks
     //ticoin after nTargetSpacing*2 time between blocks:
     if (TestNet() && nTime > nTargetSpacing*2)
         return bnLimit.GetCompact();
 
-    CBigNum bnResult;
+    arith_uint256 bnResult;
     bnResult.SetCompact(nBase);
     while (nTime > 0 && bnResult < bnLimit)
     {
         //ticoin Maximum 400% adjustment...
-        bnResult *= 4;
+        //ticoin (anything that would exceed the limit is clamped before it can overflow)
+        if (bnResult > bnLimit / 4)
+            bnResult = bnLimit;
+        else
+            bnResult *= 4;
         //ticoin ... in best-case exactly 4-times-normal target time
         nTime -= nTargetTimespan*4;
     }
@@ -1256,7 +1350,8 @@ unsigned int ComputeMinWork(unsigned int nBase, int64_t nTime)
 
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock)
 {
-    unsigned int nProofOfWorkLimit = Params().ProofOfWorkLimit().GetCompact();
+    const arith_uint256 bnLimit = UintToArith256(Params().ProofOfWorkLimit());
+    unsigned int nProofOfWorkLimit = bnLimit.GetCompact();
 
     //ticoin Genesis block
     if (pindexLast == NULL)
@@ -1298,35 +1393,44 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
     if (nActualTimespan > nTargetTimespan*4)
         nActualTimespan = nTargetTimespan*4;
 
-    //ticoin Retarget
-    CBigNum bnNew;
-    bnNew.SetCompact(pindexLast->nBits);
-    bnNew *= nActualTimespan;
-    bnNew /= nTargetTimespan;
+    //ticoin Retarget: bnNew = bnOld * nActualTimespan / nTargetTimespan.
+    //ticoin The product can exceed 256 bits for targets close to an easy limit, so divide
+    //ticoin first and carry the remainder, clamping to the limit before anything overflows.
+    arith_uint256 bnOld;
+    bnOld.SetCompact(pindexLast->nBits);
+    arith_uint256 bnQuotient = bnOld / (uint64_t)nTargetTimespan;
+    arith_uint256 bnRemainder = bnOld - bnQuotient * (uint32_t)nTargetTimespan;
+    arith_uint256 bnNew;
+    if (bnQuotient > bnLimit / (uint64_t)nActualTimespan)
+        bnNew = bnLimit;
+    else
+        bnNew = bnQuotient * (uint32_t)nActualTimespan + bnRemainder * (uint32_t)nActualTimespan / (uint64_t)nTargetTimespan;
 
-    if (bnNew > Params().ProofOfWorkLimit())
-        bnNew = Params().ProofOfWorkLimit();
+    if (bnNew > bnLimit)
+        bnNew = bnLimit;
 
     ///ticoin debug print
     LogPrintf("GetNextWorkRequired RETARGET\n");
     LogPrintf("nTargetTimespan = %d    nActualTimespan = %d\n", nTargetTimespan, nActualTimespan);
-    LogPrintf("Before: %08x  %s\n", pindexLast->nBits, CBigNum().SetCompact(pindexLast->nBits).getuint256().ToString());
-    LogPrintf("After:  %08x  %s\n", bnNew.GetCompact(), bnNew.getuint256().ToString());
+    LogPrintf("Before: %08x  %s\n", pindexLast->nBits, bnOld.GetHex());
+    LogPrintf("After:  %08x  %s\n", bnNew.GetCompact(), bnNew.GetHex());
 
     return bnNew.GetCompact();
 }
 
 bool CheckProofOfWork(uint256 hash, unsigned int nBits)
 {
-    CBigNum bnTarget;
-    bnTarget.SetCompact(nBits);
+    bool fNegative;
+    bool fOverflow;
+    arith_uint256 bnTarget;
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
 
     //ticoin Check range
-    if (bnTarget <= 0 || bnTarget > Params().ProofOfWorkLimit())
+    if (fNegative || bnTarget == 0 || fOverflow || bnTarget > UintToArith256(Params().ProofOfWorkLimit()))
         return error("CheckProofOfWork() : nBits below minimum work");
 
     //ticoin Check proof of work matches claimed amount
-    if (hash > bnTarget.getuint256())
+    if (UintToArith256(hash) > bnTarget)
         return error("CheckProofOfWork() : hash doesn't match nBits");
 
     return true;
@@ -1365,7 +1469,7 @@ void CheckForkWarningConditions()
     if (pindexBestForkTip && chainActive.Height() - pindexBestForkTip->nHeight >= 72)
         pindexBestForkTip = NULL;
 
-    if (pindexBestForkTip || (pindexBestInvalid && pindexBestInvalid->nChainWork > chainActive.Tip()->nChainWork + (chainActive.Tip()->GetBlockWork() * 6).getuint256()))
+    if (pindexBestForkTip || (pindexBestInvalid && pindexBestInvalid->nChainWork > chainActive.Tip()->nChainWork + ArithToUint256(UintToArith256(chainActive.Tip()->GetBlockWork()) * 6)))
     {
         if (!fLargeWorkForkFound && pindexBestForkBase)
         {
@@ -1416,7 +1520,7 @@ void CheckForkWarningConditionsOnNewFork(CBlockIndex* pindexNewForkTip)
     //ticoin We define it this way because it allows us to only store the highest fork tip (+ base) which meets
     //ticoin the 7-block condition and from this always have the most-likely-to-cause-warning fork
     if (pfork && (!pindexBestForkTip || (pindexBestForkTip && pindexNewForkTip->nHeight > pindexBestForkTip->nHeight)) &&
-            pindexNewForkTip->nChainWork - pfork->nChainWork > (pfork->GetBlockWork() * 7).getuint256() &&
+            pindexNewForkTip->nChainWork - pfork->nChainWork > ArithToUint256(UintToArith256(pfork->GetBlockWork()) * 7) &&
             chainActive.Height() - pindexNewForkTip->nHeight < 72)
     {
         pindexBestForkTip = pindexNewForkTip;
@@ -1525,7 +1629,7 @@ void UpdateCoins(const CTransaction& tx, CValidationState &state, CCoinsViewCach
 
 bool CScriptCheck::operator()() const {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
-    if (!VerifyScript(scriptSig, scriptPubKey, *ptxTo, nIn, nFlags, nHashType))
+    if (!VerifyScript(scriptSig, scriptPubKey, *ptxTo, nIn, nFlags, nHashType, psighash.get()))
         return error("CScriptCheck() : %s VerifySignature failed", ptxTo->GetHash().ToString());
     return true;
 }
@@ -1596,12 +1700,17 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, CCoinsViewCach
         //ticoin before the last block chain checkpoint. This is safe because block merkle hashes are
         //ticoin still computed and checked, and any change will be caught at the next checkpoint.
         if (fScriptChecks) {
+            //ticoin The signature hashes of all inputs share one serialization of tx and the
+            //ticoin hashing of everything before each input, instead of redoing both per input.
+            boost::shared_ptr<const CSigHashContext> psighash;
+            if (tx.vin.size() > 1)
+                psighash.reset(new CSigHashContext(tx));
             for (unsigned int i = 0; i < tx.vin.size(); i++) {
                 const COutPoint &prevout = tx.vin[i].prevout;
                 const CCoins &coins = inputs.GetCoins(prevout.hash);
 
                 //ticoin Verify signature
-                CScriptCheck check(coins, tx, i, flags, 0);
+                CScriptCheck check(coins, tx, i, flags, 0, psighash);
                 if (pvChecks) {
                     pvChecks->push_back(CScriptCheck());
                     check.swap(pvChecks->back());
@@ -1609,7 +1718,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, CCoinsViewCach
                     if (flags & SCRIPT_VERIFY_STRICTENC) {
                         //ticoin For now, check whether the failure was caused by non-canonical
                         //ticoin encodings or not; if so, don't trigger DoS protection.
-                        CScriptCheck check(coins, tx, i, flags & (~SCRIPT_VERIFY_STRICTENC), 0);
+                        CScriptCheck check(coins, tx, i, flags & (~SCRIPT_VERIFY_STRICTENC), 0, psighash);
                         if (check())
                             return state.Invalid(false, REJECT_NONSTANDARD, "non-canonical");
                     }
@@ -1643,11 +1752,28 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
         return error("DisconnectBlock() : block and undo data inconsistent");
 
+    //ticoin Address index entries to drop. VerifyDB disconnects on a scratch view (pfClean set),
+    //ticoin which must leave the index alone.
+    bool fUpdateAddressIndex = fAddressIndex && !pfClean;
+    std::vector<std::pair<CAddressIndexKey, int64_t> > vAddressHistory;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vAddressUnspent;
+
     //ticoin undo transactions in reverse order
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction &tx = block.vtx[i];
         uint256 hash = tx.GetHash();
 
+        if (fUpdateAddressIndex) {
+            for (unsigned int k = 0; k < tx.vout.size(); k++) {
+                unsigned char nType;
+                uint160 hashBytes;
+                if (!GetAddressIndexHash(tx.vout[k].scriptPubKey, nType, hashBytes))
+                    continue;
+                vAddressHistory.push_back(std::make_pair(CAddressIndexKey(nType, hashBytes, pindex->nHeight, i, hash, k, false), tx.vout[k].nValue));
+                vAddressUnspent.push_back(std::make_pair(CAddressUnspentKey(nType, hashBytes, hash, k), CAddressUnspentValue()));
+            }
+        }
+
         //ticoin Check that all outputs are available and match the outputs in the block itself
         //ticoin exactly. Note that transactions with only provably unspendable outputs won't
         //ticoin have outputs available even in the block itself, so we handle that case
@@ -1697,10 +1823,22 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
                 coins.vout[out.n] = undo.txout;
                 if (!view.SetCoins(out.hash, coins))
                     return error("DisconnectBlock() : cannot restore coin inputs");
+
+                unsigned char nType;
+                uint160 hashBytes;
+                if (fUpdateAddressIndex && GetAddressIndexHash(undo.txout.scriptPubKey, nType, hashBytes)) {
+                    vAddressHistory.push_back(std::make_pair(CAddressIndexKey(nType, hashBytes, pindex->nHeight, i, hash, j, true), -undo.txout.nValue));
+                    vAddressUnspent.push_back(std::make_pair(CAddressUnspentKey(nType, hashBytes, out.hash, out.n),
+                                                             CAddressUnspentValue(undo.txout.nValue, undo.txout.scriptPubKey, coins.nHeight)));
+                }
             }
         }
     }
 
+    if (fUpdateAddressIndex)
+        if (!pblocktree->EraseAddressIndex(vAddressHistory, vAddressUnspent))
+            return state.Abort(_("Failed to write address index"));
+
     //ticoin move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
@@ -1744,6 +1882,31 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+void CollectMainMetrics()
+{
+    uint64_t nChecksRun;
+    int64_t nBusyMicros;
+    scriptcheckqueue.GetStats(nChecksRun, nBusyMicros);
+    metrics.Counter("ticoin_scriptcheck_checks_total", "Script checks run by the parallel verification threads").Set(nChecksRun);
+    metrics.Counter("ticoin_scriptcheck_busy_seconds_total", "Time the parallel verification threads together spent running script checks").Set(nBusyMicros * 0.000001);
+    metrics.Gauge("ticoin_scriptcheck_threads", "Number of parallel script verification threads, besides the one connecting the block").Set(nScriptCheckThreads);
+
+    metrics.Gauge("ticoin_mempool_transactions", "Number of transactions in the memory pool").Set(mempool.size());
+    metrics.Gauge("ticoin_mempool_bytes", "Serialized size of the transactions in the memory pool").Set(mempool.GetTotalTxSize());
+
+    LOCK(cs_main);
+    metrics.Gauge("ticoin_chain_height", "Height of the active chain").Set(chainActive.Height());
+    metrics.Counter("ticoin_connected_transactions_total", "Transactions in blocks connected to the active chain").Set(validationStats.nTransactions);
+    metrics.Counter("ticoin_connected_inputs_total", "Transaction inputs spent by blocks connected to the active chain").Set(validationStats.nInputs);
+    if (pcoinsTip) {
+        uint64_t nHits, nMisses;
+        pcoinsTip->GetCacheStats(nHits, nMisses);
+        metrics.Counter("ticoin_coinscache_hits_total", "Coins lookups answered from the coins cache").Set(nHits);
+        metrics.Counter("ticoin_coinscache_misses_total", "Coins lookups that had to go to the coins database").Set(nMisses);
+        metrics.Gauge("ticoin_coinscache_transactions", "Number of transactions held in the coins cache").Set(pcoinsTip->GetCacheSize());
+    }
+}
+
 bool ConnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, bool fJustCheck)
 {
     AssertLockHeld(cs_main);
@@ -1809,9 +1972,8 @@ bool ConnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex, C
     int64_t nFees = 0;
     int nInputs = 0;
     unsigned int nSigOps = 0;
-    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos> > vPos;
-    vPos.reserve(block.vtx.size());
+    std::vector<std::pair<CAddressIndexKey, int64_t> > vAddressHistory;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vAddressUnspent;
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = block.vtx[i];
@@ -1847,13 +2009,35 @@ bool ConnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex, C
             control.Add(vChecks);
         }
 
+        if (fAddressIndex && !fJustCheck) {
+            const uint256 &hash = block.GetTxHash(i);
+            unsigned char nType;
+            uint160 hashBytes;
+            if (!tx.IsCoinBase()) {
+                for (unsigned int j = 0; j < tx.vin.size(); j++) {
+                    const COutPoint &prevout = tx.vin[j].prevout;
+                    const CCoins &coins = view.GetCoins(prevout.hash);
+                    const CTxOut &out = coins.vout[prevout.n];
+                    if (!GetAddressIndexHash(out.scriptPubKey, nType, hashBytes))
+                        continue;
+                    vAddressHistory.push_back(std::make_pair(CAddressIndexKey(nType, hashBytes, pindex->nHeight, i, hash, j, true), -out.nValue));
+                    vAddressUnspent.push_back(std::make_pair(CAddressUnspentKey(nType, hashBytes, prevout.hash, prevout.n), CAddressUnspentValue()));
+                }
+            }
+            for (unsigned int k = 0; k < tx.vout.size(); k++) {
+                const CTxOut &out = tx.vout[k];
+                if (!GetAddressIndexHash(out.scriptPubKey, nType, hashBytes))
+                    continue;
+                vAddressHistory.push_back(std::make_pair(CAddressIndexKey(nType, hashBytes, pindex->nHeight, i, hash, k, false), out.nValue));
+                vAddressUnspent.push_back(std::make_pair(CAddressUnspentKey(nType, hashBytes, hash, k),
+                                                         CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
+            }
+        }
+
         CTxUndo txundo;
         UpdateCoins(tx, state, view, txundo, pindex->nHeight, block.GetTxHash(i));
         if (!tx.IsCoinBase())
             blockundo.vtxundo.push_back(txundo);
-
-        vPos.push_back(std::make_pair(block.GetTxHash(i), pos));
-        pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
     }
     int64_t nTime = GetTimeMicros() - nStart;
     if (fBenchmark)
@@ -1896,9 +2080,9 @@ bool ConnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex, C
             return state.Abort(_("Failed to write block index"));
     }
 
-    if (fTxIndex)
-        if (!pblocktree->WriteTxIndex(vPos))
-            return state.Abort(_("Failed to write transaction index"));
+    if (fAddressIndex)
+        if (!pblocktree->WriteAddressIndex(vAddressHistory, vAddressUnspent))
+            return state.Abort(_("Failed to write address index"));
 
     //ticoin add this block to the view's block chain
     bool ret;
@@ -1909,13 +2093,84 @@ bool ConnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex, C
     for (unsigned int i = 0; i < block.vtx.size(); i++)
         g_signals.SyncTransaction(block.GetTxHash(i), block.vtx[i], &block);
 
+    validationStats.nBlocks++;
+    validationStats.nTransactions += block.vtx.size();
+    validationStats.nInputs += nInputs - 1;
+    validationStats.nTimeConnect += nTime;
+    validationStats.nTimeVerify += nTime2 - nTime;
+    validationStats.nTimeWriteIndex += GetTimeMicros() - nStart - nTime2;
+
+    return true;
+}
+
+//ticoin Delete the oldest block and undo files until their total size is back under the
+//ticoin -prune target. Must only run right after the coin database was flushed, so that
+//ticoin every block that a restart may have to reconnect is still on disk.
+bool PruneBlockFiles(CValidationState &state) {
+    LOCK(cs_LastBlockFile);
+    fCheckForPruning = false;
+    if (!fPruneMode || fReindex || fImporting || chainActive.Height() <= (int)MIN_BLOCKS_TO_KEEP)
+        return true;
+
+    //ticoin Leave room for the chunks preallocated for the next blocks, to avoid pruning one file at a time.
+    uint64_t nBuffer = BLOCKFILE_CHUNK_SIZE + UNDOFILE_CHUNK_SIZE;
+    unsigned int nLastBlockWeCanPrune = chainActive.Height() - MIN_BLOCKS_TO_KEEP;
+    std::set<int> setFilesToPrune;
+    for (int nFile = nFirstUnprunedFile; nFile < nLastBlockFile && nBlockFilesUsage + nBuffer >= nPruneTarget; nFile++) {
+        CBlockFileInfo info;
+        if (!pblocktree->ReadBlockFileInfo(nFile, info) || (info.nSize == 0 && info.nUndoSize == 0)) {
+            if (nFile == nFirstUnprunedFile)
+                nFirstUnprunedFile++;
+            continue;
+        }
+        //ticoin Files are filled in height order, so later ones hold no older blocks.
+        if (info.nHeightLast > nLastBlockWeCanPrune)
+            break;
+        LogPrint("prune", "Pruning block file %i: %s\n", nFile, info.ToString());
+        nBlockFilesUsage -= info.nSize + info.nUndoSize;
+        info.SetNull();
+        if (!pblocktree->WriteBlockFileInfo(nFile, info))
+            return state.Abort(_("Failed to write file info"));
+        setFilesToPrune.insert(nFile);
+        if (nFile == nFirstUnprunedFile)
+            nFirstUnprunedFile++;
+    }
+    if (setFilesToPrune.empty())
+        return true;
+
+    //ticoin Forget where the blocks and undo data of the pruned files were stored
+    for (BlockMap::iterator it = mapBlockIndex.begin(); it != mapBlockIndex.end(); it++) {
+        CBlockIndex *pindex = it->second;
+        if ((pindex->nStatus & (BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO)) && setFilesToPrune.count(pindex->nFile)) {
+            pindex->nStatus &= ~(BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO);
+            pindex->nFile = 0;
+            pindex->nDataPos = 0;
+            pindex->nUndoPos = 0;
+            if (!pblocktree->WriteBlockIndex(CDiskBlockIndex(pindex)))
+                return state.Abort(_("Failed to write block index"));
+        }
+    }
+    if (!fHavePruned) {
+        fHavePruned = true;
+        pblocktree->WriteFlag("prunedblockfiles", true);
+    }
+    //ticoin The index must no longer point into the files before they are removed
+    if (!pblocktree->Sync())
+        return state.Abort(_("Failed to sync block index"));
+
+    for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); it++) {
+        CDiskBlockPos pos(*it, 0);
+        boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
+        boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
+    }
+    LogPrintf("Pruned %u block files, %d MiB of block and undo files left\n", setFilesToPrune.size(), nBlockFilesUsage / 1024 / 1024);
     return true;
 }
 
 //ticoin Update the on-disk chain state.
 bool static WriteChainState(CValidationState &state) {
     static int64_t nLastWrite = 0;
-    if (!IsInitialBlockDownload() || pcoinsTip->GetCacheSize() > nCoinCacheSize || GetTimeMicros() > nLastWrite + 600*1000000) {
+    if (!IsInitialBlockDownload() || pcoinsTip->GetCacheSize() > nCoinCacheSize || GetTimeMicros() > nLastWrite + 600*1000000 || fCheckForPruning) {
         //ticoin Typical CCoins structures on disk are around 100 bytes in size.
         //ticoin Pushing a new one to the database can cause it to be written
         //ticoin twice (once in the log, and once in the tables). This is already
@@ -1923,10 +2178,17 @@ bool static WriteChainState(CValidationState &state) {
         //ticoin overwrite one. Still, use a conservative safety factor of 2.
         if (!CheckDiskSpace(100 * 2 * 2 * pcoinsTip->GetCacheSize()))
             return state.Error("out of disk space");
+        int64_t nStart = GetTimeMicros();
         FlushBlockFile();
         pblocktree->Sync();
         if (!pcoinsTip->Flush())
             return state.Abort(_("Failed to write to coin database"));
+        validationStats.nTimeFlushDisk += GetTimeMicros() - nStart;
+        validationStats.nFlushes++;
+        static CMetricHistogram& histFlush = metrics.Histogram("ticoin_chainstate_flush_seconds", "Time to write the coins cache and block files to disk");
+        histFlush.Observe((GetTimeMicros() - nStart) * 0.000001);
+        if (fPruneMode && !PruneBlockFiles(state))
+            return false;
         nLastWrite = GetTimeMicros();
     }
     return true;
@@ -2002,6 +2264,7 @@ bool static DisconnectTip(CValidationState &state) {
     mempool.check(pcoinsTip);
     //ticoin Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev);
+    g_signals.BlockDisconnected(block, pindexDelete);
     //ticoin Let wallets know transactions went from 1-confirmed to
     //ticoin 0-confirmed or conflicted:
     BOOST_FOREACH(const CTransaction &tx, block.vtx) {
@@ -2016,8 +2279,10 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pindexNew) {
     mempool.check(pcoinsTip);
     //ticoin Read block from disk.
     CBlock block;
+    int64_t nStartRead = GetTimeMicros();
     if (!ReadBlockFromDisk(block, pindexNew))
         return state.Abort(_("Failed to read block"));
+    validationStats.nTimeReadBlock += GetTimeMicros() - nStartRead;
     //ticoin Apply the block atomically to the chain state.
     int64_t nStart = GetTimeMicros();
     {
@@ -2028,8 +2293,12 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pindexNew) {
                 InvalidBlockFound(pindexNew, state);
             return error("ConnectTip() : ConnectBlock %s failed", pindexNew->GetBlockHash().ToString());
         }
+        static CMetricHistogram& histConnect = metrics.Histogram("ticoin_connectblock_seconds", "Time to validate a block and apply it to the chain state");
+        histConnect.Observe((GetTimeMicros() - nStart) * 0.000001);
         mapBlockSource.erase(inv.hash);
+        int64_t nStartFlush = GetTimeMicros();
         assert(view.Flush());
+        validationStats.nTimeFlushView += GetTimeMicros() - nStartFlush;
     }
     if (fBenchmark)
         LogPrintf("- Connect: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
@@ -2046,6 +2315,7 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pindexNew) {
     mempool.check(pcoinsTip);
     //ticoin Update chainActive & related variables.
     UpdateTip(pindexNew);
+    g_signals.BlockConnected(block, pindexNew);
     //ticoin Tell wallet about transactions that went from mempool
     //ticoin to conflicted:
     BOOST_FOREACH(const CTransaction &tx, txConflicted) {
@@ -2168,22 +2438,22 @@ bool AddToBlockIndex(CBlock& block, CValidationState& state, const CDiskBlockPos
         return state.Invalid(error("AddToBlockIndex() : %s already exists", hash.ToString()), 0, "duplicate");
 
     //ticoin Construct new block index object
-    CBlockIndex* pindexNew = new CBlockIndex(block);
-    assert(pindexNew);
+    CBlockIndex* pindexNew = AllocateBlockIndex();
+    *pindexNew = CBlockIndex(block);
     {
          LOCK(cs_nBlockSequenceId);
          pindexNew->nSequenceId = nBlockSequenceId++;
     }
-    map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
+    BlockMap::iterator mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
-    map<uint256, CBlockIndex*>::iterator miPrev = mapBlockIndex.find(block.hashPrevBlock);
+    BlockMap::iterator miPrev = mapBlockIndex.find(block.hashPrevBlock);
     if (miPrev != mapBlockIndex.end())
     {
         pindexNew->pprev = (*miPrev).second;
         pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
     }
     pindexNew->nTx = block.vtx.size();
-    pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + pindexNew->GetBlockWork().getuint256();
+    pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + pindexNew->GetBlockWork();
     pindexNew->nChainTx = (pindexNew->pprev ? pindexNew->pprev->nChainTx : 0) + pindexNew->nTx;
     pindexNew->nFile = pos.nFile;
     pindexNew->nDataPos = pos.nPos;
@@ -2239,12 +2509,15 @@ bool FindBlockPos(CValidationState &state, CDiskBlockPos &pos, unsigned int nAdd
             infoLastBlockFile.SetNull();
             pblocktree->ReadBlockFileInfo(nLastBlockFile, infoLastBlockFile); //ticoin check whether data for the new file somehow already exist; can fail just fine
             fUpdatedLast = true;
+            if (fPruneMode)
+                fCheckForPruning = true;
         }
         pos.nFile = nLastBlockFile;
         pos.nPos = infoLastBlockFile.nSize;
     }
 
     infoLastBlockFile.nSize += nAddSize;
+    nBlockFilesUsage += nAddSize;
     infoLastBlockFile.AddBlock(nHeight, nTime);
 
     if (!fKnown) {
@@ -2293,6 +2566,7 @@ bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigne
         if (!pblocktree->WriteBlockFileInfo(nFile, info))
             return state.Abort(_("Failed to write block info"));
     }
+    nBlockFilesUsage += nAddSize;
 
     unsigned int nOldChunks = (pos.nPos + UNDOFILE_CHUNK_SIZE - 1) / UNDOFILE_CHUNK_SIZE;
     unsigned int nNewChunks = (nNewSize + UNDOFILE_CHUNK_SIZE - 1) / UNDOFILE_CHUNK_SIZE;
@@ -2391,7 +2665,7 @@ bool AcceptBlock(CBlock& block, CValidationState& state, CDiskBlockPos* dbp)
     CBlockIndex* pindexPrev = NULL;
     int nHeight = 0;
     if (hash != Params().HashGenesisBlock()) {
-        map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.find(block.hashPrevBlock);
+        BlockMap::iterator mi = mapBlockIndex.find(block.hashPrevBlock);
         if (mi == mapBlockIndex.end())
             return state.DoS(10, error("AcceptBlock() : prev block not found"), 0, "bad-prevblk");
         pindexPrev = (*mi).second;
@@ -2419,7 +2693,7 @@ bool AcceptBlock(CBlock& block, CValidationState& state, CDiskBlockPos* dbp)
                              REJECT_CHECKPOINT, "checkpoint mismatch");
 
         //ticoin Don't accept any forks from the main chain prior to last checkpoint
-        CBlockIndex* pcheckpoint = Checkpoints::GetLastCheckpoint(mapBlockIndex);
+        CBlockIndex* pcheckpoint = Checkpoints::GetLastCheckpoint();
         if (pcheckpoint && nHeight < pcheckpoint->nHeight)
             return state.DoS(100, error("AcceptBlock() : forked chain older than last checkpoint (height %d)", nHeight));
 
@@ -2541,7 +2815,7 @@ bool ProcessBlock(CValidationState &state, CNode* pfrom, CBlock* pblock, CDiskBl
     if (!CheckBlock(*pblock, state))
         return error("ProcessBlock() : CheckBlock FAILED");
 
-    CBlockIndex* pcheckpoint = Checkpoints::GetLastCheckpoint(mapBlockIndex);
+    CBlockIndex* pcheckpoint = Checkpoints::GetLastCheckpoint();
     if (pcheckpoint && pblock->hashPrevBlock != (chainActive.Tip() ? chainActive.Tip()->GetBlockHash() : uint256(0)))
     {
         //ticoin Extra checks to prevent "fill up memory by spamming with bogus blocks"
@@ -2551,9 +2825,9 @@ bool ProcessBlock(CValidationState &state, CNode* pfrom, CBlock* pblock, CDiskBl
             return state.DoS(100, error("ProcessBlock() : block with timestamp before last checkpoint"),
                              REJECT_CHECKPOINT, "time-too-old");
         }
-        CBigNum bnNewBlock;
+        arith_uint256 bnNewBlock;
         bnNewBlock.SetCompact(pblock->nBits);
-        CBigNum bnRequired;
+        arith_uint256 bnRequired;
         bnRequired.SetCompact(ComputeMinWork(pcheckpoint->nBits, deltaTime));
         if (bnNewBlock > bnRequired)
         {
@@ -2629,10 +2903,10 @@ bool ProcessBlock(CValidationState &state, CNode* pfrom, CBlock* pblock, CDiskBl
 
 
 
-CMerkleBlock::CMerkleBlock(const CBlock& block, CBloomFilter& filter)
+//ticoin Match the transactions of a CBlock or CBlockView against filter
+template<typename Block>
+static CPartialMerkleTree FilterBlockTransactions(const Block& block, CBloomFilter& filter, std::vector<std::pair<unsigned int, uint256> >& vMatchedTxn)
 {
-    header = block.GetBlockHeader();
-
     vector<bool> vMatch;
     vector<uint256> vHashes;
 
@@ -2652,7 +2926,19 @@ CMerkleBlock::CMerkleBlock(const CBlock& block, CBloomFilter& filter)
         vHashes.push_back(hash);
     }
 
-    txn = CPartialMerkleTree(vHashes, vMatch);
+    return CPartialMerkleTree(vHashes, vMatch);
+}
+
+CMerkleBlock::CMerkleBlock(const CBlock& block, CBloomFilter& filter)
+{
+    header = block.GetBlockHeader();
+    txn = FilterBlockTransactions(block, filter, vMatchedTxn);
+}
+
+CMerkleBlock::CMerkleBlock(const CBlockView& block, CBloomFilter& filter)
+{
+    header = block.header;
+    txn = FilterBlockTransactions(block, filter, vMatchedTxn);
 }
 
 
@@ -2784,7 +3070,7 @@ uint256 CPartialMerkleTree::ExtractMatches(std::vector<uint256> &vMatch) {
 
 bool AbortNode(const std::string &strMessage) {
     strMiscWarning = strMessage;
-    LogPrintf("*** %s\n", strMessage);
+    LogPrintStr("*** " + strMessage + "\n", NULL, true);
     uiInterface.ThreadSafeMessageBox(strMessage, "", CClientUIInterface::MSG_ERROR);
     StartShutdown();
     return false;
@@ -2801,11 +3087,16 @@ bool CheckDiskSpace(uint64_t nAdditionalBytes)
     return true;
 }
 
+boost::filesystem::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix)
+{
+    return GetDataDir() / "blocks" / strprintf("%s%05u.dat", prefix, pos.nFile);
+}
+
 FILE* OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 {
     if (pos.IsNull())
         return NULL;
-    boost::filesystem::path path = GetDataDir() / "blocks" / strprintf("%s%05u.dat", prefix, pos.nFile);
+    boost::filesystem::path path = GetBlockPosFilename(pos, prefix);
     boost::filesystem::create_directories(path.parent_path());
     FILE* file = fopen(path.string().c_str(), "rb+");
     if (!file && !fReadOnly)
@@ -2838,14 +3129,12 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
         return NULL;
 
     //ticoin Return existing
-    map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.find(hash);
+    BlockMap::iterator mi = mapBlockIndex.find(hash);
     if (mi != mapBlockIndex.end())
         return (*mi).second;
 
     //ticoin Create new
-    CBlockIndex* pindexNew = new CBlockIndex();
-    if (!pindexNew)
-        throw runtime_error("LoadBlockIndex() : new CBlockIndex failed");
+    CBlockIndex* pindexNew = AllocateBlockIndex();
     mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
 
@@ -2862,7 +3151,7 @@ bool static LoadBlockIndexDB()
     //ticoin Calculate nChainWork
     vector<pair<int, CBlockIndex*> > vSortedByHeight;
     vSortedByHeight.reserve(mapBlockIndex.size());
-    BOOST_FOREACH(const PAIRTYPE(uint256, CBlockIndex*)& item, mapBlockIndex)
+    BOOST_FOREACH(const PAIRTYPE(const uint256, CBlockIndex*)& item, mapBlockIndex)
     {
         CBlockIndex* pindex = item.second;
         vSortedByHeight.push_back(make_pair(pindex->nHeight, pindex));
@@ -2871,7 +3160,7 @@ bool static LoadBlockIndexDB()
     BOOST_FOREACH(const PAIRTYPE(int, CBlockIndex*)& item, vSortedByHeight)
     {
         CBlockIndex* pindex = item.second;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + pindex->GetBlockWork().getuint256();
+        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + pindex->GetBlockWork();
         pindex->nChainTx = (pindex->pprev ? pindex->pprev->nChainTx : 0) + pindex->nTx;
         if ((pindex->nStatus & BLOCK_VALID_MASK) >= BLOCK_VALID_TRANSACTIONS && !(pindex->nStatus & BLOCK_FAILED_MASK))
             setBlockIndexValid.insert(pindex);
@@ -2880,22 +3169,26 @@ bool static LoadBlockIndexDB()
     }
 
     //ticoin Load block file info
-    pblocktree->ReadLastBlockFile(nLastBlockFile);
-    LogPrintf("LoadBlockIndexDB(): last block file = %i\n", nLastBlockFile);
-    if (pblocktree->ReadBlockFileInfo(nLastBlockFile, infoLastBlockFile))
-        LogPrintf("LoadBlockIndexDB(): last block file info: %s\n", infoLastBlockFile.ToString());
+    LoadBlockFileInfo();
 
     //ticoin Check whether we need to continue reindexing
     bool fReindexing = false;
     pblocktree->ReadReindexing(fReindexing);
     fReindex |= fReindexing;
 
-    //ticoin Check whether we have a transaction index
-    pblocktree->ReadFlag("txindex", fTxIndex);
-    LogPrintf("LoadBlockIndexDB(): transaction index %s\n", fTxIndex ? "enabled" : "disabled");
+    //ticoin Check whether block files were ever pruned
+    pblocktree->ReadFlag("prunedblockfiles", fHavePruned);
+
+    //ticoin Check whether the chain state was bootstrapped from a UTXO snapshot; blocks below it were never downloaded
+    pblocktree->ReadFlag("utxosnapshot", fSnapshotChainstate);
+    fHavePruned |= fSnapshotChainstate;
+
+    //ticoin Check whether we have an address index
+    pblocktree->ReadFlag("addressindex", fAddressIndex);
+    LogPrintf("LoadBlockIndexDB(): address index %s\n", fAddressIndex ? "enabled" : "disabled");
 
     //ticoin Load pointer to end of best chain
-    std::map<uint256, CBlockIndex*>::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
+    BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
     if (it == mapBlockIndex.end())
         return true;
     chainActive.SetTip(it->second);
@@ -2907,6 +3200,42 @@ bool static LoadBlockIndexDB()
     return true;
 }
 
+void LoadBlockFileInfo()
+{
+    LOCK(cs_LastBlockFile);
+    nLastBlockFile = 0;
+    infoLastBlockFile.SetNull();
+    pblocktree->ReadLastBlockFile(nLastBlockFile);
+    LogPrintf("LoadBlockFileInfo(): last block file = %i\n", nLastBlockFile);
+    if (pblocktree->ReadBlockFileInfo(nLastBlockFile, infoLastBlockFile))
+        LogPrintf("LoadBlockFileInfo(): last block file info: %s\n", infoLastBlockFile.ToString());
+
+    //ticoin Sum up the sizes of the block and undo files for further pruning
+    nFirstUnprunedFile = 0;
+    if (fPruneMode) {
+        nBlockFilesUsage = 0;
+        for (int nFile = 0; nFile <= nLastBlockFile; nFile++) {
+            CBlockFileInfo info;
+            if (pblocktree->ReadBlockFileInfo(nFile, info))
+                nBlockFilesUsage += info.nSize + info.nUndoSize;
+        }
+        LogPrintf("LoadBlockFileInfo(): block and undo files use %d MiB\n", nBlockFilesUsage / 1024 / 1024);
+    }
+}
+
+bool HaveBlockDataFrom(const CBlockIndex* pindex)
+{
+    if (!fHavePruned)
+        return true;
+    for (const CBlockIndex* pindexWalk = chainActive.Tip(); pindexWalk; pindexWalk = pindexWalk->pprev) {
+        if (!(pindexWalk->nStatus & BLOCK_HAVE_DATA))
+            return false;
+        if (pindexWalk == pindex)
+            break;
+    }
+    return true;
+}
+
 bool VerifyDB(int nCheckLevel, int nCheckDepth)
 {
     LOCK(cs_main);
@@ -2930,6 +3259,11 @@ bool VerifyDB(int nCheckLevel, int nCheckDepth)
         boost::this_thread::interruption_point();
         if (pindex->nHeight < chainActive.Height()-nCheckDepth)
             break;
+        if (fHavePruned && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            //ticoin Nothing older than this is left on disk
+            LogPrintf("VerifyDB(): block verification stopping at height %d (pruned data)\n", pindex->nHeight);
+            break;
+        }
         CBlock block;
         //ticoin check level 0: read from disk
         if (!ReadBlockFromDisk(block, pindex))
@@ -2986,6 +3320,7 @@ void UnloadBlockIndex()
     mapBlockIndex.clear();
     setBlockIndexValid.clear();
     chainActive.SetTip(NULL);
+    chainMostWork.SetTip(NULL);
     pindexBestInvalid = NULL;
 }
 
@@ -3004,9 +3339,9 @@ bool InitBlockIndex() {
     if (chainActive.Genesis() != NULL)
         return true;
 
-    //ticoin Use the provided setting for -txindex in the new database
-    fTxIndex = GetBoolArg("-txindex", false);
-    pblocktree->WriteFlag("txindex", fTxIndex);
+    //ticoin Use the provided setting for -addressindex in the new database
+    fAddressIndex = GetBoolArg("-addressindex", false);
+    pblocktree->WriteFlag("addressindex", fAddressIndex);
     LogPrintf("Initializing databases...\n");
 
     //ticoin Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -3038,7 +3373,7 @@ void PrintBlockTree()
     AssertLockHeld(cs_main);
     //ticoin pre-compute tree structure
     map<CBlockIndex*, vector<CBlockIndex*> > mapNext;
-    for (map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi)
+    for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi)
     {
         CBlockIndex* pindex = (*mi).second;
         mapNext[pindex->pprev].push_back(pindex);
@@ -3174,6 +3509,495 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
     return nLoaded > 0;
 }
 
+//ticoin Location of a block found while scanning the block files during -reindex.
+struct CBlockFileScanEntry
+{
+    uint256 hash;
+    uint256 hashPrev;
+    CDiskBlockPos pos;
+    unsigned int nSize;
+};
+
+//ticoin Buffer of the header scan. Small enough that the bodies of most blocks are skipped by seeking
+//ticoin past them instead of being read, as stage 2 reads them anyway.
+static const unsigned int REINDEX_SCAN_BUFFER_SIZE = 16 * 1024;
+
+//ticoin Scans block files for block headers. Several threads run Thread() at once, each
+//ticoin taking the next unscanned file; only the 80-byte headers are deserialized.
+class CBlockFileScanner
+{
+private:
+    boost::mutex mutex;
+    int nNextFile;
+
+public:
+    std::vector<std::vector<CBlockFileScanEntry> > vEntries; //ticoin per file, in file order
+    std::vector<uint64_t> vEnd; //ticoin per file, end of the last block found
+
+    CBlockFileScanner(int nFiles) : nNextFile(0), vEntries(nFiles), vEnd(nFiles, 0) {}
+
+    void ScanFile(int nFile)
+    {
+        CDiskBlockPos pos(nFile, 0);
+        FILE *fileIn = OpenBlockFile(pos, true);
+        if (!fileIn)
+            return;
+        std::vector<CBlockFileScanEntry> &vFile = vEntries[nFile];
+        try {
+            //ticoin Rewinds are counted from the end of what was read from the file, so keep a whole
+            //ticoin buffer's worth behind it; only a failed header has to be rewound over.
+            CBufferedFile blkdat(fileIn, 2*REINDEX_SCAN_BUFFER_SIZE, REINDEX_SCAN_BUFFER_SIZE+MESSAGE_START_SIZE+4+80, SER_DISK, CLIENT_VERSION);
+            uint64_t nRewind = blkdat.GetPos();
+            while (blkdat.good() && !blkdat.eof()) {
+                boost::this_thread::interruption_point();
+
+                blkdat.SetPos(nRewind);
+                nRewind++; //ticoin start one byte further next time, in case of failure
+                blkdat.SetLimit(); //ticoin remove former limit
+                unsigned int nSize = 0;
+                try {
+                    //ticoin locate a header
+                    unsigned char buf[MESSAGE_START_SIZE];
+                    blkdat.FindByte(Params().MessageStart()[0]);
+                    nRewind = blkdat.GetPos()+1;
+                    blkdat >> FLATDATA(buf);
+                    if (memcmp(buf, Params().MessageStart(), MESSAGE_START_SIZE))
+                        continue;
+                    //ticoin read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SIZE)
+                        continue;
+                } catch (std::exception &e) {
+                    //ticoin no valid block header found; don't complain
+                    break;
+                }
+                try {
+                    uint64_t nBlockPos = blkdat.GetPos();
+                    blkdat.SetLimit(nBlockPos + nSize);
+                    CBlockHeader header;
+                    blkdat >> header;
+                    CBlockFileScanEntry entry;
+                    entry.hash = header.GetHash();
+                    if (!CheckProofOfWork(entry.hash, header.nBits))
+                        continue;
+                    entry.hashPrev = header.hashPrevBlock;
+                    entry.pos = CDiskBlockPos(nFile, nBlockPos);
+                    entry.nSize = nSize;
+                    vFile.push_back(entry);
+                    vEnd[nFile] = nBlockPos + nSize;
+
+                    //ticoin skip the transactions; stay within the buffer unless the block ends beyond what was read of it
+                    nRewind = nBlockPos + nSize;
+                    blkdat.SetLimit();
+                    if (!blkdat.SetPos(nRewind))
+                        blkdat.Seek(nRewind);
+                } catch (std::exception &e) {
+                    LogPrintf("%s : Deserialize or I/O error - %s", __func__, e.what());
+                }
+            }
+        } catch (std::runtime_error &e) {
+            LogPrintf("%s : error scanning blk%05u.dat - %s\n", __func__, (unsigned int)nFile, e.what());
+        }
+        fclose(fileIn);
+    }
+
+    void Thread()
+    {
+        while (true) {
+            int nFile;
+            {
+                boost::mutex::scoped_lock lock(mutex);
+                if (nNextFile >= (int)vEntries.size())
+                    return;
+                nFile = nNextFile++;
+            }
+            ScanFile(nFile);
+        }
+    }
+};
+
+//ticoin Reads the blocks found by the scan, keeping the block file of the last one open. Stage 2
+//ticoin mostly asks for blocks in file order, which are then served from one sequential read
+//ticoin instead of opening and seeking the file for every block.
+class CBlockFileReader
+{
+private:
+    int nFile;
+    FILE *file;
+    CBufferedFile *pblkdat;
+    //ticoin Where the buffer started reading after the last seek; it holds nothing before that
+    unsigned int nSeekPos;
+
+public:
+    CBlockFileReader() : nFile(-1), file(NULL), pblkdat(NULL), nSeekPos(0) {}
+    ~CBlockFileReader() { Close(); }
+
+    void Close()
+    {
+        delete pblkdat;
+        pblkdat = NULL;
+        if (file)
+            fclose(file);
+        file = NULL;
+        nFile = -1;
+    }
+
+    bool Read(CBlock &block, const CBlockFileScanEntry &entry)
+    {
+        if (entry.pos.nFile != nFile) {
+            Close();
+            file = OpenBlockFile(CDiskBlockPos(entry.pos.nFile, 0), true);
+            if (!file)
+                return false;
+            nFile = entry.pos.nFile;
+            pblkdat = new CBufferedFile(file, 2*MAX_BLOCK_SIZE, MAX_BLOCK_SIZE, SER_DISK, CLIENT_VERSION);
+            nSeekPos = 0;
+        }
+        try {
+            pblkdat->SetLimit();
+            if (entry.pos.nPos < nSeekPos || !pblkdat->SetPos(entry.pos.nPos)) {
+                if (!pblkdat->Seek(entry.pos.nPos))
+                    return false;
+                nSeekPos = entry.pos.nPos;
+            }
+            pblkdat->SetLimit(entry.pos.nPos + entry.nSize);
+            *pblkdat >> block;
+        } catch (std::exception &e) {
+            Close();
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+        return true;
+    }
+};
+
+bool ReindexBlockFiles()
+{
+    int64_t nStart = GetTimeMillis();
+
+    int nFiles = 0;
+    while (true) {
+        FILE *file = OpenBlockFile(CDiskBlockPos(nFiles, 0), true);
+        if (!file)
+            break;
+        fclose(file);
+        nFiles++;
+    }
+    if (nFiles == 0)
+        return false;
+
+    //ticoin Stage 1: collect the headers of all block files in parallel.
+    CBlockFileScanner scanner(nFiles);
+    {
+        int nThreads = std::min(nFiles, std::max((int)boost::thread::hardware_concurrency(), 1));
+        boost::thread_group threadGroup;
+        for (int i = 0; i < nThreads; i++)
+            threadGroup.create_thread(boost::bind(&CBlockFileScanner::Thread, &scanner));
+        try {
+            threadGroup.join_all();
+        } catch (boost::thread_interrupted) {
+            threadGroup.interrupt_all();
+            threadGroup.join_all();
+            throw;
+        }
+        LogPrintf("Scanned %d block files using %d threads in %dms\n", nFiles, nThreads, GetTimeMillis() - nStart);
+    }
+
+    std::vector<CBlockFileScanEntry> vEntries;
+    for (int nFile = 0; nFile < nFiles; nFile++) {
+        vEntries.insert(vEntries.end(), scanner.vEntries[nFile].begin(), scanner.vEntries[nFile].end());
+        std::vector<CBlockFileScanEntry>().swap(scanner.vEntries[nFile]);
+    }
+
+    //ticoin Link every header to its parent. A block stored more than once is used at its first position.
+    boost::unordered_map<uint256, size_t, BlockHasher> mapScanned;
+    std::multimap<uint256, size_t> mapChildren;
+    for (size_t i = 0; i < vEntries.size(); i++) {
+        if (mapScanned.insert(make_pair(vEntries[i].hash, i)).second)
+            mapChildren.insert(make_pair(vEntries[i].hashPrev, i));
+    }
+
+    //ticoin Stage 2: connect blocks parents first, reading each one from its known position only
+    //ticoin when it is its turn. Taking the lowest ready entry keeps the reads close to file order.
+    std::set<size_t> setReady;
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < vEntries.size(); i++) {
+            const CBlockFileScanEntry &entry = vEntries[i];
+            if (mapScanned[entry.hash] != i || mapScanned.count(entry.hashPrev))
+                continue;
+            if (entry.hash == Params().HashGenesisBlock() || mapBlockIndex.count(entry.hashPrev))
+                setReady.insert(i);
+        }
+    }
+
+    CBlockFileReader reader;
+    int nLoaded = 0;
+    while (!setReady.empty()) {
+        boost::this_thread::interruption_point();
+
+        size_t i = *setReady.begin();
+        setReady.erase(setReady.begin());
+        const CBlockFileScanEntry &entry = vEntries[i];
+
+        bool fHave;
+        {
+            LOCK(cs_main);
+            fHave = mapBlockIndex.count(entry.hash) > 0;
+        }
+        if (!fHave) {
+            CBlock block;
+            if (!reader.Read(block, entry) || block.GetHash() != entry.hash) {
+                LogPrintf("%s : failed to read block %s from blk%05u.dat\n", __func__, entry.hash.ToString(), (unsigned int)entry.pos.nFile);
+                continue;
+            }
+            LOCK(cs_main);
+            CDiskBlockPos pos = entry.pos;
+            CValidationState state;
+            if (ProcessBlock(state, NULL, &block, &pos))
+                nLoaded++;
+            if (state.IsError())
+                break;
+            if (!mapBlockIndex.count(entry.hash))
+                continue;
+        }
+
+        for (std::multimap<uint256, size_t>::iterator mi = mapChildren.lower_bound(entry.hash); mi != mapChildren.upper_bound(entry.hash); ++mi)
+            setReady.insert(mi->second);
+    }
+
+    //ticoin Blocks were not accepted in file order, so point new blocks past everything already in the last file.
+    {
+        LOCK(cs_LastBlockFile);
+        int nLastFile = nFiles - 1;
+        if (nLastBlockFile != nLastFile) {
+            nLastBlockFile = nLastFile;
+            infoLastBlockFile.SetNull();
+            pblocktree->ReadBlockFileInfo(nLastBlockFile, infoLastBlockFile);
+            pblocktree->WriteLastBlockFile(nLastBlockFile);
+        }
+        if (infoLastBlockFile.nSize < scanner.vEnd[nLastFile]) {
+            infoLastBlockFile.nSize = scanner.vEnd[nLastFile];
+            pblocktree->WriteBlockFileInfo(nLastBlockFile, infoLastBlockFile);
+        }
+    }
+
+    LogPrintf("Reindexed %i of %u blocks found in %dms\n", nLoaded, (unsigned int)mapScanned.size(), GetTimeMillis() - nStart);
+    return nLoaded > 0;
+}
+
+bool DumpUtxoSnapshot(const boost::filesystem::path &path, CCoinsStats &stats)
+{
+    int64_t nStart = GetTimeMillis();
+
+    CUtxoSnapshotHeader header;
+    std::vector<CBlockHeader> vHeaders;
+    std::vector<unsigned int> vTxCount;
+    CCoinsViewDBCursor *pcursor;
+    {
+        LOCK(cs_main);
+        //ticoin Flush first, so the database holds exactly the tip's state. The cursor keeps
+        //ticoin seeing that state while new blocks are connected during the dump.
+        if (!pcoinsTip->Flush())
+            return error("DumpUtxoSnapshot() : failed to flush coins");
+        header.hashBlock = pcoinsdbview->GetBestBlock();
+        BlockMap::iterator mi = mapBlockIndex.find(header.hashBlock);
+        if (mi == mapBlockIndex.end())
+            return error("DumpUtxoSnapshot() : best block of the coin database not found");
+        CBlockIndex *pindex = mi->second;
+        header.nHeight = pindex->nHeight;
+        vHeaders.resize(pindex->nHeight + 1);
+        vTxCount.resize(pindex->nHeight + 1);
+        for (; pindex; pindex = pindex->pprev) {
+            vHeaders[pindex->nHeight] = pindex->GetBlockHeader();
+            vTxCount[pindex->nHeight] = pindex->nTx;
+        }
+        pcursor = pcoinsdbview->Cursor();
+    }
+
+    boost::filesystem::path pathTmp = path.string() + ".incomplete";
+    CAutoFile fileout = CAutoFile(fopen(pathTmp.string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+    if (!fileout) {
+        delete pcursor;
+        return error("DumpUtxoSnapshot() : cannot open %s", pathTmp.string());
+    }
+
+    try {
+        fileout << header;
+        for (unsigned int i = 0; i < vHeaders.size(); i++)
+            fileout << vHeaders[i] << VARINT(vTxCount[i]);
+
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        stats = CCoinsStats();
+        stats.hashBlock = header.hashBlock;
+        stats.nHeight = header.nHeight;
+        ss << stats.hashBlock;
+        while (pcursor->Valid()) {
+            uint256 txid;
+            CCoins coins;
+            if (!pcursor->GetCoins(txid, coins))
+                throw std::runtime_error("cannot read coin database");
+            fileout << txid << coins;
+            UpdateCoinsStats(ss, stats, txid, coins);
+            stats.nSerializedSize += 32 + ::GetSerializeSize(coins, SER_DISK, CLIENT_VERSION);
+            pcursor->Next();
+        }
+        stats.hashSerialized = ss.GetHash();
+        fileout << stats.hashSerialized;
+
+        //ticoin The number of records is only known now
+        header.nTransactions = stats.nTransactions;
+        if (fseek(fileout, 0, SEEK_SET))
+            throw std::runtime_error("seek failed");
+        fileout << header;
+        fflush(fileout);
+        FileCommit(fileout);
+    } catch (std::exception &e) {
+        delete pcursor;
+        fileout.fclose();
+        boost::filesystem::remove(pathTmp);
+        return error("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    delete pcursor;
+    fileout.fclose();
+    if (!RenameOver(pathTmp, path))
+        return error("DumpUtxoSnapshot() : cannot rename %s", pathTmp.string());
+
+    LogPrintf("Dumped UTXO snapshot at height %d (%u transactions, hash %s) in %dms\n",
+        stats.nHeight, stats.nTransactions, stats.hashSerialized.ToString(), GetTimeMillis() - nStart);
+    return true;
+}
+
+bool LoadUtxoSnapshot(CCoinsViewDB &view, const boost::filesystem::path &path, const uint256 &hashExpected)
+{
+    int64_t nStart = GetTimeMillis();
+
+    LOCK(cs_main);
+    if (!mapBlockIndex.empty() || view.GetBestBlock() != 0)
+        return error("LoadUtxoSnapshot() : a snapshot can only be loaded into an empty data directory");
+
+    CAutoFile filein = CAutoFile(fopen(path.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return error("LoadUtxoSnapshot() : cannot open %s", path.string());
+
+    try {
+        CUtxoSnapshotHeader header;
+        filein >> header;
+        if (!header.IsValid())
+            return error("LoadUtxoSnapshot() : %s is not a UTXO snapshot of a supported version", path.string());
+
+        //ticoin Each header takes at least its 80 bytes and a one byte transaction count
+        uint64_t nHeaderSize = ::GetSerializeSize(CBlockHeader(), SER_DISK, CLIENT_VERSION) + 1;
+        if ((uint64_t)header.nHeight + 1 > boost::filesystem::file_size(path) / nHeaderSize)
+            return error("LoadUtxoSnapshot() : %s is too short for height %d", path.string(), header.nHeight);
+
+        //ticoin Check the headers like AcceptBlock does, on a chain that only lives during the load.
+        //ticoin Deques grow as headers are read without moving the entries pprev points to.
+        std::deque<uint256> vHash;
+        std::deque<CBlockIndex> vIndex;
+        for (int nHeight = 0; nHeight <= header.nHeight; nHeight++) {
+            boost::this_thread::interruption_point();
+            CBlockHeader block;
+            unsigned int nTx;
+            filein >> block >> VARINT(nTx);
+            vHash.push_back(block.GetHash());
+            vIndex.push_back(CBlockIndex());
+            uint256 &hash = vHash[nHeight];
+            CBlockIndex *pindexPrev = nHeight > 0 ? &vIndex[nHeight - 1] : NULL;
+            if (!CheckProofOfWork(hash, block.nBits))
+                return error("LoadUtxoSnapshot() : proof of work failed at height %d", nHeight);
+            if (pindexPrev == NULL) {
+                if (hash != Params().HashGenesisBlock())
+                    return error("LoadUtxoSnapshot() : snapshot is for a different network");
+            } else {
+                if (block.hashPrevBlock != vHash[nHeight - 1])
+                    return error("LoadUtxoSnapshot() : headers do not form a chain at height %d", nHeight);
+                if (block.nBits != GetNextWorkRequired(pindexPrev, &block))
+                    return error("LoadUtxoSnapshot() : incorrect proof of work at height %d", nHeight);
+                if (block.GetBlockTime() <= pindexPrev->GetMedianTimePast())
+                    return error("LoadUtxoSnapshot() : timestamp too early at height %d", nHeight);
+                if (!Checkpoints::CheckBlock(nHeight, hash))
+                    return error("LoadUtxoSnapshot() : rejected by checkpoint lock-in at %d", nHeight);
+            }
+            CBlockIndex &index = vIndex[nHeight];
+            index = CBlockIndex(block);
+            index.phashBlock = &hash;
+            index.pprev = pindexPrev;
+            index.nHeight = nHeight;
+            index.nTx = nTx;
+            index.nStatus = BLOCK_VALID_SCRIPTS;
+        }
+        if (vHash.back() != header.hashBlock)
+            return error("LoadUtxoSnapshot() : headers do not end at the snapshot block");
+
+        //ticoin First pass: verify the coins against the hash before anything is written
+        long nCoinsPos = ftell(filein);
+        CCoinsStats stats;
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        ss << header.hashBlock;
+        uint256 txidLast;
+        for (uint64_t i = 0; i < header.nTransactions; i++) {
+            boost::this_thread::interruption_point();
+            uint256 txid;
+            CCoins coins;
+            filein >> txid >> coins;
+            //ticoin Database key order is the byte order of the txids
+            if (i > 0 && memcmp(txidLast.begin(), txid.begin(), txid.size()) >= 0)
+                return error("LoadUtxoSnapshot() : transactions are not in database order");
+            if (coins.IsPruned())
+                return error("LoadUtxoSnapshot() : transaction %s has no unspent outputs", txid.ToString());
+            UpdateCoinsStats(ss, stats, txid, coins);
+            txidLast = txid;
+        }
+        uint256 hashFile;
+        filein >> hashFile;
+        uint256 hashSerialized = ss.GetHash();
+        if (hashSerialized != hashFile)
+            return error("LoadUtxoSnapshot() : %s is corrupt", path.string());
+        if (hashSerialized != hashExpected)
+            return error("LoadUtxoSnapshot() : snapshot hash %s does not match the expected %s", hashSerialized.ToString(), hashExpected.ToString());
+
+        //ticoin Second pass: bulk load the coins; they arrive sorted, so each batch is a sequential run of keys
+        if (fseek(filein, nCoinsPos, SEEK_SET))
+            return error("LoadUtxoSnapshot() : seek failed");
+        std::vector<std::pair<uint256, CCoins> > vCoins;
+        vCoins.reserve(UTXO_SNAPSHOT_BATCH_SIZE);
+        for (uint64_t i = 0; i < header.nTransactions; i++) {
+            boost::this_thread::interruption_point();
+            vCoins.push_back(std::make_pair(uint256(), CCoins()));
+            filein >> vCoins.back().first >> vCoins.back().second;
+            if (vCoins.size() == UTXO_SNAPSHOT_BATCH_SIZE || i + 1 == header.nTransactions) {
+                if (!view.WriteCoins(vCoins))
+                    return error("LoadUtxoSnapshot() : failed to write coins");
+                vCoins.clear();
+            }
+        }
+
+        //ticoin The blocks themselves are never downloaded: index them like pruned blocks
+        std::vector<CDiskBlockIndex> vDiskIndex;
+        vDiskIndex.reserve(std::min((size_t)UTXO_SNAPSHOT_BATCH_SIZE, vIndex.size()));
+        for (unsigned int i = 0; i < vIndex.size(); i++) {
+            vDiskIndex.push_back(CDiskBlockIndex(&vIndex[i]));
+            if (vDiskIndex.size() == UTXO_SNAPSHOT_BATCH_SIZE || i + 1 == vIndex.size()) {
+                if (!pblocktree->WriteBlockIndex(vDiskIndex))
+                    return error("LoadUtxoSnapshot() : failed to write block index");
+                vDiskIndex.clear();
+            }
+        }
+        if (!pblocktree->WriteFlag("utxosnapshot", true) || !pblocktree->Sync())
+            return error("LoadUtxoSnapshot() : failed to write block index");
+
+        //ticoin Setting the best block commits the snapshot; until then the chain state still counts as empty
+        if (!view.SetBestBlock(header.hashBlock))
+            return error("LoadUtxoSnapshot() : failed to write best block");
+
+        LogPrintf("Loaded UTXO snapshot at height %d (%u transactions, hash %s) in %dms\n",
+            header.nHeight, stats.nTransactions, hashSerialized.ToString(), GetTimeMillis() - nStart);
+    } catch (std::exception &e) {
+        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    return true;
+}
+
 
 
 
@@ -3294,13 +4118,13 @@ void static ProcessGetData(CNode* pfrom)
             if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK)
             {
                 bool send = false;
-                map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.find(inv.hash);
-                if (mi != mapBlockIndex.end())
+                BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
+                if (mi != mapBlockIndex.end() && (mi->second->nStatus & BLOCK_HAVE_DATA))
                 {
                     //ticoin If the requested block is at a height below our last
                     //ticoin checkpoint, only serve it if it's in the checkpointed chain
                     int nHeight = mi->second->nHeight;
-                    CBlockIndex* pcheckpoint = Checkpoints::GetLastCheckpoint(mapBlockIndex);
+                    CBlockIndex* pcheckpoint = Checkpoints::GetLastCheckpoint();
                     if (pcheckpoint && nHeight < pcheckpoint->nHeight) {
                         if (!chainActive.Contains(mi->second))
                         {
@@ -3314,11 +4138,16 @@ void static ProcessGetData(CNode* pfrom)
                 }
                 if (send)
                 {
-                    //ticoin Send block from disk
-                    CBlock block;
-                    ReadBlockFromDisk(block, (*mi).second);
-                    if (inv.type == MSG_BLOCK)
-                        pfrom->PushMessage("block", block);
+                    //ticoin Send block from disk. Full blocks are relayed byte for byte without
+                    //ticoin deserializing them; filtered blocks only parse a view over the bytes.
+                    std::vector<unsigned char> vchBlock;
+                    CBlockView block;
+                    if (!ReadRawBlockFromDisk(vchBlock, (*mi).second))
+                        LogPrintf("ProcessGetData(): failed to read block %s\n", inv.hash.ToString());
+                    else if (inv.type == MSG_BLOCK)
+                        pfrom->PushMessage("block", CFlatData(&vchBlock[0], &vchBlock[0] + vchBlock.size()));
+                    else if (!block.Parse(&vchBlock[0], &vchBlock[0] + vchBlock.size()))
+                        LogPrintf("ProcessGetData(): failed to parse block %s\n", inv.hash.ToString());
                     else //ticoin MSG_FILTERED_BLOCK)
                     {
                         LOCK(pfrom->cs_filter);
@@ -3403,7 +4232,7 @@ void static ProcessGetData(CNode* pfrom)
     }
 }
 
-bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv)
+bool static ProcessMessage(CNode* pfrom, string strCommand, CNetDataStream& vRecv)
 {
     RandAddSeedPerfmon();
     LogPrint("net", "received: %s (%u bytes)\n", SanitizeString(strCommand), vRecv.size());
@@ -3694,6 +4523,11 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv)
                 LogPrint("net", "  getblocks stopping at %d %s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
                 break;
             }
+            if (fHavePruned && !(pindex->nStatus & BLOCK_HAVE_DATA))
+            {
+                LogPrint("net", "  getblocks stopping at pruned block %d %s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
+                break;
+            }
             pfrom->PushInventory(CInv(MSG_BLOCK, pindex->GetBlockHash()));
             if (--nLimit <= 0)
             {
@@ -3719,7 +4553,7 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv)
         if (locator.IsNull())
         {
             //ticoin If locator is null, return the hashStop block
-            map<uint256, CBlockIndex*>::iterator mi = mapBlockIndex.find(hashStop);
+            BlockMap::iterator mi = mapBlockIndex.find(hashStop);
             if (mi == mapBlockIndex.end())
                 return true;
             pindex = (*mi).second;
@@ -4097,6 +4931,33 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv)
     return true;
 }
 
+//ticoin The commands ProcessMessage handles. Peers may send any command, so only these
+//ticoin get their own time series; the rest share "other".
+static const char* pszKnownCommands[] = {
+    "version", "verack", "addr", "inv", "getdata", "getblocks", "getheaders", "tx", "block",
+    "getaddr", "mempool", "ping", "pong", "alert", "filterload", "filteradd", "filterclear", "reject"
+};
+
+static std::vector<CMetricHistogram*> GetMessageHistograms()
+{
+    std::vector<CMetricHistogram*> vHistograms;
+    for (unsigned int i = 0; i <= ARRAYLEN(pszKnownCommands); i++)
+        vHistograms.push_back(&metrics.Histogram("ticoin_message_seconds", "Time to process a received message",
+                                                 "command", i < ARRAYLEN(pszKnownCommands) ? pszKnownCommands[i] : "other"));
+    return vHistograms;
+}
+
+//ticoin The processing time histogram for strCommand. The histograms are looked up
+//ticoin once, instead of in the registry for every message.
+static CMetricHistogram& MessageHistogram(const string& strCommand)
+{
+    static const std::vector<CMetricHistogram*> vHistograms = GetMessageHistograms();
+    unsigned int i = 0;
+    while (i < ARRAYLEN(pszKnownCommands) && strCommand != pszKnownCommands[i])
+        i++;
+    return *vHistograms[i];
+}
+
 //ticoin requires LOCK(cs_vRecvMsg)
 bool ProcessMessages(CNode* pfrom)
 {
@@ -4160,7 +5021,7 @@ bool ProcessMessages(CNode* pfrom)
         unsigned int nMessageSize = hdr.nMessageSize;
 
         //ticoin Checksum
-        CDataStream& vRecv = msg.vRecv;
+        CNetDataStream& vRecv = msg.vRecv;
         uint256 hash = Hash(vRecv.begin(), vRecv.begin() + nMessageSize);
         unsigned int nChecksum = 0;
         memcpy(&nChecksum, &hash, sizeof(nChecksum));
@@ -4175,6 +5036,7 @@ bool ProcessMessages(CNode* pfrom)
         bool fRet = false;
         try
         {
+            CMetricTimer timer(MessageHistogram(strCommand));
             fRet = ProcessMessage(pfrom, strCommand, vRecv);
             boost::this_thread::interruption_point();
         }
@@ -4453,10 +5315,10 @@ public:
     CMainCleanup() {}
     ~CMainCleanup() {
         //ticoin block headers
-        std::map<uint256, CBlockIndex*>::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
         mapBlockIndex.clear();
+        BOOST_FOREACH(CBlockIndex* pslab, vBlockIndexSlabs)
+            delete[] pslab;
+        vBlockIndexSlabs.clear();
 
         //ticoin orphan blocks
         std::map<uint256, COrphanBlock*>::iterator it2 = mapOrphanBlocks.begin();
@@ -10,6 +10,7 @@
 #include "ticoin-config.h"
 #endif
 
+#include "arith_uint256.h"
 #include "bignum.h"
 #include "chainparams.h"
 #include "coins.h"
@@ -29,7 +30,11 @@
 #include <utility>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
 class CBlockIndex;
+class CBlockView;
 class CBloomFilter;
 class CInv;
 
@@ -54,6 +59,14 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; //ticoin 128 MiB
 static const unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; //ticoin 16 MiB
 /** The pre-allocation chunk size for rev?????.dat files (since 0.8) */
 static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; //ticoin 1 MiB
+//ticoin Block files holding any of the last MIN_BLOCKS_TO_KEEP blocks of the active chain are never pruned
+static const unsigned int MIN_BLOCKS_TO_KEEP = 288;
+//ticoin Smallest -prune target: MIN_BLOCKS_TO_KEEP blocks with undo data, plus a block and undo file being filled
+static const uint64_t MIN_DISK_SPACE_FOR_BLOCK_FILES = 550 * 1024 * 1024;
+/** Version of the file format written by dumptxoutset */
+static const int UTXO_SNAPSHOT_VERSION = 1;
+/** Number of transactions written to the coin database per batch when loading a UTXO snapshot */
+static const unsigned int UTXO_SNAPSHOT_BATCH_SIZE = 50000;
 /** Coinbase transaction outputs can only be spent after this number of new blocks (network rule) */
 static const int COINBASE_MATURITY = 100;
 /** Threshold for nLockTime: below this value it is interpreted as block number, otherwise as UNIX timestamp. */
@@ -87,7 +100,13 @@ static const unsigned char REJECT_CHECKPOINT = 0x43;
 extern CScript COINBASE_FLAGS;
 extern CCriticalSection cs_main;
 extern CTxMemPool mempool;
-extern std::map<uint256, CBlockIndex*> mapBlockIndex;
+struct BlockHasher
+{
+    //ticoin Block hashes are uniformly distributed in their low bits, so they are their own hash
+    size_t operator()(const uint256& hash) const { return hash.GetLow64(); }
+};
+typedef boost::unordered_map<uint256, CBlockIndex*, BlockHasher> BlockMap;
+extern BlockMap mapBlockIndex;
 extern uint64_t nLastBlockTx;
 extern uint64_t nLastBlockSize;
 extern const std::string strMessageMagic;
@@ -97,6 +116,11 @@ extern bool fReindex;
 extern bool fBenchmark;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+extern bool fAddressIndex;
+extern bool fPruneMode;
+extern bool fHavePruned;
+extern bool fSnapshotChainstate;
+extern uint64_t nPruneTarget;
 extern unsigned int nCoinCacheSize;
 
 //ticoin Minimum disk space required - used in CheckDiskSpace()
@@ -104,11 +128,13 @@ static const uint64_t nMinDiskSpace = 52428800;
 
 
 class CCoinsDB;
+class CCoinsViewDB;
 class CBlockTreeDB;
 struct CDiskBlockPos;
 class CTxUndo;
 class CScriptCheck;
 class CValidationState;
+class CIndexInterface;
 class CWalletInterface;
 struct CNodeStateStats;
 
@@ -122,6 +148,10 @@ void UnregisterWallet(CWalletInterface* pwalletIn);
 void UnregisterAllWallets();
 /** Push an updated transaction to all registered wallets */
 void SyncWithWallets(const uint256 &hash, const CTransaction& tx, const CBlock* pblock = NULL);
+/** Register an index to be told about blocks connected to and disconnected from the active chain */
+void RegisterIndex(CIndexInterface* pindexIn);
+/** Unregister an index from core */
+void UnregisterIndex(CIndexInterface* pindexIn);
 
 /** Register with a network node to receive its signals */
 void RegisterNodeSignals(CNodeSignals& nodeSignals);
@@ -134,20 +164,36 @@ void PushGetBlocks(CNode* pnode, CBlockIndex* pindexBegin, uint256 hashEnd);
 bool ProcessBlock(CValidationState &state, CNode* pfrom, CBlock* pblock, CDiskBlockPos *dbp = NULL);
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
+/** Path of the block (prefix "blk") or undo (prefix "rev") file holding pos */
+boost::filesystem::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix);
 /** Open a block file (blk?????.dat) */
 FILE* OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 /** Open an undo file (rev?????.dat) */
 FILE* OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 /** Import blocks from an external file */
 bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp = NULL);
+/** Rebuild the block index from the block files on disk (-reindex). All files are scanned for
+ *  headers in parallel first; blocks are then read back from their positions and connected
+ *  in chain order. */
+bool ReindexBlockFiles();
+/** Write the UTXO set at the current tip to a snapshot file; stats receives its totals and hash */
+bool DumpUtxoSnapshot(const boost::filesystem::path &path, CCoinsStats &stats);
+/** Bootstrap an empty chain state and block index from a snapshot file, provided its hash_serialized equals hashExpected */
+bool LoadUtxoSnapshot(CCoinsViewDB &view, const boost::filesystem::path &path, const uint256 &hashExpected);
 /** Initialize a new block tree database + block data on disk */
 bool InitBlockIndex();
 /** Load the block tree and coins database from disk */
 bool LoadBlockIndex();
 /** Unload database information */
 void UnloadBlockIndex();
+/** Read the last block file and, with -prune, the combined size of all block and undo files from the block tree database */
+void LoadBlockFileInfo();
+/** Delete the oldest block and undo files until they fit the -prune target again. Public only for unit testing */
+bool PruneBlockFiles(CValidationState &state);
 /** Verify consistency of the block and coin databases */
 bool VerifyDB(int nCheckLevel, int nCheckDepth);
+/** Whether block data is on disk for every block of the active chain from pindex up to the tip */
+bool HaveBlockDataFrom(const CBlockIndex* pindex);
 /** Print the loaded block tree */
 void PrintBlockTree();
 /** Process protocol messages received from a given node */
@@ -156,6 +202,8 @@ bool ProcessMessages(CNode* pfrom);
 bool SendMessages(CNode* pto, bool fSendTrickle);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Copy chain state, coins cache, memory pool and script check figures into the metrics registry */
+void CollectMainMetrics();
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits);
 /** Calculate the minimum amount of work a received block needs, without knowing its direct parent */
@@ -166,6 +214,8 @@ bool IsInitialBlockDownload();
 std::string GetWarnings(std::string strFor);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256 &hash, CTransaction &tx, uint256 &hashBlock, bool fAllowSlow = false);
+/** Map a destination to the type and hash it is stored under in the address index */
+bool GetAddressIndexHash(const CTxDestination &dest, unsigned char &nType, uint160 &hashBytes);
 /** Find the best known block, and make it the tip of the block chain */
 bool ActivateBestChain(CValidationState &state);
 int64_t GetBlockValue(int nHeight, int64_t nFees);
@@ -200,6 +250,30 @@ struct CNodeStateStats {
     int nMisbehavior;
 };
 
+//ticoin Totals over the blocks connected to the active chain, for replay benchmarks.
+//ticoin Times are in microseconds. Protected by cs_main.
+struct CValidationStats {
+    uint64_t nBlocks;
+    uint64_t nTransactions;
+    uint64_t nInputs;
+    int64_t nTimeReadBlock;  //ticoin reading the block back from disk
+    int64_t nTimeConnect;    //ticoin checking transactions and updating coins
+    int64_t nTimeVerify;     //ticoin waiting for the script checks
+    int64_t nTimeWriteIndex; //ticoin writing undo data and the block and transaction indexes
+    int64_t nTimeFlushView;  //ticoin flushing the block's view into the coins cache
+    int64_t nTimeFlushDisk;  //ticoin flushing the coins cache and block files to disk
+    uint64_t nFlushes;
+
+    CValidationStats() { SetNull(); }
+
+    void SetNull()
+    {
+        nBlocks = nTransactions = nInputs = nFlushes = 0;
+        nTimeReadBlock = nTimeConnect = nTimeVerify = nTimeWriteIndex = nTimeFlushView = nTimeFlushDisk = 0;
+    }
+};
+extern CValidationStats validationStats;
+
 struct CDiskBlockPos
 {
     int nFile;
@@ -404,12 +478,14 @@ private:
     unsigned int nIn;
     unsigned int nFlags;
     int nHashType;
+    boost::shared_ptr<const CSigHashContext> psighash; //ticoin shared by the checks of all inputs of ptxTo
 
 public:
     CScriptCheck() {}
-    CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, int nHashTypeIn) :
+    CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, int nHashTypeIn,
+                 const boost::shared_ptr<const CSigHashContext>& psighashIn = boost::shared_ptr<const CSigHashContext>()) :
         scriptPubKey(txFromIn.vout[txToIn.vin[nInIn].prevout.n].scriptPubKey),
-        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), nHashType(nHashTypeIn) { }
+        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), nHashType(nHashTypeIn), psighash(psighashIn) { }
 
     bool operator()() const;
 
@@ -419,6 +495,7 @@ public:
         std::swap(nIn, check.nIn);
         std::swap(nFlags, check.nFlags);
         std::swap(nHashType, check.nHashType);
+        psighash.swap(check.psighash);
     }
 };
 
@@ -584,6 +661,8 @@ public:
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+/** Read the serialized bytes of a block, checking only that its header matches pindex */
+bool ReadRawBlockFromDisk(std::vector<unsigned char>& vchBlock, const CBlockIndex* pindex);
 
 
 /** Functions for validating blocks and updating the block tree */
@@ -662,6 +741,41 @@ public:
      }
 };
 
+/** Header of a UTXO snapshot file. It is followed by the block headers (each with its
+ *  transaction count) from the genesis block up to hashBlock, nTransactions (txid, CCoins)
+ *  records in coin database order, and finally their hash_serialized as reported by
+ *  gettxoutsetinfo.
+ */
+class CUtxoSnapshotHeader
+{
+public:
+    unsigned char pchMagic[4];
+    int nVersion;
+    uint256 hashBlock;
+    int nHeight;
+    uint64_t nTransactions;
+
+    CUtxoSnapshotHeader() {
+        memcpy(pchMagic, "utxo", sizeof(pchMagic));
+        nVersion = UTXO_SNAPSHOT_VERSION;
+        hashBlock = 0;
+        nHeight = 0;
+        nTransactions = 0;
+    }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(FLATDATA(pchMagic));
+        READWRITE(this->nVersion);
+        READWRITE(hashBlock);
+        READWRITE(nHeight);
+        READWRITE(nTransactions);
+    )
+
+    bool IsValid() const {
+        return memcmp(pchMagic, "utxo", sizeof(pchMagic)) == 0 && nVersion == UTXO_SNAPSHOT_VERSION && nHeight >= 0;
+    }
+};
+
 enum BlockStatus {
     BLOCK_VALID_UNKNOWN      =    0,
     BLOCK_VALID_HEADER       =    1, //ticoin parsed, version ok, hash satisfies claimed PoW, 1 <= vtx count <= max, timestamp not in future
@@ -812,13 +926,19 @@ public:
         return (int64_t)nTime;
     }
 
-    CBigNum GetBlockWork() const
+    uint256 GetBlockWork() const
     {
-        CBigNum bnTarget;
-        bnTarget.SetCompact(nBits);
-        if (bnTarget <= 0)
+        arith_uint256 bnTarget;
+        bool fNegative;
+        bool fOverflow;
+        bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+        if (fNegative || fOverflow || bnTarget == 0)
             return 0;
-        return (CBigNum(1)<<256) / (bnTarget+1);
+        //ticoin We need to compute 2**256 / (bnTarget+1), but we can't represent 2**256
+        //ticoin as it's too large for an arith_uint256. However, as 2**256 is at least as large
+        //ticoin as bnTarget+1, it is equal to ((2**256 - bnTarget - 1) / (bnTarget+1)) + 1,
+        //ticoin or ~bnTarget / (bnTarget+1) + 1.
+        return ArithToUint256((~bnTarget / (bnTarget + 1)) + 1);
     }
 
     bool CheckIndex() const
@@ -1063,6 +1183,9 @@ extern CChain chainMostWork;
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern CCoinsViewCache *pcoinsTip;
 
+/** Global variable that points to the coin database underneath pcoinsTip (protected by cs_main) */
+extern CCoinsViewDB *pcoinsdbview;
+
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern CBlockTreeDB *pblocktree;
 
@@ -1097,6 +1220,7 @@ public:
     //ticoin Note that this will call IsRelevantAndUpdate on the filter for each transaction,
     //ticoin thus the filter will likely be modified.
     CMerkleBlock(const CBlock& block, CBloomFilter& filter);
+    CMerkleBlock(const CBlockView& block, CBloomFilter& filter);
 
     IMPLEMENT_SERIALIZE
     (
@@ -1119,4 +1243,16 @@ protected:
     friend void ::UnregisterAllWallets();
 };
 
+/** Interface of indexes that follow the active chain. Both are called with cs_main
+ *  held, after chainActive was updated. */
+class CIndexInterface {
+public:
+    virtual ~CIndexInterface() {}
+protected:
+    virtual void BlockConnected(const CBlock &block, const CBlockIndex *pindex) =0;
+    virtual void BlockDisconnected(const CBlock &block, const CBlockIndex *pindex) =0;
+    friend void ::RegisterIndex(CIndexInterface*);
+    friend void ::UnregisterIndex(CIndexInterface*);
+};
+
 #endif
@@ -0,0 +1,232 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "metrics.h"
+
+#include "util.h"
+
+#include <assert.h>
+
+#include <boost/foreach.hpp>
+
+using namespace std;
+
+CMetricsRegistry metrics;
+
+/**-5-10Upper bounds of the histogram buckets, in seconds
+static const double HISTOGRAM_BOUNDS[] = { 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10 };
+static const unsigned int HISTOGRAM_BUCKETS = sizeof(HISTOGRAM_BOUNDS) / sizeof(HISTOGRAM_BOUNDS[0]);
+
+static string FormatValue(double d)
+{
+    return strprintf("%.15g", d);
+}
+
+/**-5-10name{labels} value, where labels are optional
+static void RenderSample(string& strOut, const string& strName, const string& strLabels, const string& strValue)
+{
+    strOut += strName;
+    if (!strLabels.empty())
+        strOut += "{" + strLabels + "}";
+    strOut += " " + strValue + "\n";
+}
+
+void CMetricCounter::Inc(double d)
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    dValue += d;
+}
+
+void CMetricCounter::Set(double d)
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    dValue = d;
+}
+
+double CMetricCounter::Get() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    return dValue;
+}
+
+void CMetricCounter::Render(string& strOut, const string& strName, const string& strLabels) const
+{
+    RenderSample(strOut, strName, strLabels, FormatValue(Get()));
+}
+
+void CMetricGauge::Set(double d)
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    dValue = d;
+}
+
+void CMetricGauge::Add(double d)
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    dValue += d;
+}
+
+double CMetricGauge::Get() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    return dValue;
+}
+
+void CMetricGauge::Render(string& strOut, const string& strName, const string& strLabels) const
+{
+    RenderSample(strOut, strName, strLabels, FormatValue(Get()));
+}
+
+CMetricHistogram::CMetricHistogram() : vCounts(HISTOGRAM_BUCKETS + 1, 0), dSum(0), nCount(0)
+{
+}
+
+void CMetricHistogram::Observe(double dSeconds)
+{
+    unsigned int nBucket = 0;
+    while (nBucket < HISTOGRAM_BUCKETS && dSeconds > HISTOGRAM_BOUNDS[nBucket])
+        nBucket++;
+    boost::lock_guard<boost::mutex> lock(mutex);
+    vCounts[nBucket]++;
+    dSum += dSeconds;
+    nCount++;
+}
+
+uint64_t CMetricHistogram::GetCount() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    return nCount;
+}
+
+void CMetricHistogram::Render(string& strOut, const string& strName, const string& strLabels) const
+{
+    vector<uint64_t> vCountsCopy;
+    double dSumCopy;
+    uint64_t nCountCopy;
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        vCountsCopy = vCounts;
+        dSumCopy = dSum;
+        nCountCopy = nCount;
+    }
+
+    /**-5-10Prometheus buckets are cumulative
+    string strPrefix = strLabels.empty() ? "" : strLabels + ",";
+    uint64_t nCumulative = 0;
+    for (unsigned int i = 0; i <= HISTOGRAM_BUCKETS; i++) {
+        nCumulative += vCountsCopy[i];
+        string strBound = i < HISTOGRAM_BUCKETS ? FormatValue(HISTOGRAM_BOUNDS[i]) : "+Inf";
+        RenderSample(strOut, strName + "_bucket", strPrefix + "le=\"" + strBound + "\"", strprintf("%u", nCumulative));
+    }
+    RenderSample(strOut, strName + "_sum", strLabels, FormatValue(dSumCopy));
+    RenderSample(strOut, strName + "_count", strLabels, strprintf("%u", nCountCopy));
+}
+
+CMetricTimer::CMetricTimer(CMetricHistogram& histogramIn) : histogram(histogramIn), nStart(GetTimeMicros())
+{
+}
+
+CMetricTimer::~CMetricTimer()
+{
+    histogram.Observe((GetTimeMicros() - nStart) * 0.000001);
+}
+
+/**-5-10Label values may hold anything; backslash, double quote and newline must be escaped
+static string EscapeLabelValue(const string& str)
+{
+    string strRet;
+    BOOST_FOREACH(char c, str) {
+        if (c == '\\')
+            strRet += "\\\\";
+        else if (c == '"')
+            strRet += "\\\"";
+        else if (c == '\n')
+            strRet += "\\n";
+        else
+            strRet += c;
+    }
+    return strRet;
+}
+
+CMetricsRegistry::~CMetricsRegistry()
+{
+    for (map<string, CMetricFamily>::iterator it = mapFamilies.begin(); it != mapFamilies.end(); it++)
+        for (map<string, CMetric*>::iterator mi = it->second.mapSeries.begin(); mi != it->second.mapSeries.end(); mi++)
+            delete mi->second;
+}
+
+CMetric& CMetricsRegistry::Get(MetricType type, const string& strName, const string& strHelp,
+                               const string& strLabel, const string& strValue)
+{
+    string strLabels = strLabel.empty() ? "" : strLabel + "=\"" + EscapeLabelValue(strValue) + "\"";
+
+    boost::lock_guard<boost::mutex> lock(mutex);
+    map<string, CMetricFamily>::iterator it = mapFamilies.find(strName);
+    if (it == mapFamilies.end()) {
+        it = mapFamilies.insert(make_pair(strName, CMetricFamily())).first;
+        it->second.type = type;
+        it->second.strHelp = strHelp;
+    }
+    /**-5-10A name always refers to the same kind of metric
+    assert(it->second.type == type);
+
+    CMetric*& pmetric = it->second.mapSeries[strLabels];
+    if (pmetric == NULL) {
+        if (type == METRIC_COUNTER)
+            pmetric = new CMetricCounter();
+        else if (type == METRIC_GAUGE)
+            pmetric = new CMetricGauge();
+        else
+            pmetric = new CMetricHistogram();
+    }
+    return *pmetric;
+}
+
+CMetricCounter& CMetricsRegistry::Counter(const string& strName, const string& strHelp,
+                                          const string& strLabel, const string& strValue)
+{
+    return static_cast<CMetricCounter&>(Get(METRIC_COUNTER, strName, strHelp, strLabel, strValue));
+}
+
+CMetricGauge& CMetricsRegistry::Gauge(const string& strName, const string& strHelp,
+                                      const string& strLabel, const string& strValue)
+{
+    return static_cast<CMetricGauge&>(Get(METRIC_GAUGE, strName, strHelp, strLabel, strValue));
+}
+
+CMetricHistogram& CMetricsRegistry::Histogram(const string& strName, const string& strHelp,
+                                              const string& strLabel, const string& strValue)
+{
+    return static_cast<CMetricHistogram&>(Get(METRIC_HISTOGRAM, strName, strHelp, strLabel, strValue));
+}
+
+void CMetricsRegistry::AddCollector(collector_type collector)
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+    vCollectors.push_back(collector);
+}
+
+string CMetricsRegistry::Render()
+{
+    /**-5-10Collectors look up metrics themselves, so they run without the registry lock
+    vector<collector_type> vCollectorsCopy;
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        vCollectorsCopy = vCollectors;
+    }
+    BOOST_FOREACH(collector_type collector, vCollectorsCopy)
+        collector();
+
+    static const char* pszTypes[] = { "counter", "gauge", "histogram" };
+    string strOut;
+    boost::lock_guard<boost::mutex> lock(mutex);
+    for (map<string, CMetricFamily>::const_iterator it = mapFamilies.begin(); it != mapFamilies.end(); it++) {
+        const CMetricFamily& family = it->second;
+        strOut += "# HELP " + it->first + " " + family.strHelp + "\n";
+        strOut += "# TYPE " + it->first + " " + pszTypes[family.type] + "\n";
+        for (map<string, CMetric*>::const_iterator mi = family.mapSeries.begin(); mi != family.mapSeries.end(); mi++)
+            mi->second->Render(strOut, it->first, mi->first);
+    }
+    return strOut;
+}
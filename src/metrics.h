@@ -0,0 +1,141 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#ifndef ticoin_METRICS_H
+#define ticoin_METRICS_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/thread/mutex.hpp>
+
+/** A single time series. Every metric has its own mutex, so that updates to
+ * different metrics never contend with each other, and an update is one
+ * uncontended lock in the common case.
+ */
+class CMetric
+{
+protected:
+    mutable boost::mutex mutex;
+
+public:
+    virtual ~CMetric() {}
+
+    /** Append this metric in the Prometheus text format. strLabels holds the
+     *  series' labels (name="value" pairs separated by commas), or is empty. */
+    virtual void Render(std::string& strOut, const std::string& strName, const std::string& strLabels) const = 0;
+};
+
+/** Total since startup, of events or of seconds spent. It only goes up. */
+class CMetricCounter : public CMetric
+{
+private:
+    double dValue;
+
+public:
+    CMetricCounter() : dValue(0) {}
+
+    void Inc(double d = 1);
+    /** For totals that are kept elsewhere and copied in by a collector */
+    void Set(double d);
+    double Get() const;
+
+    void Render(std::string& strOut, const std::string& strName, const std::string& strLabels) const;
+};
+
+/** Current value of something that goes up and down. */
+class CMetricGauge : public CMetric
+{
+private:
+    double dValue;
+
+public:
+    CMetricGauge() : dValue(0) {}
+
+    void Set(double d);
+    void Add(double d);
+    double Get() const;
+
+    void Render(std::string& strOut, const std::string& strName, const std::string& strLabels) const;
+};
+
+/** Distribution of durations in seconds, counted into fixed buckets that
+ *  range from 100us to 10s. */
+class CMetricHistogram : public CMetric
+{
+private:
+    std::vector<uint64_t> vCounts; /**-5-10per bucket, not cumulative; the last one is +Inf
+    double dSum;
+    uint64_t nCount;
+
+public:
+    CMetricHistogram();
+
+    void Observe(double dSeconds);
+    uint64_t GetCount() const;
+
+    void Render(std::string& strOut, const std::string& strName, const std::string& strLabels) const;
+};
+
+/** Records the lifetime of the object in a histogram. */
+class CMetricTimer
+{
+private:
+    CMetricHistogram& histogram;
+    int64_t nStart;
+
+public:
+    explicit CMetricTimer(CMetricHistogram& histogramIn);
+    ~CMetricTimer();
+};
+
+/** Set of all metrics, by name and label. Metrics are created on first use
+ *  and live until shutdown, so references to them can be kept, for example
+ *  in function-local statics, to skip the lookup on later updates.
+ */
+class CMetricsRegistry
+{
+public:
+    /** Called before every export, to copy in values that are kept elsewhere */
+    typedef void (*collector_type)();
+
+private:
+    enum MetricType { METRIC_COUNTER, METRIC_GAUGE, METRIC_HISTOGRAM };
+
+    struct CMetricFamily
+    {
+        MetricType type;
+        std::string strHelp;
+        std::map<std::string, CMetric*> mapSeries; /**-5-10by rendered labels
+    };
+
+    boost::mutex mutex;
+    std::map<std::string, CMetricFamily> mapFamilies;
+    std::vector<collector_type> vCollectors;
+
+    CMetric& Get(MetricType type, const std::string& strName, const std::string& strHelp,
+                 const std::string& strLabel, const std::string& strValue);
+
+public:
+    ~CMetricsRegistry();
+
+    /** Look up or create a metric. A metric may carry one label, for example
+     *  Histogram("ticoin_message_seconds", "...", "command", "inv"). */
+    CMetricCounter& Counter(const std::string& strName, const std::string& strHelp,
+                            const std::string& strLabel = "", const std::string& strValue = "");
+    CMetricGauge& Gauge(const std::string& strName, const std::string& strHelp,
+                        const std::string& strLabel = "", const std::string& strValue = "");
+    CMetricHistogram& Histogram(const std::string& strName, const std::string& strHelp,
+                                const std::string& strLabel = "", const std::string& strValue = "");
+
+    void AddCollector(collector_type collector);
+
+    /** Run the collectors and return all metrics in the Prometheus text exposition format */
+    std::string Render();
+};
+
+extern CMetricsRegistry metrics;
+
+#endif /**-5-10ticoin_METRICS_H
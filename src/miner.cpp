@@ -11,6 +11,9 @@
 #ifdef ENABLE_WALLET
 #include "wallet.h"
 #endif
+
+#include <boost/shared_ptr.hpp>
+
 //////////////////////////////////////////////////////////////////////////////
 //
 //ticoin ticoinMiner
@@ -354,6 +357,11 @@ void IncrementExtraNonce(CBlock* pblock, CBlockIndex* pindexPrev, unsigned int&
         hashPrevBlock = pblock->hashPrevBlock;
     }
     ++nExtraNonce;
+    SetExtraNonce(pblock, pindexPrev, nExtraNonce);
+}
+
+void SetExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int nExtraNonce)
+{
     unsigned int nHeight = pindexPrev->nHeight+1; //ticoin Height first in coinbase required for block.version=2
     pblock->vtx[0].vin[0].scriptSig = (CScript() << nHeight << CScriptNum(nExtraNonce)) + COINBASE_FLAGS;
     assert(pblock->vtx[0].vin[0].scriptSig.size() <= 100);
@@ -407,6 +415,140 @@ void FormatHashBuffers(CBlock* pblock, char* pmidstate, char* pdata, char* phash
     memcpy(phash1, &tmp.hash1, 64);
 }
 
+//
+//ticoin Multi-nonce SHA-256 kernel of the internal miner. Every step is a loop over
+//ticoin MINER_LANES independent hashes, which the compiler turns into SIMD code where
+//ticoin the target has it.
+//
+
+static const uint32_t pSHA256K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t SHA256Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+static inline uint32_t SHA256Ch(uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); }
+static inline uint32_t SHA256Maj(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (z & (x | y)); }
+static inline uint32_t SHA256Sigma0(uint32_t x) { return SHA256Rotr(x, 2) ^ SHA256Rotr(x, 13) ^ SHA256Rotr(x, 22); }
+static inline uint32_t SHA256Sigma1(uint32_t x) { return SHA256Rotr(x, 6) ^ SHA256Rotr(x, 11) ^ SHA256Rotr(x, 25); }
+static inline uint32_t SHA256sigma0(uint32_t x) { return SHA256Rotr(x, 7) ^ SHA256Rotr(x, 18) ^ (x >> 3); }
+static inline uint32_t SHA256sigma1(uint32_t x) { return SHA256Rotr(x, 17) ^ SHA256Rotr(x, 19) ^ (x >> 10); }
+
+static inline uint32_t ReadBE32(const unsigned char* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+//ticoin Extend the message schedule w of N hashes, whose first 16 words are set, up to word nEnd
+template <unsigned int N>
+static void SHA256Expand(uint32_t w[64][N], unsigned int nEnd)
+{
+    for (unsigned int r = 16; r < nEnd; r++)
+        for (unsigned int l = 0; l < N; l++)
+            w[r][l] = SHA256sigma1(w[r - 2][l]) + w[r - 7][l] + SHA256sigma0(w[r - 15][l]) + w[r - 16][l];
+}
+
+//ticoin Run the first nRounds rounds of SHA-256 on the working variables s of N hashes.
+//ticoin Instead of moving the variables along, each round of eight renames them.
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, i) \
+    if (r + i < nRounds) \
+        for (unsigned int l = 0; l < N; l++) \
+        { \
+            uint32_t t1 = s[h][l] + SHA256Sigma1(s[e][l]) + SHA256Ch(s[e][l], s[f][l], s[g][l]) + pSHA256K[r + i] + w[r + i][l]; \
+            uint32_t t2 = SHA256Sigma0(s[a][l]) + SHA256Maj(s[a][l], s[b][l], s[c][l]); \
+            s[d][l] += t1; \
+            s[h][l] = t1 + t2; \
+        }
+
+template <unsigned int N>
+static void SHA256Rounds(uint32_t s[8][N], uint32_t w[64][N], unsigned int nRounds)
+{
+    for (unsigned int r = 0; r < nRounds; r += 8)
+    {
+        SHA256_ROUND(0, 1, 2, 3, 4, 5, 6, 7, 0);
+        SHA256_ROUND(7, 0, 1, 2, 3, 4, 5, 6, 1);
+        SHA256_ROUND(6, 7, 0, 1, 2, 3, 4, 5, 2);
+        SHA256_ROUND(5, 6, 7, 0, 1, 2, 3, 4, 3);
+        SHA256_ROUND(4, 5, 6, 7, 0, 1, 2, 3, 4);
+        SHA256_ROUND(3, 4, 5, 6, 7, 0, 1, 2, 5);
+        SHA256_ROUND(2, 3, 4, 5, 6, 7, 0, 1, 6);
+        SHA256_ROUND(1, 2, 3, 4, 5, 6, 7, 0, 7);
+    }
+}
+
+#undef SHA256_ROUND
+
+void CMinerMidstate::Set(const CBlockHeader& header)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << header;
+    assert(ss.size() == 80);
+    const unsigned char* pheader = (const unsigned char*)&ss[0];
+
+    uint32_t w[64][1];
+    uint32_t s[8][1];
+    for (int i = 0; i < 16; i++)
+        w[i][0] = ReadBE32(pheader + 4 * i);
+    for (int i = 0; i < 8; i++)
+        s[i][0] = pSHA256InitState[i];
+    SHA256Expand<1>(w, 64);
+    SHA256Rounds<1>(s, w, 64);
+    for (int i = 0; i < 8; i++)
+        state[i] = pSHA256InitState[i] + s[i][0];
+    for (int i = 0; i < 3; i++)
+        tail[i] = ReadBE32(pheader + 64 + 4 * i);
+}
+
+void ScanNonces(const CMinerMidstate& midstate, uint32_t nNonce, uint32_t pHashHigh[MINER_LANES])
+{
+    uint32_t w[64][MINER_LANES];
+    uint32_t s[8][MINER_LANES];
+
+    //ticoin Second half of the header: the tail, the nonce, and padding to 80 bytes
+    for (unsigned int l = 0; l < MINER_LANES; l++)
+    {
+        w[0][l] = midstate.tail[0];
+        w[1][l] = midstate.tail[1];
+        w[2][l] = midstate.tail[2];
+        w[3][l] = ByteReverse(nNonce + l);
+        w[4][l] = 0x80000000;
+        for (int i = 5; i < 15; i++)
+            w[i][l] = 0;
+        w[15][l] = 80 * 8;
+        for (int i = 0; i < 8; i++)
+            s[i][l] = midstate.state[i];
+    }
+    SHA256Expand<MINER_LANES>(w, 64);
+    SHA256Rounds<MINER_LANES>(s, w, 64);
+
+    //ticoin Hash the 32-byte digest again
+    for (unsigned int l = 0; l < MINER_LANES; l++)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            w[i][l] = midstate.state[i] + s[i][l];
+            s[i][l] = pSHA256InitState[i];
+        }
+        w[8][l] = 0x80000000;
+        for (int i = 9; i < 15; i++)
+            w[i][l] = 0;
+        w[15][l] = 32 * 8;
+    }
+    //ticoin The last word of the digest is e after round 60; the last three rounds only
+    //ticoin move it along, so they are skipped. After round 60, e is held in s[7].
+    SHA256Expand<MINER_LANES>(w, 61);
+    SHA256Rounds<MINER_LANES>(s, w, 61);
+    for (unsigned int l = 0; l < MINER_LANES; l++)
+        pHashHigh[l] = ByteReverse(pSHA256InitState[7] + s[7][l]);
+}
+
 #ifdef ENABLE_WALLET
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -415,41 +557,35 @@ void FormatHashBuffers(CBlock* pblock, char* pmidstate, char* pdata, char* phash
 double dHashesPerSec = 0.0;
 int64_t nHPSTimerStart = 0;
 
-//
-//ticoin ScanHash scans nonces looking for a hash with at least some zero bits.
-//ticoin It operates on big endian data.  Caller does the byte reversing.
-//ticoin All input buffers are 16-byte aligned.  nNonce is usually preserved
-//ticoin between calls, but periodically or if nNonce is 0xffff0000 or above,
-//ticoin the block is rebuilt and nNonce starts over at zero.
-//
-unsigned int static ScanHash_CryptoPP(char* pmidstate, char* pdata, char* phash1, char* phash, unsigned int& nHashesDone)
+//ticoin Hash rate of each miner thread; dHashesPerSec is their sum
+static CCriticalSection cs_hashmeter;
+static std::vector<double> vThreadHashesPerSec;
+
+static void UpdateHashMeter(unsigned int nThread, double dThreadHashesPerSec)
 {
-    unsigned int& nNonce = *(unsigned int*)(pdata + 12);
-    for (;;)
+    LOCK(cs_hashmeter);
+    if (nThread >= vThreadHashesPerSec.size())
+        return;
+    vThreadHashesPerSec[nThread] = dThreadHashesPerSec;
+    dHashesPerSec = 0.0;
+    BOOST_FOREACH(double d, vThreadHashesPerSec)
+        dHashesPerSec += d;
+    nHPSTimerStart = GetTimeMillis();
+
+    static int64_t nLogTime;
+    if (GetTime() - nLogTime > 30 * 60)
     {
-        //ticoin Crypto++ SHA256
-        //ticoin Hash pdata using pmidstate as the starting state into
-        //ticoin pre-formatted buffer phash1, then hash phash1 into phash
-        nNonce++;
-        SHA256Transform(phash1, pdata, pmidstate);
-        SHA256Transform(phash, phash1, pSHA256InitState);
-
-        //ticoin Return the nonce if the hash has at least some zero bits,
-        //ticoin caller will check if it has enough to reach the target
-        if (((unsigned short*)phash)[14] == 0)
-            return nNonce;
-
-        //ticoin If nothing found after trying for a while, return -1
-        if ((nNonce & 0xffff) == 0)
-        {
-            nHashesDone = 0xffff+1;
-            return (unsigned int) -1;
-        }
-        if ((nNonce & 0xfff) == 0)
-            boost::this_thread::interruption_point();
+        nLogTime = GetTime();
+        LogPrintf("hashmeter %6.0f khash/s\n", dHashesPerSec/1000.0);
     }
 }
 
+void GetMinerHashRates(std::vector<double>& vRates)
+{
+    LOCK(cs_hashmeter);
+    vRates = vThreadHashesPerSec;
+}
+
 CBlockTemplate* CreateNewBlockWithKey(CReserveKey& reservekey)
 {
     CPubKey pubkey;
@@ -463,7 +599,7 @@ CBlockTemplate* CreateNewBlockWithKey(CReserveKey& reservekey)
 bool CheckWork(CBlock* pblock, CWallet& wallet, CReserveKey& reservekey)
 {
     uint256 hash = pblock->GetHash();
-    uint256 hashTarget = CBigNum().SetCompact(pblock->nBits).getuint256();
+    uint256 hashTarget = ArithToUint256(arith_uint256().SetCompact(pblock->nBits));
 
     if (hash > hashTarget)
         return false;
@@ -498,15 +634,43 @@ bool CheckWork(CBlock* pblock, CWallet& wallet, CReserveKey& reservekey)
     return true;
 }
 
-void static ticoinMiner(CWallet *pwallet)
+//ticoin Work shared by the miner threads: one block template, with a single coinbase key,
+//ticoin rebuilt by whichever thread first finds it stale. Thread i of n hashes the
+//ticoin extranonces i+1, i+1+n, i+1+2n, ... of each template, each over the whole
+//ticoin nonce range, so the threads never hash the same header.
+class CMinerWork
+{
+public:
+    CCriticalSection cs;
+    CReserveKey reservekey;
+    boost::shared_ptr<CBlockTemplate> ptemplate;
+    CBlockIndex* pindexPrev;
+    unsigned int nTransactionsUpdatedLast;
+    int64_t nStart;
+    //ticoin Incremented each time the template is replaced
+    unsigned int nGeneration;
+
+    CMinerWork(CWallet* pwallet) : reservekey(pwallet), pindexPrev(NULL), nTransactionsUpdatedLast(0), nStart(0), nGeneration(0) {}
+
+    //ticoin Whether the template should be rebuilt before hashing more of it
+    bool IsStale()
+    {
+        AssertLockHeld(cs);
+        return !ptemplate || pindexPrev != chainActive.Tip() ||
+               (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 60);
+    }
+};
+
+void static ticoinMiner(CWallet *pwallet, boost::shared_ptr<CMinerWork> pwork, unsigned int nThread, unsigned int nThreads)
 {
-    LogPrintf("ticoinMiner started\n");
+    LogPrintf("ticoinMiner %u started\n", nThread);
     SetThreadPriority(THREAD_PRIORITY_LOWEST);
     RenameThread("ticoin-miner");
 
-    //ticoin Each thread has its own key and counter
-    CReserveKey reservekey(pwallet);
+    unsigned int nGeneration = 0;
     unsigned int nExtraNonce = 0;
+    uint64_t nHashes = 0;
+    int64_t nMeterStart = GetTimeMillis();
 
     try { while (true) {
         if (Params().NetworkID() != CChainParams::REGTEST) {
@@ -517,129 +681,124 @@ void static ticoinMiner(CWallet *pwallet)
         }
 
         //
-        //ticoin Create new block
-        //
-        unsigned int nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrev = chainActive.Tip();
-
-        auto_ptr<CBlockTemplate> pblocktemplate(CreateNewBlockWithKey(reservekey));
-        if (!pblocktemplate.get())
-            return;
-        CBlock *pblock = &pblocktemplate->block;
-        IncrementExtraNonce(pblock, pindexPrev, nExtraNonce);
-
-        LogPrintf("Running ticoinMiner with %u transactions in block (%u bytes)\n", pblock->vtx.size(),
-               ::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION));
-
-        //
-        //ticoin Pre-build hash buffers
-        //
-        char pmidstatebuf[32+16]; char* pmidstate = alignup<16>(pmidstatebuf);
-        char pdatabuf[128+16];    char* pdata     = alignup<16>(pdatabuf);
-        char phash1buf[64+16];    char* phash1    = alignup<16>(phash1buf);
-
-        FormatHashBuffers(pblock, pmidstate, pdata, phash1);
-
-        unsigned int& nBlockTime = *(unsigned int*)(pdata + 64 + 4);
-        unsigned int& nBlockBits = *(unsigned int*)(pdata + 64 + 8);
-        unsigned int& nBlockNonce = *(unsigned int*)(pdata + 64 + 12);
-
-
-        //
-        //ticoin Search
+        //ticoin Take the next extranonce of the current template
         //
-        int64_t nStart = GetTime();
-        uint256 hashTarget = CBigNum().SetCompact(pblock->nBits).getuint256();
-        uint256 hashbuf[2];
-        uint256& hash = *alignup<16>(hashbuf);
-        while (true)
+        CBlock block;
+        CBlockIndex* pindexPrev;
         {
-            unsigned int nHashesDone = 0;
-            unsigned int nNonceFound;
-
-            //ticoin Crypto++ SHA256
-            nNonceFound = ScanHash_CryptoPP(pmidstate, pdata + 64, phash1,
-                                            (char*)&hash, nHashesDone);
-
-            //ticoin Check if something found
-            if (nNonceFound != (unsigned int) -1)
+            LOCK(pwork->cs);
+            if (pwork->IsStale())
             {
-                for (unsigned int i = 0; i < sizeof(hash)/4; i++)
-                    ((unsigned int*)&hash)[i] = ByteReverse(((unsigned int*)&hash)[i]);
-
-                if (hash <= hashTarget)
+                pwork->nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
+                pwork->pindexPrev = chainActive.Tip();
+                pwork->ptemplate.reset(CreateNewBlockWithKey(pwork->reservekey));
+                if (!pwork->ptemplate)
                 {
-                    //ticoin Found a solution
-                    pblock->nNonce = ByteReverse(nNonceFound);
-                    assert(hash == pblock->GetHash());
-
-                    SetThreadPriority(THREAD_PRIORITY_NORMAL);
-                    CheckWork(pblock, *pwallet, reservekey);
-                    SetThreadPriority(THREAD_PRIORITY_LOWEST);
-
-                    //ticoin In regression test mode, stop mining after a block is found. This
-                    //ticoin allows developers to controllably generate a block on demand.
-                    if (Params().NetworkID() == CChainParams::REGTEST)
-                        throw boost::thread_interrupted();
-
-                    break;
+                    LogPrintf("ticoinMiner : keypool ran out, please call keypoolrefill\n");
+                    return;
                 }
+                pwork->nStart = GetTime();
+                pwork->nGeneration++;
+                LogPrintf("Running ticoinMiner with %u transactions in block (%u bytes)\n", pwork->ptemplate->block.vtx.size(),
+                       ::GetSerializeSize(pwork->ptemplate->block, SER_NETWORK, PROTOCOL_VERSION));
             }
-
-            //ticoin Meter hashes/sec
-            static int64_t nHashCounter;
-            if (nHPSTimerStart == 0)
+            if (nGeneration != pwork->nGeneration)
             {
-                nHPSTimerStart = GetTimeMillis();
-                nHashCounter = 0;
+                nGeneration = pwork->nGeneration;
+                nExtraNonce = nThread + 1;
             }
             else
-                nHashCounter += nHashesDone;
-            if (GetTimeMillis() - nHPSTimerStart > 4000)
+                nExtraNonce += nThreads;
+            block = pwork->ptemplate->block;
+            pindexPrev = pwork->pindexPrev;
+        }
+        SetExtraNonce(&block, pindexPrev, nExtraNonce);
+
+        //
+        //ticoin Search
+        //
+        CMinerMidstate midstate;
+        midstate.Set(block);
+        uint256 hashTarget = ArithToUint256(arith_uint256().SetCompact(block.nBits));
+        uint32_t nTargetHigh = (uint32_t)(hashTarget >> 224).GetLow64();
+        uint32_t vHashHigh[MINER_LANES];
+        uint32_t nNonce = 0;
+        bool fFound = false;
+        while (!fFound)
+        {
+            for (unsigned int n = 0; n < 0x10000 && !fFound; n += MINER_LANES, nNonce += MINER_LANES)
             {
-                static CCriticalSection cs;
+                ScanNonces(midstate, nNonce, vHashHigh);
+                for (unsigned int l = 0; l < MINER_LANES; l++)
                 {
-                    LOCK(cs);
-                    if (GetTimeMillis() - nHPSTimerStart > 4000)
+                    if (vHashHigh[l] > nTargetHigh)
+                        continue;
+                    block.nNonce = nNonce + l;
+                    if (block.GetHash() <= hashTarget)
                     {
-                        dHashesPerSec = 1000.0 * nHashCounter / (GetTimeMillis() - nHPSTimerStart);
-                        nHPSTimerStart = GetTimeMillis();
-                        nHashCounter = 0;
-                        static int64_t nLogTime;
-                        if (GetTime() - nLogTime > 30 * 60)
-                        {
-                            nLogTime = GetTime();
-                            LogPrintf("hashmeter %6.0f khash/s\n", dHashesPerSec/1000.0);
-                        }
+                        fFound = true;
+                        break;
                     }
                 }
             }
+            nHashes += 0x10000;
 
-            //ticoin Check for stop or if block needs to be rebuilt
+            if (fFound)
+            {
+                //ticoin Found a solution
+                SetThreadPriority(THREAD_PRIORITY_NORMAL);
+                {
+                    //ticoin A template replaced since only on a mempool refresh still builds on
+                    //ticoin the tip and pays the same key; CheckWork turns down stale blocks
+                    LOCK(pwork->cs);
+                    CheckWork(&block, *pwallet, pwork->reservekey);
+                    //ticoin The coinbase key is used up; the next template gets a new one
+                    pwork->ptemplate.reset();
+                }
+                SetThreadPriority(THREAD_PRIORITY_LOWEST);
+
+                //ticoin In regression test mode, stop mining after a block is found. This
+                //ticoin allows developers to controllably generate a block on demand.
+                if (Params().NetworkID() == CChainParams::REGTEST)
+                    throw boost::thread_interrupted();
+                break;
+            }
+
+            //ticoin Meter hashes/sec
+            int64_t nElapsed = GetTimeMillis() - nMeterStart;
+            if (nElapsed > 4000)
+            {
+                UpdateHashMeter(nThread, 1000.0 * nHashes / nElapsed);
+                nHashes = 0;
+                nMeterStart = GetTimeMillis();
+            }
+
+            //ticoin Check for stop or if the template needs to be rebuilt
             boost::this_thread::interruption_point();
             if (vNodes.empty() && Params().NetworkID() != CChainParams::REGTEST)
                 break;
-            if (nBlockNonce >= 0xffff0000)
-                break;
-            if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 60)
-                break;
-            if (pindexPrev != chainActive.Tip())
+            if (nNonce >= 0xffff0000)
                 break;
+            {
+                LOCK(pwork->cs);
+                if (nGeneration != pwork->nGeneration || pwork->IsStale())
+                    break;
+            }
 
             //ticoin Update nTime every few seconds
-            UpdateTime(*pblock, pindexPrev);
-            nBlockTime = ByteReverse(pblock->nTime);
+            UpdateTime(block, pindexPrev);
+            midstate.Set(block);
             if (TestNet())
             {
-                //ticoin Changing pblock->nTime can change work required on testnet:
-                nBlockBits = ByteReverse(pblock->nBits);
-                hashTarget = CBigNum().SetCompact(pblock->nBits).getuint256();
+                //ticoin Changing block.nTime can change work required on testnet:
+                hashTarget = ArithToUint256(arith_uint256().SetCompact(block.nBits));
+                nTargetHigh = (uint32_t)(hashTarget >> 224).GetLow64();
             }
         }
     } }
     catch (boost::thread_interrupted)
     {
-        LogPrintf("ticoinMiner terminated\n");
+        LogPrintf("ticoinMiner %u terminated\n", nThread);
         throw;
     }
 }
@@ -662,12 +821,20 @@ void Generateticoins(bool fGenerate, CWallet* pwallet, int nThreads)
         minerThreads = NULL;
     }
 
+    {
+        LOCK(cs_hashmeter);
+        vThreadHashesPerSec.assign(fGenerate ? nThreads : 0, 0.0);
+        dHashesPerSec = 0.0;
+    }
+
     if (nThreads == 0 || !fGenerate)
         return;
 
+    //ticoin Threads that were just interrupted may still hold a reference to their own work
+    boost::shared_ptr<CMinerWork> pwork(new CMinerWork(pwallet));
     minerThreads = new boost::thread_group();
     for (int i = 0; i < nThreads; i++)
-        minerThreads->create_thread(boost::bind(&ticoinMiner, pwallet));
+        minerThreads->create_thread(boost::bind(&ticoinMiner, pwallet, pwork, i, nThreads));
 }
 
 #endif
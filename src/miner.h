@@ -7,8 +7,10 @@
 #define ticoin_MINER_H
 
 #include <stdint.h>
+#include <vector>
 
 class CBlock;
+class CBlockHeader;
 class CBlockIndex;
 struct CBlockTemplate;
 class CReserveKey;
@@ -22,6 +24,8 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn);
 CBlockTemplate* CreateNewBlockWithKey(CReserveKey& reservekey);
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
+/** Set the extranonce of a block's coinbase and update its merkle root */
+void SetExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int nExtraNonce);
 /** Do mining precalculation */
 void FormatHashBuffers(CBlock* pblock, char* pmidstate, char* pdata, char* phash1);
 /** Check mined block */
@@ -29,6 +33,28 @@ bool CheckWork(CBlock* pblock, CWallet& wallet, CReserveKey& reservekey);
 /** Base sha256 mining transform */
 void SHA256Transform(void* pstate, void* pinput, const void* pinit);
 
+/** Nonces hashed together by ScanNonces */
+static const unsigned int MINER_LANES = 8;
+
+/** A block header prepared for hashing with many nonces: the SHA-256 state
+ *  after its first 64 bytes, and the three words that follow before the nonce */
+struct CMinerMidstate
+{
+    uint32_t state[8];
+    uint32_t tail[3];
+
+    void Set(const CBlockHeader& header);
+};
+
+/** Hash the prepared header with nonces nNonce .. nNonce + MINER_LANES - 1 at once.
+ *  For each, returns the most significant 32 bits of the block hash (as a
+ *  uint256), which rule out all but a few nonces before a full comparison
+ *  with the target. */
+void ScanNonces(const CMinerMidstate& midstate, uint32_t nNonce, uint32_t pHashHigh[MINER_LANES]);
+
+/** Recent hashes per second of each miner thread */
+void GetMinerHashRates(std::vector<double>& vRates);
+
 extern double dHashesPerSec;
 extern int64_t nHPSTimerStart;
 
@@ -692,10 +692,10 @@ int CNetMessage::readData(const char *pch, unsigned int nBytes)
 //ticoin requires LOCK(cs_vSend)
 void SocketSendData(CNode *pnode)
 {
-    std::deque<CSerializeData>::iterator it = pnode->vSendMsg.begin();
+    std::deque<CNetSerializeData>::iterator it = pnode->vSendMsg.begin();
 
     while (it != pnode->vSendMsg.end()) {
-        const CSerializeData &data = *it;
+        const CNetSerializeData &data = *it;
         assert(data.size() > pnode->nSendOffset);
         int nBytes = send(pnode->hSocket, &data[pnode->nSendOffset], data.size() - pnode->nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
         if (nBytes > 0) {
@@ -1877,21 +1877,21 @@ void CNode::Fuzz(int nChance)
     case 0:
         //ticoin xor a random byte with a random value:
         if (!ssSend.empty()) {
-            CDataStream::size_type pos = GetRand(ssSend.size());
+            CNetDataStream::size_type pos = GetRand(ssSend.size());
             ssSend[pos] ^= (unsigned char)(GetRand(256));
         }
         break;
     case 1:
         //ticoin delete a random byte:
         if (!ssSend.empty()) {
-            CDataStream::size_type pos = GetRand(ssSend.size());
+            CNetDataStream::size_type pos = GetRand(ssSend.size());
             ssSend.erase(ssSend.begin()+pos);
         }
         break;
     case 2:
         //ticoin insert a random byte at a random position
         {
-            CDataStream::size_type pos = GetRand(ssSend.size());
+            CNetDataStream::size_type pos = GetRand(ssSend.size());
             char ch = (char)GetRand(256);
             ssSend.insert(ssSend.begin()+pos, ch);
         }
@@ -1919,7 +1919,9 @@ bool CAddrDB::Write(const CAddrMan& addr)
     std::string tmpfn = strprintf("peers.dat.%04x", randv);
 
     //ticoin serialize addresses, checksum data up to that point, then append csum
+    //ticoin (an entry takes a bit over 60 bytes; reserving avoids regrowing the buffer)
     CDataStream ssPeers(SER_DISK, CLIENT_VERSION);
+    ssPeers.reserve(64 * addr.size() + 4 * (ADDRMAN_NEW_BUCKET_COUNT * (ADDRMAN_NEW_BUCKET_SIZE + 1)));
     ssPeers << FLATDATA(Params().MessageStart());
     ssPeers << addr;
     uint256 hash = Hash(ssPeers.begin(), ssPeers.end());
@@ -1963,13 +1965,14 @@ bool CAddrDB::Read(CAddrMan& addr)
     //ticoin Don't try to resize to a negative number if file is small
     if (dataSize < 0)
         dataSize = 0;
-    vector<unsigned char> vchData;
-    vchData.resize(dataSize);
+    //ticoin read straight into the stream that is deserialized from, without an intermediate copy
+    CDataStream ssPeers(SER_DISK, CLIENT_VERSION);
+    ssPeers.resize(dataSize);
     uint256 hashIn;
 
     //ticoin read data and checksum from file
     try {
-        filein.read((char *)&vchData[0], dataSize);
+        filein.read(&ssPeers[0], dataSize);
         filein >> hashIn;
     }
     catch (std::exception &e) {
@@ -1977,8 +1980,6 @@ bool CAddrDB::Read(CAddrMan& addr)
     }
     filein.fclose();
 
-    CDataStream ssPeers(vchData, SER_DISK, CLIENT_VERSION);
-
     //ticoin verify stored checksum matches input data
     uint256 hashTmp = Hash(ssPeers.begin(), ssPeers.end());
     if (hashIn != hashTmp)
@@ -156,11 +156,11 @@ class CNetMessage {
 public:
     bool in_data;                   //ticoin parsing header (false) or data (true)
 
-    CDataStream hdrbuf;             //ticoin partially received header
+    CNetDataStream hdrbuf;          //ticoin partially received header
     CMessageHeader hdr;             //ticoin complete header
     unsigned int nHdrPos;
 
-    CDataStream vRecv;              //ticoin received message data
+    CNetDataStream vRecv;           //ticoin received message data
     unsigned int nDataPos;
 
     CNetMessage(int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), vRecv(nTypeIn, nVersionIn) {
@@ -198,11 +198,11 @@ public:
     //ticoin socket
     uint64_t nServices;
     SOCKET hSocket;
-    CDataStream ssSend;
+    CNetDataStream ssSend;
     size_t nSendSize; //ticoin total size of all vSendMsg entries
     size_t nSendOffset; //ticoin offset inside the first vSendMsg already sent
     uint64_t nSendBytes;
-    std::deque<CSerializeData> vSendMsg;
+    std::deque<CNetSerializeData> vSendMsg;
     CCriticalSection cs_vSend;
 
     std::deque<CInv> vRecvGetData;
@@ -512,7 +512,7 @@ public:
 
         LogPrint("net", "(%d bytes)\n", nSize);
 
-        std::deque<CSerializeData>::iterator it = vSendMsg.insert(vSendMsg.end(), CSerializeData());
+        std::deque<CNetSerializeData>::iterator it = vSendMsg.insert(vSendMsg.end(), CNetSerializeData());
         ssSend.GetAndClear(*it);
         nSendSize += (*it).size();
 
@@ -0,0 +1,404 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "pubsub.h"
+
+#include "core.h"
+#include "main.h"
+#include "netbase.h"
+#include "serialize.h"
+#include "sync.h"
+#include "ui_interface.h"
+#include "util.h"
+#include "version.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+using namespace std;
+using namespace boost::asio;
+
+typedef boost::shared_ptr<const std::string> CPubMessage;
+
+static const char* pszPubTopics[] = { "hashblock", "rawblock", "hashtx", "rawtx" };
+
+/** Delay before accepting again after a failed accept, doubled on each further failure */
+static const int64_t PUB_ACCEPT_RETRY_MIN_MS = 100;
+static const int64_t PUB_ACCEPT_RETRY_MAX_MS = 10000;
+
+static io_service* pubsub_io_service = NULL;
+static io_service::work* pubsub_work = NULL;
+static boost::thread_group* pubsub_thread = NULL;
+static unsigned int nPubHWM = DEFAULT_PUB_HWM;
+
+/**-5-10Listeners, connections and their queues are only used from the publisher thread,
+/**-5-10so they need no locks.
+
+/** A subscriber */
+class CPubConnection
+{
+public:
+    virtual ~CPubConnection() {}
+    virtual void Start() = 0;
+    virtual void Send(const CPubMessage& msg) = 0;
+    virtual void Close() = 0;
+    virtual bool IsClosed() const = 0;
+};
+
+template <typename Protocol>
+class CPubConnectionImpl : public CPubConnection, public boost::enable_shared_from_this< CPubConnectionImpl<Protocol> >
+{
+public:
+    typename Protocol::socket socket;
+
+    CPubConnectionImpl(io_service& io_serviceIn) : socket(io_serviceIn), fWriting(false), fClosed(false) {}
+
+    void Start()
+    {
+        /**-5-10Subscribers have nothing to say; reading only notices when they go away
+        socket.async_read_some(buffer(&chRead, 1),
+                               boost::bind(&CPubConnectionImpl::HandleRead, this->shared_from_this(), boost::asio::placeholders::error));
+    }
+
+    void Send(const CPubMessage& msg)
+    {
+        /**-5-10A subscriber that does not keep up misses messages, rather than holding on to
+        /**-5-10an unbounded backlog
+        if (fClosed || queue.size() >= nPubHWM)
+            return;
+        queue.push_back(msg);
+        if (!fWriting)
+            WriteNext();
+    }
+
+    void Close()
+    {
+        if (fClosed)
+            return;
+        fClosed = true;
+        boost::system::error_code ec;
+        socket.close(ec);
+    }
+
+    bool IsClosed() const { return fClosed; }
+
+private:
+    std::deque<CPubMessage> queue;
+    bool fWriting;
+    bool fClosed;
+    char chRead;
+
+    void WriteNext()
+    {
+        fWriting = true;
+        async_write(socket, buffer(*queue.front()),
+                    boost::bind(&CPubConnectionImpl::HandleWrite, this->shared_from_this(), boost::asio::placeholders::error));
+    }
+
+    void HandleWrite(const boost::system::error_code& err)
+    {
+        fWriting = false;
+        if (err) {
+            Close();
+            return;
+        }
+        queue.pop_front();
+        if (!queue.empty() && !fClosed)
+            WriteNext();
+    }
+
+    void HandleRead(const boost::system::error_code& err)
+    {
+        if (err)
+            Close();
+        else
+            Start();
+    }
+};
+
+/** An address subscribers connect to, and the topics published there */
+class CPubListener
+{
+public:
+    std::set<std::string> setTopics;
+
+    virtual ~CPubListener() {}
+    virtual void Accept() = 0;
+    virtual void Cancel() = 0;
+
+    void Broadcast(const std::string& strTopic, const CPubMessage& msg)
+    {
+        if (!setTopics.count(strTopic))
+            return;
+        std::vector<boost::shared_ptr<CPubConnection> > vOpen;
+        BOOST_FOREACH(const boost::shared_ptr<CPubConnection>& conn, vConnections) {
+            if (conn->IsClosed())
+                continue;
+            conn->Send(msg);
+            vOpen.push_back(conn);
+        }
+        vConnections.swap(vOpen);
+    }
+
+protected:
+    std::vector<boost::shared_ptr<CPubConnection> > vConnections;
+};
+
+template <typename Protocol>
+class CPubListenerImpl : public CPubListener
+{
+public:
+    CPubListenerImpl(io_service& io_serviceIn, const typename Protocol::endpoint& endpoint) :
+        io(io_serviceIn), acceptor(io_serviceIn), timerRetry(io_serviceIn), nRetryMs(0)
+    {
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(socket_base::reuse_address(true));
+        acceptor.bind(endpoint);
+        acceptor.listen(socket_base::max_connections);
+    }
+
+    void Accept()
+    {
+        boost::shared_ptr< CPubConnectionImpl<Protocol> > conn(new CPubConnectionImpl<Protocol>(io));
+        acceptor.async_accept(conn->socket, boost::bind(&CPubListenerImpl::HandleAccept, this, conn, boost::asio::placeholders::error));
+    }
+
+    void Cancel()
+    {
+        boost::system::error_code ec;
+        acceptor.close(ec);
+        timerRetry.cancel(ec);
+        BOOST_FOREACH(const boost::shared_ptr<CPubConnection>& conn, vConnections)
+            conn->Close();
+        vConnections.clear();
+    }
+
+private:
+    io_service& io;
+    typename Protocol::acceptor acceptor;
+    deadline_timer timerRetry;
+    int64_t nRetryMs;
+
+    void HandleAccept(boost::shared_ptr< CPubConnectionImpl<Protocol> > conn, const boost::system::error_code& err)
+    {
+        if (err == error::operation_aborted)
+            return;
+        if (err) {
+            /**-5-10Errors such as running out of file descriptors fail again straight away, so
+            /**-5-10back off instead of spinning on them
+            nRetryMs = nRetryMs ? std::min(2 * nRetryMs, PUB_ACCEPT_RETRY_MAX_MS) : PUB_ACCEPT_RETRY_MIN_MS;
+            LogPrintf("Accepting a notification subscriber failed, retrying in %d ms: %s\n", nRetryMs, err.message());
+            timerRetry.expires_from_now(boost::posix_time::milliseconds(nRetryMs));
+            timerRetry.async_wait(boost::bind(&CPubListenerImpl::HandleRetry, this, boost::asio::placeholders::error));
+            return;
+        }
+        nRetryMs = 0;
+        LogPrint("pubsub", "New notification subscriber\n");
+        vConnections.push_back(conn);
+        conn->Start();
+        Accept();
+    }
+
+    void HandleRetry(const boost::system::error_code& err)
+    {
+        if (err != error::operation_aborted)
+            Accept();
+    }
+};
+
+static std::vector<CPubListener*> vPubListeners;
+static std::vector<boost::filesystem::path> vPubSocketPaths;
+
+static void BroadcastMessage(const std::string& strTopic, const CPubMessage& msg)
+{
+    BOOST_FOREACH(CPubListener* plistener, vPubListeners)
+        plistener->Broadcast(strTopic, msg);
+}
+
+/** Turns validation signals into messages. Validation threads only frame the
+ *  message and hand it to the publisher thread. */
+class CPublisher : public CWalletInterface, public CIndexInterface
+{
+private:
+    std::set<std::string> setTopics;
+    CCriticalSection cs_sequence;
+    std::map<std::string, uint32_t> mapSequence;
+
+    void Publish(const std::string& strTopic, const std::string& strPayload)
+    {
+        /**-5-10Queue under the lock, so that messages go out in sequence order
+        LOCK(cs_sequence);
+        CPubMessage msg(new std::string(FormatPubMessage(strTopic, mapSequence[strTopic]++, strPayload)));
+        pubsub_io_service->post(boost::bind(&BroadcastMessage, strTopic, msg));
+    }
+
+    static std::string HashPayload(const uint256& hash)
+    {
+        std::string str(hash.begin(), hash.end());
+        std::reverse(str.begin(), str.end());
+        return str;
+    }
+
+protected:
+    void SyncTransaction(const uint256 &hash, const CTransaction &tx, const CBlock *pblock)
+    {
+        if (setTopics.count("hashtx"))
+            Publish("hashtx", HashPayload(hash));
+        if (setTopics.count("rawtx")) {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << tx;
+            Publish("rawtx", ss.str());
+        }
+    }
+
+    void BlockConnected(const CBlock &block, const CBlockIndex *pindex)
+    {
+        if (setTopics.count("hashblock"))
+            Publish("hashblock", HashPayload(pindex->GetBlockHash()));
+        if (setTopics.count("rawblock")) {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << block;
+            Publish("rawblock", ss.str());
+        }
+    }
+
+    void EraseFromWallet(const uint256 &hash) {}
+    void SetBestChain(const CBlockLocator &locator) {}
+    void UpdatedTransaction(const uint256 &hash) {}
+    void Inventory(const uint256 &hash) {}
+    void ResendWalletTransactions() {}
+    void BlockDisconnected(const CBlock &block, const CBlockIndex *pindex) {}
+
+public:
+    CPublisher(const std::set<std::string>& setTopicsIn) : setTopics(setTopicsIn) {}
+};
+
+static CPublisher* ppublisher = NULL;
+
+std::string FormatPubMessage(const std::string& strTopic, uint32_t nSequence, const std::string& strPayload)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << strTopic << nSequence;
+    ss.write(strPayload.data(), strPayload.size());
+    CDataStream ssFrame(SER_NETWORK, PROTOCOL_VERSION);
+    ssFrame << (uint32_t)ss.size();
+    return ssFrame.str() + ss.str();
+}
+
+/**-5-10Listen on strAddress, or return NULL if it is not a valid address
+static CPubListener* CreateListener(const std::string& strAddress)
+{
+    if (boost::algorithm::starts_with(strAddress, "tcp://")) {
+        std::string strHost;
+        int nPort = 0;
+        SplitHostPort(strAddress.substr(6), nPort, strHost);
+        boost::system::error_code ec;
+        ip::address address = ip::address::from_string(strHost, ec);
+        if (ec || nPort <= 0 || nPort > 65535)
+            return NULL;
+        return new CPubListenerImpl<ip::tcp>(*pubsub_io_service, ip::tcp::endpoint(address, nPort));
+    }
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    if (boost::algorithm::starts_with(strAddress, "unix:")) {
+        boost::filesystem::path path(strAddress.substr(5));
+        if (path.empty())
+            return NULL;
+        if (!path.is_complete())
+            path = GetDataDir() / path;
+        /**-5-10A socket left behind by an unclean shutdown; anything else is not ours to remove
+        if (boost::filesystem::status(path).type() == boost::filesystem::socket_file)
+            boost::filesystem::remove(path);
+        CPubListener* plistener = new CPubListenerImpl<local::stream_protocol>(*pubsub_io_service, local::stream_protocol::endpoint(path.string()));
+        vPubSocketPaths.push_back(path);
+        return plistener;
+    }
+#endif
+    return NULL;
+}
+
+bool StartPubSub(std::string& strError)
+{
+    std::map<std::string, std::set<std::string> > mapAddressTopics;
+    std::set<std::string> setTopics;
+    for (unsigned int i = 0; i < sizeof(pszPubTopics) / sizeof(pszPubTopics[0]); i++) {
+        BOOST_FOREACH(const std::string& strAddress, mapMultiArgs[std::string("-pub") + pszPubTopics[i]]) {
+            mapAddressTopics[strAddress].insert(pszPubTopics[i]);
+            setTopics.insert(pszPubTopics[i]);
+        }
+    }
+    if (mapAddressTopics.empty())
+        return true;
+
+    nPubHWM = std::max((int64_t)1, GetArg("-pubhwm", DEFAULT_PUB_HWM));
+    pubsub_io_service = new io_service();
+    for (std::map<std::string, std::set<std::string> >::const_iterator it = mapAddressTopics.begin(); it != mapAddressTopics.end(); it++) {
+        CPubListener* plistener = NULL;
+        try {
+            plistener = CreateListener(it->first);
+        } catch (boost::system::system_error &e) {
+            strError = strprintf(_("Unable to listen for notification subscribers on %s: %s"), it->first, e.what());
+            StopPubSub();
+            return false;
+        }
+        if (plistener == NULL) {
+            strError = strprintf(_("Invalid notification address: '%s'"), it->first);
+            StopPubSub();
+            return false;
+        }
+        plistener->setTopics = it->second;
+        plistener->Accept();
+        vPubListeners.push_back(plistener);
+        LogPrintf("Publishing %s on %s\n", boost::algorithm::join(it->second, ", "), it->first);
+    }
+
+    ppublisher = new CPublisher(setTopics);
+    RegisterWallet(ppublisher);
+    RegisterIndex(ppublisher);
+
+    pubsub_work = new io_service::work(*pubsub_io_service);
+    pubsub_thread = new boost::thread_group();
+    pubsub_thread->create_thread(boost::bind(&io_service::run, pubsub_io_service));
+    return true;
+}
+
+void StopPubSub()
+{
+    if (ppublisher) {
+        UnregisterIndex(ppublisher);
+        UnregisterWallet(ppublisher);
+        delete ppublisher; ppublisher = NULL;
+    }
+    if (pubsub_io_service == NULL)
+        return;
+
+    pubsub_io_service->stop();
+    if (pubsub_thread != NULL)
+        pubsub_thread->join_all();
+    BOOST_FOREACH(CPubListener* plistener, vPubListeners) {
+        plistener->Cancel();
+        delete plistener;
+    }
+    vPubListeners.clear();
+    BOOST_FOREACH(const boost::filesystem::path& path, vPubSocketPaths) {
+        boost::system::error_code ec;
+        boost::filesystem::remove(path, ec);
+    }
+    vPubSocketPaths.clear();
+    delete pubsub_work; pubsub_work = NULL;
+    delete pubsub_thread; pubsub_thread = NULL;
+    delete pubsub_io_service; pubsub_io_service = NULL;
+}
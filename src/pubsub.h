@@ -0,0 +1,42 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ticoin_PUBSUB_H
+#define ticoin_PUBSUB_H
+
+#include <string>
+#include <stdint.h>
+
+/** Default for -pubhwm, the number of messages queued for a subscriber */
+static const unsigned int DEFAULT_PUB_HWM = 1000;
+
+/** Notifications pushed to local subscribers (-pubhashblock, -pubrawblock,
+ * -pubhashtx, -pubrawtx). Each option names an address to listen on,
+ * tcp://<ip>:<port> or unix:<path>, and subscribers that connect there get
+ * every message of the topic, framed as:
+ *
+ *   uint32   length of the rest of the frame (little endian)
+ *   string   topic ("hashblock", "rawblock", "hashtx" or "rawtx")
+ *   uint32   sequence number, counted per topic (little endian)
+ *   bytes    payload: a hash in the byte order shown by RPC, or a block or
+ *            transaction serialized as on the network
+ *
+ * Blocks are published as they are connected to the active chain.
+ * Transactions are published whenever a wallet would be told about them: as
+ * they enter the mempool, are connected in a block, or leave one.
+ * Validation only queues a message; a separate thread writes it out. A
+ * subscriber that falls more than -pubhwm messages behind misses messages,
+ * which shows as a gap in the sequence numbers.
+ */
+
+/** Start listening on the configured addresses, if any. Returns false, with
+ *  strError set, if an address is invalid or cannot be bound. */
+bool StartPubSub(std::string& strError);
+/** Stop publishing and close all subscriber connections */
+void StopPubSub();
+
+/** Frame a message as described above */
+std::string FormatPubMessage(const std::string& strTopic, uint32_t nSequence, const std::string& strPayload);
+
+#endif /**-5-10ticoin_PUBSUB_H
@@ -0,0 +1,284 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rest.h"
+
+#include "core.h"
+#include "main.h"
+#include "rpcserver.h"
+#include "sync.h"
+#include "txmempool.h"
+#include "util.h"
+#include "version.h"
+
+#include <boost/algorithm/string.hpp>
+
+using namespace std;
+using namespace json_spirit;
+
+/** Bytes of a block file copied to the connection at a time */
+static const unsigned int REST_BLOCK_CHUNK = 65536;
+
+static const struct {
+    enum RetFormat rf;
+    const char *name;
+} rf_names[] = {
+    { RF_BINARY, "bin" },
+    { RF_HEX,    "hex" },
+    { RF_JSON,   "json" },
+};
+
+static RestErr RESTERR(enum HTTPStatusCode status, string message)
+{
+    RestErr re;
+    re.status = status;
+    re.message = message;
+    return re;
+}
+
+enum RetFormat ParseDataFormat(vector<string>& params, const string& strReq)
+{
+    boost::split(params, strReq, boost::is_any_of("/"));
+    string& strLast = params.back();
+    size_t pos = strLast.rfind('.');
+    if (pos != string::npos) {
+        string strSuffix = strLast.substr(pos + 1);
+        strLast.erase(pos);
+        for (unsigned int i = 0; i < ARRAYLEN(rf_names); i++)
+            if (strSuffix == rf_names[i].name)
+                return rf_names[i].rf;
+    }
+    throw RESTERR(HTTP_NOT_FOUND, "output format not found (available: bin, hex, json)");
+}
+
+uint256 ParseHashStr(const string& strHash)
+{
+    if (strHash.size() != 64 || !IsHex(strHash))
+        throw RESTERR(HTTP_BAD_REQUEST, "Invalid hash: " + strHash);
+    uint256 hash;
+    hash.SetHex(strHash);
+    return hash;
+}
+
+unsigned int ParseHeaderCount(const string& strCount)
+{
+    /**-5-10No sign, spaces or trailing characters, and short enough not to overflow
+    if (strCount.empty() || strCount.size() > 4 || strCount.find_first_not_of("0123456789") != string::npos)
+        throw RESTERR(HTTP_BAD_REQUEST, "Header count out of range: " + strCount);
+    unsigned int nCount = atoi(strCount);
+    if (nCount < 1 || nCount > MAX_REST_HEADERS)
+        throw RESTERR(HTTP_BAD_REQUEST, "Header count out of range: " + strCount);
+    return nCount;
+}
+
+/**-5-10Reply with serialized data in the requested format
+static bool ReplyData(AcceptedConnection *conn, const CDataStream& ss, enum RetFormat rf, bool fRun)
+{
+    if (rf == RF_HEX)
+        conn->stream() << HTTPReply(HTTP_OK, HexStr(ss.begin(), ss.end()) + "\n", fRun, "text/plain") << std::flush;
+    else
+        conn->stream() << HTTPReply(HTTP_OK, ss.str(), fRun, "application/octet-stream") << std::flush;
+    return true;
+}
+
+static bool ReplyJSON(AcceptedConnection *conn, const Value& val, bool fRun)
+{
+    conn->stream() << HTTPReply(HTTP_OK, write_string(val, false) + "\n", fRun) << std::flush;
+    return true;
+}
+
+/**-5-10Copy a block from its file to the connection, without holding all of it in
+/**-5-10memory. file is positioned at the size that precedes the block.
+static bool StreamBlock(AcceptedConnection *conn, FILE *file, const CBlockIndex *pindex, enum RetFormat rf, bool fRun)
+{
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    unsigned int nSize;
+    vector<char> vBuf(REST_BLOCK_CHUNK);
+    try {
+        filein >> nSize;
+        if (nSize < 80 || nSize > MAX_BLOCK_SIZE)
+            throw RESTERR(HTTP_INTERNAL_SERVER_ERROR, "Block read failed");
+        filein.read(&vBuf[0], 80);
+    } catch (std::exception &e) {
+        error("%s : I/O error - %s", __func__, e.what());
+        throw RESTERR(HTTP_INTERNAL_SERVER_ERROR, "Block read failed");
+    }
+    /**-5-10The hash of the leading header identifies the block
+    if (Hash(vBuf.begin(), vBuf.begin() + 80) != pindex->GetBlockHash())
+        throw RESTERR(HTTP_INTERNAL_SERVER_ERROR, "Block read failed");
+
+    if (rf == RF_HEX)
+        conn->stream() << HTTPReplyHeader(HTTP_OK, fRun, 2 * (size_t)nSize + 1, "text/plain");
+    else
+        conn->stream() << HTTPReplyHeader(HTTP_OK, fRun, nSize, "application/octet-stream");
+
+    /**-5-10Errors from here on can only be reported by closing the connection
+    unsigned int nChunk = 80;
+    unsigned int nLeft = nSize - 80;
+    while (true) {
+        if (rf == RF_HEX) {
+            string strHex = HexStr(vBuf.begin(), vBuf.begin() + nChunk);
+            conn->stream().write(strHex.data(), strHex.size());
+        } else
+            conn->stream().write(&vBuf[0], nChunk);
+        if (nLeft == 0)
+            break;
+        nChunk = min(nLeft, REST_BLOCK_CHUNK);
+        try {
+            filein.read(&vBuf[0], nChunk);
+        } catch (std::exception &e) {
+            return error("%s : I/O error - %s", __func__, e.what());
+        }
+        nLeft -= nChunk;
+    }
+    if (rf == RF_HEX)
+        conn->stream() << "\n";
+    conn->stream() << std::flush;
+    return true;
+}
+
+static bool rest_block(AcceptedConnection *conn, const vector<string>& params, enum RetFormat rf, bool fRun)
+{
+    if (params.size() != 1)
+        throw RESTERR(HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/block/<hash>.<ext>");
+    uint256 hash = ParseHashStr(params[0]);
+
+    FILE *file;
+    CBlockIndex *pblockindex;
+    {
+        /**-5-10Pruning removes block files under cs_main; once open, the file stays readable
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end())
+            throw RESTERR(HTTP_NOT_FOUND, hash.GetHex() + " not found");
+        pblockindex = mi->second;
+        if (!(pblockindex->nStatus & BLOCK_HAVE_DATA))
+            throw RESTERR(HTTP_NOT_FOUND, hash.GetHex() + " not available (pruned data)");
+
+        if (rf == RF_JSON) {
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pblockindex))
+                throw RESTERR(HTTP_INTERNAL_SERVER_ERROR, "Block read failed");
+            Object objBlock = blockToJSON(block, pblockindex, true);
+            return ReplyJSON(conn, objBlock, fRun);
+        }
+
+        CDiskBlockPos pos = pblockindex->GetBlockPos();
+        if (pos.nPos < 4)
+            throw RESTERR(HTTP_INTERNAL_SERVER_ERROR, "Block read failed");
+        pos.nPos -= 4;
+        file = OpenBlockFile(pos, true);
+        if (!file)
+            throw RESTERR(HTTP_INTERNAL_SERVER_ERROR, "Block read failed");
+    }
+    return StreamBlock(conn, file, pblockindex, rf, fRun);
+}
+
+static bool rest_tx(AcceptedConnection *conn, const vector<string>& params, enum RetFormat rf, bool fRun)
+{
+    if (params.size() != 1)
+        throw RESTERR(HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/tx/<txid>.<ext>");
+    uint256 hash = ParseHashStr(params[0]);
+
+    CTransaction tx;
+    uint256 hashBlock = 0;
+    if (!GetTransaction(hash, tx, hashBlock, true))
+        throw RESTERR(HTTP_NOT_FOUND, hash.GetHex() + " not found");
+
+    if (rf == RF_JSON) {
+        Object objTx;
+        {
+            LOCK(cs_main);
+            TxToJSON(tx, hashBlock, objTx);
+        }
+        return ReplyJSON(conn, objTx, fRun);
+    }
+
+    CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
+    ssTx << tx;
+    return ReplyData(conn, ssTx, rf, fRun);
+}
+
+static bool rest_headers(AcceptedConnection *conn, const vector<string>& params, enum RetFormat rf, bool fRun)
+{
+    if (params.size() != 2)
+        throw RESTERR(HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/headers/<count>/<hash>.<ext>");
+    unsigned int nCount = ParseHeaderCount(params[0]);
+    uint256 hash = ParseHashStr(params[1]);
+
+    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+    Array arrHeaders;
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end())
+            throw RESTERR(HTTP_NOT_FOUND, hash.GetHex() + " not found");
+
+        /**-5-10Follow the active chain from the block; a block off it is returned alone
+        const CBlockIndex *pindex = mi->second;
+        while (pindex && nCount-- > 0) {
+            if (rf == RF_JSON)
+                arrHeaders.push_back(blockheaderToJSON(pindex));
+            else
+                ssHeader << pindex->GetBlockHeader();
+            if (!chainActive.Contains(pindex))
+                break;
+            pindex = chainActive.Next(pindex);
+        }
+    }
+
+    if (rf == RF_JSON)
+        return ReplyJSON(conn, arrHeaders, fRun);
+    return ReplyData(conn, ssHeader, rf, fRun);
+}
+
+static bool rest_mempool(AcceptedConnection *conn, const vector<string>& params, enum RetFormat rf, bool fRun)
+{
+    if (params.size() != 1 || !params[0].empty())
+        throw RESTERR(HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/mempool.<ext>");
+
+    vector<uint256> vtxid;
+    mempool.queryHashes(vtxid);
+
+    if (rf == RF_JSON) {
+        Array arrTxids;
+        BOOST_FOREACH(const uint256& hash, vtxid)
+            arrTxids.push_back(hash.GetHex());
+        return ReplyJSON(conn, arrTxids, fRun);
+    }
+
+    CDataStream ssTxids(SER_NETWORK, PROTOCOL_VERSION);
+    ssTxids << vtxid;
+    return ReplyData(conn, ssTxids, rf, fRun);
+}
+
+static const struct {
+    const char *prefix;
+    bool (*handler)(AcceptedConnection *conn, const vector<string>& params, enum RetFormat rf, bool fRun);
+} uri_prefixes[] = {
+    { "/rest/block/",   rest_block },
+    { "/rest/tx/",      rest_tx },
+    { "/rest/headers/", rest_headers },
+    { "/rest/mempool",  rest_mempool },
+};
+
+bool HTTPReq_REST(AcceptedConnection *conn, const string& strURI, bool fRun)
+{
+    try {
+        for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++) {
+            unsigned int plen = strlen(uri_prefixes[i].prefix);
+            if (strURI.substr(0, plen) == uri_prefixes[i].prefix) {
+                vector<string> params;
+                enum RetFormat rf = ParseDataFormat(params, strURI.substr(plen));
+                return uri_prefixes[i].handler(conn, params, rf, fRun);
+            }
+        }
+    } catch (RestErr& re) {
+        conn->stream() << HTTPReply(re.status, re.message + "\r\n", false, "text/plain") << std::flush;
+        return false;
+    }
+
+    conn->stream() << HTTPReply(HTTP_NOT_FOUND, "", false) << std::flush;
+    return false;
+}
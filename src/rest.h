@@ -0,0 +1,40 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ticoin_REST_H
+#define ticoin_REST_H
+
+#include "rpcprotocol.h"
+#include "uint256.h"
+
+#include <string>
+#include <vector>
+
+/** Most headers returned by one /rest/headers request */
+static const unsigned int MAX_REST_HEADERS = 2000;
+
+/** Output format of a REST request, taken from the extension of its URI */
+enum RetFormat {
+    RF_BINARY,
+    RF_HEX,
+    RF_JSON,
+};
+
+/** A failed REST request, answered with status and message */
+class RestErr
+{
+public:
+    enum HTTPStatusCode status;
+    std::string message;
+};
+
+/** Split the part of a URI after the resource name at '/', and take the
+ *  output format off the extension of the last element. */
+enum RetFormat ParseDataFormat(std::vector<std::string>& params, const std::string& strReq);
+/** A hash of exactly 64 hex digits */
+uint256 ParseHashStr(const std::string& strHash);
+/** A header count of 1 to MAX_REST_HEADERS, in decimal digits only */
+unsigned int ParseHeaderCount(const std::string& strCount);
+
+#endif /**-5-10ticoin_REST_H
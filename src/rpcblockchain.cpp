@@ -4,12 +4,17 @@
 /**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "rpcserver.h"
+#include "base58.h"
 #include "main.h"
 #include "sync.h"
 #include "checkpoints.h"
+#include "txdb.h"
+#include "txindex.h"
 
 #include <stdint.h>
 
+#include <boost/filesystem.hpp>
+
 #include "json/json_spirit_value.h"
 
 using namespace json_spirit;
@@ -49,7 +54,33 @@ double GetDifficulty(const CBlockIndex* blockindex)
 }
 
 
-Object blockToJSON(const CBlock& block, const CBlockIndex* blockindex)
+Object blockheaderToJSON(const CBlockIndex* blockindex)
+{
+    Object result;
+    result.push_back(Pair("hash", blockindex->GetBlockHash().GetHex()));
+    int confirmations = -1;
+    /**-5-10Only report confirmations if the block is on the main chain
+    if (chainActive.Contains(blockindex))
+        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    result.push_back(Pair("confirmations", confirmations));
+    result.push_back(Pair("height", blockindex->nHeight));
+    result.push_back(Pair("version", blockindex->nVersion));
+    result.push_back(Pair("merkleroot", blockindex->hashMerkleRoot.GetHex()));
+    result.push_back(Pair("time", (int64_t)blockindex->nTime));
+    result.push_back(Pair("nonce", (uint64_t)blockindex->nNonce));
+    result.push_back(Pair("bits", HexBits(blockindex->nBits)));
+    result.push_back(Pair("difficulty", GetDifficulty(blockindex)));
+    result.push_back(Pair("chainwork", blockindex->nChainWork.GetHex()));
+
+    if (blockindex->pprev)
+        result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
+    CBlockIndex *pnext = chainActive.Next(blockindex);
+    if (pnext)
+        result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
+    return result;
+}
+
+Object blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool fTxDetails)
 {
     Object result;
     result.push_back(Pair("hash", block.GetHash().GetHex()));
@@ -62,7 +93,16 @@ Object blockToJSON(const CBlock& block, const CBlockIndex* blockindex)
     result.push_back(Pair("merkleroot", block.hashMerkleRoot.GetHex()));
     Array txs;
     BOOST_FOREACH(const CTransaction&tx, block.vtx)
-        txs.push_back(tx.GetHash().GetHex());
+    {
+        if (fTxDetails)
+        {
+            Object objTx;
+            TxToJSON(tx, 0, objTx);
+            txs.push_back(objTx);
+        }
+        else
+            txs.push_back(tx.GetHash().GetHex());
+    }
     result.push_back(Pair("tx", txs));
     result.push_back(Pair("time", block.GetBlockTime()));
     result.push_back(Pair("nonce", (uint64_t)block.nNonce));
@@ -277,6 +317,9 @@ Value getblock(const Array& params, bool fHelp)
     CBlock block;
     CBlockIndex* pblockindex = mapBlockIndex[hash];
 
+    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA))
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Block not available (pruned data)");
+
     if(!ReadBlockFromDisk(block, pblockindex))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
 
@@ -328,6 +371,153 @@ Value gettxoutsetinfo(const Array& params, bool fHelp)
     return ret;
 }
 
+Value dumptxoutset(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+            "dumptxoutset \"filename\"\n"
+            "\nWrites the unspent transaction output set at the current tip to a snapshot file,\n"
+            "from which a new node can be started with -loadutxosnapshot.\n"
+            "Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"filename\"    (string, required) The file to write, relative to the data directory unless absolute. It must not exist.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"height\":n,                (numeric) The height of the snapshot block\n"
+            "  \"bestblock\": \"hex\",       (string) The hash of the snapshot block\n"
+            "  \"transactions\": n,         (numeric) The number of transactions with unspent outputs\n"
+            "  \"txouts\": n,               (numeric) The number of unspent outputs\n"
+            "  \"hash_serialized\": \"hash\", (string) The snapshot hash, to be passed to -utxosnapshothash\n"
+            "  \"path\": \"path\"            (string) The absolute path of the written file\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+
+    boost::filesystem::path path = params[0].get_str();
+    if (!path.is_complete())
+        path = GetDataDir() / path;
+    if (boost::filesystem::exists(path))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+
+    CCoinsStats stats;
+    if (!DumpUtxoSnapshot(path, stats))
+        throw JSONRPCError(RPC_MISC_ERROR, "Failed to write UTXO snapshot");
+
+    Object ret;
+    ret.push_back(Pair("height", (int64_t)stats.nHeight));
+    ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
+    ret.push_back(Pair("transactions", (int64_t)stats.nTransactions));
+    ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
+    ret.push_back(Pair("hash_serialized", stats.hashSerialized.GetHex()));
+    ret.push_back(Pair("path", path.string()));
+    return ret;
+}
+
+static Object DBStatsToJSON(CLevelDBWrapper &db)
+{
+    const CLevelDBOptions &dboptions = db.GetOptions();
+    CLevelDBStats stats = db.GetStats();
+
+    Object obj;
+    obj.push_back(Pair("profile", dboptions.strProfile));
+    obj.push_back(Pair("block_cache_mb", (int64_t)(dboptions.nBlockCacheSize >> 20)));
+    obj.push_back(Pair("write_buffer_mb", (int64_t)(dboptions.nWriteBufferSize >> 20)));
+    obj.push_back(Pair("max_open_files", dboptions.nMaxOpenFiles));
+    obj.push_back(Pair("compression", dboptions.fCompression));
+    obj.push_back(Pair("verify_checksums", dboptions.fVerifyChecksums));
+    Array levels;
+    BOOST_FOREACH(const CLevelDBLevelStats &level, stats.vLevels) {
+        Object entry;
+        entry.push_back(Pair("level", level.nLevel));
+        entry.push_back(Pair("files", level.nFiles));
+        entry.push_back(Pair("size_mb", level.dSizeMB));
+        entry.push_back(Pair("compaction_seconds", level.dCompactionSeconds));
+        entry.push_back(Pair("compaction_read_mb", level.dCompactionReadMB));
+        entry.push_back(Pair("compaction_write_mb", level.dCompactionWriteMB));
+        levels.push_back(entry);
+    }
+    obj.push_back(Pair("levels", levels));
+    obj.push_back(Pair("read_amplification", stats.nReadAmplification));
+    obj.push_back(Pair("writes", (int64_t)stats.nWrites));
+    obj.push_back(Pair("write_ms", stats.nWriteMicros / 1000));
+    obj.push_back(Pair("write_stalls", (int64_t)stats.nWriteStalls));
+    obj.push_back(Pair("write_stall_ms", stats.nWriteStallMicros / 1000));
+    return obj;
+}
+
+Value getdbstats(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getdbstats\n"
+            "\nReturns the tuning and LevelDB statistics of the chainstate and blockindex databases.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"chainstate\": {                (json object) the coin database\n"
+            "    \"profile\": \"name\",           (string) the -dbprofile in use\n"
+            "    \"block_cache_mb\": n,          (numeric) size of the block cache\n"
+            "    \"write_buffer_mb\": n,         (numeric) size of a write buffer\n"
+            "    \"max_open_files\": n,          (numeric) table files kept open\n"
+            "    \"compression\": true|false,    (boolean) whether tables are compressed\n"
+            "    \"verify_checksums\": true|false, (boolean) whether reads verify checksums\n"
+            "    \"levels\": [                   (array) one entry per level with files or compaction work\n"
+            "      {\n"
+            "        \"level\": n,               (numeric) the level\n"
+            "        \"files\": n,               (numeric) number of table files\n"
+            "        \"size_mb\": x.x,           (numeric) size of the level\n"
+            "        \"compaction_seconds\": x.x,  (numeric) time spent compacting into this level\n"
+            "        \"compaction_read_mb\": x.x,  (numeric) data read by those compactions\n"
+            "        \"compaction_write_mb\": x.x  (numeric) data written by those compactions\n"
+            "      }, ...\n"
+            "    ],\n"
+            "    \"read_amplification\": n,      (numeric) sorted runs a lookup may search: level-0 files plus deeper non-empty levels\n"
+            "    \"writes\": n,                  (numeric) batches written since startup\n"
+            "    \"write_ms\": n,                (numeric) time spent writing them\n"
+            "    \"write_stalls\": n,            (numeric) writes that waited for compaction\n"
+            "    \"write_stall_ms\": n           (numeric) time spent in those writes\n"
+            "  },\n"
+            "  \"blockindex\": { ... }         (json object) the block index database, same fields\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbstats", "")
+            + HelpExampleRpc("getdbstats", "")
+        );
+
+    Object ret;
+    ret.push_back(Pair("chainstate", DBStatsToJSON(pcoinsdbview->GetDB())));
+    ret.push_back(Pair("blockindex", DBStatsToJSON(*pblocktree)));
+    return ret;
+}
+
+Value compactdb(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() > 1)
+        throw runtime_error(
+            "compactdb ( \"database\" )\n"
+            "\nCompacts a database completely. This can take a long time; the node keeps running meanwhile.\n"
+            "\nArguments:\n"
+            "1. \"database\"    (string, optional) \"chainstate\" or \"blockindex\"; both if omitted\n"
+            "\nResult:\n"
+            "n              (numeric) seconds the compaction took\n"
+            "\nExamples:\n"
+            + HelpExampleCli("compactdb", "\"chainstate\"")
+            + HelpExampleRpc("compactdb", "\"chainstate\"")
+        );
+
+    std::string strName = params.size() > 0 ? params[0].get_str() : "";
+    if (!strName.empty() && strName != "chainstate" && strName != "blockindex")
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown database: " + strName);
+
+    int64_t nStart = GetTimeMillis();
+    if (strName.empty() || strName == "chainstate")
+        pcoinsdbview->GetDB().Compact();
+    if (strName.empty() || strName == "blockindex")
+        pblocktree->Compact();
+    return (GetTimeMillis() - nStart) / 1000.0;
+}
+
 Value gettxout(const Array& params, bool fHelp)
 {
     if (fHelp || params.size() < 2 || params.size() > 3)
@@ -389,7 +579,7 @@ Value gettxout(const Array& params, bool fHelp)
     if (n<0 || (unsigned int)n>=coins.vout.size() || coins.vout[n].IsNull())
         return Value::null;
 
-    std::map<uint256, CBlockIndex*>::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
+    BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
     CBlockIndex *pindex = it->second;
     ret.push_back(Pair("bestblock", pindex->GetBlockHash().GetHex()));
     if ((unsigned int)coins.nHeight == MEMPOOL_HEIGHT)
@@ -406,6 +596,154 @@ Value gettxout(const Array& params, bool fHelp)
     return ret;
 }
 
+/** Parse the address argument of the address index RPCs into its index type and hash */
+static void ParseAddressIndexParam(const Value& v, unsigned char &nType, uint160 &hashBytes)
+{
+    if (!fAddressIndex)
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled (start with -addressindex and -reindex)");
+    CticoinAddress address(v.get_str());
+    if (!address.IsValid() || !GetAddressIndexHash(address.Get(), nType, hashBytes))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid ticoin address");
+}
+
+/** Parse an "a:b" paging cursor */
+static void ParseAddressIndexCursor(const Value& v, std::string &strFirst, std::string &strSecond)
+{
+    std::string str = v.get_str();
+    size_t nSep = str.find(':');
+    if (nSep == std::string::npos)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid start cursor");
+    strFirst = str.substr(0, nSep);
+    strSecond = str.substr(nSep + 1);
+}
+
+Value getaddressutxos(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 3)
+        throw runtime_error(
+            "getaddressutxos \"address\" ( count \"start\" )\n"
+            "\nReturns the confirmed unspent outputs paying to an address. Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"     (string, required) The ticoin address\n"
+            "2. count          (numeric, optional, default=1000) The maximum number of outputs to return\n"
+            "3. \"start\"       (string, optional) The \"next\" cursor of a previous call, to continue from there\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"utxos\" : [                (array of json objects)\n"
+            "    {\n"
+            "      \"txid\" : \"txid\",        (string) The transaction id\n"
+            "      \"vout\" : n,             (numeric) The output number\n"
+            "      \"scriptPubKey\" : \"hex\", (string) The output script\n"
+            "      \"amount\" : x.xxx,       (numeric) The output value in btc\n"
+            "      \"height\" : n            (numeric) The height of the block containing the output\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"next\" : \"cursor\"         (string) Cursor for the next page, or null if this was the last\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressutxos", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\" 100") +
+            "\nAs a json rpc call\n"
+            + HelpExampleRpc("getaddressutxos", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\", 100")
+        );
+
+    CAddressUnspentKey keyStart;
+    ParseAddressIndexParam(params[0], keyStart.nType, keyStart.hashBytes);
+    int nCount = 1000;
+    if (params.size() > 1)
+        nCount = params[1].get_int();
+    if (nCount <= 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid count");
+    if (params.size() > 2) {
+        std::string strTxid, strIndex;
+        ParseAddressIndexCursor(params[2], strTxid, strIndex);
+        keyStart.txhash.SetHex(strTxid);
+        keyStart.nIndex = atoi(strIndex);
+    }
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+    CAddressUnspentKey keyNext;
+    if (!pblocktree->ReadAddressUnspentIndex(keyStart, nCount, vUnspent, &keyNext))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+
+    Array utxos;
+    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it = vUnspent.begin(); it != vUnspent.end(); it++) {
+        Object o;
+        o.push_back(Pair("txid", it->first.txhash.GetHex()));
+        o.push_back(Pair("vout", (int)it->first.nIndex));
+        o.push_back(Pair("scriptPubKey", HexStr(it->second.script.begin(), it->second.script.end())));
+        o.push_back(Pair("amount", ValueFromAmount(it->second.nValue)));
+        o.push_back(Pair("height", it->second.nHeight));
+        utxos.push_back(o);
+    }
+
+    Object ret;
+    ret.push_back(Pair("utxos", utxos));
+    if (keyNext.nType != ADDRESSINDEX_NONE)
+        ret.push_back(Pair("next", strprintf("%s:%u", keyNext.txhash.GetHex(), keyNext.nIndex)));
+    else
+        ret.push_back(Pair("next", Value::null));
+    return ret;
+}
+
+Value getaddresstxids(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 3)
+        throw runtime_error(
+            "getaddresstxids \"address\" ( count \"start\" )\n"
+            "\nReturns the ids of confirmed transactions paying to or spending from an address,\n"
+            "oldest first. Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"     (string, required) The ticoin address\n"
+            "2. count          (numeric, optional, default=1000) The maximum number of transactions to return\n"
+            "3. \"start\"       (string, optional) The \"next\" cursor of a previous call, to continue from there\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"txids\" : [                (array of string)\n"
+            "    \"transactionid\"          (string) The transaction id\n"
+            "    ,...\n"
+            "  ],\n"
+            "  \"next\" : \"cursor\"         (string) Cursor for the next page, or null if this was the last\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddresstxids", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\" 100") +
+            "\nAs a json rpc call\n"
+            + HelpExampleRpc("getaddresstxids", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\", 100")
+        );
+
+    CAddressIndexKey keyStart;
+    ParseAddressIndexParam(params[0], keyStart.nType, keyStart.hashBytes);
+    int nCount = 1000;
+    if (params.size() > 1)
+        nCount = params[1].get_int();
+    if (nCount <= 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid count");
+    if (params.size() > 2) {
+        std::string strHeight, strTxPos;
+        ParseAddressIndexCursor(params[2], strHeight, strTxPos);
+        keyStart.nHeight = atoi(strHeight);
+        keyStart.nTxPos = atoi(strTxPos);
+    }
+
+    std::vector<std::pair<CAddressIndexKey, int64_t> > vHistory;
+    CAddressIndexKey keyNext;
+    if (!pblocktree->ReadAddressIndex(keyStart, nCount, vHistory, &keyNext))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+
+    Array txids;
+    for (std::vector<std::pair<CAddressIndexKey, int64_t> >::const_iterator it = vHistory.begin(); it != vHistory.end(); it++) {
+        if (it == vHistory.begin() || it->first.txhash != (it - 1)->first.txhash)
+            txids.push_back(it->first.txhash.GetHex());
+    }
+
+    Object ret;
+    ret.push_back(Pair("txids", txids));
+    if (keyNext.nType != ADDRESSINDEX_NONE)
+        ret.push_back(Pair("next", strprintf("%d:%u", keyNext.nHeight, keyNext.nTxPos)));
+    else
+        ret.push_back(Pair("next", Value::null));
+    return ret;
+}
+
 Value verifychain(const Array& params, bool fHelp)
 {
     if (fHelp || params.size() > 2)
@@ -445,7 +783,12 @@ Value getblockchaininfo(const Array& params, bool fHelp)
             "  \"bestblockhash\": \"...\", (string) the hash of the currently best block\n"
             "  \"difficulty\": xxxxxx,     (numeric) the current difficulty\n"
             "  \"verificationprogress\": xxxx, (numeric) estimate of verification progress [0..1]\n"
-            "  \"chainwork\": \"xxxx\"     (string) total amount of work in active chain, in hexadecimal\n"
+            "  \"chainwork\": \"xxxx\",    (string) total amount of work in active chain, in hexadecimal\n"
+            "  \"pruned\": xx,            (boolean) if the blocks are subject to pruning\n"
+            "  \"txindex\": {             (json object, only with -txindex) progress of the transaction index\n"
+            "    \"synced\": xx,          (boolean) whether it is up to date with the chain\n"
+            "    \"height\": xxxxxx       (numeric) the last block indexed\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getblockchaininfo", "")
@@ -465,5 +808,12 @@ Value getblockchaininfo(const Array& params, bool fHelp)
     obj.push_back(Pair("difficulty",    (double)GetDifficulty()));
     obj.push_back(Pair("verificationprogress", Checkpoints::GuessVerificationProgress(chainActive.Tip())));
     obj.push_back(Pair("chainwork",     chainActive.Tip()->nChainWork.GetHex()));
+    obj.push_back(Pair("pruned",        fPruneMode));
+    if (ptxindex) {
+        Object txindex;
+        txindex.push_back(Pair("synced", ptxindex->IsSynced()));
+        txindex.push_back(Pair("height", ptxindex->GetHeight()));
+        obj.push_back(Pair("txindex", txindex));
+    }
     return obj;
 }
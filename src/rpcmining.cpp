@@ -213,21 +213,42 @@ Value setgenerate(const Array& params, bool fHelp)
 
 Value gethashespersec(const Array& params, bool fHelp)
 {
-    if (fHelp || params.size() != 0)
+    if (fHelp || params.size() > 1)
         throw runtime_error(
-            "gethashespersec\n"
+            "gethashespersec ( perthread )\n"
             "\nReturns a recent hashes per second performance measurement while generating.\n"
             "See the getgenerate and setgenerate calls to turn generation on and off.\n"
-            "\nResult:\n"
+            "\nArguments:\n"
+            "1. perthread   (boolean, optional, default=false) Also return the rate of each miner thread\n"
+            "\nResult (perthread=false):\n"
             "n            (numeric) The recent hashes per second when generation is on (will return 0 if generation is off)\n"
+            "\nResult (perthread=true):\n"
+            "{\n"
+            "  \"hashespersec\": n,      (numeric) The recent hashes per second of all threads\n"
+            "  \"threads\": [ n, ... ]   (array) The recent hashes per second of each miner thread\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gethashespersec", "")
+            + HelpExampleCli("gethashespersec", "true")
             + HelpExampleRpc("gethashespersec", "")
         );
 
-    if (GetTimeMillis() - nHPSTimerStart > 8000)
-        return (int64_t)0;
-    return (int64_t)dHashesPerSec;
+    bool fPerThread = params.size() > 0 && params[0].get_bool();
+    bool fRecent = GetTimeMillis() - nHPSTimerStart <= 8000;
+    int64_t nHashesPerSec = fRecent ? (int64_t)dHashesPerSec : 0;
+    if (!fPerThread)
+        return nHashesPerSec;
+
+    vector<double> vRates;
+    GetMinerHashRates(vRates);
+    Array threads;
+    BOOST_FOREACH(double dRate, vRates)
+        threads.push_back(fRecent ? (int64_t)dRate : (int64_t)0);
+
+    Object obj;
+    obj.push_back(Pair("hashespersec", nHashesPerSec));
+    obj.push_back(Pair("threads", threads));
+    return obj;
 }
 #endif
 
@@ -363,7 +384,7 @@ Value getwork(const Array& params, bool fHelp)
         char phash1[64];
         FormatHashBuffers(pblock, pmidstate, pdata, phash1);
 
-        uint256 hashTarget = CBigNum().SetCompact(pblock->nBits).getuint256();
+        uint256 hashTarget = ArithToUint256(arith_uint256().SetCompact(pblock->nBits));
 
         Object result;
         result.push_back(Pair("midstate", HexStr(BEGIN(pmidstate), END(pmidstate)))); /**-5-10deprecated
@@ -559,7 +580,7 @@ Value getblocktemplate(const Array& params, bool fHelp)
     Object aux;
     aux.push_back(Pair("flags", HexStr(COINBASE_FLAGS.begin(), COINBASE_FLAGS.end())));
 
-    uint256 hashTarget = CBigNum().SetCompact(pblock->nBits).getuint256();
+    uint256 hashTarget = ArithToUint256(arith_uint256().SetCompact(pblock->nBits));
 
     static Array aMutable;
     if (aMutable.empty())
@@ -15,9 +15,12 @@
 #include "walletdb.h"
 #endif
 
+#include <algorithm>
+#include <fstream>
 #include <stdint.h>
 
 #include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
 #include "json/json_spirit_utils.h"
 #include "json/json_spirit_value.h"
 
@@ -330,3 +333,121 @@ Value verifymessage(const Array& params, bool fHelp)
 
     return (pubkey.GetID() == keyID);
 }
+
+static bool CompareLockStatsByHoldTime(const CLockStats& a, const CLockStats& b)
+{
+    return a.nHoldMicros > b.nHoldMicros;
+}
+
+Value getlockstats(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() > 1)
+        throw runtime_error(
+            "getlockstats ( \"flamegraphfile\" )\n"
+            "\nReturns wait and hold times per lock site, longest total hold time first.\n"
+            "Only recorded when ticoind runs with -lockprofile.\n"
+            "\nArguments:\n"
+            "1. \"flamegraphfile\"  (string, optional) Also write the hold times per nesting of lock sites to this\n"
+            "                      file in the data directory, in the folded stacks format that flamegraph.pl reads\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"lock\": \"name\",         (string) the locked expression, as written at the site\n"
+            "    \"site\": \"file:line\",    (string) where the lock is taken\n"
+            "    \"acquisitions\": n,      (numeric) times the lock was taken here\n"
+            "    \"contended\": n,         (numeric) times it had to wait for another thread\n"
+            "    \"wait_us\": n,           (numeric) total microseconds spent waiting\n"
+            "    \"maxwait_us\": n,        (numeric) longest wait in microseconds\n"
+            "    \"hold_us\": n,           (numeric) total microseconds the lock was held from here\n"
+            "    \"maxhold_us\": n         (numeric) longest hold in microseconds\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getlockstats", "")
+            + HelpExampleCli("getlockstats", "\"locks.folded\"")
+            + HelpExampleRpc("getlockstats", "")
+        );
+
+    if (params.size() > 0) {
+        /**-5-10Only a relative path that stays within the data directory
+        filesystem::path path(params[0].get_str());
+        bool fInDataDir = !path.empty() && !path.has_root_path();
+        for (filesystem::path::iterator it = path.begin(); it != path.end(); ++it)
+            if (*it == "..")
+                fInDataDir = false;
+        if (!fInDataDir)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "flamegraphfile must be a path within the data directory");
+        ofstream file;
+        file.open((GetDataDir() / path).string().c_str());
+        if (!file.is_open())
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Cannot open flamegraph file");
+        file << GetLockStacksFolded();
+        file.close();
+    }
+
+    vector<CLockStats> vStats = GetLockStats();
+    sort(vStats.begin(), vStats.end(), CompareLockStatsByHoldTime);
+
+    Array ret;
+    BOOST_FOREACH(const CLockStats& stats, vStats) {
+        Object obj;
+        obj.push_back(Pair("lock", stats.strName));
+        obj.push_back(Pair("site", strprintf("%s:%d", stats.strFile, stats.nLine)));
+        obj.push_back(Pair("acquisitions", (uint64_t)stats.nAcquisitions));
+        obj.push_back(Pair("contended", (uint64_t)stats.nContended));
+        obj.push_back(Pair("wait_us", stats.nWaitMicros));
+        obj.push_back(Pair("maxwait_us", stats.nMaxWaitMicros));
+        obj.push_back(Pair("hold_us", stats.nHoldMicros));
+        obj.push_back(Pair("maxhold_us", stats.nMaxHoldMicros));
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
+/**-5-10The debug categories listed in -help; others can be turned on as well
+static const char* pszLogCategories[] = {
+    "addrman", "alert", "coindb", "db", "lock", "rand", "rpc", "selectcoins", "mempool", "net", "qt"
+};
+
+Value logging(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() > 2)
+        throw runtime_error(
+            "logging ( [\"category\",...] [\"category\",...] )\n"
+            "\nTurns debug logging categories on and off, and returns which are on.\n"
+            "\"all\" stands for every category.\n"
+            "\nArguments:\n"
+            "1. \"include\"   (array of strings, optional) Categories to turn on\n"
+            "2. \"exclude\"   (array of strings, optional) Categories to turn off\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"category\": true|false,  (boolean) whether messages of this category are logged\n"
+            "  ,...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("logging", "\"[\\\"net\\\",\\\"mempool\\\"]\" \"[\\\"rpc\\\"]\"")
+            + HelpExampleRpc("logging", "[\"net\", \"mempool\"], [\"rpc\"]")
+        );
+
+    for (unsigned int i = 0; i < params.size(); i++) {
+        bool fEnable = (i == 0);
+        BOOST_FOREACH(const Value& category, params[i].get_array()) {
+            string strCategory = category.get_str();
+            EnableLogCategory(strCategory == "all" ? "" : strCategory, fEnable);
+        }
+    }
+
+    set<string> setCategories = GetLogCategories();
+    bool fAll = setCategories.count("") > 0;
+    Object ret;
+    ret.push_back(Pair("all", fAll));
+    for (unsigned int i = 0; i < sizeof(pszLogCategories) / sizeof(pszLogCategories[0]); i++)
+        ret.push_back(Pair(pszLogCategories[i], fAll || setCategories.count(pszLogCategories[i]) > 0));
+    BOOST_FOREACH(const string& strCategory, setCategories) {
+        if (strCategory.empty() || find_value(ret, strCategory).type() != null_type)
+            continue;
+        ret.push_back(Pair(strCategory, true));
+    }
+    return ret;
+}
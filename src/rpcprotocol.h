@@ -125,7 +125,9 @@ private:
 };
 
 std::string HTTPPost(const std::string& strMsg, const std::map<std::string,std::string>& mapRequestHeaders);
-std::string HTTPReply(int nStatus, const std::string& strMsg, bool keepalive);
+std::string HTTPReply(int nStatus, const std::string& strMsg, bool keepalive, const char* pszContentType = "application/json");
+/** Status line and headers of a reply whose body of nContentLength bytes is written separately */
+std::string HTTPReplyHeader(int nStatus, bool keepalive, size_t nContentLength, const char* pszContentType);
 bool ReadHTTPRequestLine(std::basic_istream<char>& stream, int &proto,
                          std::string& http_method, std::string& http_uri);
 int ReadHTTPStatus(std::basic_istream<char>& stream, int &proto);
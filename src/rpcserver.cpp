@@ -8,6 +8,7 @@
 #include "base58.h"
 #include "init.h"
 #include "main.h"
+#include "metrics.h"
 #include "ui_interface.h"
 #include "util.h"
 #ifdef ENABLE_WALLET
@@ -227,6 +228,8 @@ static const CRPCCommand vRPCCommands[] =
     { "getinfo",                &getinfo,                true,      false,      false }, /* uses wallet if enabled */
     { "help",                   &help,                   true,      true,       false },
     { "stop",                   &stop,                   true,      true,       false },
+    { "getlockstats",           &getlockstats,           true,      true,       false },
+    { "logging",                &logging,                true,      true,       false },
 
     /* P2P networking */
     { "getnetworkinfo",         &getnetworkinfo,         true,      false,      false },
@@ -238,11 +241,16 @@ static const CRPCCommand vRPCCommands[] =
     { "ping",                   &ping,                   true,      false,      false },
 
     /* Block chain and UTXO */
+    { "compactdb",              &compactdb,              true,      true,       false },
+    { "dumptxoutset",           &dumptxoutset,           true,      true,       false },
+    { "getaddresstxids",        &getaddresstxids,        true,      false,      false },
+    { "getaddressutxos",        &getaddressutxos,        true,      false,      false },
     { "getblockchaininfo",      &getblockchaininfo,      true,      false,      false },
     { "getbestblockhash",       &getbestblockhash,       true,      false,      false },
     { "getblockcount",          &getblockcount,          true,      false,      false },
     { "getblock",               &getblock,               false,     false,      false },
     { "getblockhash",           &getblockhash,           false,     false,      false },
+    { "getdbstats",             &getdbstats,             true,      true,       false },
     { "getdifficulty",          &getdifficulty,          true,      false,      false },
     { "getrawmempool",          &getrawmempool,          true,      false,      false },
     { "gettxout",               &gettxout,               true,      false,      false },
@@ -382,16 +390,6 @@ bool ClientAllowed(const boost::asio::ip::address& address)
     return false;
 }
 
-class AcceptedConnection
-{
-public:
-    virtual ~AcceptedConnection() {}
-
-    virtual std::iostream& stream() = 0;
-    virtual std::string peer_address_to_string() const = 0;
-    virtual void close() = 0;
-};
-
 template <typename Protocol>
 class AcceptedConnectionImpl : public AcceptedConnection
 {
@@ -774,7 +772,18 @@ void ServiceConnection(AcceptedConnection *conn)
         /**-5-10Read HTTP message headers and body
         ReadHTTPMessage(conn->stream(), mapHeaders, strRequest, nProto);
 
-        if (strURI != "/") {
+        /**-5-10-rest serves read-only chain data under /rest/, without authorization
+        if (strMethod == "GET" && boost::starts_with(strURI, "/rest/") && GetBoolArg("-rest", false)) {
+            if (mapHeaders["connection"] == "close")
+                fRun = false;
+            if (!HTTPReq_REST(conn, strURI, fRun))
+                break;
+            continue;
+        }
+
+        /**-5-10-metrics serves GET /metrics next to JSON-RPC, with the same authorization
+        bool fMetrics = strMethod == "GET" && strURI == "/metrics" && GetBoolArg("-metrics", false);
+        if (strURI != "/" && !fMetrics) {
             conn->stream() << HTTPReply(HTTP_NOT_FOUND, "", false) << std::flush;
             break;
         }
@@ -800,6 +809,11 @@ void ServiceConnection(AcceptedConnection *conn)
         if (mapHeaders["connection"] == "close")
             fRun = false;
 
+        if (fMetrics) {
+            conn->stream() << HTTPReply(HTTP_OK, metrics.Render(), fRun, "text/plain; version=0.0.4") << std::flush;
+            continue;
+        }
+
         JSONRequest jreq;
         try
         {
@@ -857,6 +871,7 @@ json_spirit::Value CRPCTable::execute(const std::string &strMethod, const json_s
         !pcmd->okSafeMode)
         throw JSONRPCError(RPC_FORBIDDEN_BY_SAFE_MODE, string("Safe mode: ") + strWarning);
 
+    CMetricTimer timer(metrics.Histogram("ticoin_rpc_seconds", "Time to execute an RPC call", "method", strMethod));
     try
     {
         /**-5-10Execute
@@ -14,6 +14,7 @@
 #include "util.h"
 
 #include <boost/foreach.hpp>
+#include <boost/thread/tss.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/tuple/tuple_comparison.hpp>
 
@@ -29,7 +30,7 @@ static const CScriptNum bnOne(1);
 static const CScriptNum bnFalse(0);
 static const CScriptNum bnTrue(1);
 
-bool CheckSig(vector<unsigned char> vchSig, const vector<unsigned char> &vchPubKey, const CScript &scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, int flags);
+bool CheckSig(vector<unsigned char> vchSig, const vector<unsigned char> &vchPubKey, const CScript &scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, int flags, const CSigHashContext* psighash = NULL);
 
 bool CastToBool(const valtype& vch)
 {
@@ -374,7 +375,7 @@ bool static CheckSignatureEncoding(const valtype &vchSig, unsigned int flags) {
     return true;
 }
 
-bool EvalScript(vector<vector<unsigned char> >& stack, const CScript& script, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType)
+bool EvalScript(vector<vector<unsigned char> >& stack, const CScript& script, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType, const CSigHashContext* psighash)
 {
     CScript::const_iterator pc = script.begin();
     CScript::const_iterator pend = script.end();
@@ -931,7 +932,7 @@ bool EvalScript(vector<vector<unsigned char> >& stack, const CScript& script, co
                     }
 
                     bool fSuccess = IsCanonicalSignature(vchSig, flags) && IsCanonicalPubKey(vchPubKey, flags) &&
-                        CheckSig(vchSig, vchPubKey, scriptCode, txTo, nIn, nHashType, flags);
+                        CheckSig(vchSig, vchPubKey, scriptCode, txTo, nIn, nHashType, flags, psighash);
 
                     popstack(stack);
                     popstack(stack);
@@ -996,7 +997,7 @@ bool EvalScript(vector<vector<unsigned char> >& stack, const CScript& script, co
 
                         /**-5-10Check signature
                         bool fOk = IsCanonicalSignature(vchSig, flags) && IsCanonicalPubKey(vchPubKey, flags) &&
-                            CheckSig(vchSig, vchPubKey, scriptCode, txTo, nIn, nHashType, flags);
+                            CheckSig(vchSig, vchPubKey, scriptCode, txTo, nIn, nHashType, flags, psighash);
 
                         if (fOk) {
                             isig++;
@@ -1053,6 +1054,28 @@ bool EvalScript(vector<vector<unsigned char> >& stack, const CScript& script, co
 
 
 namespace {
+/** Serialize the passed scriptCode, skipping OP_CODESEPARATORs */
+template<typename S>
+void SerializeScriptCode(S &s, const CScript &scriptCode) {
+    CScript::const_iterator it = scriptCode.begin();
+    CScript::const_iterator itBegin = it;
+    opcodetype opcode;
+    unsigned int nCodeSeparators = 0;
+    while (scriptCode.GetOp(it, opcode)) {
+        if (opcode == OP_CODESEPARATOR)
+            nCodeSeparators++;
+    }
+    ::WriteCompactSize(s, scriptCode.size() - nCodeSeparators);
+    it = itBegin;
+    while (scriptCode.GetOp(it, opcode)) {
+        if (opcode == OP_CODESEPARATOR) {
+            s.write((char*)&itBegin[0], it-itBegin-1);
+            itBegin = it;
+        }
+    }
+    s.write((char*)&itBegin[0], it-itBegin);
+}
+
 /** Wrapper that serializes like CTransaction, but with the modifications
  *  required for the signature hash done in-place
  */
@@ -1072,28 +1095,6 @@ public:
         fHashSingle((nHashTypeIn & 0x1f) == SIGHASH_SINGLE),
         fHashNone((nHashTypeIn & 0x1f) == SIGHASH_NONE) {}
 
-    /** Serialize the passed scriptCode, skipping OP_CODESEPARATORs */
-    template<typename S>
-    void SerializeScriptCode(S &s, int nType, int nVersion) const {
-        CScript::const_iterator it = scriptCode.begin();
-        CScript::const_iterator itBegin = it;
-        opcodetype opcode;
-        unsigned int nCodeSeparators = 0;
-        while (scriptCode.GetOp(it, opcode)) {
-            if (opcode == OP_CODESEPARATOR)
-                nCodeSeparators++;
-        }
-        ::WriteCompactSize(s, scriptCode.size() - nCodeSeparators);
-        it = itBegin;
-        while (scriptCode.GetOp(it, opcode)) {
-            if (opcode == OP_CODESEPARATOR) {
-                s.write((char*)&itBegin[0], it-itBegin-1);
-                itBegin = it;
-            }
-        }
-        s.write((char*)&itBegin[0], it-itBegin);
-    }
-
     /** Serialize an input of txTo */
     template<typename S>
     void SerializeInput(S &s, unsigned int nInput, int nType, int nVersion) const {
@@ -1107,7 +1108,7 @@ public:
             /**-5-10Blank out other inputs' signatures
             ::Serialize(s, CScript(), nType, nVersion);
         else
-            SerializeScriptCode(s, nType, nVersion);
+            SerializeScriptCode(s, scriptCode);
         /**-5-10Serialize the nSequence
         if (nInput != nIn && (fHashSingle || fHashNone))
             /**-5-10let the others update at will
@@ -1171,6 +1172,49 @@ uint256 SignatureHash(const CScript &scriptCode, const CTransaction& txTo, unsig
     return ss.GetHash();
 }
 
+CSigHashContext::CSigHashContext(const CTransaction& txToIn) : txTo(txToIn)
+{
+    /**-5-10Same bytes CTransactionSignatureSerializer writes, with no input selected
+    CDataStream ss(SER_GETHASH, 0);
+    ss << txTo.nVersion;
+    WriteCompactSize(ss, txTo.vin.size());
+    vInputPos.reserve(txTo.vin.size());
+    BOOST_FOREACH(const CTxIn& txin, txTo.vin)
+    {
+        vInputPos.push_back(ss.size());
+        ss << txin.prevout << CScript() << txin.nSequence;
+    }
+    ss << txTo.vout << txTo.nLockTime;
+    vchData.assign(ss.begin(), ss.end());
+
+    vMidstate.resize(vInputPos.size());
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    unsigned int nPos = 0;
+    for (unsigned int i = 0; i < vInputPos.size(); i++)
+    {
+        SHA256_Update(&ctx, &vchData[nPos], vInputPos[i] - nPos);
+        nPos = vInputPos[i];
+        vMidstate[i] = ctx;
+    }
+}
+
+uint256 CSigHashContext::SignatureHash(const CScript& scriptCode, unsigned int nIn, int nHashType) const
+{
+    if (nIn >= vInputPos.size() || (nHashType & SIGHASH_ANYONECANPAY) ||
+        (nHashType & 0x1f) == SIGHASH_NONE || (nHashType & 0x1f) == SIGHASH_SINGLE)
+        return ::SignatureHash(scriptCode, txTo, nIn, nHashType);
+
+    /**-5-10A blanked input is its prevout (36 bytes), an empty script (1 byte) and nSequence
+    unsigned int nPos = vInputPos[nIn];
+    CHashWriter ss(vMidstate[nIn], SER_GETHASH, 0);
+    ss.write((const char*)&vchData[nPos], 36);
+    SerializeScriptCode(ss, scriptCode);
+    ss.write((const char*)&vchData[nPos + 37], vchData.size() - nPos - 37);
+    ss << nHashType;
+    return ss.GetHash();
+}
+
 
 /**-5-10Valid signature cache, to avoid doing expensive ECDSA signature checking
 /**-5-10twice for every transaction (once when accepted into memory pool, and
@@ -1228,8 +1272,52 @@ public:
     }
 };
 
+/**-5-10Signatures looked up by CheckSig, and how many of them the cache already held.
+/**-5-10Every thread counts into its own counters, whose lock is only ever contended
+/**-5-10by GetSigCheckStats; the counters outlive their thread so that totals survive.
+struct CSigCheckCounters
+{
+    boost::mutex mutex;
+    uint64_t nChecks;
+    uint64_t nCacheHits;
+
+    CSigCheckCounters() : nChecks(0), nCacheHits(0) {}
+};
+
+static void KeepSigCheckCounters(CSigCheckCounters *) {}
+
+static CCriticalSection cs_sigstats;
+static std::vector<CSigCheckCounters*> vSigCheckCounters;
+static boost::thread_specific_ptr<CSigCheckCounters> sigcheckcounters(KeepSigCheckCounters);
+
+static void CountSigCheck(bool fCached)
+{
+    CSigCheckCounters *pcounters = sigcheckcounters.get();
+    if (pcounters == NULL) {
+        pcounters = new CSigCheckCounters();
+        sigcheckcounters.reset(pcounters);
+        LOCK(cs_sigstats);
+        vSigCheckCounters.push_back(pcounters);
+    }
+    boost::unique_lock<boost::mutex> lock(pcounters->mutex);
+    pcounters->nChecks++;
+    if (fCached)
+        pcounters->nCacheHits++;
+}
+
+void GetSigCheckStats(uint64_t& nChecks, uint64_t& nCacheHits)
+{
+    nChecks = nCacheHits = 0;
+    LOCK(cs_sigstats);
+    BOOST_FOREACH(CSigCheckCounters *pcounters, vSigCheckCounters) {
+        boost::unique_lock<boost::mutex> lock(pcounters->mutex);
+        nChecks += pcounters->nChecks;
+        nCacheHits += pcounters->nCacheHits;
+    }
+}
+
 bool CheckSig(vector<unsigned char> vchSig, const vector<unsigned char> &vchPubKey, const CScript &scriptCode,
-              const CTransaction& txTo, unsigned int nIn, int nHashType, int flags)
+              const CTransaction& txTo, unsigned int nIn, int nHashType, int flags, const CSigHashContext* psighash)
 {
     static CSignatureCache signatureCache;
 
@@ -1246,9 +1334,12 @@ bool CheckSig(vector<unsigned char> vchSig, const vector<unsigned char> &vchPubK
         return false;
     vchSig.pop_back();
 
-    uint256 sighash = SignatureHash(scriptCode, txTo, nIn, nHashType);
+    uint256 sighash = psighash ? psighash->SignatureHash(scriptCode, nIn, nHashType) :
+                                 SignatureHash(scriptCode, txTo, nIn, nHashType);
 
-    if (signatureCache.Get(sighash, vchSig, pubkey))
+    bool fCached = signatureCache.Get(sighash, vchSig, pubkey);
+    CountSigCheck(fCached);
+    if (fCached)
         return true;
 
     if (!pubkey.Verify(sighash, vchSig))
@@ -1673,15 +1764,209 @@ void ExtractAffectedKeys(const CKeyStore &keystore, const CScript& scriptPubKey,
     CAffectedKeysVisitor(keystore, vKeys).Process(scriptPubKey);
 }
 
+//
+/**-5-10Fast path for the standard script forms. The functions below reproduce what
+/**-5-10EvalScript does for pay-to-pubkey, pay-to-pubkey-hash and bare multisig
+/**-5-10scripts, alone or as P2SH redeem scripts, working on the pushes of the
+/**-5-10scriptSig in place instead of on a copied stack. Anything they do not
+/**-5-10recognize is left to the generic interpreter.
+//
+namespace {
+
+typedef pair<CScript::const_iterator, CScript::const_iterator> pushrange;
+
+/**-5-10Dummy element, 16 signatures and a redeem script
+const unsigned int MAX_STANDARD_PUSHES = 18;
+
+/**-5-10Split a scriptSig that consists only of data pushes into the pushed ranges
+bool GetPushes(const CScript& script, pushrange* pPushes, unsigned int& nPushes)
+{
+    if (script.size() > 10000)
+        return false;
+    nPushes = 0;
+    CScript::const_iterator pc = script.begin();
+    CScript::const_iterator pend = script.end();
+    while (pc < pend)
+    {
+        CScript::const_iterator pstart = pc;
+        opcodetype opcode;
+        if (!GetScriptOp(pc, pend, opcode, NULL) || opcode > OP_PUSHDATA4)
+            return false;
+        unsigned int nHeader = 1;
+        if (opcode == OP_PUSHDATA1)
+            nHeader = 2;
+        else if (opcode == OP_PUSHDATA2)
+            nHeader = 3;
+        else if (opcode == OP_PUSHDATA4)
+            nHeader = 5;
+        if (pc - (pstart + nHeader) > (long)MAX_SCRIPT_ELEMENT_SIZE || nPushes == MAX_STANDARD_PUSHES)
+            return false;
+        pPushes[nPushes++] = pushrange(pstart + nHeader, pc);
+    }
+    return true;
+}
+
+/**-5-10OP_CHECKSIG as EvalScript runs it. Returns false if the signature encoding
+/**-5-10makes the whole script fail, otherwise sets fSuccess.
+bool CheckSigOp(const valtype& vchSig, const valtype& vchPubKey, const CScript& scriptCode, const CTransaction& txTo,
+                unsigned int nIn, unsigned int flags, int nHashType, const CSigHashContext* psighash, bool& fSuccess)
+{
+    if (!CheckSignatureEncoding(vchSig, flags))
+        return false;
+    fSuccess = IsCanonicalSignature(vchSig, flags) && IsCanonicalPubKey(vchPubKey, flags) &&
+        CheckSig(vchSig, vchPubKey, scriptCode, txTo, nIn, nHashType, flags, psighash);
+    return true;
+}
+
+/**-5-10Evaluate script on a stack that holds exactly the given pushes, if script has
+/**-5-10one of the standard forms and the stack has the expected number of elements.
+/**-5-10fRet is set to the truth of the top of the resulting stack.
+bool EvalStandardScript(const CScript& script, const pushrange* pStack, unsigned int nStack, const CTransaction& txTo,
+                        unsigned int nIn, unsigned int flags, int nHashType, const CSigHashContext* psighash, bool& fRet)
+{
+    unsigned int nSize = script.size();
+    if (nSize < 2)
+        return false;
+
+    /**-5-10OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG
+    if (nSize == 25 && script[0] == OP_DUP && script[1] == OP_HASH160 && script[2] == 20 &&
+        script[23] == OP_EQUALVERIFY && script[24] == OP_CHECKSIG)
+    {
+        if (nStack != 2)
+            return false;
+        uint160 hash = Hash160(pStack[1].first, pStack[1].second);
+        if (memcmp(hash.begin(), &script[3], 20) != 0)
+        {
+            fRet = false;
+            return true;
+        }
+        valtype vchSig(pStack[0].first, pStack[0].second);
+        valtype vchPubKey(pStack[1].first, pStack[1].second);
+        CScript scriptCode(script);
+        scriptCode.FindAndDelete(CScript(vchSig));
+        bool fSuccess = false;
+        fRet = CheckSigOp(vchSig, vchPubKey, scriptCode, txTo, nIn, flags, nHashType, psighash, fSuccess) && fSuccess;
+        return true;
+    }
+
+    /**-5-10<pubkey> OP_CHECKSIG
+    if (script[0] >= 1 && script[0] < OP_PUSHDATA1 && nSize == script[0] + 2u && script[nSize - 1] == OP_CHECKSIG)
+    {
+        if (nStack != 1)
+            return false;
+        valtype vchSig(pStack[0].first, pStack[0].second);
+        valtype vchPubKey(script.begin() + 1, script.end() - 1);
+        CScript scriptCode(script);
+        scriptCode.FindAndDelete(CScript(vchSig));
+        bool fSuccess = false;
+        fRet = CheckSigOp(vchSig, vchPubKey, scriptCode, txTo, nIn, flags, nHashType, psighash, fSuccess) && fSuccess;
+        return true;
+    }
+
+    /**-5-10OP_m <pubkey> ... <pubkey> OP_n OP_CHECKMULTISIG, with a dummy element and m signatures
+    if (script[0] >= OP_1 && script[0] <= OP_16 && script[nSize - 1] == OP_CHECKMULTISIG)
+    {
+        int nSigsCount = CScript::DecodeOP_N((opcodetype)script[0]);
+        pushrange vKeys[16];
+        int nKeysCount = 0;
+        CScript::const_iterator pc = script.begin() + 1;
+        CScript::const_iterator pend = script.end() - 1;
+        while (pc < pend && *pc >= 1 && *pc < OP_PUSHDATA1)
+        {
+            if (nKeysCount == 16 || pend - pc < 1 + *pc)
+                return false;
+            vKeys[nKeysCount++] = pushrange(pc + 1, pc + 1 + *pc);
+            pc += 1 + *pc;
+        }
+        if (pend - pc != 1 || *pc < OP_1 || *pc > OP_16 || CScript::DecodeOP_N((opcodetype)*pc) != nKeysCount)
+            return false;
+        if (nSigsCount > nKeysCount || nStack != (unsigned int)nSigsCount + 1)
+            return false;
+
+        vector<valtype> vchSigs;
+        vchSigs.reserve(nSigsCount);
+        for (int k = 1; k <= nSigsCount; k++)
+            vchSigs.push_back(valtype(pStack[k].first, pStack[k].second));
+
+        /**-5-10Signatures are removed starting from the top of the stack, as EvalScript does
+        CScript scriptCode(script);
+        for (int k = nSigsCount - 1; k >= 0; k--)
+            scriptCode.FindAndDelete(CScript(vchSigs[k]));
+
+        int isig = nSigsCount - 1;
+        int ikey = nKeysCount - 1;
+        bool fSuccess = true;
+        while (fSuccess && nSigsCount > 0)
+        {
+            valtype vchPubKey(vKeys[ikey].first, vKeys[ikey].second);
+            bool fOk = false;
+            if (!CheckSigOp(vchSigs[isig], vchPubKey, scriptCode, txTo, nIn, flags, nHashType, psighash, fOk))
+            {
+                fRet = false;
+                return true;
+            }
+            if (fOk) {
+                isig--;
+                nSigsCount--;
+            }
+            ikey--;
+            nKeysCount--;
+            if (nSigsCount > nKeysCount)
+                fSuccess = false;
+        }
+        fRet = fSuccess;
+        return true;
+    }
+
+    return false;
+}
+
+}
+
+bool VerifyStandardScript(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn,
+                          unsigned int flags, int nHashType, bool& fRet, const CSigHashContext* psighash)
+{
+    pushrange vPushes[MAX_STANDARD_PUSHES];
+    unsigned int nPushes;
+    if (!GetPushes(scriptSig, vPushes, nPushes))
+        return false;
+
+    if ((flags & SCRIPT_VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash())
+    {
+        if (nPushes == 0)
+            return false;
+        const pushrange& redeem = vPushes[nPushes - 1];
+        uint160 hash = Hash160(redeem.first, redeem.second);
+        if (memcmp(hash.begin(), &scriptPubKey[2], 20) != 0)
+        {
+            fRet = false;
+            return true;
+        }
+        CScript scriptRedeem(redeem.first, redeem.second);
+        return EvalStandardScript(scriptRedeem, vPushes, nPushes - 1, txTo, nIn, flags, nHashType, psighash, fRet);
+    }
+
+    return EvalStandardScript(scriptPubKey, vPushes, nPushes, txTo, nIn, flags, nHashType, psighash, fRet);
+}
+
 bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn,
-                  unsigned int flags, int nHashType)
+                  unsigned int flags, int nHashType, const CSigHashContext* psighash)
+{
+    bool fRet;
+    if (VerifyStandardScript(scriptSig, scriptPubKey, txTo, nIn, flags, nHashType, fRet, psighash))
+        return fRet;
+    return VerifyScriptGeneric(scriptSig, scriptPubKey, txTo, nIn, flags, nHashType, psighash);
+}
+
+bool VerifyScriptGeneric(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn,
+                         unsigned int flags, int nHashType, const CSigHashContext* psighash)
 {
     vector<vector<unsigned char> > stack, stackCopy;
-    if (!EvalScript(stack, scriptSig, txTo, nIn, flags, nHashType))
+    if (!EvalScript(stack, scriptSig, txTo, nIn, flags, nHashType, psighash))
         return false;
     if (flags & SCRIPT_VERIFY_P2SH)
         stackCopy = stack;
-    if (!EvalScript(stack, scriptPubKey, txTo, nIn, flags, nHashType))
+    if (!EvalScript(stack, scriptPubKey, txTo, nIn, flags, nHashType, psighash))
         return false;
     if (stack.empty())
         return false;
@@ -1704,7 +1989,7 @@ bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const C
         CScript pubKey2(pubKeySerialized.begin(), pubKeySerialized.end());
         popstack(stackCopy);
 
-        if (!EvalScript(stackCopy, pubKey2, txTo, nIn, flags, nHashType))
+        if (!EvalScript(stackCopy, pubKey2, txTo, nIn, flags, nHashType, psighash))
             return false;
         if (stackCopy.empty())
             return false;
@@ -1742,7 +2027,7 @@ bool SignSignature(const CKeyStore &keystore, const CScript& fromPubKey, CTransa
         bool fSolved =
             Solver(keystore, subscript, hash2, nHashType, txin.scriptSig, subType) && subType != TX_SCRIPTHASH;
         /**-5-10Append serialized subscript whether or not it is completely signed:
-        txin.scriptSig << static_cast<valtype>(subscript);
+        txin.scriptSig << ToByteVector(subscript);
         if (!fSolved) return false;
     }
 
@@ -1935,9 +2220,9 @@ bool CScript::IsPayToScriptHash() const
 {
     /**-5-10Extra-fast test for pay-to-script-hash CScripts:
     return (this->size() == 23 &&
-            this->at(0) == OP_HASH160 &&
-            this->at(1) == 0x14 &&
-            this->at(22) == OP_EQUAL);
+            (*this)[0] == OP_HASH160 &&
+            (*this)[1] == 0x14 &&
+            (*this)[22] == OP_EQUAL);
 }
 
 bool CScript::IsPushOnly() const
@@ -16,6 +16,7 @@
 
 #include <boost/foreach.hpp>
 #include <boost/variant.hpp>
+#include <openssl/sha.h>
 
 class CCoins;
 class CKeyStore;
@@ -369,6 +370,13 @@ enum opcodetype
 
 const char* GetOpName(opcodetype opcode);
 
+/** Copy of the bytes of a script or other container, e.g. to push a serialized script as data */
+template<typename T>
+std::vector<unsigned char> ToByteVector(const T& in)
+{
+    return std::vector<unsigned char>(in.begin(), in.end());
+}
+
 
 
 inline std::string ValueString(const std::vector<unsigned char>& vch)
@@ -398,8 +406,66 @@ inline std::string StackString(const std::vector<std::vector<unsigned char> >& v
 
 
 
+/** Decode the instruction at pc in the script ending at pend and advance pc past it.
+ * Works on any random access iterator over the script bytes, so raw buffers can be
+ * parsed without building a CScript.
+ */
+template<typename Iterator>
+bool GetScriptOp(Iterator& pc, Iterator pend, opcodetype& opcodeRet, std::vector<unsigned char>* pvchRet)
+{
+    opcodeRet = OP_INVALIDOPCODE;
+    if (pvchRet)
+        pvchRet->clear();
+    if (pc >= pend)
+        return false;
+
+    /**-5-10Read instruction
+    if (pend - pc < 1)
+        return false;
+    unsigned int opcode = *pc++;
+
+    /**-5-10Immediate operand
+    if (opcode <= OP_PUSHDATA4)
+    {
+        unsigned int nSize = 0;
+        if (opcode < OP_PUSHDATA1)
+        {
+            nSize = opcode;
+        }
+        else if (opcode == OP_PUSHDATA1)
+        {
+            if (pend - pc < 1)
+                return false;
+            nSize = *pc++;
+        }
+        else if (opcode == OP_PUSHDATA2)
+        {
+            if (pend - pc < 2)
+                return false;
+            nSize = 0;
+            memcpy(&nSize, &pc[0], 2);
+            pc += 2;
+        }
+        else if (opcode == OP_PUSHDATA4)
+        {
+            if (pend - pc < 4)
+                return false;
+            memcpy(&nSize, &pc[0], 4);
+            pc += 4;
+        }
+        if (pend - pc < 0 || (unsigned int)(pend - pc) < nSize)
+            return false;
+        if (pvchRet)
+            pvchRet->assign(pc, pc + nSize);
+        pc += nSize;
+    }
+
+    opcodeRet = (opcodetype)opcode;
+    return true;
+}
+
 /** Serialized script, used inside transaction inputs and outputs */
-class CScript : public std::vector<unsigned char>
+class CScript : public CScriptBase
 {
 protected:
     CScript& push_int64(int64_t n)
@@ -416,14 +482,18 @@ protected:
     }
 public:
     CScript() { }
-    CScript(const CScript& b) : std::vector<unsigned char>(b.begin(), b.end()) { }
-    CScript(const_iterator pbegin, const_iterator pend) : std::vector<unsigned char>(pbegin, pend) { }
-#ifndef _MSC_VER
-    CScript(const unsigned char* pbegin, const unsigned char* pend) : std::vector<unsigned char>(pbegin, pend) { }
-#endif
+    CScript(const CScript& b) : CScriptBase(b.begin(), b.end()) { }
+    CScript(const_iterator pbegin, const_iterator pend) : CScriptBase(pbegin, pend) { }
+    CScript(std::vector<unsigned char>::const_iterator pbegin, std::vector<unsigned char>::const_iterator pend) : CScriptBase(pbegin, pend) { }
 
     CScript& operator+=(const CScript& b)
     {
+        /**-5-10prevector::insert() needs a range outside the script itself
+        if (&b == this) {
+            CScript copy(b);
+            insert(end(), copy.begin(), copy.end());
+            return *this;
+        }
         insert(end(), b.begin(), b.end());
         return *this;
     }
@@ -547,55 +617,7 @@ public:
 
     bool GetOp2(const_iterator& pc, opcodetype& opcodeRet, std::vector<unsigned char>* pvchRet) const
     {
-        opcodeRet = OP_INVALIDOPCODE;
-        if (pvchRet)
-            pvchRet->clear();
-        if (pc >= end())
-            return false;
-
-        /**-5-10Read instruction
-        if (end() - pc < 1)
-            return false;
-        unsigned int opcode = *pc++;
-
-        /**-5-10Immediate operand
-        if (opcode <= OP_PUSHDATA4)
-        {
-            unsigned int nSize = 0;
-            if (opcode < OP_PUSHDATA1)
-            {
-                nSize = opcode;
-            }
-            else if (opcode == OP_PUSHDATA1)
-            {
-                if (end() - pc < 1)
-                    return false;
-                nSize = *pc++;
-            }
-            else if (opcode == OP_PUSHDATA2)
-            {
-                if (end() - pc < 2)
-                    return false;
-                nSize = 0;
-                memcpy(&nSize, &pc[0], 2);
-                pc += 2;
-            }
-            else if (opcode == OP_PUSHDATA4)
-            {
-                if (end() - pc < 4)
-                    return false;
-                memcpy(&nSize, &pc[0], 4);
-                pc += 4;
-            }
-            if (end() - pc < 0 || (unsigned int)(end() - pc) < nSize)
-                return false;
-            if (pvchRet)
-                pvchRet->assign(pc, pc + nSize);
-            pc += nSize;
-        }
-
-        opcodeRet = (opcodetype)opcode;
-        return true;
+        return GetScriptOp(pc, end(), opcodeRet, pvchRet);
     }
 
     /**-5-10Encode/decode small integers:
@@ -785,10 +807,35 @@ public:
     }
 };
 
+/** Precomputed data for the signature hashes of all inputs of one transaction.
+ *
+ * Unless the hash type has SIGHASH_ANYONECANPAY, SIGHASH_NONE or SIGHASH_SINGLE, what is signed
+ * for an input is the whole transaction with every scriptSig blanked, except that the input's
+ * own is replaced by the scriptCode. Everything else is serialized once here, along with the
+ * SHA256 state at the start of each input, so each signature hash only hashes the signed input
+ * and what follows it. Other hash types go to SignatureHash. The context does not change after
+ * construction and may be shared between script check threads.
+ */
+class CSigHashContext
+{
+private:
+    const CTransaction& txTo;
+    std::vector<unsigned char> vchData;    /**-5-10txTo with all scriptSigs blanked
+    std::vector<unsigned int> vInputPos;   /**-5-10offset of each input in vchData
+    std::vector<SHA256_CTX> vMidstate;     /**-5-10SHA256 state after hashing vchData up to each input
+
+public:
+    explicit CSigHashContext(const CTransaction& txToIn);
+
+    uint256 SignatureHash(const CScript& scriptCode, unsigned int nIn, int nHashType) const;
+};
+
+/** Number of signature checks done so far, and how many of them were answered by the signature cache */
+void GetSigCheckStats(uint64_t& nChecks, uint64_t& nCacheHits);
 bool IsCanonicalPubKey(const std::vector<unsigned char> &vchPubKey, unsigned int flags);
 bool IsCanonicalSignature(const std::vector<unsigned char> &vchSig, unsigned int flags);
 
-bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript& script, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType);
+bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript& script, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType, const CSigHashContext* psighash = NULL);
 bool Solver(const CScript& scriptPubKey, txnouttype& typeRet, std::vector<std::vector<unsigned char> >& vSolutionsRet);
 int ScriptSigArgsExpected(txnouttype t, const std::vector<std::vector<unsigned char> >& vSolutions);
 bool IsStandard(const CScript& scriptPubKey, txnouttype& whichType);
@@ -799,7 +846,14 @@ bool ExtractDestination(const CScript& scriptPubKey, CTxDestination& addressRet)
 bool ExtractDestinations(const CScript& scriptPubKey, txnouttype& typeRet, std::vector<CTxDestination>& addressRet, int& nRequiredRet);
 bool SignSignature(const CKeyStore& keystore, const CScript& fromPubKey, CTransaction& txTo, unsigned int nIn, int nHashType=SIGHASH_ALL);
 bool SignSignature(const CKeyStore& keystore, const CTransaction& txFrom, CTransaction& txTo, unsigned int nIn, int nHashType=SIGHASH_ALL);
-bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType);
+bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType, const CSigHashContext* psighash = NULL);
+/** VerifyScript for the standard forms (P2PK, P2PKH, multisig, and those as P2SH redeem scripts) without
+ * running the generic interpreter. Returns false if the script pair is not handled; otherwise sets fRet
+ * to the result VerifyScript gives for it.
+ */
+bool VerifyStandardScript(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType, bool& fRet, const CSigHashContext* psighash = NULL);
+/** VerifyScript using only EvalScript */
+bool VerifyScriptGeneric(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType, const CSigHashContext* psighash = NULL);
 
 /**-5-10Given two sets of signatures for scriptPubKey, possibly with OP_0 placeholders,
 /**-5-10combine them intelligently and return the result.
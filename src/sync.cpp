@@ -16,6 +16,132 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+bool fLockProfiling = false;
+
+/**-5-10A lock currently held by this thread: when it was taken, and how much of the
+/**-5-10time since went to locks nested in it and to the profiler's bookkeeping
+struct CLockProfileFrame
+{
+    CLockStats* psite;
+    bool fContended;
+    int64_t nWaitMicros;
+    int64_t nStart;
+    int64_t nChildMicros;
+    int64_t nOverheadMicros;
+};
+
+typedef std::vector<CLockProfileFrame> LockProfileStack;
+
+/**-5-10A plain mutex: the profiler must not profile itself
+static boost::mutex lockprofile_mutex;
+/**-5-10Lock sites by file, line and lock name (LOCK2 takes two locks on one line).
+/**-5-10Entries are never removed, so pointers to them stay valid.
+typedef std::pair<std::pair<const char*, int>, const char*> LockSiteKey;
+static std::map<LockSiteKey, CLockStats> mapLockSites;
+/**-5-10Time spent holding the innermost lock, by nesting of lock sites
+static std::map<std::vector<const CLockStats*>, int64_t> mapLockStacks;
+static boost::thread_specific_ptr<LockProfileStack> lockprofilestack;
+
+int64_t LockProfileTime()
+{
+    return GetTimeMicros();
+}
+
+CLockStats* LockProfileSite(const char* pszName, const char* pszFile, int nLine)
+{
+    int64_t nBegin = LockProfileTime();
+    CLockStats* psite;
+    {
+        boost::unique_lock<boost::mutex> lock(lockprofile_mutex);
+        LockSiteKey key(std::make_pair(pszFile, nLine), pszName);
+        std::map<LockSiteKey, CLockStats>::iterator it = mapLockSites.find(key);
+        if (it == mapLockSites.end()) {
+            CLockStats stats;
+            stats.strName = pszName;
+            stats.strFile = pszFile;
+            stats.nLine = nLine;
+            stats.nAcquisitions = stats.nContended = 0;
+            stats.nWaitMicros = stats.nMaxWaitMicros = stats.nHoldMicros = stats.nMaxHoldMicros = 0;
+            it = mapLockSites.insert(std::make_pair(key, stats)).first;
+        }
+        psite = &it->second;
+    }
+    if (lockprofilestack.get() == NULL)
+        lockprofilestack.reset(new LockProfileStack);
+    if (!lockprofilestack->empty())
+        lockprofilestack->back().nOverheadMicros += LockProfileTime() - nBegin;
+    return psite;
+}
+
+void LockProfileAcquired(CLockStats* psite, bool fContended, int64_t nStartMicros)
+{
+    CLockProfileFrame frame;
+    frame.psite = psite;
+    frame.fContended = fContended;
+    frame.nStart = LockProfileTime();
+    frame.nWaitMicros = fContended ? frame.nStart - nStartMicros : 0;
+    frame.nChildMicros = 0;
+    frame.nOverheadMicros = 0;
+    lockprofilestack->push_back(frame);
+}
+
+void LockProfileReleased(int64_t nEndMicros)
+{
+    LockProfileStack& stack = *lockprofilestack;
+    CLockProfileFrame frame = stack.back();
+    int64_t nHoldMicros = std::max((int64_t)0, nEndMicros - frame.nStart - frame.nOverheadMicros);
+    std::vector<const CLockStats*> vSites;
+    vSites.reserve(stack.size());
+    BOOST_FOREACH(const CLockProfileFrame& f, stack)
+        vSites.push_back(f.psite);
+    stack.pop_back();
+
+    {
+        boost::unique_lock<boost::mutex> lock(lockprofile_mutex);
+        CLockStats& stats = *frame.psite;
+        stats.nAcquisitions++;
+        if (frame.fContended)
+            stats.nContended++;
+        stats.nWaitMicros += frame.nWaitMicros;
+        stats.nMaxWaitMicros = std::max(stats.nMaxWaitMicros, frame.nWaitMicros);
+        stats.nHoldMicros += nHoldMicros;
+        stats.nMaxHoldMicros = std::max(stats.nMaxHoldMicros, nHoldMicros);
+        mapLockStacks[vSites] += std::max((int64_t)0, nHoldMicros - frame.nChildMicros);
+    }
+
+    if (!stack.empty()) {
+        /**-5-10The enclosing lock was held through this lock's bookkeeping as well
+        stack.back().nChildMicros += nHoldMicros;
+        stack.back().nOverheadMicros += frame.nOverheadMicros + (LockProfileTime() - nEndMicros);
+    }
+}
+
+std::vector<CLockStats> GetLockStats()
+{
+    std::vector<CLockStats> vStats;
+    boost::unique_lock<boost::mutex> lock(lockprofile_mutex);
+    vStats.reserve(mapLockSites.size());
+    for (std::map<LockSiteKey, CLockStats>::const_iterator it = mapLockSites.begin(); it != mapLockSites.end(); it++)
+        vStats.push_back(it->second);
+    return vStats;
+}
+
+std::string GetLockStacksFolded()
+{
+    std::string strOut;
+    boost::unique_lock<boost::mutex> lock(lockprofile_mutex);
+    for (std::map<std::vector<const CLockStats*>, int64_t>::const_iterator it = mapLockStacks.begin(); it != mapLockStacks.end(); it++) {
+        for (unsigned int i = 0; i < it->first.size(); i++) {
+            const CLockStats& stats = *it->first[i];
+            if (i > 0)
+                strOut += ";";
+            strOut += strprintf("%s@%s:%d", stats.strName, stats.strFile, stats.nLine);
+        }
+        strOut += strprintf(" %d\n", it->second);
+    }
+    return strOut;
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 /**-5-10Early deadlock detection.
@@ -13,6 +13,10 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 
+#include <stdint.h>
+#include <string>
+#include <vector>
+
 
 ////////////////////////////////////////////////
 /**-5-10                                           //
@@ -100,16 +104,59 @@ void static inline AssertLockHeldInternal(const char* pszName, const char* pszFi
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/**-5-10Lock profiling (-lockprofile): how often each LOCK/TRY_LOCK site takes its
+/**-5-10lock, how long it waits for it and how long it holds it. Costs a single
+/**-5-10branch per lock when off. The profiler's own bookkeeping is done while the
+/**-5-10lock is not held, and is not counted as holding enclosing locks either.
+extern bool fLockProfiling;
+
+struct CLockStats
+{
+    std::string strName;
+    std::string strFile;
+    int nLine;
+    uint64_t nAcquisitions;
+    uint64_t nContended;      /**-5-10acquisitions that had to wait
+    int64_t nWaitMicros;
+    int64_t nMaxWaitMicros;
+    int64_t nHoldMicros;
+    int64_t nMaxHoldMicros;
+};
+
+/** The statistics of a lock site, looked up before the lock is taken */
+CLockStats* LockProfileSite(const char* pszName, const char* pszFile, int nLine);
+/** The lock of psite was taken; waiting for it started at nStartMicros */
+void LockProfileAcquired(CLockStats* psite, bool fContended, int64_t nStartMicros);
+/** The innermost profiled lock was held until nEndMicros, and has been released */
+void LockProfileReleased(int64_t nEndMicros);
+int64_t LockProfileTime();
+/** Statistics for every lock site taken since profiling started */
+std::vector<CLockStats> GetLockStats();
+/** Hold times in the "folded stacks" format of flamegraph.pl: one line per
+ *  nesting of lock sites, "outer;inner microseconds", where the time is spent
+ *  holding the innermost lock and no lock nested in it. */
+std::string GetLockStacksFolded();
+
 /** Wrapper around boost::unique_lock<Mutex> */
 template<typename Mutex>
 class CMutexLock
 {
 private:
     boost::unique_lock<Mutex> lock;
+    CLockStats* pprofilesite;
 
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
+        if (fLockProfiling) {
+            pprofilesite = LockProfileSite(pszName, pszFile, nLine);
+            int64_t nStart = LockProfileTime();
+            bool fContended = !lock.try_lock();
+            if (fContended)
+                lock.lock();
+            LockProfileAcquired(pprofilesite, fContended, nStart);
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (!lock.try_lock())
         {
@@ -124,14 +171,22 @@ private:
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()), true);
+        int64_t nStart = 0;
+        if (fLockProfiling) {
+            pprofilesite = LockProfileSite(pszName, pszFile, nLine);
+            nStart = LockProfileTime();
+        }
         lock.try_lock();
-        if (!lock.owns_lock())
+        if (!lock.owns_lock()) {
             LeaveCritical();
+            pprofilesite = NULL;
+        } else if (pprofilesite)
+            LockProfileAcquired(pprofilesite, false, nStart);
         return lock.owns_lock();
     }
 
 public:
-    CMutexLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) : lock(mutexIn, boost::defer_lock)
+    CMutexLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) : lock(mutexIn, boost::defer_lock), pprofilesite(NULL)
     {
         if (fTry)
             TryEnter(pszName, pszFile, nLine);
@@ -143,6 +198,11 @@ public:
     {
         if (lock.owns_lock())
             LeaveCritical();
+        if (pprofilesite) {
+            int64_t nEnd = LockProfileTime();
+            lock.unlock();
+            LockProfileReleased(nEnd);
+        }
     }
 
     operator bool()
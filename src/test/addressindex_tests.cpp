@@ -0,0 +1,237 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "addressindex.h"
+#include "chainparams.h"
+#include "main.h"
+#include "serialize.h"
+#include "txdb.h"
+#include "uint256.h"
+#include "util.h"
+#include "version.h"
+
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+static std::string SerializeKey(const CAddressIndexKey& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << std::make_pair('a', key);
+    return ss.str();
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_key_order)
+{
+    /**-5-10LevelDB iterates in bytewise key order, which must follow (height, position in block)
+    uint160 hash(0x1234);
+    CAddressIndexKey a(ADDRESSINDEX_PUBKEYHASH, hash, 255, 3, uint256(7), 0, false);
+    CAddressIndexKey b(ADDRESSINDEX_PUBKEYHASH, hash, 256, 0, uint256(1), 0, false);
+    CAddressIndexKey c(ADDRESSINDEX_PUBKEYHASH, hash, 256, 1, uint256(0), 0, true);
+    CAddressIndexKey d(ADDRESSINDEX_PUBKEYHASH, hash, 65536, 0, uint256(0), 0, false);
+    BOOST_CHECK(SerializeKey(a) < SerializeKey(b));
+    BOOST_CHECK(SerializeKey(b) < SerializeKey(c));
+    BOOST_CHECK(SerializeKey(c) < SerializeKey(d));
+
+    /**-5-10All entries of one address sort before those of another
+    CAddressIndexKey e(ADDRESSINDEX_SCRIPTHASH, hash, 0, 0, uint256(0), 0, false);
+    BOOST_CHECK(SerializeKey(d) < SerializeKey(e));
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_key_roundtrip)
+{
+    CAddressIndexKey key(ADDRESSINDEX_SCRIPTHASH, uint160(42), 300000, 17, uint256(99), 5, true);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    BOOST_CHECK_EQUAL(ss.size(), key.GetSerializeSize(SER_DISK, CLIENT_VERSION));
+    CAddressIndexKey key2;
+    ss >> key2;
+    BOOST_CHECK_EQUAL(key2.nType, key.nType);
+    BOOST_CHECK(key2.hashBytes == key.hashBytes);
+    BOOST_CHECK_EQUAL(key2.nHeight, key.nHeight);
+    BOOST_CHECK_EQUAL(key2.nTxPos, key.nTxPos);
+    BOOST_CHECK(key2.txhash == key.txhash);
+    BOOST_CHECK_EQUAL(key2.nIndex, key.nIndex);
+    BOOST_CHECK_EQUAL(key2.fSpending, key.fSpending);
+
+    CAddressUnspentKey ukey(ADDRESSINDEX_PUBKEYHASH, uint160(42), uint256(99), 70000);
+    CDataStream ssu(SER_DISK, CLIENT_VERSION);
+    ssu << ukey;
+    CAddressUnspentKey ukey2;
+    ssu >> ukey2;
+    BOOST_CHECK(ukey2.txhash == ukey.txhash);
+    BOOST_CHECK_EQUAL(ukey2.nIndex, ukey.nIndex);
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_destination)
+{
+    unsigned char nType;
+    uint160 hashBytes;
+    BOOST_CHECK(GetAddressIndexHash(CKeyID(uint160(5)), nType, hashBytes));
+    BOOST_CHECK_EQUAL(nType, ADDRESSINDEX_PUBKEYHASH);
+    BOOST_CHECK(hashBytes == uint160(5));
+    BOOST_CHECK(GetAddressIndexHash(CScriptID(uint160(6)), nType, hashBytes));
+    BOOST_CHECK_EQUAL(nType, ADDRESSINDEX_SCRIPTHASH);
+    BOOST_CHECK(!GetAddressIndexHash(CNoDestination(), nType, hashBytes));
+}
+
+/**-5-10Mine a regtest block on top of pprev, whose coinbase pays nValue to scriptCoinbase
+static CBlock MineIndexTestBlock(CBlockIndex *pprev, const CScript &scriptCoinbase, int64_t nValue,
+                                 const std::vector<CTransaction> &vtx, int nExtraNonce)
+{
+    CBlock block;
+    block.nVersion = 1;
+    block.hashPrevBlock = pprev->GetBlockHash();
+    block.nTime = pprev->nTime + 1;
+    block.nBits = pprev->nBits;
+    block.vtx.resize(1);
+    block.vtx[0].vin.resize(1);
+    block.vtx[0].vin[0].scriptSig = CScript() << (pprev->nHeight + 1) << nExtraNonce;
+    block.vtx[0].vout.resize(1);
+    block.vtx[0].vout[0].nValue = nValue;
+    block.vtx[0].vout[0].scriptPubKey = scriptCoinbase;
+    block.vtx.insert(block.vtx.end(), vtx.begin(), vtx.end());
+    block.hashMerkleRoot = block.BuildMerkleTree();
+    while (!CheckProofOfWork(block.GetHash(), block.nBits))
+        block.nNonce++;
+    return block;
+}
+
+static std::vector<std::pair<CAddressIndexKey, int64_t> > ReadHistory(unsigned char nType, const uint160 &hashBytes)
+{
+    std::vector<std::pair<CAddressIndexKey, int64_t> > vHistory;
+    BOOST_CHECK(pblocktree->ReadAddressIndex(CAddressIndexKey(nType, hashBytes, 0, 0, 0, 0, false), 100, vHistory, NULL));
+    return vHistory;
+}
+
+static std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > ReadUnspent(unsigned char nType, const uint160 &hashBytes)
+{
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+    BOOST_CHECK(pblocktree->ReadAddressUnspentIndex(CAddressUnspentKey(nType, hashBytes, 0, 0), 100, vUnspent, NULL));
+    return vUnspent;
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_connect_disconnect)
+{
+    LOCK(cs_main);
+    uint256 hashTipSaved = chainActive.Tip()->GetBlockHash();
+    CBlockTreeDB *pblocktreeSaved = pblocktree;
+    CCoinsViewDB *pcoinsdbviewSaved = pcoinsdbview;
+    CCoinsViewCache *pcoinsTipSaved = pcoinsTip;
+    BOOST_CHECK(pcoinsTip->Flush());
+
+    /**-5-10A new regtest chain state with the address index enabled
+    SelectParams(CChainParams::REGTEST);
+    UnloadBlockIndex();
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+    pcoinsdbview = new CCoinsViewDB(1 << 23, true);
+    pcoinsTip = new CCoinsViewCache(*pcoinsdbview);
+    LoadBlockFileInfo();
+    mapArgs["-addressindex"] = "1";
+    BOOST_REQUIRE(InitBlockIndex());
+    BOOST_REQUIRE(fAddressIndex);
+
+    /**-5-10Block 1 pays a script hash address; a transaction in block 101, once the coinbase
+    /**-5-10has matured, moves the coins on to a key hash address
+    CScript scriptRedeem = CScript() << OP_TRUE;
+    uint160 hashScript = scriptRedeem.GetID();
+    CScript scriptP2SH;
+    scriptP2SH.SetDestination(scriptRedeem.GetID());
+    uint160 hashKey(0x5678);
+    CScript scriptP2PKH;
+    scriptP2PKH.SetDestination(CKeyID(hashKey));
+    CScript scriptNone = CScript() << OP_TRUE;
+
+    CValidationState state;
+    std::vector<CTransaction> vtxNone;
+    CBlock block = MineIndexTestBlock(chainActive.Tip(), scriptP2SH, COIN, vtxNone, 0);
+    uint256 hashCoinbase = block.vtx[0].GetHash();
+    BOOST_REQUIRE(ProcessBlock(state, NULL, &block));
+    while (chainActive.Height() < COINBASE_MATURITY) {
+        block = MineIndexTestBlock(chainActive.Tip(), scriptNone, 0, vtxNone, 0);
+        BOOST_REQUIRE(ProcessBlock(state, NULL, &block));
+    }
+    CBlockIndex *pindexFork = chainActive.Tip();
+
+    std::vector<std::pair<CAddressIndexKey, int64_t> > vHistory = ReadHistory(ADDRESSINDEX_SCRIPTHASH, hashScript);
+    BOOST_REQUIRE_EQUAL(vHistory.size(), 1U);
+    BOOST_CHECK_EQUAL(vHistory[0].first.nHeight, 1);
+    BOOST_CHECK(vHistory[0].first.txhash == hashCoinbase);
+    BOOST_CHECK(!vHistory[0].first.fSpending);
+    BOOST_CHECK_EQUAL(vHistory[0].second, COIN);
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent = ReadUnspent(ADDRESSINDEX_SCRIPTHASH, hashScript);
+    BOOST_REQUIRE_EQUAL(vUnspent.size(), 1U);
+    BOOST_CHECK(vUnspent[0].first.txhash == hashCoinbase);
+    BOOST_CHECK_EQUAL(vUnspent[0].second.nValue, COIN);
+    BOOST_CHECK_EQUAL(vUnspent[0].second.nHeight, 1);
+    BOOST_CHECK(vUnspent[0].second.script == scriptP2SH);
+
+    CTransaction tx;
+    tx.vin.push_back(CTxIn(COutPoint(hashCoinbase, 0), CScript() << std::vector<unsigned char>(scriptRedeem.begin(), scriptRedeem.end())));
+    tx.vout.push_back(CTxOut(COIN, scriptP2PKH));
+    uint256 hashSpend = tx.GetHash();
+    block = MineIndexTestBlock(chainActive.Tip(), scriptNone, 0, std::vector<CTransaction>(1, tx), 0);
+    BOOST_REQUIRE(ProcessBlock(state, NULL, &block));
+    BOOST_REQUIRE_EQUAL(chainActive.Height(), COINBASE_MATURITY + 1);
+
+    /**-5-10Connecting the block adds the spend and the new output to the history, and moves
+    /**-5-10the unspent entry
+    vHistory = ReadHistory(ADDRESSINDEX_SCRIPTHASH, hashScript);
+    BOOST_REQUIRE_EQUAL(vHistory.size(), 2U);
+    BOOST_CHECK_EQUAL(vHistory[1].first.nHeight, COINBASE_MATURITY + 1);
+    BOOST_CHECK_EQUAL(vHistory[1].first.nTxPos, 1U);
+    BOOST_CHECK(vHistory[1].first.txhash == hashSpend);
+    BOOST_CHECK(vHistory[1].first.fSpending);
+    BOOST_CHECK_EQUAL(vHistory[1].second, -COIN);
+    BOOST_CHECK(ReadUnspent(ADDRESSINDEX_SCRIPTHASH, hashScript).empty());
+    vHistory = ReadHistory(ADDRESSINDEX_PUBKEYHASH, hashKey);
+    BOOST_REQUIRE_EQUAL(vHistory.size(), 1U);
+    BOOST_CHECK(vHistory[0].first.txhash == hashSpend && !vHistory[0].first.fSpending);
+    BOOST_CHECK_EQUAL(vHistory[0].second, COIN);
+    vUnspent = ReadUnspent(ADDRESSINDEX_PUBKEYHASH, hashKey);
+    BOOST_REQUIRE_EQUAL(vUnspent.size(), 1U);
+    BOOST_CHECK(vUnspent[0].first.txhash == hashSpend);
+    BOOST_CHECK_EQUAL(vUnspent[0].second.nHeight, COINBASE_MATURITY + 1);
+
+    /**-5-10A longer fork without the spend disconnects its block, which erases its entries
+    /**-5-10and brings back the spent output
+    CBlockIndex *pindex = pindexFork;
+    for (int i = 0; i < 2; i++) {
+        block = MineIndexTestBlock(pindex, scriptNone, 0, vtxNone, 1);
+        BOOST_REQUIRE(ProcessBlock(state, NULL, &block));
+        pindex = mapBlockIndex[block.GetHash()];
+    }
+    BOOST_REQUIRE(chainActive.Tip() == pindex);
+
+    vHistory = ReadHistory(ADDRESSINDEX_SCRIPTHASH, hashScript);
+    BOOST_REQUIRE_EQUAL(vHistory.size(), 1U);
+    BOOST_CHECK(vHistory[0].first.txhash == hashCoinbase);
+    vUnspent = ReadUnspent(ADDRESSINDEX_SCRIPTHASH, hashScript);
+    BOOST_REQUIRE_EQUAL(vUnspent.size(), 1U);
+    BOOST_CHECK(vUnspent[0].first.txhash == hashCoinbase);
+    BOOST_CHECK_EQUAL(vUnspent[0].second.nValue, COIN);
+    BOOST_CHECK_EQUAL(vUnspent[0].second.nHeight, 1);
+    BOOST_CHECK(vUnspent[0].second.script == scriptP2SH);
+    BOOST_CHECK(ReadHistory(ADDRESSINDEX_PUBKEYHASH, hashKey).empty());
+    BOOST_CHECK(ReadUnspent(ADDRESSINDEX_PUBKEYHASH, hashKey).empty());
+
+    /**-5-10Bring back the fixture's chain
+    mempool.clear();
+    mapArgs.erase("-addressindex");
+    UnloadBlockIndex();
+    delete pcoinsTip;
+    delete pcoinsdbview;
+    delete pblocktree;
+    pblocktree = pblocktreeSaved;
+    pcoinsdbview = pcoinsdbviewSaved;
+    pcoinsTip = pcoinsTipSaved;
+    SelectParams(CChainParams::MAIN);
+    BOOST_CHECK(LoadBlockIndex());
+    BOOST_CHECK(!fAddressIndex);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == hashTipSaved);
+    LoadBlockFileInfo();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
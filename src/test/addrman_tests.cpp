@@ -0,0 +1,161 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "addrman.h"
+#include "serialize.h"
+#include "util.h"
+#include "version.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+
+static CAddress RandomAddress(uint16_t nPort = 8333)
+{
+    /**-5-105.0.0.0/8 is routable, and spreads over many /16 groups
+    std::string strIP = strprintf("5.%i.%i.%i", insecure_rand() % 256, insecure_rand() % 256, insecure_rand() % 256);
+    CAddress addr(CService(strIP, nPort));
+    addr.nTime = GetAdjustedTime() - insecure_rand() % (24 * 60 * 60);
+    return addr;
+}
+
+static std::string Serialized(const CAddrMan& addrman)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << addrman;
+    return ss.str();
+}
+
+BOOST_AUTO_TEST_SUITE(addrman_tests)
+
+BOOST_AUTO_TEST_CASE(addrman_simple)
+{
+    CAddrMan addrman;
+    BOOST_CHECK_EQUAL(addrman.size(), 0);
+    BOOST_CHECK(!addrman.Select().IsValid());
+
+    CAddress addr(CService("5.1.2.3", 8333));
+    addr.nTime = GetAdjustedTime();
+    CNetAddr source("5.9.9.9");
+    BOOST_CHECK(addrman.Add(addr, source));
+    BOOST_CHECK(!addrman.Add(addr, source));
+    BOOST_CHECK_EQUAL(addrman.size(), 1);
+    BOOST_CHECK(addrman.Select(100) == addr);
+
+    /**-5-10Unroutable addresses are ignored
+    BOOST_CHECK(!addrman.Add(CAddress(CService("10.0.0.1", 8333)), source));
+    BOOST_CHECK_EQUAL(addrman.size(), 1);
+
+    /**-5-10Once good, the only address moves to the tried table
+    addrman.Good(addr);
+    BOOST_CHECK_EQUAL(addrman.size(), 1);
+    BOOST_CHECK(addrman.Select(0) == addr);
+}
+
+BOOST_AUTO_TEST_CASE(addrman_flood)
+{
+    seed_insecure_rand(true);
+    CAddrMan addrman;
+    std::set<CService> setAdded;
+
+    /**-5-10Few sources, so that their "new" buckets overflow and entries get evicted
+    for (int i = 0; i < 30000; i++) {
+        CAddress addr = RandomAddress();
+        CNetAddr source(strprintf("5.%i.0.1", insecure_rand() % 4));
+        addrman.Add(addr, source);
+        setAdded.insert(addr);
+    }
+    BOOST_CHECK(addrman.size() > 0);
+    BOOST_CHECK(addrman.size() <= ADDRMAN_NEW_BUCKET_COUNT * ADDRMAN_NEW_BUCKET_SIZE);
+
+    /**-5-10Mark a part of what is left good, evicting from full "tried" buckets too
+    std::vector<CAddress> vAddr = addrman.GetAddr();
+    BOOST_CHECK(!vAddr.empty());
+    BOOST_CHECK(vAddr.size() <= (unsigned int)addrman.size());
+    for (unsigned int i = 0; i < vAddr.size(); i++) {
+        BOOST_CHECK(setAdded.count(vAddr[i]));
+        addrman.Good(vAddr[i]);
+    }
+    int nSize = addrman.size();
+    BOOST_CHECK(nSize > 0);
+
+    for (int i = 0; i < 1000; i++) {
+        CAddress addr = addrman.Select(insecure_rand() % 101);
+        BOOST_CHECK(setAdded.count(addr));
+        addrman.Attempt(addr);
+    }
+    BOOST_CHECK_EQUAL(addrman.size(), nSize);
+
+    /**-5-10Deserializing and serializing again reproduces the same bytes
+    std::string str = Serialized(addrman);
+    CDataStream ss(str.data(), str.data() + str.size(), SER_DISK, CLIENT_VERSION);
+    CAddrMan addrman2;
+    ss >> addrman2;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK_EQUAL(addrman2.size(), nSize);
+    BOOST_CHECK(Serialized(addrman2) == str);
+}
+
+/**-5-10A peers.dat whose "new" entries do not all fit: nNew addresses from one
+/**-5-10group and source, followed by nUBuckets bucket lists of which the first
+/**-5-10holds every entry
+static std::string OverfullPeers(int nNew, int nUBuckets)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    unsigned char nVersion = 0;
+    std::vector<unsigned char> nKey(32, 0x55);
+    int nTried = 0;
+    ss << nVersion << nKey << nNew << nTried << nUBuckets;
+    CNetAddr source("5.9.9.9");
+    for (int i = 0; i < nNew; i++) {
+        CAddress addr(CService(strprintf("5.1.%i.%i", i / 256, i % 256), 8333));
+        addr.nTime = GetAdjustedTime();
+        ss << CAddrInfo(addr, source);
+    }
+    for (int b = 0; b < nUBuckets; b++) {
+        int nSize = b == 0 ? nNew : 0;
+        ss << nSize;
+        for (int i = 0; i < nSize; i++)
+            ss << i;
+    }
+    return ss.str();
+}
+
+BOOST_AUTO_TEST_CASE(addrman_load_overfull)
+{
+    /**-5-10Bucket count changed: every address is rehashed into the same full bucket.
+    /**-5-10Same bucket count: the stored list overflows bucket 0.
+    int vUBuckets[] = { ADDRMAN_NEW_BUCKET_COUNT / 2, ADDRMAN_NEW_BUCKET_COUNT };
+    BOOST_FOREACH(int nUBuckets, vUBuckets) {
+        std::string str = OverfullPeers(3 * ADDRMAN_NEW_BUCKET_SIZE, nUBuckets);
+        CDataStream ss(str.data(), str.data() + str.size(), SER_DISK, CLIENT_VERSION);
+        CAddrMan addrman;
+        ss >> addrman;
+        BOOST_CHECK(ss.empty());
+        addrman.Check();
+        BOOST_CHECK_EQUAL(addrman.size(), ADDRMAN_NEW_BUCKET_SIZE);
+
+        /**-5-10What is written back loads again, and unchanged
+        std::string str2 = Serialized(addrman);
+        CDataStream ss2(str2.data(), str2.data() + str2.size(), SER_DISK, CLIENT_VERSION);
+        CAddrMan addrman2;
+        ss2 >> addrman2;
+        BOOST_CHECK(ss2.empty());
+        addrman2.Check();
+        BOOST_CHECK_EQUAL(addrman2.size(), ADDRMAN_NEW_BUCKET_SIZE);
+        BOOST_CHECK(Serialized(addrman2) == str2);
+
+        /**-5-10Freed entries are reused by new addresses
+        CAddress addr(CService("5.200.1.1", 8333));
+        addr.nTime = GetAdjustedTime();
+        BOOST_CHECK(addrman2.Add(addr, CNetAddr("5.201.1.1")));
+        addrman2.Check();
+        BOOST_CHECK_EQUAL(addrman2.size(), ADDRMAN_NEW_BUCKET_SIZE + 1);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
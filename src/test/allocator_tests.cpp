@@ -114,4 +114,49 @@ BOOST_AUTO_TEST_CASE(test_LockedPageManagerBase)
     BOOST_CHECK((last_unlock_len & (test_page_size-1)) == 0); /**-5-10always unlock entire pages
 }
 
+
+BOOST_AUTO_TEST_CASE(net_buffer_pool)
+{
+    BOOST_CHECK_EQUAL(CNetBufferPool::GetClass(1), 0);
+    BOOST_CHECK_EQUAL(CNetBufferPool::GetClass(256), 0);
+    BOOST_CHECK_EQUAL(CNetBufferPool::GetClass(257), 1);
+    BOOST_CHECK_EQUAL(CNetBufferPool::GetClass(8 << 20), 15);
+    BOOST_CHECK_EQUAL(CNetBufferPool::GetClass((8 << 20) + 1), -1);
+
+    CNetBufferPool& pool = CNetBufferPool::Instance();
+
+    /**-5-10A released buffer is handed out again for any request of its size class
+    void* p = pool.Allocate(1000);
+    size_t nPooled = pool.GetPooledBytes();
+    pool.Deallocate(p, 1000);
+    BOOST_CHECK_EQUAL(pool.GetPooledBytes(), nPooled + 1024);
+    uint64_t nHits = pool.GetHits();
+    void* q = pool.Allocate(700);
+    BOOST_CHECK(q == p);
+    BOOST_CHECK_EQUAL(pool.GetHits(), nHits + 1);
+    BOOST_CHECK_EQUAL(pool.GetPooledBytes(), nPooled);
+
+    /**-5-10Oversized requests bypass the pool
+    void* pLarge = pool.Allocate((8 << 20) + 1);
+    pool.Deallocate(pLarge, (8 << 20) + 1);
+    BOOST_CHECK_EQUAL(pool.GetPooledBytes(), nPooled);
+
+    /**-5-10Nothing is kept beyond the limit, and lowering it releases what is pooled
+    pool.SetMaxPooledBytes(0);
+    BOOST_CHECK_EQUAL(pool.GetPooledBytes(), 0);
+    pool.Deallocate(q, 700);
+    BOOST_CHECK_EQUAL(pool.GetPooledBytes(), 0);
+    pool.SetMaxPooledBytes(32 << 20);
+
+    /**-5-10Vectors using the allocator recycle their buffers
+    {
+        std::vector<char, pooled_allocator<char> > v(5000, 'x');
+    }
+    BOOST_CHECK_EQUAL(pool.GetPooledBytes(), 8192);
+    nHits = pool.GetHits();
+    std::vector<char, pooled_allocator<char> > v(6000);
+    BOOST_CHECK_EQUAL(pool.GetHits(), nHits + 1);
+    BOOST_CHECK(v[0] == 0 && v[5999] == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
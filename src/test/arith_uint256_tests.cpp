@@ -0,0 +1,177 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "arith_uint256.h"
+#include "bignum.h"
+#include "chainparams.h"
+#include "main.h"
+#include "uint256.h"
+#include "util.h"
+
+#include <stdint.h>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+/**-5-10Differential ("fuzz") tests of arith_uint256 against the CBigNum code it replaced
+/**-5-10in the consensus paths. Every case runs on insecure_rand() inputs and requires
+/**-5-10bit-for-bit identical results.
+
+BOOST_AUTO_TEST_SUITE(arith_uint256_tests)
+
+static const int FUZZ_ROUNDS = 20000;
+
+/**-5-10A random 256-bit value with a random number of leading zero bits
+static arith_uint256 RandomArith()
+{
+    std::vector<unsigned char> vch(32);
+    for (unsigned int i = 0; i < vch.size(); i++)
+        vch[i] = insecure_rand() & 0xff;
+    return UintToArith256(uint256(vch)) >> (insecure_rand() % 256);
+}
+
+/**-5-10A random compact encoding, biased towards the exponents actually used for targets
+static uint32_t RandomCompact()
+{
+    uint32_t nSize = (insecure_rand() % 4) ? 0x1a + insecure_rand() % 8 : insecure_rand() % 0x24;
+    return (nSize << 24) | (insecure_rand() & 0x00ffffff);
+}
+
+static CBigNum ToBigNum(const arith_uint256& a)
+{
+    return CBigNum(ArithToUint256(a));
+}
+
+BOOST_AUTO_TEST_CASE(arith_uint256_compact)
+{
+    seed_insecure_rand(true);
+    for (int i = 0; i < FUZZ_ROUNDS; i++) {
+        uint32_t nCompact = RandomCompact();
+        CBigNum bn;
+        bn.SetCompact(nCompact);
+
+        bool fNegative;
+        bool fOverflow;
+        arith_uint256 a;
+        a.SetCompact(nCompact, &fNegative, &fOverflow);
+
+        BOOST_CHECK_EQUAL(fNegative, bn < 0);
+        if (!fNegative)
+            BOOST_CHECK_EQUAL(fOverflow, bn > ToBigNum(~arith_uint256()));
+        if (!fNegative && !fOverflow) {
+            BOOST_CHECK(ArithToUint256(a) == bn.getuint256());
+            BOOST_CHECK_EQUAL(a.GetCompact(), bn.GetCompact());
+        }
+
+        arith_uint256 b = RandomArith();
+        BOOST_CHECK_EQUAL(b.GetCompact(), ToBigNum(b).GetCompact());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(arith_uint256_arithmetic)
+{
+    seed_insecure_rand(true);
+    for (int i = 0; i < FUZZ_ROUNDS; i++) {
+        arith_uint256 a = RandomArith();
+        arith_uint256 b = RandomArith();
+        uint32_t n = insecure_rand();
+        unsigned int nShift = insecure_rand() % 256;
+        CBigNum bnA = ToBigNum(a);
+        CBigNum bnB = ToBigNum(b);
+
+        /**-5-10getuint256() truncates to the low 256 bits, like arith_uint256 wraps
+        BOOST_CHECK(ArithToUint256(a + b) == (bnA + bnB).getuint256());
+        BOOST_CHECK(ArithToUint256(a * b) == (bnA * bnB).getuint256());
+        BOOST_CHECK(ArithToUint256(a * n) == (bnA * CBigNum((uint64_t)n)).getuint256());
+        BOOST_CHECK(ArithToUint256(a << nShift) == (bnA << nShift).getuint256());
+        BOOST_CHECK(ArithToUint256(a >> nShift) == (bnA >> nShift).getuint256());
+        if (a >= b)
+            BOOST_CHECK(ArithToUint256(a - b) == (bnA - bnB).getuint256());
+        if (b != 0)
+            BOOST_CHECK(ArithToUint256(a / b) == (bnA / bnB).getuint256());
+        BOOST_CHECK_EQUAL(a < b, bnA < bnB);
+        BOOST_CHECK_EQUAL(a == b, bnA == bnB);
+    }
+    BOOST_CHECK_THROW(arith_uint256(1) / arith_uint256(0), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(arith_uint256_blockwork)
+{
+    seed_insecure_rand(true);
+    CBlockIndex index;
+    for (int i = 0; i < FUZZ_ROUNDS; i++) {
+        index.nBits = RandomCompact();
+
+        CBigNum bnTarget;
+        bnTarget.SetCompact(index.nBits);
+        CBigNum bnWork = 0;
+        if (bnTarget > 0)
+            bnWork = (CBigNum(1)<<256) / (bnTarget+1);
+        BOOST_CHECK(index.GetBlockWork() == bnWork.getuint256());
+
+        /**-5-10CheckProofOfWork against the old range and hash checks
+        uint256 hash = ArithToUint256(RandomArith());
+        bool fExpected = bnTarget > 0 && bnTarget <= CBigNum(Params().ProofOfWorkLimit()) &&
+                         hash <= bnTarget.getuint256();
+        BOOST_CHECK_EQUAL(CheckProofOfWork(hash, index.nBits), fExpected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(arith_uint256_minwork)
+{
+    seed_insecure_rand(true);
+    const CBigNum bnLimit(Params().ProofOfWorkLimit());
+    for (int i = 0; i < FUZZ_ROUNDS; i++) {
+        uint32_t nBase = RandomArith().GetCompact();
+        int64_t nTime = insecure_rand() % (60 * 24 * 60 * 60);
+
+        CBigNum bnResult;
+        bnResult.SetCompact(nBase);
+        int64_t nTimeLeft = nTime;
+        while (nTimeLeft > 0 && bnResult < bnLimit) {
+            bnResult *= 4;
+            nTimeLeft -= 14 * 24 * 60 * 60 * 4;
+        }
+        if (bnResult > bnLimit)
+            bnResult = bnLimit;
+
+        BOOST_CHECK_EQUAL(ComputeMinWork(nBase, nTime), bnResult.GetCompact());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(arith_uint256_retarget)
+{
+    seed_insecure_rand(true);
+    const int64_t nTargetTimespan = 14 * 24 * 60 * 60;
+    const int nInterval = nTargetTimespan / 60;
+    const CBigNum bnLimit(Params().ProofOfWorkLimit());
+
+    /**-5-10One full retarget interval; only the timestamps of its ends matter
+    std::vector<CBlockIndex> vIndex(nInterval);
+    for (int i = 0; i < nInterval; i++) {
+        vIndex[i].nHeight = i;
+        vIndex[i].pprev = i ? &vIndex[i - 1] : NULL;
+    }
+    CBlockIndex* pindexLast = &vIndex.back();
+
+    for (int i = 0; i < 500; i++) {
+        pindexLast->nBits = RandomArith().GetCompact();
+        vIndex[0].nTime = 1000000000;
+        pindexLast->nTime = vIndex[0].nTime + insecure_rand() % (nTargetTimespan * 5);
+
+        int64_t nActualTimespan = pindexLast->GetBlockTime() - vIndex[0].GetBlockTime();
+        nActualTimespan = std::max(nActualTimespan, nTargetTimespan / 4);
+        nActualTimespan = std::min(nActualTimespan, nTargetTimespan * 4);
+        CBigNum bnNew;
+        bnNew.SetCompact(pindexLast->nBits);
+        bnNew *= nActualTimespan;
+        bnNew /= nTargetTimespan;
+        if (bnNew > bnLimit)
+            bnNew = bnLimit;
+
+        BOOST_CHECK_EQUAL(GetNextWorkRequired(pindexLast, NULL), bnNew.GetCompact());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -273,6 +273,72 @@ BOOST_AUTO_TEST_CASE(base58_keys_invalid)
     }
 }
 
+/**-5-10The digit-at-a-time codec the word-based one replaced, kept as a reference
+static std::string ReferenceEncodeBase58(const unsigned char* pbegin, const unsigned char* pend)
+{
+    static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    int zeroes = 0;
+    while (pbegin != pend && *pbegin == 0) {
+        pbegin++;
+        zeroes++;
+    }
+    std::vector<unsigned char> b58((pend - pbegin) * 138 / 100 + 1);
+    while (pbegin != pend) {
+        int carry = *pbegin;
+        for (std::vector<unsigned char>::reverse_iterator it = b58.rbegin(); it != b58.rend(); it++) {
+            carry += 256 * (*it);
+            *it = carry % 58;
+            carry /= 58;
+        }
+        pbegin++;
+    }
+    std::vector<unsigned char>::iterator it = b58.begin();
+    while (it != b58.end() && *it == 0)
+        it++;
+    std::string str(zeroes, '1');
+    while (it != b58.end())
+        str += pszBase58[*(it++)];
+    return str;
+}
+
+/**-5-10Goal: random round trips agree with the reference codec, including leading zero bytes
+BOOST_AUTO_TEST_CASE(base58_random_roundtrip)
+{
+    seed_insecure_rand(true);
+    for (int i = 0; i < 10000; i++) {
+        std::vector<unsigned char> vch(insecure_rand() % 100);
+        for (unsigned int j = 0; j < vch.size(); j++)
+            vch[j] = (insecure_rand() % 4) ? insecure_rand() & 0xff : 0;
+        const unsigned char* pbegin = vch.empty() ? NULL : &vch[0];
+        std::string str = EncodeBase58(pbegin, pbegin + vch.size());
+        BOOST_CHECK_EQUAL(str, ReferenceEncodeBase58(pbegin, pbegin + vch.size()));
+
+        std::vector<unsigned char> vchDecoded;
+        BOOST_CHECK(DecodeBase58(" " + str + " ", vchDecoded));
+        BOOST_CHECK(vchDecoded == vch);
+    }
+}
+
+/**-5-10Goal: batch encoding matches encoding each address on its own
+BOOST_AUTO_TEST_CASE(base58_EncodeDestinations)
+{
+    std::vector<CTxDestination> vDest;
+    for (int i = 0; i < 100; i++) {
+        uint160 hash;
+        for (unsigned char* p = hash.begin(); p != hash.end(); p++)
+            *p = insecure_rand() & 0xff;
+        if (i % 3 == 0)
+            vDest.push_back(CKeyID(hash));
+        else if (i % 3 == 1)
+            vDest.push_back(CScriptID(hash));
+        else
+            vDest.push_back(CNoDestination());
+    }
+    std::vector<std::string> vstr = EncodeDestinations(vDest);
+    BOOST_CHECK_EQUAL(vstr.size(), vDest.size());
+    for (unsigned int i = 0; i < vDest.size(); i++)
+        BOOST_CHECK_EQUAL(vstr[i], CticoinAddress(vDest[i]).ToString());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,109 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "leveldbwrapper.h"
+#include "util.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(leveldbwrapper_tests)
+
+static void ResetArgs(const std::string& strArg)
+{
+    std::vector<std::string> vecArg;
+    if (!strArg.empty())
+        boost::split(vecArg, strArg, boost::is_space(), boost::token_compress_on);
+    vecArg.insert(vecArg.begin(), "testticoin");
+
+    std::vector<const char*> vecChar;
+    BOOST_FOREACH(std::string& s, vecArg)
+        vecChar.push_back(s.c_str());
+
+    ParseParameters(vecChar.size(), &vecChar[0]);
+}
+
+static bool CheckArgs(const std::string& strArg)
+{
+    ResetArgs(strArg);
+    std::string strError;
+    bool fOk = CheckLevelDBArgs(strError);
+    BOOST_CHECK(fOk == strError.empty());
+    return fOk;
+}
+
+BOOST_AUTO_TEST_CASE(leveldb_check_args)
+{
+    BOOST_CHECK(CheckArgs(""));
+    BOOST_CHECK(CheckArgs("-dbprofile=ibd -dbprofile=blockindex:lowmem -dbcompression=chainstate:1"));
+    BOOST_CHECK(CheckArgs("-dbmaxopenfiles=chainstate:200 -dbwritebuffer=blockindex:8"));
+
+    BOOST_CHECK(!CheckArgs("-dbprofile=fast"));
+    BOOST_CHECK(!CheckArgs("-dbprofile=chainstate:fast"));
+    BOOST_CHECK(!CheckArgs("-dbprofile=chainstate:"));
+
+    //ticoin A misspelt or unknown database is an error for every option, not silently ignored
+    BOOST_CHECK(!CheckArgs("-dbprofile=chainstat:ibd"));
+    BOOST_CHECK(!CheckArgs("-dbcompression=txindex:1"));
+    BOOST_CHECK(!CheckArgs("-dbmaxopenfiles=:200"));
+    BOOST_CHECK(!CheckArgs("-dbwritebuffer=chainstate:8 -dbwritebuffer=blocks:8"));
+
+    ResetArgs("");
+}
+
+BOOST_AUTO_TEST_CASE(leveldb_options)
+{
+    const size_t nCacheSize = 64 << 20;
+
+    ResetArgs("");
+    CLevelDBOptions dboptions = GetLevelDBOptions("chainstate", nCacheSize);
+    BOOST_CHECK_EQUAL(dboptions.strProfile, "default");
+    BOOST_CHECK_EQUAL(dboptions.nMaxOpenFiles, nDefaultDbMaxOpenFiles);
+    BOOST_CHECK(!dboptions.fCompression);
+    BOOST_CHECK(dboptions.fVerifyChecksums);
+
+    //ticoin A database-specific value wins over a plain one, whatever the order
+    ResetArgs("-dbprofile=chainstate:ibd -dbprofile=lowmem -dbmaxopenfiles=300 -dbmaxopenfiles=blockindex:100");
+    dboptions = GetLevelDBOptions("chainstate", nCacheSize);
+    BOOST_CHECK_EQUAL(dboptions.strProfile, "ibd");
+    BOOST_CHECK(!dboptions.fVerifyChecksums);
+    BOOST_CHECK_EQUAL(dboptions.nMaxOpenFiles, 300);
+    dboptions = GetLevelDBOptions("blockindex", nCacheSize);
+    BOOST_CHECK_EQUAL(dboptions.strProfile, "lowmem");
+    BOOST_CHECK(dboptions.fCompression);
+    BOOST_CHECK_EQUAL(dboptions.nMaxOpenFiles, 100);
+
+    ResetArgs("-dbprofile=lowmem -dbcompression=0 -dbwritebuffer=chainstate:8");
+    dboptions = GetLevelDBOptions("chainstate", nCacheSize);
+    BOOST_CHECK(!dboptions.fCompression);
+    BOOST_CHECK_EQUAL(dboptions.nWriteBufferSize, 8U << 20);
+    BOOST_CHECK_EQUAL(GetLevelDBOptions("blockindex", nCacheSize).nWriteBufferSize, nCacheSize / 8);
+
+    ResetArgs("");
+}
+
+BOOST_AUTO_TEST_CASE(leveldb_file_descriptors)
+{
+    //ticoin By default the tables of both databases fit the mmap budget
+    ResetArgs("");
+    int nDefault = GetLevelDBFileDescriptors();
+    BOOST_CHECK_EQUAL(nDefault, std::max(2 * (nDefaultDbMaxOpenFiles - nDbNonTableFiles) - nDbMmapFiles, 0) + 2 * nDbNonTableFiles);
+
+    //ticoin Tables beyond it each hold a descriptor
+    ResetArgs("-dbmaxopenfiles=chainstate:5000");
+    BOOST_CHECK_EQUAL(GetLevelDBFileDescriptors(),
+        std::max(5000 + nDefaultDbMaxOpenFiles - 2 * nDbNonTableFiles - nDbMmapFiles, 0) + 2 * nDbNonTableFiles);
+
+    //ticoin LevelDB keeps at least 64 tables open whatever the option says
+    ResetArgs("-dbmaxopenfiles=10");
+    BOOST_CHECK_EQUAL(GetLevelDBFileDescriptors(), std::max(2 * 64 - nDbMmapFiles, 0) + 2 * nDbNonTableFiles);
+
+    ResetArgs("");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,71 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "metrics.h"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+static bool Contains(const std::string& str, const std::string& strLine)
+{
+    return str.find(strLine + "\n") != std::string::npos;
+}
+
+static int nCollected = 0;
+
+static void TestCollector()
+{
+    nCollected++;
+}
+
+BOOST_AUTO_TEST_SUITE(metrics_tests)
+
+BOOST_AUTO_TEST_CASE(metrics_counter_gauge)
+{
+    CMetricsRegistry registry;
+    CMetricCounter& counter = registry.Counter("test_events_total", "Events");
+    counter.Inc();
+    counter.Inc(2);
+    BOOST_CHECK_EQUAL(counter.Get(), 3);
+    /**-5-10The same name and label give the same metric
+    BOOST_CHECK(&registry.Counter("test_events_total", "Events") == &counter);
+
+    registry.Gauge("test_level", "Level", "kind", "a").Set(1.5);
+    registry.Gauge("test_level", "Level", "kind", "b\"").Add(-2);
+
+    registry.AddCollector(TestCollector);
+    nCollected = 0;
+    std::string str = registry.Render();
+    BOOST_CHECK_EQUAL(nCollected, 1);
+
+    BOOST_CHECK(Contains(str, "# HELP test_events_total Events"));
+    BOOST_CHECK(Contains(str, "# TYPE test_events_total counter"));
+    BOOST_CHECK(Contains(str, "test_events_total 3"));
+    BOOST_CHECK(Contains(str, "# TYPE test_level gauge"));
+    BOOST_CHECK(Contains(str, "test_level{kind=\"a\"} 1.5"));
+    BOOST_CHECK(Contains(str, "test_level{kind=\"b\\\"\"} -2"));
+}
+
+BOOST_AUTO_TEST_CASE(metrics_histogram)
+{
+    CMetricsRegistry registry;
+    CMetricHistogram& histogram = registry.Histogram("test_seconds", "Durations", "op", "x");
+    histogram.Observe(0.0002);
+    histogram.Observe(0.003);
+    histogram.Observe(0.003);
+    histogram.Observe(100);
+    BOOST_CHECK_EQUAL(histogram.GetCount(), 4);
+
+    std::string str = registry.Render();
+    BOOST_CHECK(Contains(str, "# TYPE test_seconds histogram"));
+    BOOST_CHECK(Contains(str, "test_seconds_bucket{op=\"x\",le=\"0.0001\"} 0"));
+    BOOST_CHECK(Contains(str, "test_seconds_bucket{op=\"x\",le=\"0.0005\"} 1"));
+    BOOST_CHECK(Contains(str, "test_seconds_bucket{op=\"x\",le=\"0.005\"} 3"));
+    BOOST_CHECK(Contains(str, "test_seconds_bucket{op=\"x\",le=\"10\"} 3"));
+    BOOST_CHECK(Contains(str, "test_seconds_bucket{op=\"x\",le=\"+Inf\"} 4"));
+    BOOST_CHECK(Contains(str, "test_seconds_count{op=\"x\"} 4"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
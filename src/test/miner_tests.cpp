@@ -174,7 +174,7 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     hash = tx.GetHash();
     mempool.addUnchecked(hash, CTxMemPoolEntry(tx, 11, GetTime(), 111.0, 11));
     tx.vin[0].prevout.hash = hash;
-    tx.vin[0].scriptSig = CScript() << (std::vector<unsigned char>)script;
+    tx.vin[0].scriptSig = CScript() << ToByteVector(script);
     tx.vout[0].nValue -= 1000000;
     hash = tx.GetHash();
     mempool.addUnchecked(hash, CTxMemPoolEntry(tx, 11, GetTime(), 111.0, 11));
@@ -285,4 +285,30 @@ BOOST_AUTO_TEST_CASE(sha256transform_equality)
     BOOST_CHECK(hash == hash_reference);
 }
 
+BOOST_AUTO_TEST_CASE(scan_nonces)
+{
+    CBlockHeader header;
+    header.nVersion = 2;
+    header.hashPrevBlock = uint256("0x000000000000000082ccf8f1557c5d40b21edabb18d2d691cfbf87118bac7254");
+    header.hashMerkleRoot = uint256("0x9f0a2b5e4c1dd6a3f0e8c55d6b3a6ac2a6fd7b0fe0d1e53c3f1e9b74d3c6c2a1");
+    header.nTime = 1400000000;
+    header.nBits = 0x1d00ffff;
+
+    CMinerMidstate midstate;
+    midstate.Set(header);
+
+    /**-5-10every lane agrees with the full hash of the header, also across a wrap of the nonce
+    uint32_t vStart[] = {0, 12345, 0xfffffffc};
+    for (unsigned int i = 0; i < sizeof(vStart)/sizeof(vStart[0]); i++)
+    {
+        uint32_t vHashHigh[MINER_LANES];
+        ScanNonces(midstate, vStart[i], vHashHigh);
+        for (unsigned int l = 0; l < MINER_LANES; l++)
+        {
+            header.nNonce = vStart[i] + l;
+            BOOST_CHECK_EQUAL(vHashHigh[l], (uint32_t)(header.GetHash() >> 224).GetLow64());
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,168 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "prevector.h"
+#include "serialize.h"
+#include "util.h"
+#include "version.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(prevector_tests)
+
+/** Applies every operation to both a prevector and a std::vector and checks they agree */
+template<unsigned int N, typename T>
+class prevector_tester
+{
+    typedef std::vector<T> realtype;
+    typedef prevector<N, T> pretype;
+
+    realtype real_vector;
+    pretype pre_vector;
+
+    void test()
+    {
+        const pretype& const_pre_vector = pre_vector;
+        BOOST_CHECK_EQUAL(real_vector.size(), pre_vector.size());
+        BOOST_CHECK_EQUAL(real_vector.empty(), pre_vector.empty());
+        for (unsigned int i = 0; i < real_vector.size(); i++) {
+            BOOST_CHECK(real_vector[i] == pre_vector[i]);
+            BOOST_CHECK(real_vector[i] == const_pre_vector[i]);
+        }
+        BOOST_CHECK(pre_vector.capacity() >= pre_vector.size());
+        BOOST_CHECK_EQUAL(pre_vector.allocated_memory() == 0, pre_vector.capacity() == N);
+
+        size_t pos = 0;
+        for (typename pretype::const_iterator it = const_pre_vector.begin(); it != const_pre_vector.end(); ++it)
+            BOOST_CHECK(*it == real_vector[pos++]);
+        BOOST_CHECK_EQUAL(pos, real_vector.size());
+        for (typename pretype::reverse_iterator it = pre_vector.rbegin(); it != pre_vector.rend(); ++it)
+            BOOST_CHECK(*it == real_vector[--pos]);
+
+        /**-5-10Copies compare equal and serialize like the std::vector
+        pretype pre_copy(pre_vector);
+        BOOST_CHECK(pre_copy == pre_vector);
+        CDataStream ss1(SER_DISK, CLIENT_VERSION), ss2(SER_DISK, CLIENT_VERSION);
+        ss1 << real_vector;
+        ss2 << pre_vector;
+        BOOST_CHECK_EQUAL(ss1.size(), ss2.size());
+        BOOST_CHECK_EQUAL(GetSerializeSize(pre_vector, SER_DISK, CLIENT_VERSION), ss2.size());
+        BOOST_CHECK(ss1.str() == ss2.str());
+        pretype pre_unserialized;
+        ss2 >> pre_unserialized;
+        BOOST_CHECK(pre_unserialized == pre_vector);
+    }
+
+public:
+    void resize(size_t s) { real_vector.resize(s); pre_vector.resize(s); test(); }
+    void reserve(size_t s) { real_vector.reserve(s); pre_vector.reserve(s); test(); }
+    void insert(size_t position, const T& value) { real_vector.insert(real_vector.begin() + position, value); pre_vector.insert(pre_vector.begin() + position, value); test(); }
+    void insert(size_t position, size_t count, const T& value) { real_vector.insert(real_vector.begin() + position, count, value); pre_vector.insert(pre_vector.begin() + position, count, value); test(); }
+
+    template<typename I>
+    void insert_range(size_t position, I first, I last)
+    {
+        real_vector.insert(real_vector.begin() + position, first, last);
+        pre_vector.insert(pre_vector.begin() + position, first, last);
+        test();
+    }
+
+    void erase(size_t position) { real_vector.erase(real_vector.begin() + position); pre_vector.erase(pre_vector.begin() + position); test(); }
+    void erase(size_t first, size_t last) { real_vector.erase(real_vector.begin() + first, real_vector.begin() + last); pre_vector.erase(pre_vector.begin() + first, pre_vector.begin() + last); test(); }
+    void update(size_t pos, const T& value) { real_vector[pos] = value; pre_vector[pos] = value; test(); }
+    void push_back(const T& value) { real_vector.push_back(value); pre_vector.push_back(value); test(); }
+    void pop_back() { real_vector.pop_back(); pre_vector.pop_back(); test(); }
+    void clear() { real_vector.clear(); pre_vector.clear(); }
+    void assign(size_t n, const T& value) { real_vector.assign(n, value); pre_vector.assign(n, value); }
+    void shrink_to_fit() { pre_vector.shrink_to_fit(); test(); }
+
+    void swap()
+    {
+        realtype real_other;
+        pretype pre_other;
+        real_other.swap(real_vector);
+        pre_other.swap(pre_vector);
+        test();
+        real_other.swap(real_vector);
+        pre_other.swap(pre_vector);
+        test();
+    }
+
+    size_t size() const { return real_vector.size(); }
+};
+
+BOOST_AUTO_TEST_CASE(prevector_random)
+{
+    seed_insecure_rand(true);
+    for (int j = 0; j < 64; j++) {
+        prevector_tester<8, int> test;
+        for (int i = 0; i < 2048; i++) {
+            int r = insecure_rand();
+            if ((r % 4) == 0)
+                test.insert(insecure_rand() % (test.size() + 1), insecure_rand());
+            if (test.size() > 0 && ((r >> 2) % 4) == 1)
+                test.erase(insecure_rand() % test.size());
+            if (((r >> 4) % 8) == 2) {
+                int new_size = std::max<int>(0, std::min<int>(30, test.size() + (insecure_rand() % 5) - 2));
+                test.resize(new_size);
+            }
+            if (((r >> 7) % 8) == 3)
+                test.insert(insecure_rand() % (test.size() + 1), 1 + (insecure_rand() % 2), insecure_rand());
+            if (((r >> 10) % 8) == 4) {
+                int del = std::min<int>(test.size(), 1 + (insecure_rand() % 2));
+                int beg = insecure_rand() % (test.size() + 1 - del);
+                test.erase(beg, beg + del);
+            }
+            if (((r >> 13) % 16) == 5)
+                test.push_back(insecure_rand());
+            if (test.size() > 0 && ((r >> 17) % 16) == 6)
+                test.pop_back();
+            if (((r >> 21) % 32) == 7) {
+                int values[4];
+                int num = 1 + (insecure_rand() % 4);
+                for (int k = 0; k < num; k++)
+                    values[k] = insecure_rand();
+                test.insert_range(insecure_rand() % (test.size() + 1), values, values + num);
+            }
+            if (((r >> 26) % 32) == 8) {
+                int del = std::min<int>(test.size(), 1 + (insecure_rand() % 4));
+                int beg = insecure_rand() % (test.size() + 1 - del);
+                test.erase(beg, beg + del);
+            }
+            r = insecure_rand();
+            if (r % 32 == 9)
+                test.reserve(insecure_rand() % 32);
+            if ((r >> 5) % 64 == 10)
+                test.shrink_to_fit();
+            if (test.size() > 0 && (r >> 11) % 16 == 11)
+                test.update(insecure_rand() % test.size(), insecure_rand());
+            if ((r >> 15) % 64 == 12)
+                test.swap();
+            if ((r >> 21) % 512 == 13)
+                test.clear();
+            if ((r >> 24) % 512 == 14)
+                test.assign(insecure_rand() % 32, insecure_rand());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(prevector_script_size)
+{
+    /**-5-10Pay-to-pubkey-hash and pay-to-script-hash scripts need no heap allocation
+    BOOST_CHECK_EQUAL(sizeof(CScriptBase), 32U);
+    CScriptBase p2pkh(25, 0x76);
+    CScriptBase p2sh(23, 0xa9);
+    BOOST_CHECK_EQUAL(p2pkh.allocated_memory(), 0U);
+    BOOST_CHECK_EQUAL(p2sh.allocated_memory(), 0U);
+    CScriptBase big(29, 0x00);
+    BOOST_CHECK(big.allocated_memory() >= 29U);
+    big.resize(10);
+    big.shrink_to_fit();
+    BOOST_CHECK_EQUAL(big.allocated_memory(), 0U);
+    BOOST_CHECK_EQUAL(big.size(), 10U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
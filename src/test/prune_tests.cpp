@@ -0,0 +1,167 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "txdb.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(prune_tests)
+
+/**-5-10The test chain fills files 1 and 2 with five blocks each, and file 3 with the rest,
+/**-5-10which include the last MIN_BLOCKS_TO_KEEP blocks of the chain
+static const int PRUNE_TEST_BLOCKS_PER_FILE = 5;
+static const int PRUNE_TEST_LAST_FILE = 3;
+
+/**-5-10Write a block on top of pprev into nFile, with its (empty) undo file, and add it to
+/**-5-10the block index and the file's info
+static CBlockIndex *AddTestBlock(CBlockIndex *pprev, int nFile, std::vector<CBlockFileInfo> &vinfo)
+{
+    CBlock block;
+    block.nVersion = 1;
+    block.hashPrevBlock = pprev->GetBlockHash();
+    block.nTime = pprev->nTime + 1;
+    block.nBits = pprev->nBits;
+    block.nNonce = insecure_rand();
+    block.vtx.resize(1);
+    block.vtx[0].vin.resize(1);
+    block.vtx[0].vin[0].prevout.hash = GetRandHash();
+    block.vtx[0].vout.resize(1);
+    block.hashMerkleRoot = block.BuildMerkleTree();
+
+    CDiskBlockPos pos(nFile, vinfo[nFile].nSize);
+    BOOST_REQUIRE(WriteBlockToDisk(block, pos));
+    vinfo[nFile].nSize = pos.nPos + ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+    FILE *fileUndo = OpenUndoFile(CDiskBlockPos(nFile, 0));
+    BOOST_REQUIRE(fileUndo);
+    fclose(fileUndo);
+
+    CBlockIndex *pindex = InsertBlockIndex(block.GetHash());
+    const uint256 *phashBlock = pindex->phashBlock;
+    *pindex = CBlockIndex(block);
+    pindex->phashBlock = phashBlock;
+    pindex->pprev = pprev;
+    pindex->nHeight = pprev->nHeight + 1;
+    pindex->nTx = block.vtx.size();
+    pindex->nFile = pos.nFile;
+    pindex->nDataPos = pos.nPos;
+    pindex->nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+    vinfo[nFile].AddBlock(pindex->nHeight, pindex->nTime);
+    return pindex;
+}
+
+static bool HaveFile(int nFile, const char *prefix)
+{
+    return boost::filesystem::exists(GetBlockPosFilename(CDiskBlockPos(nFile, 0), prefix));
+}
+
+/**-5-10Whether blocks nBegin to nEnd (exclusive) of the test chain all have, or all lack, their block and undo data
+static bool HaveBlocks(const std::vector<CBlockIndex*> &vpindex, int nBegin, int nEnd, bool fHave)
+{
+    for (int i = nBegin; i < nEnd; i++) {
+        if (((vpindex[i]->nStatus & BLOCK_HAVE_DATA) != 0) != fHave || ((vpindex[i]->nStatus & BLOCK_HAVE_UNDO) != 0) != fHave)
+            return false;
+    }
+    return true;
+}
+
+BOOST_AUTO_TEST_CASE(prune_block_files)
+{
+    LOCK(cs_main);
+    CBlockIndex *pindexStart = chainActive.Tip();
+    bool fPruneModeSaved = fPruneMode;
+    uint64_t nPruneTargetSaved = nPruneTarget;
+    BOOST_REQUIRE(!fHavePruned);
+    BOOST_REQUIRE(pindexStart->nHeight < (int)MIN_BLOCKS_TO_KEEP);
+
+    /**-5-10A block tree of its own, where the file of the fixture's blocks is empty so the
+    /**-5-10pruner leaves it alone, and which the test blocks don't outlive
+    CBlockTreeDB *pblocktreeSaved = pblocktree;
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+
+    std::vector<CBlockFileInfo> vinfo(PRUNE_TEST_LAST_FILE + 1);
+    std::vector<CBlockIndex*> vpindex;
+    CBlockIndex *pindex = pindexStart;
+    for (int i = 0; i < 2 * PRUNE_TEST_BLOCKS_PER_FILE + (int)MIN_BLOCKS_TO_KEEP; i++) {
+        int nFile = std::min(1 + i / PRUNE_TEST_BLOCKS_PER_FILE, PRUNE_TEST_LAST_FILE);
+        pindex = AddTestBlock(pindex, nFile, vinfo);
+        vpindex.push_back(pindex);
+    }
+    for (int nFile = 0; nFile <= PRUNE_TEST_LAST_FILE; nFile++)
+        BOOST_REQUIRE(pblocktree->WriteBlockFileInfo(nFile, vinfo[nFile]));
+    /**-5-10The pruner never touches the file being filled
+    BOOST_REQUIRE(pblocktree->WriteLastBlockFile(PRUNE_TEST_LAST_FILE + 1));
+    BOOST_REQUIRE(pblocktree->WriteBlockFileInfo(PRUNE_TEST_LAST_FILE + 1, CBlockFileInfo()));
+    uint64_t nUsage = vinfo[1].nSize + vinfo[2].nSize + vinfo[3].nSize;
+    uint64_t nBuffer = BLOCKFILE_CHUNK_SIZE + UNDOFILE_CHUNK_SIZE;
+
+    fPruneMode = true;
+    LoadBlockFileInfo();
+    CValidationState state;
+
+    /**-5-10Nothing is pruned while the chain is no longer than the blocks always kept
+    chainActive.SetTip(vpindex[MIN_BLOCKS_TO_KEEP - pindexStart->nHeight - 1]);
+    nPruneTarget = 1;
+    BOOST_CHECK(PruneBlockFiles(state));
+    BOOST_CHECK(HaveFile(1, "blk") && HaveFile(1, "rev"));
+    BOOST_CHECK(!fHavePruned);
+
+    /**-5-10Nor without -prune, or while the files fit the target
+    chainActive.SetTip(pindex);
+    fPruneMode = false;
+    BOOST_CHECK(PruneBlockFiles(state));
+    BOOST_CHECK(HaveFile(1, "blk"));
+    fPruneMode = true;
+    nPruneTarget = nUsage + nBuffer + 1;
+    BOOST_CHECK(PruneBlockFiles(state));
+    BOOST_CHECK(HaveFile(1, "blk"));
+    BOOST_CHECK(!fHavePruned);
+
+    /**-5-10Only as many of the oldest files as needed to fit the target go
+    nPruneTarget = nUsage - vinfo[1].nSize + nBuffer + 1;
+    BOOST_CHECK(PruneBlockFiles(state));
+    BOOST_CHECK(!HaveFile(1, "blk") && !HaveFile(1, "rev"));
+    BOOST_CHECK(HaveFile(2, "blk") && HaveFile(2, "rev"));
+    BOOST_CHECK(HaveBlocks(vpindex, 0, PRUNE_TEST_BLOCKS_PER_FILE, false));
+    BOOST_CHECK(HaveBlocks(vpindex, PRUNE_TEST_BLOCKS_PER_FILE, vpindex.size(), true));
+    /**-5-10Pruned blocks stay validated
+    BOOST_CHECK_EQUAL(vpindex[0]->nStatus, BLOCK_VALID_SCRIPTS);
+    CBlockFileInfo info;
+    BOOST_CHECK(pblocktree->ReadBlockFileInfo(1, info) && info.nSize == 0 && info.nBlocks == 0);
+    bool fFlag = false;
+    BOOST_CHECK(fHavePruned && pblocktree->ReadFlag("prunedblockfiles", fFlag) && fFlag);
+    BOOST_CHECK(!HaveBlockDataFrom(vpindex[0]));
+    BOOST_CHECK(HaveBlockDataFrom(vpindex[PRUNE_TEST_BLOCKS_PER_FILE]));
+
+    /**-5-10However low the target, the files holding the last MIN_BLOCKS_TO_KEEP blocks stay
+    nPruneTarget = 1;
+    BOOST_CHECK(PruneBlockFiles(state));
+    BOOST_CHECK(!HaveFile(2, "blk") && !HaveFile(2, "rev"));
+    BOOST_CHECK(HaveFile(3, "blk") && HaveFile(3, "rev"));
+    BOOST_CHECK(HaveBlocks(vpindex, 0, 2 * PRUNE_TEST_BLOCKS_PER_FILE, false));
+    BOOST_CHECK(HaveBlocks(vpindex, 2 * PRUNE_TEST_BLOCKS_PER_FILE, vpindex.size(), true));
+    {
+        /**-5-10The test blocks carry no proof of work, so read the kept one back directly
+        CBlock block;
+        CAutoFile filein(OpenBlockFile(vpindex[2 * PRUNE_TEST_BLOCKS_PER_FILE]->GetBlockPos(), true), SER_DISK, CLIENT_VERSION);
+        BOOST_REQUIRE(!!filein);
+        filein >> block;
+        BOOST_CHECK(block.GetHash() == vpindex[2 * PRUNE_TEST_BLOCKS_PER_FILE]->GetBlockHash());
+    }
+    BOOST_CHECK(PruneBlockFiles(state));
+    BOOST_CHECK(HaveFile(3, "blk"));
+
+    /**-5-10Restore the fixture's chain, block tree and flags
+    chainActive.SetTip(pindexStart);
+    fPruneMode = fPruneModeSaved;
+    nPruneTarget = nPruneTargetSaved;
+    fHavePruned = false;
+    delete pblocktree;
+    pblocktree = pblocktreeSaved;
+    LoadBlockFileInfo();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "pubsub.h"
+
+#include "core.h"
+#include "main.h"
+#include "serialize.h"
+#include "util.h"
+#include "version.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(pubsub_tests)
+
+BOOST_AUTO_TEST_CASE(pubsub_message_format)
+{
+    std::string strPayload("\x01\x02\x03", 3);
+    std::string str = FormatPubMessage("hashtx", 0x01020304, strPayload);
+    /**-5-10length, topic with its size, sequence, payload
+    BOOST_CHECK_EQUAL(HexStr(str.begin(), str.end()), "0e000000" "06" "686173687478" "04030201" "010203");
+
+    std::string strEmpty = FormatPubMessage("rawtx", 0, "");
+    BOOST_CHECK_EQUAL(strEmpty.size(), 4 + 1 + 5 + 4);
+    BOOST_CHECK_EQUAL(strEmpty[0], 10);
+}
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+typedef boost::asio::local::stream_protocol::socket CPubTestSocket;
+
+/**-5-10Read one message from a subscriber socket
+static void ReadPubMessage(CPubTestSocket& socket, std::string& strTopic, uint32_t& nSequence, std::string& strPayload)
+{
+    std::vector<char> vch(4);
+    boost::asio::read(socket, boost::asio::buffer(vch));
+    CDataStream ssLength(vch, SER_NETWORK, PROTOCOL_VERSION);
+    uint32_t nLength;
+    ssLength >> nLength;
+    vch.resize(nLength);
+    boost::asio::read(socket, boost::asio::buffer(vch));
+    CDataStream ss(vch, SER_NETWORK, PROTOCOL_VERSION);
+    ss >> strTopic >> nSequence;
+    strPayload = ss.str();
+}
+
+/**-5-10A transaction whose output script pushes nSize bytes
+static CTransaction PubTestTx(unsigned int nSize)
+{
+    static int nLockTime = 0;
+    CTransaction tx;
+    tx.nLockTime = nLockTime++;
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << std::vector<unsigned char>(nSize, 0);
+    return tx;
+}
+
+static std::string SerializeTx(const CTransaction& tx)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << tx;
+    return ss.str();
+}
+
+BOOST_AUTO_TEST_CASE(pubsub_socket)
+{
+    mapMultiArgs["-pubrawtx"].push_back("unix:pubsub_test.sock");
+    mapArgs["-pubhwm"] = "4";
+    std::string strError;
+    BOOST_REQUIRE(StartPubSub(strError));
+
+    boost::asio::io_service io;
+    CPubTestSocket socket(io);
+    socket.connect(boost::asio::local::stream_protocol::endpoint((GetDataDir() / "pubsub_test.sock").string()));
+
+    /**-5-10Publish until the publisher has taken the subscriber on
+    std::string strTopic, strPayload;
+    uint32_t nSequence = 0;
+    for (int i = 0; i < 500 && socket.available() == 0; i++) {
+        CTransaction tx = PubTestTx(1);
+        SyncWithWallets(tx.GetHash(), tx);
+        MilliSleep(10);
+    }
+    BOOST_REQUIRE(socket.available() > 0);
+    ReadPubMessage(socket, strTopic, nSequence, strPayload);
+    BOOST_CHECK_EQUAL(strTopic, "rawtx");
+    while (socket.available() > 0)
+        ReadPubMessage(socket, strTopic, nSequence, strPayload);
+
+    /**-5-10Each message follows on from the one before
+    uint32_t nLast = nSequence;
+    for (int i = 0; i < 3; i++) {
+        CTransaction tx = PubTestTx(1);
+        SyncWithWallets(tx.GetHash(), tx);
+        ReadPubMessage(socket, strTopic, nSequence, strPayload);
+        BOOST_CHECK_EQUAL(strTopic, "rawtx");
+        BOOST_CHECK_EQUAL(nSequence, nLast + 1);
+        BOOST_CHECK(strPayload == SerializeTx(tx));
+        nLast = nSequence;
+    }
+
+    /**-5-10A subscriber that stops reading keeps no more than -pubhwm messages queued; the
+    /**-5-10rest are dropped, and show as gaps in the sequence
+    static const int PUB_TEST_FLOOD = 100;
+    for (int i = 0; i < PUB_TEST_FLOOD; i++) {
+        CTransaction tx = PubTestTx(100000);
+        SyncWithWallets(tx.GetHash(), tx);
+    }
+    MilliSleep(500);
+    CTransaction txLast = PubTestTx(1);
+    uint32_t nLastSequence = nLast + PUB_TEST_FLOOD + 1;
+    int nReceived = 0;
+    bool fGap = false;
+    bool fSentLast = false;
+    while (true) {
+        /**-5-10Once the backlog is read, a new message gets through again
+        if (!fSentLast && socket.available() == 0) {
+            MilliSleep(100);
+            if (socket.available() == 0) {
+                SyncWithWallets(txLast.GetHash(), txLast);
+                fSentLast = true;
+            }
+            continue;
+        }
+        ReadPubMessage(socket, strTopic, nSequence, strPayload);
+        BOOST_REQUIRE(nSequence > nLast && nSequence <= nLastSequence);
+        fGap = fGap || nSequence != nLast + 1;
+        nLast = nSequence;
+        if (nSequence == nLastSequence)
+            break;
+        nReceived++;
+    }
+    BOOST_CHECK(fGap);
+    BOOST_CHECK(nReceived < PUB_TEST_FLOOD);
+    BOOST_CHECK(strPayload == SerializeTx(txLast));
+
+    StopPubSub();
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / "pubsub_test.sock"));
+    mapMultiArgs.erase("-pubrawtx");
+    mapArgs.erase("-pubhwm");
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
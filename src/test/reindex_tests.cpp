@@ -0,0 +1,142 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "main.h"
+#include "txdb.h"
+#include "util.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(reindex_tests)
+
+static const int REINDEX_TEST_BLOCKS = 20;
+/**-5-10A block larger than the header scan's buffer, whose body the scan skips
+static const int REINDEX_TEST_LARGE_BLOCK = 5;
+
+/**-5-10Mine a regtest block with only a coinbase on top of prev
+static CBlock MineTestBlock(const CBlock &prev, int nHeight, bool fLarge)
+{
+    CBlock block;
+    block.nVersion = 1;
+    block.hashPrevBlock = prev.GetHash();
+    block.nTime = prev.nTime + 1;
+    block.nBits = prev.nBits;
+    block.vtx.resize(1);
+    block.vtx[0].vin.resize(1);
+    block.vtx[0].vin[0].scriptSig = CScript() << nHeight << OP_0;
+    block.vtx[0].vout.resize(fLarge ? 8 : 1);
+    BOOST_FOREACH(CTxOut &txout, block.vtx[0].vout) {
+        txout.nValue = 0;
+        if (fLarge)
+            txout.scriptPubKey = CScript() << OP_RETURN << std::vector<unsigned char>(10000, 0x42);
+        else
+            txout.scriptPubKey = CScript() << OP_TRUE;
+    }
+    block.hashMerkleRoot = block.BuildMerkleTree();
+    while (!CheckProofOfWork(block.GetHash(), block.nBits))
+        block.nNonce++;
+    return block;
+}
+
+/**-5-10Append a block to block file nFile, whose end is tracked in vEnd
+static CDiskBlockPos AppendBlock(CBlock &block, int nFile, std::vector<unsigned int> &vEnd)
+{
+    CDiskBlockPos pos(nFile, vEnd[nFile]);
+    BOOST_REQUIRE(WriteBlockToDisk(block, pos));
+    vEnd[nFile] = pos.nPos + ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+    return pos;
+}
+
+BOOST_AUTO_TEST_CASE(reindex_block_files)
+{
+    uint256 hashTipSaved;
+    CBlockTreeDB *pblocktreeSaved = pblocktree;
+    CCoinsViewDB *pcoinsdbviewSaved = pcoinsdbview;
+    CCoinsViewCache *pcoinsTipSaved = pcoinsTip;
+    {
+        LOCK(cs_main);
+        hashTipSaved = chainActive.Tip()->GetBlockHash();
+        BOOST_CHECK(pcoinsTip->Flush());
+
+        /**-5-10An empty block index and chain state, with block files in the regtest data directory
+        SelectParams(CChainParams::REGTEST);
+        UnloadBlockIndex();
+        pblocktree = new CBlockTreeDB(1 << 20, true);
+        pcoinsdbview = new CCoinsViewDB(1 << 23, true);
+        pcoinsTip = new CCoinsViewCache(*pcoinsdbview);
+        LoadBlockFileInfo();
+    }
+
+    std::vector<CBlock> vBlocks(1, Params().GenesisBlock());
+    for (int i = 1; i <= REINDEX_TEST_BLOCKS; i++)
+        vBlocks.push_back(MineTestBlock(vBlocks.back(), i, i == REINDEX_TEST_LARGE_BLOCK));
+
+    /**-5-10File 0 stores block 2 before its parent, some junk and block 1 twice; file 1 starts
+    /**-5-10with children of the block it ends with.
+    std::vector<unsigned int> vEnd(2, 0);
+    std::vector<CDiskBlockPos> vPos(vBlocks.size());
+    vPos[0] = AppendBlock(vBlocks[0], 0, vEnd);
+    vPos[2] = AppendBlock(vBlocks[2], 0, vEnd);
+    {
+        FILE *file = OpenBlockFile(CDiskBlockPos(0, vEnd[0]));
+        BOOST_REQUIRE(file);
+        unsigned int nBadSize = 0xffffffff;
+        fwrite(Params().MessageStart(), 1, MESSAGE_START_SIZE, file);
+        fwrite(&nBadSize, 1, sizeof(nBadSize), file);
+        fwrite(Params().MessageStart(), 1, 2, file);
+        vEnd[0] += MESSAGE_START_SIZE + sizeof(nBadSize) + 2;
+        fclose(file);
+    }
+    vPos[1] = AppendBlock(vBlocks[1], 0, vEnd);
+    AppendBlock(vBlocks[1], 0, vEnd);
+    for (int i = 3; i < REINDEX_TEST_BLOCKS / 2; i++)
+        vPos[i] = AppendBlock(vBlocks[i], 0, vEnd);
+    for (int i = REINDEX_TEST_BLOCKS / 2 + 1; i <= REINDEX_TEST_BLOCKS; i++)
+        vPos[i] = AppendBlock(vBlocks[i], 1, vEnd);
+    vPos[REINDEX_TEST_BLOCKS / 2] = AppendBlock(vBlocks[REINDEX_TEST_BLOCKS / 2], 1, vEnd);
+
+    fReindex = true;
+    BOOST_CHECK(ReindexBlockFiles());
+    fReindex = false;
+
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainActive.Height(), REINDEX_TEST_BLOCKS);
+        BOOST_CHECK(chainActive.Tip()->GetBlockHash() == vBlocks.back().GetHash());
+        /**-5-10Every block is indexed where it was first stored, and reads back whole
+        for (int i = 0; i <= REINDEX_TEST_BLOCKS; i++) {
+            CBlockIndex *pindex = chainActive[i];
+            BOOST_CHECK(pindex->GetBlockHash() == vBlocks[i].GetHash());
+            BOOST_CHECK(pindex->nStatus & BLOCK_HAVE_DATA);
+            BOOST_CHECK(pindex->GetBlockPos() == vPos[i]);
+            CBlock block;
+            BOOST_CHECK(ReadBlockFromDisk(block, pindex) && block.GetHash() == vBlocks[i].GetHash());
+        }
+        BOOST_CHECK(::GetSerializeSize(vBlocks[REINDEX_TEST_LARGE_BLOCK], SER_DISK, CLIENT_VERSION) > 64 * 1024);
+
+        /**-5-10New blocks go after everything found in the last file
+        int nLastFile = -1;
+        CBlockFileInfo info;
+        BOOST_CHECK(pblocktree->ReadLastBlockFile(nLastFile) && nLastFile == 1);
+        BOOST_CHECK(pblocktree->ReadBlockFileInfo(1, info) && info.nSize == vEnd[1]);
+    }
+
+    /**-5-10Bring back the fixture's chain
+    {
+        LOCK(cs_main);
+        UnloadBlockIndex();
+        delete pcoinsTip;
+        delete pcoinsdbview;
+        delete pblocktree;
+        pblocktree = pblocktreeSaved;
+        pcoinsdbview = pcoinsdbviewSaved;
+        pcoinsTip = pcoinsTipSaved;
+        SelectParams(CChainParams::MAIN);
+        BOOST_CHECK(LoadBlockIndex());
+        BOOST_CHECK(chainActive.Tip()->GetBlockHash() == hashTipSaved);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,205 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rest.h"
+
+#include "main.h"
+#include "rpcserver.h"
+#include "txmempool.h"
+#include "util.h"
+
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace json_spirit;
+
+extern Value CallRPC(string args);
+
+/**-5-10Collects what a request handler writes to the client
+class CTestConnection : public AcceptedConnection
+{
+public:
+    stringstream ss;
+
+    iostream& stream() { return ss; }
+    string peer_address_to_string() const { return "127.0.0.1"; }
+    void close() {}
+};
+
+/**-5-10Serve strURI, and split the reply into its status and body
+static int RestRequest(const string& strURI, string& strBody)
+{
+    CTestConnection conn;
+    HTTPReq_REST(&conn, strURI, false);
+    string strReply = conn.ss.str();
+    size_t nHeaderEnd = strReply.find("\r\n\r\n");
+    BOOST_REQUIRE(nHeaderEnd != string::npos);
+    strBody = strReply.substr(nHeaderEnd + 4);
+
+    /**-5-10The body is as long as announced
+    size_t nLength = strReply.find("Content-Length: ");
+    BOOST_REQUIRE(nLength != string::npos && nLength < nHeaderEnd);
+    BOOST_CHECK_EQUAL(atoi(strReply.substr(nLength + 16)), (int)strBody.size());
+
+    BOOST_REQUIRE(strReply.compare(0, 9, "HTTP/1.1 ") == 0);
+    return atoi(strReply.substr(9, 3));
+}
+
+static int RestError(const string& strReq)
+{
+    vector<string> params;
+    try {
+        ParseDataFormat(params, strReq);
+    } catch (RestErr& re) {
+        return re.status;
+    }
+    return 0;
+}
+
+BOOST_AUTO_TEST_SUITE(rest_tests)
+
+BOOST_AUTO_TEST_CASE(rest_parse_format)
+{
+    vector<string> params;
+    BOOST_CHECK_EQUAL(ParseDataFormat(params, "abc.bin"), RF_BINARY);
+    BOOST_CHECK_EQUAL(params.size(), 1U);
+    BOOST_CHECK_EQUAL(params[0], "abc");
+    BOOST_CHECK_EQUAL(ParseDataFormat(params, "5/abc.hex"), RF_HEX);
+    BOOST_CHECK_EQUAL(params.size(), 2U);
+    BOOST_CHECK_EQUAL(params[0], "5");
+    BOOST_CHECK_EQUAL(params[1], "abc");
+    BOOST_CHECK_EQUAL(ParseDataFormat(params, ".json"), RF_JSON);
+    BOOST_CHECK_EQUAL(params.size(), 1U);
+    BOOST_CHECK_EQUAL(params[0], "");
+
+    /**-5-10Only the last dot counts, and the extension must be known exactly
+    BOOST_CHECK_EQUAL(ParseDataFormat(params, "a.b.json"), RF_JSON);
+    BOOST_CHECK_EQUAL(params[0], "a.b");
+    BOOST_CHECK_EQUAL(RestError("abc"), HTTP_NOT_FOUND);
+    BOOST_CHECK_EQUAL(RestError("abc."), HTTP_NOT_FOUND);
+    BOOST_CHECK_EQUAL(RestError("abc.BIN"), HTTP_NOT_FOUND);
+    BOOST_CHECK_EQUAL(RestError("abc.jsonx"), HTTP_NOT_FOUND);
+    BOOST_CHECK_EQUAL(RestError("abc.json/"), HTTP_NOT_FOUND);
+    BOOST_CHECK_EQUAL(RestError(""), HTTP_NOT_FOUND);
+}
+
+BOOST_AUTO_TEST_CASE(rest_parse_args)
+{
+    string strHash = "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f";
+    BOOST_CHECK(ParseHashStr(strHash) == uint256(strHash));
+    BOOST_CHECK_THROW(ParseHashStr(strHash.substr(1)), RestErr);
+    BOOST_CHECK_THROW(ParseHashStr(strHash + "0"), RestErr);
+    BOOST_CHECK_THROW(ParseHashStr("0x" + strHash.substr(2)), RestErr);
+    BOOST_CHECK_THROW(ParseHashStr(strHash.substr(1) + "g"), RestErr);
+    BOOST_CHECK_THROW(ParseHashStr(""), RestErr);
+
+    BOOST_CHECK_EQUAL(ParseHeaderCount("1"), 1U);
+    BOOST_CHECK_EQUAL(ParseHeaderCount("05"), 5U);
+    BOOST_CHECK_EQUAL(ParseHeaderCount(strprintf("%u", MAX_REST_HEADERS)), MAX_REST_HEADERS);
+    BOOST_CHECK_THROW(ParseHeaderCount(strprintf("%u", MAX_REST_HEADERS + 1)), RestErr);
+    BOOST_CHECK_THROW(ParseHeaderCount("0"), RestErr);
+    BOOST_CHECK_THROW(ParseHeaderCount(""), RestErr);
+    BOOST_CHECK_THROW(ParseHeaderCount("5abc"), RestErr);
+    BOOST_CHECK_THROW(ParseHeaderCount(" 5"), RestErr);
+    BOOST_CHECK_THROW(ParseHeaderCount("+5"), RestErr);
+    BOOST_CHECK_THROW(ParseHeaderCount("-5"), RestErr);
+    BOOST_CHECK_THROW(ParseHeaderCount("4294967297"), RestErr);
+}
+
+BOOST_AUTO_TEST_CASE(rest_requests)
+{
+    CBlockIndex *pindexTip;
+    {
+        LOCK(cs_main);
+        pindexTip = chainActive.Tip();
+    }
+    string strHash = pindexTip->GetBlockHash().GetHex();
+    string strBody;
+
+    /**-5-10A block streamed from its file is what getblock returns
+    string strHex = CallRPC("getblock " + strHash + " false").get_str();
+    BOOST_CHECK_EQUAL(RestRequest("/rest/block/" + strHash + ".bin", strBody), HTTP_OK);
+    BOOST_CHECK_EQUAL(HexStr(strBody.begin(), strBody.end()), strHex);
+    BOOST_CHECK_EQUAL(RestRequest("/rest/block/" + strHash + ".hex", strBody), HTTP_OK);
+    BOOST_CHECK_EQUAL(strBody, strHex + "\n");
+    BOOST_CHECK_EQUAL(RestRequest("/rest/block/" + strHash + ".json", strBody), HTTP_OK);
+    Value valBlock;
+    BOOST_REQUIRE(read_string(strBody, valBlock));
+    BOOST_CHECK_EQUAL(find_value(valBlock.get_obj(), "hash").get_str(), strHash);
+    BOOST_CHECK_EQUAL(find_value(valBlock.get_obj(), "height").get_int(), pindexTip->nHeight);
+
+    BOOST_CHECK_EQUAL(RestRequest("/rest/block/" + strHash.substr(1) + "0.bin", strBody), HTTP_NOT_FOUND);
+    BOOST_CHECK_EQUAL(RestRequest("/rest/block/" + strHash.substr(1) + ".bin", strBody), HTTP_BAD_REQUEST);
+    BOOST_CHECK_EQUAL(RestRequest("/rest/block/" + strHash + ".txt", strBody), HTTP_NOT_FOUND);
+    BOOST_CHECK_EQUAL(RestRequest("/rest/block/" + strHash + "/1.bin", strBody), HTTP_BAD_REQUEST);
+
+    /**-5-10Headers follow the active chain from the given block, up to its tip
+    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+    ssHeader << pindexTip->GetBlockHeader();
+    BOOST_CHECK_EQUAL(RestRequest("/rest/headers/5/" + strHash + ".bin", strBody), HTTP_OK);
+    BOOST_CHECK(strBody == ssHeader.str());
+    BOOST_CHECK_EQUAL(RestRequest("/rest/headers/1/" + strHash + ".hex", strBody), HTTP_OK);
+    BOOST_CHECK_EQUAL(strBody, HexStr(ssHeader.begin(), ssHeader.end()) + "\n");
+    if (pindexTip->pprev) {
+        string strPrev = pindexTip->pprev->GetBlockHash().GetHex();
+        BOOST_CHECK_EQUAL(RestRequest("/rest/headers/2/" + strPrev + ".bin", strBody), HTTP_OK);
+        BOOST_CHECK_EQUAL(strBody.size(), 160U);
+        BOOST_CHECK(strBody.substr(80) == ssHeader.str());
+        BOOST_CHECK_EQUAL(RestRequest("/rest/headers/1/" + strPrev + ".bin", strBody), HTTP_OK);
+        BOOST_CHECK_EQUAL(strBody.size(), 80U);
+    }
+    BOOST_CHECK_EQUAL(RestRequest("/rest/headers/1/" + strHash + ".json", strBody), HTTP_OK);
+    Value valHeaders;
+    BOOST_REQUIRE(read_string(strBody, valHeaders));
+    BOOST_CHECK_EQUAL(valHeaders.get_array().size(), 1U);
+    BOOST_CHECK_EQUAL(find_value(valHeaders.get_array()[0].get_obj(), "hash").get_str(), strHash);
+    BOOST_CHECK_EQUAL(RestRequest("/rest/headers/5abc/" + strHash + ".bin", strBody), HTTP_BAD_REQUEST);
+    BOOST_CHECK_EQUAL(RestRequest("/rest/headers/0/" + strHash + ".bin", strBody), HTTP_BAD_REQUEST);
+    BOOST_CHECK_EQUAL(RestRequest("/rest/headers/" + strHash + ".bin", strBody), HTTP_BAD_REQUEST);
+
+    /**-5-10A transaction in the mempool, and the mempool
+    CTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.hash = GetRandHash();
+    tx.vin[0].prevout.n = 0;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 12345;
+    uint256 txid = tx.GetHash();
+    mempool.addUnchecked(txid, CTxMemPoolEntry(tx, 0, GetTime(), 0.0, pindexTip->nHeight));
+
+    CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
+    ssTx << tx;
+    BOOST_CHECK_EQUAL(RestRequest("/rest/tx/" + txid.GetHex() + ".bin", strBody), HTTP_OK);
+    BOOST_CHECK(strBody == ssTx.str());
+    BOOST_CHECK_EQUAL(RestRequest("/rest/tx/" + txid.GetHex() + ".hex", strBody), HTTP_OK);
+    BOOST_CHECK_EQUAL(strBody, HexStr(ssTx.begin(), ssTx.end()) + "\n");
+    BOOST_CHECK_EQUAL(RestRequest("/rest/tx/" + txid.GetHex() + ".json", strBody), HTTP_OK);
+    Value valTx;
+    BOOST_REQUIRE(read_string(strBody, valTx));
+    BOOST_CHECK_EQUAL(find_value(valTx.get_obj(), "txid").get_str(), txid.GetHex());
+    BOOST_CHECK_EQUAL(RestRequest("/rest/tx/" + GetRandHash().GetHex() + ".bin", strBody), HTTP_NOT_FOUND);
+
+    vector<uint256> vtxid;
+    mempool.queryHashes(vtxid);
+    CDataStream ssMempool(SER_NETWORK, PROTOCOL_VERSION);
+    ssMempool << vtxid;
+    BOOST_CHECK_EQUAL(RestRequest("/rest/mempool.bin", strBody), HTTP_OK);
+    BOOST_CHECK(strBody == ssMempool.str());
+    BOOST_CHECK_EQUAL(RestRequest("/rest/mempool.hex", strBody), HTTP_OK);
+    BOOST_CHECK_EQUAL(strBody, HexStr(ssMempool.begin(), ssMempool.end()) + "\n");
+    BOOST_CHECK_EQUAL(RestRequest("/rest/mempool.json", strBody), HTTP_OK);
+    Value valMempool;
+    BOOST_REQUIRE(read_string(strBody, valMempool));
+    BOOST_CHECK_EQUAL(valMempool.get_array().size(), vtxid.size());
+    BOOST_CHECK_EQUAL(RestRequest("/rest/mempool/x.json", strBody), HTTP_BAD_REQUEST);
+
+    list<CTransaction> removed;
+    mempool.remove(tx, removed);
+
+    BOOST_CHECK_EQUAL(RestRequest("/rest/nothing/" + strHash + ".bin", strBody), HTTP_NOT_FOUND);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
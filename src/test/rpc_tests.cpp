@@ -6,8 +6,11 @@
 #include "rpcclient.h"
 
 #include "base58.h"
+#include "sync.h"
+#include "util.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
 using namespace std;
@@ -138,4 +141,39 @@ BOOST_AUTO_TEST_CASE(rpc_parse_monetary_values)
     BOOST_CHECK(AmountFromValue(ValueFromString("20999999.99999999")) == 2099999999999999LL);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_getlockstats)
+{
+    /**-5-10The flame graph file must stay within the data directory
+    BOOST_CHECK_THROW(CallRPC("getlockstats /tmp/locks.folded"), runtime_error);
+    BOOST_CHECK_THROW(CallRPC("getlockstats ../locks.folded"), runtime_error);
+    BOOST_CHECK_THROW(CallRPC("getlockstats stats/../../locks.folded"), runtime_error);
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / ".." / "locks.folded"));
+
+    CCriticalSection csRPC;
+    fLockProfiling = true;
+    {
+        LOCK(csRPC);
+        MilliSleep(1);
+    }
+    fLockProfiling = false;
+
+    Value result;
+    BOOST_CHECK_NO_THROW(result = CallRPC("getlockstats locks.folded"));
+    BOOST_CHECK(boost::filesystem::exists(GetDataDir() / "locks.folded"));
+    const Array& arr = result.get_array();
+    bool fFound = false;
+    for (unsigned int i = 0; i < arr.size(); i++) {
+        const Object& obj = arr[i].get_obj();
+        if (find_value(obj, "lock").get_str() == "csRPC") {
+            fFound = true;
+            BOOST_CHECK_EQUAL(find_value(obj, "acquisitions").get_int(), 1);
+            BOOST_CHECK(find_value(obj, "hold_us").get_int64() >= 1000);
+        }
+        /**-5-10Longest total hold time first
+        if (i > 0)
+            BOOST_CHECK(find_value(arr[i - 1].get_obj(), "hold_us").get_int64() >= find_value(obj, "hold_us").get_int64());
+    }
+    BOOST_CHECK(fFound);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,7 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/foreach.hpp>
@@ -393,7 +394,7 @@ BOOST_AUTO_TEST_CASE(script_combineSigs)
     combined = CombineSignatures(scriptPubKey, txTo, 0, scriptSigCopy, scriptSig);
     BOOST_CHECK(combined == scriptSigCopy || combined == scriptSig);
     /**-5-10dummy scriptSigCopy with placeholder, should always choose non-placeholder:
-    scriptSigCopy = CScript() << OP_0 << static_cast<vector<unsigned char> >(pkSingle);
+    scriptSigCopy = CScript() << OP_0 << ToByteVector(pkSingle);
     combined = CombineSignatures(scriptPubKey, txTo, 0, scriptSigCopy, scriptSig);
     BOOST_CHECK(combined == scriptSig);
     combined = CombineSignatures(scriptPubKey, txTo, 0, scriptSig, scriptSigCopy);
@@ -452,6 +453,198 @@ BOOST_AUTO_TEST_CASE(script_combineSigs)
     BOOST_CHECK(combined == partial3c);
 }
 
+/**-5-10Check that the standard-form fast path, where it applies, agrees with the
+/**-5-10generic interpreter. Returns whether it applied.
+static bool
+CheckFastPath(const CScript& scriptSig, const CScript& scriptPubKey, const CTransaction& txTo, unsigned int flagsIn, const string& strTest)
+{
+    bool fFast;
+    if (!VerifyStandardScript(scriptSig, scriptPubKey, txTo, 0, flagsIn, 0, fFast))
+        return false;
+    BOOST_CHECK_MESSAGE(fFast == VerifyScriptGeneric(scriptSig, scriptPubKey, txTo, 0, flagsIn, 0),
+                        strTest << " flags " << flagsIn);
+    return true;
+}
+
+static const unsigned int vFastPathFlags[] = {
+    SCRIPT_VERIFY_NONE, SCRIPT_VERIFY_P2SH, flags, flags | SCRIPT_VERIFY_DERSIG, flags | SCRIPT_VERIFY_EVEN_S
+};
+
+BOOST_AUTO_TEST_CASE(script_fastpath_json)
+{
+    /**-5-10Run the script test vectors through both paths; most of the signature
+    /**-5-10tests end in NOT, so they are also run without it.
+    Array tests = read_json(std::string(json_tests::script_valid, json_tests::script_valid + sizeof(json_tests::script_valid)));
+    Array invalid = read_json(std::string(json_tests::script_invalid, json_tests::script_invalid + sizeof(json_tests::script_invalid)));
+    tests.insert(tests.end(), invalid.begin(), invalid.end());
+
+    int nFast = 0;
+    BOOST_FOREACH(Value& tv, tests)
+    {
+        Array test = tv.get_array();
+        if (test.size() < 2)
+            continue;
+        string strTest = write_string(tv, false);
+        CScript scriptSig = ParseScript(test[0].get_str());
+        string scriptPubKeyString = trim_copy(test[1].get_str());
+        vector<CScript> scriptPubKeys(1, ParseScript(scriptPubKeyString));
+        if (ends_with(scriptPubKeyString, " NOT"))
+            scriptPubKeys.push_back(ParseScript(scriptPubKeyString.substr(0, scriptPubKeyString.size() - 4)));
+
+        BOOST_FOREACH(const CScript& scriptPubKey, scriptPubKeys)
+            BOOST_FOREACH(unsigned int flagsNow, vFastPathFlags)
+                if (CheckFastPath(scriptSig, scriptPubKey, CTransaction(), flagsNow, strTest))
+                    nFast++;
+    }
+    BOOST_CHECK(nFast > 0);
+}
+
+/**-5-10Randomly corrupt the pushes of a scriptSig, or the way they are pushed
+static CScript
+MutateScriptSig(const CScript& scriptSig)
+{
+    vector<vector<unsigned char> > pushes;
+    CScript::const_iterator pc = scriptSig.begin();
+    opcodetype opcode;
+    vector<unsigned char> vch;
+    while (scriptSig.GetOp(pc, opcode, vch))
+        pushes.push_back(vch);
+    if (pushes.empty())
+        return scriptSig;
+
+    vector<unsigned char>& push = pushes[insecure_rand() % pushes.size()];
+    switch (insecure_rand() % 7)
+    {
+    case 0:
+        if (!push.empty())
+            push[insecure_rand() % push.size()] ^= 1 << (insecure_rand() % 8);
+        break;
+    case 1:
+        if (!push.empty())
+            push.back() = insecure_rand() % 4;
+        break;
+    case 2:
+        push.clear();
+        break;
+    case 3:
+        pushes.erase(pushes.begin() + insecure_rand() % pushes.size());
+        break;
+    case 4:
+        pushes.insert(pushes.begin() + insecure_rand() % pushes.size(), pushes[insecure_rand() % pushes.size()]);
+        break;
+    case 5:
+        swap(push, pushes[insecure_rand() % pushes.size()]);
+        break;
+    }
+
+    CScript result;
+    BOOST_FOREACH(const vector<unsigned char>& v, pushes)
+    {
+        if (v.size() <= 0xff && insecure_rand() % 8 == 0)
+        {
+            /**-5-10Non-minimal push
+            result << OP_PUSHDATA1;
+            result.insert(result.end(), (unsigned char)v.size());
+            result.insert(result.end(), v.begin(), v.end());
+        }
+        else
+            result << v;
+    }
+    if (insecure_rand() % 16 == 0)
+        result << OP_1;
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(script_fastpath_standard)
+{
+    seed_insecure_rand(true);
+    CBasicKeyStore keystore;
+    vector<CKey> keys;
+    vector<CPubKey> pubkeys;
+    for (int i = 0; i < 4; i++)
+    {
+        CKey key;
+        key.MakeNewKey(i % 2 == 0);
+        keys.push_back(key);
+        pubkeys.push_back(key.GetPubKey());
+        keystore.AddKey(key);
+    }
+
+    /**-5-10Every standard form, bare and as a P2SH redeem script
+    vector<CScript> scriptPubKeys;
+    for (int i = 0; i < 2; i++)
+    {
+        scriptPubKeys.push_back(CScript() << pubkeys[i] << OP_CHECKSIG);
+        CScript scriptPubKey;
+        scriptPubKey.SetDestination(pubkeys[i].GetID());
+        scriptPubKeys.push_back(scriptPubKey);
+    }
+    for (unsigned int nKeys = 1; nKeys <= pubkeys.size(); nKeys++)
+        for (unsigned int nRequired = 1; nRequired <= nKeys; nRequired++)
+        {
+            CScript scriptPubKey;
+            scriptPubKey.SetMultisig(nRequired, vector<CPubKey>(pubkeys.begin(), pubkeys.begin() + nKeys));
+            scriptPubKeys.push_back(scriptPubKey);
+        }
+    unsigned int nBare = scriptPubKeys.size();
+    for (unsigned int i = 0; i < nBare; i++)
+    {
+        keystore.AddCScript(scriptPubKeys[i]);
+        CScript scriptPubKey;
+        scriptPubKey.SetDestination(scriptPubKeys[i].GetID());
+        scriptPubKeys.push_back(scriptPubKey);
+    }
+
+    BOOST_FOREACH(const CScript& scriptPubKey, scriptPubKeys)
+    {
+        CTransaction txFrom;
+        txFrom.vout.resize(1);
+        txFrom.vout[0].scriptPubKey = scriptPubKey;
+        CTransaction txTo;
+        txTo.vin.resize(1);
+        txTo.vout.resize(1);
+        txTo.vin[0].prevout.n = 0;
+        txTo.vin[0].prevout.hash = txFrom.GetHash();
+        txTo.vout[0].nValue = 1;
+        BOOST_CHECK(SignSignature(keystore, txFrom, txTo, 0));
+        const CScript& scriptSig = txTo.vin[0].scriptSig;
+        string strTest = scriptSig.ToString() + " / " + scriptPubKey.ToString();
+
+        bool fFast = false;
+        BOOST_CHECK_MESSAGE(VerifyStandardScript(scriptSig, scriptPubKey, txTo, 0, flags, 0, fFast) && fFast, strTest);
+        BOOST_FOREACH(unsigned int flagsNow, vFastPathFlags)
+            CheckFastPath(scriptSig, scriptPubKey, txTo, flagsNow, strTest);
+
+        for (int i = 0; i < 50; i++)
+        {
+            CScript mutated = MutateScriptSig(scriptSig);
+            BOOST_FOREACH(unsigned int flagsNow, vFastPathFlags)
+                CheckFastPath(mutated, scriptPubKey, txTo, flagsNow, mutated.ToString() + " / " + scriptPubKey.ToString());
+        }
+    }
+
+    /**-5-10Every ordered pair of signing keys against a 2-of-3 multisig, bare and P2SH
+    CScript scriptPubKey23;
+    scriptPubKey23.SetMultisig(2, vector<CPubKey>(pubkeys.begin(), pubkeys.begin() + 3));
+    CScript scriptPubKeyP2SH;
+    scriptPubKeyP2SH.SetDestination(scriptPubKey23.GetID());
+    CTransaction txTo;
+    txTo.vin.resize(1);
+    txTo.vout.resize(1);
+    for (unsigned int i = 0; i < keys.size(); i++)
+        for (unsigned int j = 0; j < keys.size(); j++)
+        {
+            vector<CKey> signers;
+            signers.push_back(keys[i]);
+            signers.push_back(keys[j]);
+            CScript scriptSig = sign_multisig(scriptPubKey23, signers, txTo);
+            string strTest = strprintf("2-of-3 signed by %u and %u", i, j);
+            BOOST_CHECK_MESSAGE(CheckFastPath(scriptSig, scriptPubKey23, txTo, flags, strTest), strTest);
+            scriptSig << ToByteVector(scriptPubKey23);
+            BOOST_CHECK_MESSAGE(CheckFastPath(scriptSig, scriptPubKeyP2SH, txTo, flags, strTest), strTest);
+        }
+}
+
 BOOST_AUTO_TEST_CASE(script_standard_push)
 {
     for (int i=0; i<1000; i++) {
@@ -470,4 +663,20 @@ BOOST_AUTO_TEST_CASE(script_standard_push)
     }
 }
 
+BOOST_AUTO_TEST_CASE(script_self_append)
+{
+    /**-5-10Appending a script to itself, both while its bytes are inline and
+    /**-5-10when the append moves them to the heap
+    CScript script = CScript() << OP_1 << OP_2;
+    script += script;
+    BOOST_CHECK(script == CScript() << OP_1 << OP_2 << OP_1 << OP_2);
+
+    CScript big = CScript() << std::vector<unsigned char>(20, 0x42);
+    CScript expected = big;
+    expected.insert(expected.end(), big.begin(), big.end());
+    big += big;
+    BOOST_CHECK(big == expected);
+    BOOST_CHECK_EQUAL(big.size(), 42U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
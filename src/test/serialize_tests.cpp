@@ -160,4 +160,35 @@ BOOST_AUTO_TEST_CASE(insert_delete)
     BOOST_CHECK_EQUAL(ss.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(netdatastream)
+{
+    CNetDataStream ss(SER_NETWORK, 0);
+    ss << (uint32_t)0x01020304 << string("message");
+    CNetDataStream::size_type nSize = ss.size();
+
+    /**-5-10An empty destination takes over the buffer instead of a copy
+    const char* pBuffer = &ss[0];
+    CNetSerializeData d;
+    ss.GetAndClear(d);
+    BOOST_CHECK_EQUAL(ss.size(), 0);
+    BOOST_CHECK_EQUAL(d.size(), nSize);
+    BOOST_CHECK(&d[0] == pBuffer);
+
+    /**-5-10Partially read streams and non-empty destinations append
+    CNetDataStream ss2(d.begin(), d.end(), SER_NETWORK, 0);
+    uint32_t n;
+    ss2 >> n;
+    BOOST_CHECK_EQUAL(n, 0x01020304U);
+    ss2.GetAndClear(d);
+    BOOST_CHECK_EQUAL(d.size(), 2 * nSize - 4);
+
+    CNetDataStream ss3(d.begin(), d.end(), SER_NETWORK, 0);
+    string str;
+    ss3 >> n >> str;
+    BOOST_CHECK_EQUAL(str, "message");
+    ss3 >> str;
+    BOOST_CHECK_EQUAL(str, "message");
+    BOOST_CHECK(ss3.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -155,6 +155,7 @@ BOOST_AUTO_TEST_CASE(sighash_test)
         std::cout << "\n";
         #endif
         BOOST_CHECK(sh == sho);
+        BOOST_CHECK(CSigHashContext(txTo).SignatureHash(scriptCode, nIn, nHashType) == sho);
     }
     #if defined(PRINT_SIGHASH_JSON)
     std::cout << "]\n";
@@ -208,6 +209,27 @@ BOOST_AUTO_TEST_CASE(sighash_from_data)
         
         sh = SignatureHash(scriptCode, tx, nIn, nHashType);
         BOOST_CHECK_MESSAGE(sh.GetHex() == sigHashHex, strTest);
+        sh = CSigHashContext(tx).SignatureHash(scriptCode, nIn, nHashType);
+        BOOST_CHECK_MESSAGE(sh.GetHex() == sigHashHex, strTest);
+    }
+}
+/**-5-10One context serves every input of a transaction
+BOOST_AUTO_TEST_CASE(sighash_context)
+{
+    seed_insecure_rand(false);
+    for (int i=0; i<1000; i++) {
+        CTransaction txTo;
+        RandomTransaction(txTo, false);
+        CSigHashContext context(txTo);
+        for (unsigned int nIn = 0; nIn < txTo.vin.size(); nIn++) {
+            CScript scriptCode;
+            RandomScript(scriptCode);
+            BOOST_CHECK(context.SignatureHash(scriptCode, nIn, SIGHASH_ALL) == SignatureHashOld(scriptCode, txTo, nIn, SIGHASH_ALL));
+            BOOST_CHECK(context.SignatureHash(scriptCode, nIn, SIGHASH_ALL | SIGHASH_ANYONECANPAY) == SignatureHashOld(scriptCode, txTo, nIn, SIGHASH_ALL | SIGHASH_ANYONECANPAY));
+        }
+        /**-5-10Out of range input
+        CScript scriptCode;
+        BOOST_CHECK(context.SignatureHash(scriptCode, txTo.vin.size(), SIGHASH_ALL) == SignatureHash(scriptCode, txTo, txTo.vin.size(), SIGHASH_ALL));
     }
 }
 BOOST_AUTO_TEST_SUITE_END()
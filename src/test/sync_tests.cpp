@@ -0,0 +1,128 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sync.h"
+#include "util.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_AUTO_TEST_SUITE(sync_tests)
+
+/**-5-10The statistics of the lock site where strName was locked
+static CLockStats FindLockStats(const std::string& strName)
+{
+    BOOST_FOREACH(const CLockStats& stats, GetLockStats())
+        if (stats.strName == strName)
+            return stats;
+    BOOST_ERROR("no lock site for " + strName);
+    return CLockStats();
+}
+
+/**-5-10The self time of the folded stacks line for the nesting strStack, or -1
+static int64_t FindFoldedStack(const std::string& strStack)
+{
+    std::vector<std::string> vLines;
+    std::string strFolded = GetLockStacksFolded();
+    boost::split(vLines, strFolded, boost::is_any_of("\n"));
+    BOOST_FOREACH(const std::string& strLine, vLines) {
+        size_t nSpace = strLine.rfind(' ');
+        if (nSpace == std::string::npos)
+            continue;
+        /**-5-10Site names are "lock@file:line"; match them without the file and line
+        std::string strNames;
+        std::vector<std::string> vSites;
+        std::string strSites = strLine.substr(0, nSpace);
+        boost::split(vSites, strSites, boost::is_any_of(";"));
+        for (unsigned int i = 0; i < vSites.size(); i++)
+            strNames += (i > 0 ? ";" : "") + vSites[i].substr(0, vSites[i].find('@'));
+        if (strNames == strStack)
+            return atoi64(strLine.substr(nSpace + 1));
+    }
+    return -1;
+}
+
+BOOST_AUTO_TEST_CASE(lockprofile_hold)
+{
+    CCriticalSection csHoldOuter, csHoldInner;
+    fLockProfiling = true;
+    {
+        LOCK(csHoldOuter);
+        MilliSleep(30);
+        {
+            LOCK(csHoldInner);
+            MilliSleep(20);
+        }
+    }
+    fLockProfiling = false;
+    {
+        /**-5-10Not recorded
+        LOCK(csHoldOuter);
+    }
+
+    CLockStats outer = FindLockStats("csHoldOuter");
+    CLockStats inner = FindLockStats("csHoldInner");
+    BOOST_CHECK_EQUAL(outer.nAcquisitions, 1U);
+    BOOST_CHECK_EQUAL(outer.nContended, 0U);
+    BOOST_CHECK_EQUAL(outer.nWaitMicros, 0);
+    BOOST_CHECK_EQUAL(inner.nAcquisitions, 1U);
+    BOOST_CHECK(inner.nHoldMicros >= 20000);
+    BOOST_CHECK(outer.nHoldMicros >= 50000);
+    BOOST_CHECK_EQUAL(outer.nMaxHoldMicros, outer.nHoldMicros);
+
+    /**-5-10The outer lock's own time excludes the time the inner one was held
+    int64_t nOuterSelf = FindFoldedStack("csHoldOuter");
+    BOOST_CHECK(nOuterSelf >= 30000);
+    BOOST_CHECK_EQUAL(nOuterSelf + inner.nHoldMicros, outer.nHoldMicros);
+    BOOST_CHECK_EQUAL(FindFoldedStack("csHoldOuter;csHoldInner"), inner.nHoldMicros);
+}
+
+static void HoldContendedLock(CCriticalSection* pcs, boost::barrier* pbarrier)
+{
+    LOCK(*pcs);
+    pbarrier->wait();
+    MilliSleep(50);
+}
+
+BOOST_AUTO_TEST_CASE(lockprofile_contention)
+{
+    CCriticalSection csContended;
+    boost::barrier barrier(2);
+    fLockProfiling = true;
+    boost::thread thread(boost::bind(&HoldContendedLock, &csContended, &barrier));
+    barrier.wait();
+    {
+        /**-5-10A failed TRY_LOCK is no acquisition
+        TRY_LOCK(csContended, lockTry);
+        BOOST_CHECK(!lockTry);
+    }
+    {
+        LOCK(csContended);
+    }
+    thread.join();
+    fLockProfiling = false;
+
+    std::vector<CLockStats> vStats = GetLockStats();
+    uint64_t nAcquisitions = 0;
+    BOOST_FOREACH(const CLockStats& stats, vStats) {
+        if (stats.strName == "*pcs") {
+            BOOST_CHECK_EQUAL(stats.nContended, 0U);
+            BOOST_CHECK(stats.nHoldMicros >= 50000);
+        }
+        if (stats.strName == "csContended" && stats.nAcquisitions > 0) {
+            nAcquisitions += stats.nAcquisitions;
+            BOOST_CHECK_EQUAL(stats.nContended, 1U);
+            BOOST_CHECK(stats.nWaitMicros > 0);
+            BOOST_CHECK_EQUAL(stats.nMaxWaitMicros, stats.nWaitMicros);
+        }
+    }
+    BOOST_CHECK_EQUAL(nAcquisitions, 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,225 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txindex.h"
+#include "serialize.h"
+#include "txdb.h"
+#include "uint256.h"
+#include "util.h"
+#include "version.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(txindex_tests)
+
+static std::string SerializeKey(const CTxIndexKey& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << std::make_pair('T', key);
+    return ss.str();
+}
+
+BOOST_AUTO_TEST_CASE(txindex_key_roundtrip)
+{
+    uint256 txid("0x4a5e1e4baab89f3a32518a88c31bc87f618f76673e2cc77ab2127b7afdeda33b");
+    CTxIndexKey key(txid, 300000, 123456);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    /**-5-10Prefix, then 3 bytes for each varint
+    BOOST_CHECK_EQUAL(ss.size(), 8 + 3 + 3);
+    CTxIndexKey key2;
+    ss >> key2;
+    BOOST_CHECK(key2.HasPrefix(txid));
+    BOOST_CHECK_EQUAL(key2.nHeight, 300000);
+    BOOST_CHECK_EQUAL(key2.nTxOffset, 123456);
+}
+
+BOOST_AUTO_TEST_CASE(txindex_key_prefix)
+{
+    /**-5-10Two transactions that only differ after the prefix share it
+    uint256 a, b;
+    a.begin()[0] = 7;
+    b.begin()[0] = 7;
+    b.begin()[31] = 1;
+    BOOST_CHECK(CTxIndexKey(a, 10, 81).HasPrefix(b));
+    a.begin()[7] = 1;
+    BOOST_CHECK(!CTxIndexKey(a, 10, 81).HasPrefix(b));
+
+    /**-5-10The lookup starts at (height 0, offset 0), before every entry of the prefix
+    std::string strSeek = SerializeKey(CTxIndexKey(b, 0, 0));
+    BOOST_CHECK(strSeek <= SerializeKey(CTxIndexKey(b, 0, 1)));
+    BOOST_CHECK(strSeek < SerializeKey(CTxIndexKey(b, 1, 0)));
+    BOOST_CHECK(strSeek < SerializeKey(CTxIndexKey(b, 500000, 1000)));
+}
+
+/**-5-10Block file of the blocks made here, and where the next one goes
+static const int TXINDEX_TEST_FILE = 9046;
+static unsigned int nTestFilePos = 0;
+
+/**-5-10Write a block of the given transactions on top of pprev, and add it to the
+/**-5-10block index without connecting it
+static CBlockIndex *AddTestBlock(CBlock &block, CBlockIndex *pprev, const std::vector<CTransaction> &vtx)
+{
+    block.SetNull();
+    block.nVersion = 1;
+    block.hashPrevBlock = pprev->GetBlockHash();
+    block.nTime = pprev->nTime + 1;
+    block.nBits = pprev->nBits;
+    block.nNonce = insecure_rand();
+    block.vtx = vtx;
+    block.hashMerkleRoot = block.BuildMerkleTree();
+
+    CDiskBlockPos pos(TXINDEX_TEST_FILE, nTestFilePos);
+    BOOST_REQUIRE(WriteBlockToDisk(block, pos));
+    nTestFilePos = pos.nPos + ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+
+    CBlockIndex *pindex = InsertBlockIndex(block.GetHash());
+    const uint256 *phashBlock = pindex->phashBlock;
+    *pindex = CBlockIndex(block);
+    pindex->phashBlock = phashBlock;
+    pindex->pprev = pprev;
+    pindex->nHeight = pprev->nHeight + 1;
+    pindex->nTx = block.vtx.size();
+    pindex->nFile = pos.nFile;
+    pindex->nDataPos = pos.nPos;
+    pindex->nStatus = BLOCK_VALID_TRANSACTIONS | BLOCK_HAVE_DATA;
+    return pindex;
+}
+
+static CTransaction TestTx()
+{
+    CTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.hash = GetRandHash();
+    tx.vin[0].prevout.n = 0;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = insecure_rand();
+    return tx;
+}
+
+/**-5-10Offset of transaction n after the header of its block, as stored in the index
+static unsigned int TxOffset(const CBlock &block, unsigned int n)
+{
+    unsigned int nOffset = GetSizeOfCompactSize(block.vtx.size());
+    for (unsigned int i = 0; i < n; i++)
+        nOffset += ::GetSerializeSize(block.vtx[i], SER_DISK, CLIENT_VERSION);
+    return nOffset;
+}
+
+/**-5-10Lets the test feed blocks to the index as the active chain changes
+class CTestTxIndex : public CTxIndex
+{
+public:
+    using CTxIndex::BlockConnected;
+    using CTxIndex::BlockDisconnected;
+};
+
+static bool CheckFindTx(const CTxIndex &txindex, const CTransaction &tx, const CBlockIndex *pindexExpected)
+{
+    LOCK(cs_main);
+    CTransaction txOut;
+    uint256 hashBlock = 0;
+    if (!txindex.FindTx(tx.GetHash(), txOut, hashBlock))
+        return pindexExpected == NULL;
+    return pindexExpected != NULL && hashBlock == pindexExpected->GetBlockHash() && txOut.GetHash() == tx.GetHash();
+}
+
+BOOST_AUTO_TEST_CASE(txindex_sync)
+{
+    CBlockIndex *pindexStart;
+    CBlock blockA1, blockA2, blockB1;
+    CBlockIndex *pindexA1, *pindexA2;
+    std::vector<CTransaction> vtxA1, vtxA2, vtxB1, vtxOld;
+    vtxA1.push_back(TestTx());
+    vtxA1.push_back(TestTx());
+    vtxA2.push_back(TestTx());
+    vtxB1.push_back(TestTx());
+    vtxOld.push_back(TestTx());
+    {
+        LOCK(cs_main);
+        pindexStart = chainActive.Tip();
+        pindexA1 = AddTestBlock(blockA1, pindexStart, vtxA1);
+        pindexA2 = AddTestBlock(blockA2, pindexA1, vtxA2);
+        chainActive.SetTip(pindexA2);
+    }
+
+    /**-5-10An entry of the old index, for a transaction of a block made earlier
+    CBlock blockOld;
+    CBlockIndex *pindexOld;
+    {
+        LOCK(cs_main);
+        pindexOld = AddTestBlock(blockOld, pindexStart, vtxOld);
+        chainActive.SetTip(pindexOld);
+    }
+    CDiskTxPos postxOld(pindexOld->GetBlockPos(), TxOffset(blockOld, 0));
+    BOOST_CHECK(pblocktree->Write(std::make_pair('t', vtxOld[0].GetHash()), postxOld));
+    BOOST_CHECK(pblocktree->HaveLegacyTxIndex());
+
+    CTestTxIndex txindex;
+    BOOST_CHECK(!txindex.IsSynced());
+    /**-5-10Until the new index has caught up, the old one answers
+    BOOST_CHECK(CheckFindTx(txindex, vtxOld[0], pindexOld));
+    BOOST_CHECK(CheckFindTx(txindex, vtxA1[0], NULL));
+
+    /**-5-10The old index only answers for blocks of the active chain
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(pindexA2);
+    }
+    BOOST_CHECK(CheckFindTx(txindex, vtxOld[0], NULL));
+
+    /**-5-10Catch up with the active chain A1, A2
+    BOOST_CHECK(txindex.Sync());
+    BOOST_CHECK(txindex.IsSynced());
+    BOOST_CHECK_EQUAL(txindex.GetHeight(), pindexA2->nHeight);
+    BOOST_CHECK(CheckFindTx(txindex, vtxA1[0], pindexA1));
+    BOOST_CHECK(CheckFindTx(txindex, vtxA1[1], pindexA1));
+    BOOST_CHECK(CheckFindTx(txindex, vtxA2[0], pindexA2));
+    BOOST_CHECK(CheckFindTx(txindex, vtxB1[0], NULL));
+
+    /**-5-10Once synced the old index is erased
+    BOOST_CHECK(txindex.EraseLegacy());
+    BOOST_CHECK(!pblocktree->HaveLegacyTxIndex());
+
+    /**-5-10Entries of a txid that shares its 8-byte prefix with another come first and are
+    /**-5-10skipped, as the transaction found there has another hash
+    std::vector<CTxIndexKey> vShared;
+    vShared.push_back(CTxIndexKey(vtxA2[0].GetHash(), pindexA1->nHeight, TxOffset(blockA1, 1)));
+    vShared.push_back(CTxIndexKey(vtxA1[1].GetHash(), pindexA1->nHeight, TxOffset(blockA1, 0)));
+    BOOST_CHECK(pblocktree->WriteTxIndex(vShared, pindexA2->GetBlockHash()));
+    BOOST_CHECK(CheckFindTx(txindex, vtxA2[0], pindexA2));
+    BOOST_CHECK(CheckFindTx(txindex, vtxA1[1], pindexA1));
+
+    /**-5-10Reorganize to B1, at the height of A1: the entries of A1 are left, and now point
+    /**-5-10into B1, where another transaction sits at the offset of A1's first one
+    {
+        LOCK(cs_main);
+        txindex.BlockDisconnected(blockA2, pindexA2);
+        txindex.BlockDisconnected(blockA1, pindexA1);
+        CBlockIndex *pindexB1 = AddTestBlock(blockB1, pindexStart, vtxB1);
+        chainActive.SetTip(pindexB1);
+        txindex.BlockConnected(blockB1, pindexB1);
+        BOOST_CHECK_EQUAL(txindex.GetHeight(), pindexB1->nHeight);
+    }
+    BOOST_CHECK(CheckFindTx(txindex, vtxA1[0], NULL));
+    BOOST_CHECK(CheckFindTx(txindex, vtxA1[1], NULL));
+    BOOST_CHECK(CheckFindTx(txindex, vtxA2[0], NULL));
+    BOOST_CHECK(CheckFindTx(txindex, vtxB1[0], chainActive.Tip()));
+
+    /**-5-10Back to A2: Sync indexes A1 and A2 again from where the chains fork
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(pindexA2);
+    }
+    CTestTxIndex txindex2;
+    BOOST_CHECK(txindex2.Sync());
+    BOOST_CHECK_EQUAL(txindex2.GetHeight(), pindexA2->nHeight);
+    BOOST_CHECK(CheckFindTx(txindex2, vtxA1[0], pindexA1));
+    BOOST_CHECK(CheckFindTx(txindex2, vtxB1[0], NULL));
+
+    LOCK(cs_main);
+    chainActive.SetTip(pindexStart);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,186 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bloom.h"
+#include "chainparams.h"
+#include "core.h"
+#include "main.h"
+#include "serialize.h"
+#include "txview.h"
+#include "util.h"
+#include "version.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(txview_tests)
+
+static void RandomScript(CScript &script)
+{
+    script = CScript();
+    int nOps = insecure_rand() % 6;
+    for (int i = 0; i < nOps; i++) {
+        if (insecure_rand() % 2)
+            script << OP_DUP;
+        else
+            script << std::vector<unsigned char>(insecure_rand() % 80, (unsigned char)insecure_rand());
+    }
+}
+
+static void RandomTransaction(CTransaction &tx)
+{
+    tx.nVersion = insecure_rand();
+    tx.vin.resize(insecure_rand() % 4);
+    tx.vout.resize(insecure_rand() % 4);
+    tx.nLockTime = insecure_rand();
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        tx.vin[i].prevout.hash = GetRandHash();
+        tx.vin[i].prevout.n = insecure_rand();
+        RandomScript(tx.vin[i].scriptSig);
+        tx.vin[i].nSequence = insecure_rand();
+    }
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        tx.vout[i].nValue = insecure_rand() % 100000000;
+        RandomScript(tx.vout[i].scriptPubKey);
+    }
+}
+
+static std::vector<unsigned char> Serialized(const CTransaction& tx)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << tx;
+    return std::vector<unsigned char>(ss.begin(), ss.end());
+}
+
+BOOST_AUTO_TEST_CASE(txview_roundtrip)
+{
+    seed_insecure_rand(true);
+    for (int i = 0; i < 1000; i++) {
+        CTransaction tx;
+        RandomTransaction(tx);
+        std::vector<unsigned char> vch = Serialized(tx);
+        const unsigned char* pbegin = &vch[0];
+        const unsigned char* pend = pbegin + vch.size();
+
+        CTransactionView view;
+        const unsigned char* pc = pbegin;
+        BOOST_CHECK(view.Parse(pc, pend));
+        BOOST_CHECK(pc == pend);
+        BOOST_CHECK(view.GetHash() == tx.GetHash());
+        BOOST_CHECK(view.ToTransaction() == tx);
+        BOOST_CHECK_EQUAL(view.IsCoinBase(), tx.IsCoinBase());
+        BOOST_CHECK_EQUAL(view.vin.size(), tx.vin.size());
+        for (unsigned int j = 0; j < view.vin.size(); j++)
+            BOOST_CHECK(view.vin[j].scriptSig.ToScript() == tx.vin[j].scriptSig);
+        for (unsigned int j = 0; j < view.vout.size(); j++)
+            BOOST_CHECK(view.vout[j].scriptPubKey.ToScript() == tx.vout[j].scriptPubKey);
+
+        /**-5-10The view serializes to the bytes it was parsed from
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << view;
+        BOOST_CHECK(std::vector<unsigned char>(ss.begin(), ss.end()) == vch);
+
+        /**-5-10Any truncation is rejected
+        pc = pbegin;
+        BOOST_CHECK(!view.Parse(pc, pend - 1 - insecure_rand() % vch.size()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(txview_noncanonical)
+{
+    CTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    std::vector<unsigned char> vch = Serialized(tx);
+
+    /**-5-10Encode the input count as 0xfd 0x01 0x00 instead of 0x01
+    BOOST_CHECK_EQUAL(vch[4], 1);
+    vch[4] = 0xfd;
+    unsigned char count[] = { 0x01, 0x00 };
+    vch.insert(vch.begin() + 5, count, count + 2);
+
+    CTransactionView view;
+    const unsigned char* pc = &vch[0];
+    BOOST_CHECK(!view.Parse(pc, &vch[0] + vch.size()));
+    CDataStream ss(vch, SER_NETWORK, PROTOCOL_VERSION);
+    CTransaction txDeserialized;
+    BOOST_CHECK_THROW(ss >> txDeserialized, std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(blockview_roundtrip)
+{
+    seed_insecure_rand(true);
+    CBlock block = Params().GenesisBlock();
+    for (int i = 0; i < 20; i++) {
+        block.vtx.push_back(CTransaction());
+        RandomTransaction(block.vtx.back());
+    }
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << block;
+    std::vector<unsigned char> vch(ss.begin(), ss.end());
+
+    CBlockView view;
+    BOOST_CHECK(view.Parse(&vch[0], &vch[0] + vch.size()));
+    BOOST_CHECK(view.GetHash() == block.GetHash());
+    BOOST_CHECK_EQUAL(view.vtx.size(), block.vtx.size());
+    for (unsigned int i = 0; i < view.vtx.size(); i++)
+        BOOST_CHECK(view.vtx[i].GetHash() == block.vtx[i].GetHash());
+    CBlock blockCopy = view.ToBlock();
+    BOOST_CHECK(blockCopy.GetHash() == block.GetHash());
+    BOOST_CHECK(blockCopy.BuildMerkleTree() == block.BuildMerkleTree());
+
+    /**-5-10The whole buffer must be consumed
+    vch.push_back(0);
+    BOOST_CHECK(!view.Parse(&vch[0], &vch[0] + vch.size()));
+    BOOST_CHECK(!view.Parse(&vch[0], &vch[0] + vch.size() - 2));
+}
+
+BOOST_AUTO_TEST_CASE(blockview_merkleblock)
+{
+    seed_insecure_rand(true);
+    CBlock block = Params().GenesisBlock();
+    for (int i = 0; i < 50; i++) {
+        block.vtx.push_back(CTransaction());
+        RandomTransaction(block.vtx.back());
+    }
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << block;
+    std::vector<unsigned char> vch(ss.begin(), ss.end());
+    CBlockView view;
+    BOOST_CHECK(view.Parse(&vch[0], &vch[0] + vch.size()));
+
+    for (int nFlags = BLOOM_UPDATE_NONE; nFlags <= BLOOM_UPDATE_P2PUBKEY_ONLY; nFlags++) {
+        /**-5-10Filters on a few pushed data elements and outpoints
+        CBloomFilter filter(20, 0.000001, insecure_rand(), nFlags);
+        for (unsigned int i = 1; i < block.vtx.size(); i += 7) {
+            const CTransaction& tx = block.vtx[i];
+            if (!tx.vout.empty()) {
+                CScript::const_iterator pc = tx.vout[0].scriptPubKey.begin();
+                opcodetype opcode;
+                std::vector<unsigned char> data;
+                while (tx.vout[0].scriptPubKey.GetOp(pc, opcode, data))
+                    if (!data.empty()) {
+                        filter.insert(data);
+                        break;
+                    }
+            }
+            if (!tx.vin.empty())
+                filter.insert(tx.vin[0].prevout);
+        }
+        CBloomFilter filterView = filter;
+
+        CMerkleBlock merkleBlock(block, filter);
+        CMerkleBlock merkleBlockView(view, filterView);
+        BOOST_CHECK(merkleBlock.vMatchedTxn == merkleBlockView.vMatchedTxn);
+
+        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION), ssView(SER_NETWORK, PROTOCOL_VERSION);
+        ssBlock << merkleBlock << filter;
+        ssView << merkleBlockView << filterView;
+        BOOST_CHECK(ssBlock.str() == ssView.str());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
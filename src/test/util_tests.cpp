@@ -9,6 +9,9 @@
 #include <stdint.h>
 #include <vector>
 
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/foreach.hpp>
 #include <boost/test/unit_test.hpp>
 
 using namespace std;
@@ -340,4 +343,107 @@ BOOST_AUTO_TEST_CASE(gettime)
     BOOST_CHECK((GetTime() & ~0xFFFFFFFFLL) == 0);
 }
 
+BOOST_AUTO_TEST_CASE(util_log_categories)
+{
+    bool fDebugSaved = fDebug;
+    fDebug = false;
+    set<string> setSaved = GetLogCategories();
+    BOOST_FOREACH(const string& category, setSaved)
+        EnableLogCategory(category, false);
+    BOOST_CHECK(!LogAcceptCategory("net"));
+    BOOST_CHECK(LogAcceptCategory(NULL));
+
+    /**-5-10A category turned on at runtime is logged without touching fDebug
+    EnableLogCategory("net", true);
+    BOOST_CHECK(!fDebug);
+    BOOST_CHECK(LogAcceptCategory("net"));
+    BOOST_CHECK(!LogAcceptCategory("mempool"));
+    EnableLogCategory("", true);
+    BOOST_CHECK(LogAcceptCategory("mempool"));
+    BOOST_CHECK(GetLogCategories().size() == 2);
+
+    EnableLogCategory("", false);
+    BOOST_CHECK(!LogAcceptCategory("mempool"));
+    EnableLogCategory("net", false);
+    BOOST_CHECK(GetLogCategories().empty());
+    BOOST_CHECK(!fDebug);
+    BOOST_CHECK(!LogAcceptCategory("net"));
+
+    BOOST_FOREACH(const string& category, setSaved)
+        EnableLogCategory(category, true);
+    fDebug = fDebugSaved;
+}
+
+/**-5-10The lines added to debug.log since it was nSize bytes long
+static vector<string> DebugLogLinesFrom(uintmax_t nSize)
+{
+    vector<string> vLines;
+    boost::filesystem::ifstream file(GetDataDir() / "debug.log");
+    file.seekg(nSize);
+    string strLine;
+    while (getline(file, strLine))
+        vLines.push_back(strLine);
+    return vLines;
+}
+
+static uintmax_t DebugLogSize()
+{
+    boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
+    return boost::filesystem::exists(pathDebug) ? boost::filesystem::file_size(pathDebug) : 0;
+}
+
+BOOST_AUTO_TEST_CASE(util_log_rate)
+{
+    fPrintToDebugLog = true;
+    nLogRateLimit = 2;
+    uintmax_t nSize = DebugLogSize();
+
+    /**-5-10Past the limit, messages of a category are dropped until the next second, which
+    /**-5-10reports how many were; messages without a category are never limited
+    SetMockTime(1400000000);
+    for (int i = 0; i < 5; i++)
+        LogPrintStr(strprintf("rate %d\n", i), "ratetest", true);
+    LogPrintStr("other\n", "ratetest2", true);
+    LogPrintStr("uncategorized\n", NULL, true);
+    SetMockTime(1400000001);
+    LogPrintStr("rate 5\n", "ratetest", true);
+    LogPrintStr("rate 6\n", "ratetest", true);
+
+    vector<string> vLines = DebugLogLinesFrom(nSize);
+    BOOST_REQUIRE_EQUAL(vLines.size(), 7U);
+    BOOST_CHECK_EQUAL(vLines[0], "rate 0");
+    BOOST_CHECK_EQUAL(vLines[1], "rate 1");
+    BOOST_CHECK_EQUAL(vLines[2], "other");
+    BOOST_CHECK_EQUAL(vLines[3], "uncategorized");
+    BOOST_CHECK_EQUAL(vLines[4], "Suppressed 3 messages in category ratetest (-lograte=2)");
+    BOOST_CHECK_EQUAL(vLines[5], "rate 5");
+    BOOST_CHECK_EQUAL(vLines[6], "rate 6");
+
+    SetMockTime(0);
+    nLogRateLimit = 0;
+    fPrintToDebugLog = false;
+}
+
+BOOST_AUTO_TEST_CASE(util_log_json)
+{
+    fPrintToDebugLog = true;
+    fLogJSON = true;
+    uintmax_t nSize = DebugLogSize();
+
+    /**-5-10Quotes, backslashes and control characters are escaped; the trailing newline is dropped
+    SetMockTime(1400000000);
+    LogPrintStr("say \"hi\" \\o/\n\tdone\x01\n", "jsontest", true);
+    LogPrintStr("plain\n", NULL, true);
+
+    vector<string> vLines = DebugLogLinesFrom(nSize);
+    BOOST_REQUIRE_EQUAL(vLines.size(), 2U);
+    BOOST_CHECK_EQUAL(vLines[0], "{\"time\":\"2014-05-13T16:53:20Z\",\"category\":\"jsontest\","
+                                 "\"message\":\"say \\\"hi\\\" \\\\o/\\n\\u0009done\\u0001\"}");
+    BOOST_CHECK_EQUAL(vLines[1], "{\"time\":\"2014-05-13T16:53:20Z\",\"category\":\"\",\"message\":\"plain\"}");
+
+    SetMockTime(0);
+    fLogJSON = false;
+    fPrintToDebugLog = false;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,150 @@
+/**-5-10Copyright (c) 2014 The ticoin Core developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "txdb.h"
+#include "util.h"
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(utxosnapshot_tests)
+
+static void WriteCoinsToTip(const std::vector<std::pair<uint256, CCoins> > &vCoins)
+{
+    LOCK(cs_main);
+    for (unsigned int i = 0; i < vCoins.size(); i++)
+        pcoinsTip->SetCoins(vCoins[i].first, vCoins[i].second);
+    BOOST_CHECK(pcoinsTip->Flush());
+}
+
+BOOST_AUTO_TEST_CASE(utxosnapshot_roundtrip)
+{
+    std::vector<std::pair<uint256, CCoins> > vCoins;
+    for (int i = 0; i < 100; i++) {
+        CCoins coins;
+        coins.nVersion = 1;
+        coins.nHeight = i;
+        coins.fCoinBase = (i % 10 == 0);
+        coins.vout.resize(1 + i % 3);
+        for (unsigned int n = 0; n < coins.vout.size(); n++) {
+            coins.vout[n].nValue = (i + 1) * 1000 + n;
+            coins.vout[n].scriptPubKey = CScript() << OP_TRUE;
+        }
+        vCoins.push_back(std::make_pair(GetRandHash(), coins));
+    }
+    WriteCoinsToTip(vCoins);
+
+    boost::filesystem::path path = GetDataDir() / "utxo.dat";
+    CCoinsStats stats;
+    BOOST_CHECK(DumpUtxoSnapshot(path, stats));
+    {
+        LOCK(cs_main);
+        CCoinsStats statsTip;
+        BOOST_CHECK(pcoinsTip->GetStats(statsTip));
+        BOOST_CHECK(stats.hashSerialized == statsTip.hashSerialized);
+        BOOST_CHECK_EQUAL(stats.nTransactions, statsTip.nTransactions);
+        BOOST_CHECK_EQUAL(stats.nTotalAmount, statsTip.nTotalAmount);
+        BOOST_CHECK(stats.hashBlock == chainActive.Tip()->GetBlockHash());
+    }
+
+    //ticoin Only an empty data directory can be bootstrapped
+    CCoinsViewDB viewLoad(1 << 20, true);
+    BOOST_CHECK(!LoadUtxoSnapshot(viewLoad, path, stats.hashSerialized));
+
+    CBlockTreeDB *pblocktreeSaved = pblocktree;
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+    BlockMap mapBlockIndexSaved;
+    mapBlockIndexSaved.swap(mapBlockIndex);
+
+    //ticoin A hash other than the expected one is rejected before anything is written
+    CCoins coins;
+    BOOST_CHECK(!LoadUtxoSnapshot(viewLoad, path, GetRandHash()));
+    BOOST_CHECK(viewLoad.GetBestBlock() == 0);
+    BOOST_CHECK(!viewLoad.GetCoins(vCoins[0].first, coins));
+
+    BOOST_CHECK(LoadUtxoSnapshot(viewLoad, path, stats.hashSerialized));
+    BOOST_CHECK(viewLoad.GetBestBlock() == stats.hashBlock);
+    for (unsigned int i = 0; i < vCoins.size(); i++) {
+        BOOST_CHECK(viewLoad.GetCoins(vCoins[i].first, coins));
+        BOOST_CHECK(coins == vCoins[i].second);
+    }
+    bool fSnapshot = false;
+    BOOST_CHECK(pblocktree->ReadFlag("utxosnapshot", fSnapshot) && fSnapshot);
+
+    delete pblocktree;
+    pblocktree = pblocktreeSaved;
+    mapBlockIndexSaved.swap(mapBlockIndex);
+
+    //ticoin Remove the test coins from the shared chain state again
+    for (unsigned int i = 0; i < vCoins.size(); i++)
+        vCoins[i].second.vout.clear();
+    WriteCoinsToTip(vCoins);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(utxosnapshot_corrupt)
+{
+    boost::filesystem::path path = GetDataDir() / "utxo_corrupt.dat";
+    CCoinsStats stats;
+    BOOST_CHECK(DumpUtxoSnapshot(path, stats));
+
+    //ticoin Flip a bit of the trailing hash
+    FILE *file = fopen(path.string().c_str(), "r+b");
+    BOOST_REQUIRE(file);
+    BOOST_CHECK(fseek(file, -1, SEEK_END) == 0);
+    int ch = fgetc(file);
+    BOOST_CHECK(fseek(file, -1, SEEK_END) == 0);
+    fputc(ch ^ 1, file);
+    fclose(file);
+
+    CBlockTreeDB *pblocktreeSaved = pblocktree;
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+    BlockMap mapBlockIndexSaved;
+    mapBlockIndexSaved.swap(mapBlockIndex);
+
+    CCoinsViewDB viewLoad(1 << 20, true);
+    BOOST_CHECK(!LoadUtxoSnapshot(viewLoad, path, stats.hashSerialized));
+    BOOST_CHECK(viewLoad.GetBestBlock() == 0);
+
+    delete pblocktree;
+    pblocktree = pblocktreeSaved;
+    mapBlockIndexSaved.swap(mapBlockIndex);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(utxosnapshot_height)
+{
+    //ticoin A height the file cannot hold is turned down before anything is allocated for it
+    boost::filesystem::path path = GetDataDir() / "utxo_height.dat";
+    CUtxoSnapshotHeader header;
+    header.hashBlock = Params().HashGenesisBlock();
+    header.nHeight = std::numeric_limits<int>::max();
+    {
+        FILE *file = fopen(path.string().c_str(), "wb");
+        BOOST_REQUIRE(file);
+        CAutoFile fileout = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+        fileout << header;
+    }
+
+    CBlockTreeDB *pblocktreeSaved = pblocktree;
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+    BlockMap mapBlockIndexSaved;
+    mapBlockIndexSaved.swap(mapBlockIndex);
+
+    CCoinsViewDB viewLoad(1 << 20, true);
+    BOOST_CHECK(!LoadUtxoSnapshot(viewLoad, path, uint256()));
+    BOOST_CHECK(viewLoad.GetBestBlock() == 0);
+
+    delete pblocktree;
+    pblocktree = pblocktreeSaved;
+    mapBlockIndexSaved.swap(mapBlockIndex);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -303,4 +303,314 @@ BOOST_AUTO_TEST_CASE(coin_selection_tests)
     empty_wallet();
 }
 
+BOOST_AUTO_TEST_CASE(keypool_fill)
+{
+    CWallet keywallet;
+    LOCK(keywallet.cs_wallet);
+
+    /**-5-10large enough to spread key generation over several threads
+    BOOST_CHECK(keywallet.TopUpKeyPool(500));
+    BOOST_CHECK_EQUAL(keywallet.setKeyPool.size(), 501U);
+    BOOST_CHECK_EQUAL(*keywallet.setKeyPool.begin(), 1);
+    BOOST_CHECK_EQUAL(*keywallet.setKeyPool.rbegin(), 501);
+
+    std::set<CKeyID> setKeys;
+    keywallet.GetKeys(setKeys);
+    BOOST_CHECK_EQUAL(setKeys.size(), 501U);
+    BOOST_CHECK_EQUAL(keywallet.mapKeyMetadata.size(), 501U);
+
+    /**-5-10topping up again only adds the missing keys
+    BOOST_CHECK(keywallet.TopUpKeyPool(510));
+    BOOST_CHECK_EQUAL(keywallet.setKeyPool.size(), 511U);
+    BOOST_CHECK_EQUAL(*keywallet.setKeyPool.rbegin(), 511);
+}
+
+BOOST_AUTO_TEST_CASE(keypool_fill_hd)
+{
+    CWallet hdwallet;
+    LOCK(hdwallet.cs_wallet);
+
+    BOOST_CHECK(hdwallet.GenerateHDMasterKey());
+    BOOST_CHECK(hdwallet.IsHDEnabled());
+    BOOST_CHECK(hdwallet.TopUpKeyPool(200));
+    BOOST_CHECK_EQUAL(hdwallet.setKeyPool.size(), 201U);
+    BOOST_CHECK_EQUAL(hdwallet.GetHDChain().nExternalChainCounter, 201U);
+
+    /**-5-10the pool keys plus the seed
+    std::set<CKeyID> setKeys;
+    hdwallet.GetKeys(setKeys);
+    BOOST_CHECK_EQUAL(setKeys.size(), 202U);
+
+    /**-5-10keys are m/0'/0'/i' of the seed
+    CKey seed;
+    BOOST_CHECK(hdwallet.GetKey(hdwallet.GetHDChain().masterKeyID, seed));
+    CExtKey masterKey, accountKey, chainKey, childKey;
+    masterKey.SetMaster(seed.begin(), seed.size());
+    BOOST_CHECK(masterKey.Derive(accountKey, BIP32_HARDENED_KEY_LIMIT));
+    BOOST_CHECK(accountKey.Derive(chainKey, BIP32_HARDENED_KEY_LIMIT));
+    BOOST_CHECK(chainKey.Derive(childKey, 7 | BIP32_HARDENED_KEY_LIMIT));
+    CPubKey pubkey = childKey.key.GetPubKey();
+    BOOST_CHECK(hdwallet.HaveKey(pubkey.GetID()));
+
+    /**-5-10secrets are derived on demand
+    CKey key;
+    CPubKey pubkeyStored;
+    BOOST_CHECK(hdwallet.GetKey(pubkey.GetID(), key));
+    BOOST_CHECK(key == childKey.key);
+    BOOST_CHECK(hdwallet.GetPubKey(pubkey.GetID(), pubkeyStored));
+    BOOST_CHECK(pubkeyStored == pubkey);
+
+    /**-5-10keys generated outside the pool continue the chain
+    CPubKey pubkeyNew = hdwallet.GenerateNewKey();
+    BOOST_CHECK(chainKey.Derive(childKey, 201 | BIP32_HARDENED_KEY_LIMIT));
+    BOOST_CHECK(pubkeyNew == childKey.key.GetPubKey());
+    BOOST_CHECK_EQUAL(hdwallet.GetHDChain().nExternalChainCounter, 202U);
+}
+
+/**-5-10The public key of HD child nChild of seed, m/0'/0'/nChild'
+static CPubKey DeriveHDPubKey(const CKey& seed, uint32_t nChild)
+{
+    CExtKey masterKey, accountKey, chainKey, childKey;
+    masterKey.SetMaster(seed.begin(), seed.size());
+    BOOST_CHECK(masterKey.Derive(accountKey, BIP32_HARDENED_KEY_LIMIT));
+    BOOST_CHECK(accountKey.Derive(chainKey, BIP32_HARDENED_KEY_LIMIT));
+    BOOST_CHECK(chainKey.Derive(childKey, nChild | BIP32_HARDENED_KEY_LIMIT));
+    return childKey.key.GetPubKey();
+}
+
+BOOST_AUTO_TEST_CASE(hd_wallet_reload)
+{
+    bool fFirstRun;
+    CHDChain chain;
+    CPubKey pubkeyNew;
+    std::set<CKeyID> setKeys;
+    unsigned int nPoolSize;
+    {
+        CWallet hdwallet("wallet_hd_reload.dat");
+        BOOST_CHECK_EQUAL(hdwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+        BOOST_CHECK(fFirstRun);
+        LOCK(hdwallet.cs_wallet);
+        BOOST_CHECK(hdwallet.GenerateHDMasterKey());
+        BOOST_CHECK(hdwallet.TopUpKeyPool(20));
+        pubkeyNew = hdwallet.GenerateNewKey();
+        chain = hdwallet.GetHDChain();
+        hdwallet.GetKeys(setKeys);
+        nPoolSize = hdwallet.setKeyPool.size();
+    }
+
+    /**-5-10The hdchain and hdkey records bring back the chain and every derived key
+    CWallet hdwallet("wallet_hd_reload.dat");
+    BOOST_CHECK_EQUAL(hdwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+    BOOST_CHECK(!fFirstRun);
+    LOCK(hdwallet.cs_wallet);
+    BOOST_CHECK(hdwallet.IsHDEnabled());
+    BOOST_CHECK(hdwallet.CanSupportFeature(FEATURE_HD));
+    /**-5-10This client can write the minversion, and 0.9.5 and older get DB_TOO_NEW
+    BOOST_CHECK(FEATURE_HD <= CLIENT_VERSION);
+    BOOST_CHECK(FEATURE_HD > 90500);
+    BOOST_CHECK(hdwallet.GetHDChain().masterKeyID == chain.masterKeyID);
+    BOOST_CHECK_EQUAL(hdwallet.GetHDChain().nExternalChainCounter, chain.nExternalChainCounter);
+    BOOST_CHECK_EQUAL(hdwallet.setKeyPool.size(), nPoolSize);
+    std::set<CKeyID> setKeysLoaded;
+    hdwallet.GetKeys(setKeysLoaded);
+    BOOST_CHECK(setKeysLoaded == setKeys);
+    BOOST_CHECK(hdwallet.mapKeyMetadata.count(pubkeyNew.GetID()));
+
+    /**-5-10Secrets are derived from the loaded seed
+    CKey seed, key;
+    BOOST_CHECK(hdwallet.GetKey(chain.masterKeyID, seed));
+    BOOST_CHECK(hdwallet.GetKey(pubkeyNew.GetID(), key));
+    BOOST_CHECK(key.GetPubKey() == pubkeyNew);
+    BOOST_CHECK(DeriveHDPubKey(seed, chain.nExternalChainCounter - 1) == pubkeyNew);
+
+    /**-5-10and new keys continue the chain
+    BOOST_CHECK(hdwallet.GenerateNewKey() == DeriveHDPubKey(seed, chain.nExternalChainCounter));
+}
+
+BOOST_AUTO_TEST_CASE(hd_wallet_encrypt)
+{
+    bool fFirstRun;
+    CWallet hdwallet("wallet_hd_encrypt.dat");
+    BOOST_CHECK_EQUAL(hdwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+    CPubKey pubkey;
+    CHDChain chainPlain;
+    {
+        LOCK(hdwallet.cs_wallet);
+        BOOST_CHECK(hdwallet.GenerateHDMasterKey());
+        pubkey = hdwallet.GenerateNewKey();
+        chainPlain = hdwallet.GetHDChain();
+    }
+    CKey keyPlain, seedPlain, key;
+    BOOST_CHECK(hdwallet.GetKey(pubkey.GetID(), keyPlain));
+    BOOST_CHECK(hdwallet.GetKey(chainPlain.masterKeyID, seedPlain));
+
+    /**-5-10The seed is encrypted with the other keys, so derived secrets need the wallet unlocked
+    SecureString strPassphrase("hd passphrase");
+    BOOST_CHECK(hdwallet.EncryptWallet(strPassphrase));
+    BOOST_CHECK(hdwallet.IsLocked());
+    BOOST_CHECK(hdwallet.HaveKey(pubkey.GetID()));
+    BOOST_CHECK(!hdwallet.GetKey(pubkey.GetID(), key));
+    {
+        LOCK(hdwallet.cs_wallet);
+        BOOST_CHECK(!hdwallet.TopUpKeyPool(200));
+    }
+
+    BOOST_CHECK(!hdwallet.Unlock(SecureString("wrong passphrase")));
+    BOOST_CHECK(hdwallet.Unlock(strPassphrase));
+    BOOST_CHECK(hdwallet.GetKey(pubkey.GetID(), key));
+    BOOST_CHECK(key == keyPlain);
+
+    /**-5-10The unencrypted seed is replaced, and keys derived after encryption come from the new one
+    CKey seed;
+    LOCK(hdwallet.cs_wallet);
+    BOOST_CHECK(hdwallet.GetHDChain().masterKeyID != chainPlain.masterKeyID);
+    BOOST_CHECK(hdwallet.GetKey(hdwallet.GetHDChain().masterKeyID, seed));
+    uint32_t nChild = hdwallet.GetHDChain().nExternalChainCounter;
+    CPubKey pubkeyNew = hdwallet.GenerateNewKey();
+    BOOST_CHECK(pubkeyNew == DeriveHDPubKey(seed, nChild));
+    BOOST_CHECK(pubkeyNew != DeriveHDPubKey(seedPlain, nChild));
+    BOOST_CHECK(pubkeyNew != DeriveHDPubKey(seedPlain, chainPlain.nExternalChainCounter));
+    BOOST_CHECK(hdwallet.Lock());
+}
+
+/**-5-10A transaction paying one coin to pubkey
+static CTransaction PayToKey(const CPubKey& pubkey)
+{
+    static int nLockTime = 0;
+    CTransaction tx;
+    tx.nLockTime = nLockTime++;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = COIN;
+    tx.vout[0].scriptPubKey.SetDestination(pubkey.GetID());
+    return tx;
+}
+
+BOOST_AUTO_TEST_CASE(hd_wallet_restore_gap)
+{
+    bool fKeypoolSet = mapArgs.count("-keypool") > 0;
+    std::string strKeypoolSaved = mapArgs["-keypool"];
+    mapArgs["-keypool"] = "10";
+
+    /**-5-10A backup whose pool holds children 0..10; the wallet it was taken from went on to
+    /**-5-10hand out later children too
+    bool fFirstRun;
+    CWallet hdwallet("wallet_hd_restore.dat");
+    BOOST_CHECK_EQUAL(hdwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+    LOCK(hdwallet.cs_wallet);
+    BOOST_CHECK(hdwallet.GenerateHDMasterKey());
+    BOOST_CHECK(hdwallet.TopUpKeyPool());
+    BOOST_CHECK_EQUAL(hdwallet.GetHDChain().nExternalChainCounter, 11U);
+    CKey seed;
+    BOOST_CHECK(hdwallet.GetKey(hdwallet.GetHDChain().masterKeyID, seed));
+    std::vector<CPubKey> vPubKeys;
+    for (uint32_t i = 0; i < 40; i++)
+        vPubKeys.push_back(DeriveHDPubKey(seed, i));
+
+    CTransaction tx = PayToKey(vPubKeys[12]);
+    BOOST_CHECK(!hdwallet.AddToWalletIfInvolvingMe(tx.GetHash(), tx, NULL, true));
+
+    /**-5-10Each payment to a pool key moves the derived keys a pool's worth past it
+    tx = PayToKey(vPubKeys[8]);
+    BOOST_CHECK(hdwallet.AddToWalletIfInvolvingMe(tx.GetHash(), tx, NULL, true));
+    BOOST_CHECK_EQUAL(hdwallet.GetHDChain().nExternalChainCounter, 20U);
+    tx = PayToKey(vPubKeys[12]);
+    BOOST_CHECK(hdwallet.AddToWalletIfInvolvingMe(tx.GetHash(), tx, NULL, true));
+    tx = PayToKey(vPubKeys[23]);
+    BOOST_CHECK(hdwallet.AddToWalletIfInvolvingMe(tx.GetHash(), tx, NULL, true));
+    BOOST_CHECK(hdwallet.HaveKey(vPubKeys[34].GetID()));
+    BOOST_CHECK(!hdwallet.HaveKey(vPubKeys[35].GetID()));
+
+    /**-5-10Keys up to the last paid one are not handed out again
+    BOOST_CHECK_EQUAL(hdwallet.setKeyPool.size(), 11U);
+    CPubKey pubkey;
+    BOOST_CHECK(hdwallet.GetKeyFromPool(pubkey));
+    BOOST_CHECK(pubkey == vPubKeys[24]);
+
+    if (fKeypoolSet)
+        mapArgs["-keypool"] = strKeypoolSaved;
+    else
+        mapArgs.erase("-keypool");
+}
+
+BOOST_AUTO_TEST_CASE(wallet_batch)
+{
+    bool fFirstRun;
+    uint256 hashAborted, hashCommitted;
+    CPubKey pubkey;
+    {
+        CWallet batchwallet("wallet_batch.dat");
+        BOOST_CHECK_EQUAL(batchwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+        LOCK(batchwallet.cs_wallet);
+        {
+            /**-5-10A batch that goes out of scope without Commit() writes nothing
+            CWalletBatch batch(&batchwallet);
+            BOOST_CHECK(batchwallet.GetActiveBatch() != NULL);
+            CWalletTx wtx(&batchwallet, PayToKey(batchwallet.GenerateNewKey()));
+            hashAborted = wtx.GetHash();
+            BOOST_CHECK(batchwallet.AddToWallet(wtx));
+        }
+        BOOST_CHECK(batchwallet.GetActiveBatch() == NULL);
+        {
+            /**-5-10A nested batch joins the outer one, whose Commit() writes every record
+            CWalletBatch batch(&batchwallet);
+            pubkey = batchwallet.GenerateNewKey();
+            CWalletTx wtx(&batchwallet, PayToKey(pubkey));
+            hashCommitted = wtx.GetHash();
+            {
+                CWalletBatch batchInner(&batchwallet);
+                BOOST_CHECK(batchwallet.AddToWallet(wtx));
+                BOOST_CHECK(batchInner.Commit());
+            }
+            BOOST_CHECK(batchwallet.GetActiveBatch() != NULL);
+            BOOST_CHECK(batch.Commit());
+            BOOST_CHECK(batchwallet.GetActiveBatch() == NULL);
+        }
+    }
+
+    CWallet batchwallet("wallet_batch.dat");
+    BOOST_CHECK_EQUAL(batchwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+    LOCK(batchwallet.cs_wallet);
+    BOOST_CHECK(!batchwallet.mapWallet.count(hashAborted));
+    BOOST_CHECK(batchwallet.mapWallet.count(hashCommitted));
+    std::set<CKeyID> setKeys;
+    batchwallet.GetKeys(setKeys);
+    BOOST_CHECK_EQUAL(setKeys.size(), 1U);
+    BOOST_CHECK(setKeys.count(pubkey.GetID()));
+}
+
+BOOST_AUTO_TEST_CASE(commit_transaction_batch)
+{
+    bool fFirstRun;
+    uint256 hash;
+    CPubKey pubkeyChange;
+    unsigned int nPoolSize;
+    {
+        CWallet sendwallet("wallet_commit.dat");
+        BOOST_CHECK_EQUAL(sendwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+        {
+            LOCK(sendwallet.cs_wallet);
+            BOOST_CHECK(sendwallet.TopUpKeyPool(10));
+            nPoolSize = sendwallet.setKeyPool.size();
+        }
+
+        /**-5-10A payment spending a coin the chain doesn't have: the mempool turns it down, but
+        /**-5-10the transaction and the change key taken from the pool are written together
+        CReserveKey reservekey(&sendwallet);
+        BOOST_CHECK(reservekey.GetReservedKey(pubkeyChange));
+        CTransaction tx = PayToKey(pubkeyChange);
+        tx.vin.push_back(CTxIn(GetRandHash(), 0));
+        CWalletTx wtx(&sendwallet, tx);
+        hash = wtx.GetHash();
+        BOOST_CHECK(!sendwallet.CommitTransaction(wtx, reservekey));
+        BOOST_CHECK(!mempool.exists(hash));
+    }
+
+    CWallet sendwallet("wallet_commit.dat");
+    BOOST_CHECK_EQUAL(sendwallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+    LOCK(sendwallet.cs_wallet);
+    BOOST_CHECK(sendwallet.mapWallet.count(hash));
+    BOOST_CHECK_EQUAL(sendwallet.setKeyPool.size(), nPoolSize - 1);
+    BOOST_CHECK(sendwallet.HaveKey(pubkeyChange.GetID()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
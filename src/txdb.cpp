@@ -10,8 +10,14 @@
 
 #include <stdint.h>
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 using namespace std;
 
+/**-5-10Number of block index records deserialized before they are hashed and inserted
+static const size_t BLOCKINDEX_LOAD_BATCH = 16384;
+
 void static BatchWriteCoins(CLevelDBBatch &batch, const uint256 &hash, const CCoins &coins) {
     if (coins.IsPruned())
         batch.Erase(make_pair('c', hash));
@@ -23,7 +29,7 @@ void static BatchWriteHashBestChain(CLevelDBBatch &batch, const uint256 &hash) {
     batch.Write('B', hash);
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe) {
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", GetLevelDBOptions("chainstate", nCacheSize), fMemory, fWipe) {
 }
 
 bool CCoinsViewDB::GetCoins(const uint256 &txid, CCoins &coins) {
@@ -65,7 +71,7 @@ bool CCoinsViewDB::BatchWrite(const std::map<uint256, CCoins> &mapCoins, const u
     return db.WriteBatch(batch);
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "blocks" / "index", GetLevelDBOptions("blockindex", nCacheSize), fMemory, fWipe) {
 }
 
 bool CBlockTreeDB::WriteBlockIndex(const CDiskBlockIndex& blockindex)
@@ -73,6 +79,14 @@ bool CBlockTreeDB::WriteBlockIndex(const CDiskBlockIndex& blockindex)
     return Write(make_pair('b', blockindex.GetBlockHash()), blockindex);
 }
 
+bool CBlockTreeDB::WriteBlockIndex(const std::vector<CDiskBlockIndex>& vblockindex)
+{
+    CLevelDBBatch batch;
+    for (std::vector<CDiskBlockIndex>::const_iterator it = vblockindex.begin(); it != vblockindex.end(); it++)
+        batch.Write(make_pair('b', it->GetBlockHash()), *it);
+    return WriteBatch(batch);
+}
+
 bool CBlockTreeDB::WriteBestInvalidWork(const CBigNum& bnBestInvalidWork)
 {
     /**-5-10Obsolete; only written for backward compatibility.
@@ -107,6 +121,24 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
     return Read('l', nFile);
 }
 
+void UpdateCoinsStats(CHashWriter &ss, CCoinsStats &stats, const uint256 &txid, const CCoins &coins) {
+    ss << txid;
+    ss << VARINT(coins.nVersion);
+    ss << (coins.fCoinBase ? 'c' : 'n');
+    ss << VARINT(coins.nHeight);
+    stats.nTransactions++;
+    for (unsigned int i=0; i<coins.vout.size(); i++) {
+        const CTxOut &out = coins.vout[i];
+        if (!out.IsNull()) {
+            stats.nTransactionOutputs++;
+            ss << VARINT(i+1);
+            ss << out;
+            stats.nTotalAmount += out.nValue;
+        }
+    }
+    ss << VARINT(0);
+}
+
 bool CCoinsViewDB::GetStats(CCoinsStats &stats) {
     leveldb::Iterator *pcursor = db.NewIterator();
     pcursor->SeekToFirst();
@@ -114,7 +146,6 @@ bool CCoinsViewDB::GetStats(CCoinsStats &stats) {
     CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
     stats.hashBlock = GetBestBlock();
     ss << stats.hashBlock;
-    int64_t nTotalAmount = 0;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         try {
@@ -129,22 +160,8 @@ bool CCoinsViewDB::GetStats(CCoinsStats &stats) {
                 ssValue >> coins;
                 uint256 txhash;
                 ssKey >> txhash;
-                ss << txhash;
-                ss << VARINT(coins.nVersion);
-                ss << (coins.fCoinBase ? 'c' : 'n');
-                ss << VARINT(coins.nHeight);
-                stats.nTransactions++;
-                for (unsigned int i=0; i<coins.vout.size(); i++) {
-                    const CTxOut &out = coins.vout[i];
-                    if (!out.IsNull()) {
-                        stats.nTransactionOutputs++;
-                        ss << VARINT(i+1);
-                        ss << out;
-                        nTotalAmount += out.nValue;
-                    }
-                }
+                UpdateCoinsStats(ss, stats, txhash, coins);
                 stats.nSerializedSize += 32 + slValue.size();
-                ss << VARINT(0);
             }
             pcursor->Next();
         } catch (std::exception &e) {
@@ -154,21 +171,271 @@ bool CCoinsViewDB::GetStats(CCoinsStats &stats) {
     delete pcursor;
     stats.nHeight = mapBlockIndex.find(GetBestBlock())->second->nHeight;
     stats.hashSerialized = ss.GetHash();
-    stats.nTotalAmount = nTotalAmount;
     return true;
 }
 
-bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
+bool CCoinsViewDB::WriteCoins(const std::vector<std::pair<uint256, CCoins> > &vCoins) {
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<uint256, CCoins> >::const_iterator it = vCoins.begin(); it != vCoins.end(); it++)
+        BatchWriteCoins(batch, it->first, it->second);
+    return db.WriteBatch(batch);
+}
+
+CCoinsViewDBCursor *CCoinsViewDB::Cursor() {
+    leveldb::Iterator *pcursor = db.NewIterator();
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << 'c';
+    pcursor->Seek(ssKeySet.str());
+    return new CCoinsViewDBCursor(pcursor);
+}
+
+CCoinsViewDBCursor::~CCoinsViewDBCursor() {
+    delete pcursor;
+}
+
+bool CCoinsViewDBCursor::Valid() const {
+    if (!pcursor->Valid())
+        return false;
+    leveldb::Slice slKey = pcursor->key();
+    return slKey.size() > 0 && slKey[0] == 'c';
+}
+
+void CCoinsViewDBCursor::Next() {
+    pcursor->Next();
+}
+
+bool CCoinsViewDBCursor::GetCoins(uint256 &txid, CCoins &coins) const {
+    try {
+        leveldb::Slice slKey = pcursor->key();
+        CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+        char chType;
+        ssKey >> chType >> txid;
+        leveldb::Slice slValue = pcursor->value();
+        CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue >> coins;
+    } catch (std::exception &e) {
+        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    return true;
+}
+
+/**-5-10Read all transaction index entries whose txid prefix matches that of txid. Entries
+/**-5-10of a prefix are adjacent, and the seek key is the smallest of them.
+bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, std::vector<CTxIndexKey> &vKeys) {
+    leveldb::Iterator *pcursor = NewIterator();
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair('T', CTxIndexKey(txid, 0, 0));
+    pcursor->Seek(ssKeySet.str());
+
+    for (; pcursor->Valid(); pcursor->Next()) {
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 'T')
+                break;
+            CTxIndexKey key;
+            ssKey >> key;
+            if (!key.HasPrefix(txid))
+                break;
+            vKeys.push_back(key);
+        } catch (std::exception &e) {
+            delete pcursor;
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+    delete pcursor;
+    return true;
+}
+
+/**-5-10Entries carry no value; everything is in the key
+bool CBlockTreeDB::WriteTxIndex(const std::vector<CTxIndexKey> &vKeys, const uint256 &hashBest) {
+    CLevelDBBatch batch;
+    for (std::vector<CTxIndexKey>::const_iterator it = vKeys.begin(); it != vKeys.end(); it++)
+        batch.Write(make_pair('T', *it), std::string());
+    batch.Write('X', hashBest);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadTxIndexBest(uint256 &hashBest) {
+    return Read('X', hashBest);
+}
+
+bool CBlockTreeDB::HaveLegacyTxIndex() {
+    bool fDone = true;
+    leveldb::Iterator *pcursor = NewIterator();
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << 't';
+    pcursor->Seek(ssKeySet.str());
+    if (pcursor->Valid()) {
+        leveldb::Slice slKey = pcursor->key();
+        fDone = slKey.size() == 0 || slKey[0] != 't';
+    }
+    delete pcursor;
+    return !fDone;
+}
+
+bool CBlockTreeDB::ReadLegacyTxIndex(const uint256 &txid, CDiskTxPos &pos) {
     return Read(make_pair('t', txid), pos);
 }
 
-bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >&vect) {
+bool CBlockTreeDB::EraseLegacyTxIndex(unsigned int nMax, bool &fDone) {
+    leveldb::Iterator *pcursor = NewIterator();
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << 't';
+    pcursor->Seek(ssKeySet.str());
+
+    CLevelDBBatch batch;
+    unsigned int nErased = 0;
+    fDone = true;
+    for (; pcursor->Valid(); pcursor->Next()) {
+        leveldb::Slice slKey = pcursor->key();
+        if (slKey.size() == 0 || slKey[0] != 't')
+            break;
+        if (nErased == nMax) {
+            fDone = false;
+            break;
+        }
+        try {
+            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            uint256 txid;
+            ssKey >> chType >> txid;
+            batch.Erase(make_pair(chType, txid));
+        } catch (std::exception &e) {
+            delete pcursor;
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+        nErased++;
+    }
+    delete pcursor;
+    return WriteBatch(batch);
+}
+
+/**-5-10Unspent entries with a null value are erased; the batch applies them in order, so an
+/**-5-10output created and spent within one update ends up erased.
+void static BatchAddressUnspent(CLevelDBBatch &batch, const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vUnspent) {
+    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it = vUnspent.begin(); it != vUnspent.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair('u', it->first));
+        else
+            batch.Write(make_pair('u', it->first), it->second);
+    }
+}
+
+bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, int64_t> > &vHistory,
+                                     const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vUnspent) {
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CAddressIndexKey, int64_t> >::const_iterator it = vHistory.begin(); it != vHistory.end(); it++)
+        batch.Write(make_pair('a', it->first), it->second);
+    BatchAddressUnspent(batch, vUnspent);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, int64_t> > &vHistory,
+                                     const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vUnspent) {
     CLevelDBBatch batch;
-    for (std::vector<std::pair<uint256,CDiskTxPos> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Write(make_pair('t', it->first), it->second);
+    for (std::vector<std::pair<CAddressIndexKey, int64_t> >::const_iterator it = vHistory.begin(); it != vHistory.end(); it++)
+        batch.Erase(make_pair('a', it->first));
+    BatchAddressUnspent(batch, vUnspent);
     return WriteBatch(batch);
 }
 
+/**-5-10Read the history of the address in keyStart, starting at keyStart, covering at most nMaxTx
+/**-5-10transactions. All entries of a transaction are returned together. If more entries follow,
+/**-5-10the key of the next one is stored in pkeyNext, otherwise pkeyNext is set to a null type.
+bool CBlockTreeDB::ReadAddressIndex(const CAddressIndexKey &keyStart, unsigned int nMaxTx,
+                                    std::vector<std::pair<CAddressIndexKey, int64_t> > &vHistory, CAddressIndexKey *pkeyNext) {
+    leveldb::Iterator *pcursor = NewIterator();
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair('a', keyStart);
+    pcursor->Seek(ssKeySet.str());
+
+    unsigned int nTx = 0;
+    if (pkeyNext)
+        pkeyNext->nType = ADDRESSINDEX_NONE;
+    for (; pcursor->Valid(); pcursor->Next()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 'a')
+                break;
+            CAddressIndexKey key;
+            ssKey >> key;
+            if (key.nType != keyStart.nType || key.hashBytes != keyStart.hashBytes)
+                break;
+            if (vHistory.empty() || vHistory.back().first.txhash != key.txhash) {
+                if (nTx == nMaxTx) {
+                    if (pkeyNext)
+                        *pkeyNext = key;
+                    break;
+                }
+                nTx++;
+            }
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+            int64_t nValue;
+            ssValue >> nValue;
+            vHistory.push_back(std::make_pair(key, nValue));
+        } catch (std::exception &e) {
+            delete pcursor;
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+    delete pcursor;
+    return true;
+}
+
+/**-5-10Read at most nMax unspent outputs of the address in keyStart, starting at keyStart.
+/**-5-10pkeyNext works as in ReadAddressIndex.
+bool CBlockTreeDB::ReadAddressUnspentIndex(const CAddressUnspentKey &keyStart, unsigned int nMax,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vUnspent, CAddressUnspentKey *pkeyNext) {
+    leveldb::Iterator *pcursor = NewIterator();
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair('u', keyStart);
+    pcursor->Seek(ssKeySet.str());
+
+    if (pkeyNext)
+        pkeyNext->nType = ADDRESSINDEX_NONE;
+    for (; pcursor->Valid(); pcursor->Next()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data()+slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 'u')
+                break;
+            CAddressUnspentKey key;
+            ssKey >> key;
+            if (key.nType != keyStart.nType || key.hashBytes != keyStart.hashBytes)
+                break;
+            if (vUnspent.size() == nMax) {
+                if (pkeyNext)
+                    *pkeyNext = key;
+                break;
+            }
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
+            CAddressUnspentValue value;
+            ssValue >> value;
+            vUnspent.push_back(std::make_pair(key, value));
+        } catch (std::exception &e) {
+            delete pcursor;
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+    delete pcursor;
+    return true;
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair('F', name), fValue ? '1' : '0');
 }
@@ -181,6 +448,55 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+/**-5-10Compute the hashes of entries [nBegin, nEnd) of vDiskIndex and check their proof of work
+static void HashBlockIndexRange(const std::vector<CDiskBlockIndex>* pvDiskIndex, std::vector<uint256>* pvHash,
+                                std::vector<char>* pvValid, size_t nBegin, size_t nEnd)
+{
+    for (size_t i = nBegin; i < nEnd; i++) {
+        (*pvHash)[i] = (*pvDiskIndex)[i].GetBlockHash();
+        (*pvValid)[i] = CheckProofOfWork((*pvHash)[i], (*pvDiskIndex)[i].nBits);
+    }
+}
+
+/**-5-10Hash a batch of loaded records on all cores, then link them into mapBlockIndex
+static bool InsertBlockIndexBatch(const std::vector<CDiskBlockIndex>& vDiskIndex)
+{
+    size_t nCount = vDiskIndex.size();
+    std::vector<uint256> vHash(nCount);
+    std::vector<char> vValid(nCount);
+
+    size_t nThreads = std::max(1u, boost::thread::hardware_concurrency());
+    size_t nPerThread = (nCount + nThreads - 1) / nThreads;
+    boost::thread_group threadGroup;
+    for (size_t nBegin = nPerThread; nBegin < nCount; nBegin += nPerThread)
+        threadGroup.create_thread(boost::bind(&HashBlockIndexRange, &vDiskIndex, &vHash, &vValid, nBegin, std::min(nBegin + nPerThread, nCount)));
+    HashBlockIndexRange(&vDiskIndex, &vHash, &vValid, 0, std::min(nPerThread, nCount));
+    threadGroup.join_all();
+
+    for (size_t i = 0; i < nCount; i++) {
+        const CDiskBlockIndex& diskindex = vDiskIndex[i];
+
+        /**-5-10Construct block index object
+        CBlockIndex* pindexNew = InsertBlockIndex(vHash[i]);
+        pindexNew->pprev          = InsertBlockIndex(diskindex.hashPrev);
+        pindexNew->nHeight        = diskindex.nHeight;
+        pindexNew->nFile          = diskindex.nFile;
+        pindexNew->nDataPos       = diskindex.nDataPos;
+        pindexNew->nUndoPos       = diskindex.nUndoPos;
+        pindexNew->nVersion       = diskindex.nVersion;
+        pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+        pindexNew->nTime          = diskindex.nTime;
+        pindexNew->nBits          = diskindex.nBits;
+        pindexNew->nNonce         = diskindex.nNonce;
+        pindexNew->nStatus        = diskindex.nStatus;
+        pindexNew->nTx            = diskindex.nTx;
+
+        if (!vValid[i])
+            return error("LoadBlockIndex() : CheckIndex failed: %s", pindexNew->ToString());
+    }
+    return true;
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts()
 {
     leveldb::Iterator *pcursor = NewIterator();
@@ -189,7 +505,10 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
     ssKeySet << make_pair('b', uint256(0));
     pcursor->Seek(ssKeySet.str());
 
-    /**-5-10Load mapBlockIndex
+    /**-5-10Load mapBlockIndex. Records are read sequentially, while hashing and the
+    /**-5-10proof-of-work check of each batch is spread over all cores.
+    std::vector<CDiskBlockIndex> vDiskIndex;
+    vDiskIndex.reserve(BLOCKINDEX_LOAD_BATCH);
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         try {
@@ -200,36 +519,27 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
             if (chType == 'b') {
                 leveldb::Slice slValue = pcursor->value();
                 CDataStream ssValue(slValue.data(), slValue.data()+slValue.size(), SER_DISK, CLIENT_VERSION);
-                CDiskBlockIndex diskindex;
-                ssValue >> diskindex;
-
-                /**-5-10Construct block index object
-                CBlockIndex* pindexNew = InsertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev          = InsertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight        = diskindex.nHeight;
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nTx            = diskindex.nTx;
-
-                if (!pindexNew->CheckIndex())
-                    return error("LoadBlockIndex() : CheckIndex failed: %s", pindexNew->ToString());
+                vDiskIndex.push_back(CDiskBlockIndex());
+                ssValue >> vDiskIndex.back();
+
+                if (vDiskIndex.size() == BLOCKINDEX_LOAD_BATCH) {
+                    if (!InsertBlockIndexBatch(vDiskIndex)) {
+                        delete pcursor;
+                        return false;
+                    }
+                    vDiskIndex.clear();
+                }
 
                 pcursor->Next();
             } else {
                 break; /**-5-10if shutdown requested or finished loading block index
             }
         } catch (std::exception &e) {
+            delete pcursor;
             return error("%s : Deserialize or I/O error - %s", __func__, e.what());
         }
     }
     delete pcursor;
 
-    return true;
+    return InsertBlockIndexBatch(vDiskIndex);
 }
@@ -6,8 +6,11 @@
 #ifndef ticoin_TXDB_LEVELDB_H
 #define ticoin_TXDB_LEVELDB_H
 
+#include "addressindex.h"
+#include "hash.h"
 #include "leveldbwrapper.h"
 #include "main.h"
+#include "txindex.h"
 
 #include <map>
 #include <string>
@@ -25,6 +28,29 @@ static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 4096 : 1024;
 /**-5-10min. -dbcache in (MiB)
 static const int64_t nMinDbCache = 4;
 
+/**-5-10Add the unspent outputs of one transaction to the totals and the running hash_serialized of gettxoutsetinfo
+void UpdateCoinsStats(CHashWriter &ss, CCoinsStats &stats, const uint256 &txid, const CCoins &coins);
+
+/** Iterates over the coins of a CCoinsViewDB in database key order, as they were when the cursor was created */
+class CCoinsViewDBCursor
+{
+public:
+    ~CCoinsViewDBCursor();
+
+    bool Valid() const;
+    void Next();
+    bool GetCoins(uint256 &txid, CCoins &coins) const;
+
+private:
+    CCoinsViewDBCursor(leveldb::Iterator *pcursorIn) : pcursor(pcursorIn) {}
+    CCoinsViewDBCursor(const CCoinsViewDBCursor&);
+    void operator=(const CCoinsViewDBCursor&);
+
+    leveldb::Iterator *pcursor;
+
+    friend class CCoinsViewDB;
+};
+
 /** CCoinsView backed by the LevelDB coin database (chainstate/) */
 class CCoinsViewDB : public CCoinsView
 {
@@ -40,6 +66,11 @@ public:
     bool SetBestBlock(const uint256 &hashBlock);
     bool BatchWrite(const std::map<uint256, CCoins> &mapCoins, const uint256 &hashBlock);
     bool GetStats(CCoinsStats &stats);
+    CLevelDBWrapper &GetDB() { return db; }
+    /**-5-10Write coins in the given order, without changing the best block
+    bool WriteCoins(const std::vector<std::pair<uint256, CCoins> > &vCoins);
+    /**-5-10Caller takes ownership of the returned cursor
+    CCoinsViewDBCursor *Cursor();
 };
 
 /** Access to the block database (blocks/index/) */
@@ -52,6 +83,7 @@ private:
     void operator=(const CBlockTreeDB&);
 public:
     bool WriteBlockIndex(const CDiskBlockIndex& blockindex);
+    bool WriteBlockIndex(const std::vector<CDiskBlockIndex>& vblockindex);
     bool WriteBestInvalidWork(const CBigNum& bnBestInvalidWork);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &fileinfo);
     bool WriteBlockFileInfo(int nFile, const CBlockFileInfo &fileinfo);
@@ -59,8 +91,22 @@ public:
     bool WriteLastBlockFile(int nFile);
     bool WriteReindexing(bool fReindex);
     bool ReadReindexing(bool &fReindex);
-    bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
-    bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
+    bool ReadTxIndex(const uint256 &txid, std::vector<CTxIndexKey> &vKeys);
+    bool WriteTxIndex(const std::vector<CTxIndexKey> &vKeys, const uint256 &hashBest);
+    bool ReadTxIndexBest(uint256 &hashBest);
+    /**-5-10The txid -> position index of earlier versions, kept until the new one has caught up
+    bool HaveLegacyTxIndex();
+    bool ReadLegacyTxIndex(const uint256 &txid, CDiskTxPos &pos);
+    /**-5-10Erase up to nMax entries of it; fDone is set once none are left
+    bool EraseLegacyTxIndex(unsigned int nMax, bool &fDone);
+    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, int64_t> > &vHistory,
+                           const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vUnspent);
+    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, int64_t> > &vHistory,
+                           const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vUnspent);
+    bool ReadAddressIndex(const CAddressIndexKey &keyStart, unsigned int nMaxTx,
+                          std::vector<std::pair<CAddressIndexKey, int64_t> > &vHistory, CAddressIndexKey *pkeyNext);
+    bool ReadAddressUnspentIndex(const CAddressUnspentKey &keyStart, unsigned int nMax,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vUnspent, CAddressUnspentKey *pkeyNext);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts();
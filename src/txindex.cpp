@@ -0,0 +1,281 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txindex.h"
+
+#include "txdb.h"
+#include "txview.h"
+#include "util.h"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+using namespace std;
+
+CTxIndex *ptxindex = NULL;
+
+/**-5-10Blocks handed to the worker threads at a time, and an upper bound on their transactions
+static const unsigned int TXINDEX_BATCH_BLOCKS = 1000;
+static const unsigned int TXINDEX_BATCH_TX = 200000;
+static const int MAX_TXINDEX_THREADS = 8;
+/**-5-10Old index entries erased per batch
+static const unsigned int TXINDEX_ERASE_BATCH = 10000;
+/**-5-10Bounds of the wait before a failed catch-up is retried, in milliseconds
+static const int64_t TXINDEX_RETRY_MIN = 1000;
+static const int64_t TXINDEX_RETRY_MAX = 10 * 60 * 1000;
+
+/**-5-10Compute the index entries of blocks nBegin, nBegin + nStep, ... of vBlocks. A block is
+/**-5-10hashed from its bytes on disk, without deserializing its transactions.
+static void IndexBlocks(const vector<const CBlockIndex*> *pvBlocks, vector<vector<CTxIndexKey> > *pvKeys,
+                        vector<char> *pvOk, size_t nBegin, size_t nStep)
+{
+    vector<unsigned char> vchBlock;
+    for (size_t i = nBegin; i < pvBlocks->size(); i += nStep) {
+        boost::this_thread::interruption_point();
+        const CBlockIndex *pindex = (*pvBlocks)[i];
+        CBlockView block;
+        if (!ReadRawBlockFromDisk(vchBlock, pindex) || !block.Parse(&vchBlock[0], &vchBlock[0] + vchBlock.size()))
+            continue;
+        vector<CTxIndexKey> &vKeys = (*pvKeys)[i];
+        vKeys.reserve(block.vtx.size());
+        BOOST_FOREACH(const CTransactionView &tx, block.vtx)
+            vKeys.push_back(CTxIndexKey(tx.GetHash(), pindex->nHeight, tx.begin() - &vchBlock[80]));
+        (*pvOk)[i] = true;
+    }
+}
+
+CTxIndex::CTxIndex() : pindexBest(NULL), fSynced(false)
+{
+    LOCK(cs_main);
+    fLegacy = pblocktree->HaveLegacyTxIndex();
+    uint256 hashBest;
+    if (pblocktree->ReadTxIndexBest(hashBest)) {
+        BlockMap::iterator mi = mapBlockIndex.find(hashBest);
+        if (mi != mapBlockIndex.end())
+            pindexBest = mi->second;
+    }
+}
+
+bool CTxIndex::Sync()
+{
+    int nThreads = max(1, min(MAX_TXINDEX_THREADS, (int)boost::thread::hardware_concurrency()));
+    int64_t nLastLog = GetTime();
+    while (true) {
+        boost::this_thread::interruption_point();
+
+        vector<const CBlockIndex*> vBlocks;
+        {
+            LOCK2(cs_main, cs_txindex);
+            /**-5-10Continue from where the last block indexed joins the active chain
+            const CBlockIndex *pindex = pindexBest;
+            while (pindex && !chainActive.Contains(pindex))
+                pindex = pindex->pprev;
+            const CBlockIndex *pindexNext = pindex ? chainActive.Next(pindex) : chainActive.Genesis();
+            unsigned int nTx = 0;
+            while (pindexNext && vBlocks.size() < TXINDEX_BATCH_BLOCKS && nTx < TXINDEX_BATCH_TX) {
+                vBlocks.push_back(pindexNext);
+                nTx += pindexNext->nTx;
+                pindexNext = chainActive.Next(pindexNext);
+            }
+            if (vBlocks.empty()) {
+                /**-5-10From here on BlockConnected, which runs under cs_main too, takes over
+                pindexBest = pindex;
+                fSynced = true;
+                LogPrintf("CTxIndex::Sync : transaction index is up to date at height %d\n", pindex ? pindex->nHeight : -1);
+                return true;
+            }
+        }
+
+        vector<vector<CTxIndexKey> > vKeys(vBlocks.size());
+        vector<char> vOk(vBlocks.size(), false);
+        boost::thread_group workers;
+        for (int i = 0; i < nThreads; i++)
+            workers.create_thread(boost::bind(&IndexBlocks, &vBlocks, &vKeys, &vOk, i, nThreads));
+        try {
+            workers.join_all();
+        } catch (boost::thread_interrupted) {
+            workers.interrupt_all();
+            workers.join_all();
+            throw;
+        }
+
+        vector<CTxIndexKey> vBatch;
+        for (unsigned int i = 0; i < vBlocks.size(); i++) {
+            if (!vOk[i])
+                return error("CTxIndex::Sync : failed to read block %s", vBlocks[i]->GetBlockHash().ToString());
+            vBatch.insert(vBatch.end(), vKeys[i].begin(), vKeys[i].end());
+        }
+        if (!pblocktree->WriteTxIndex(vBatch, vBlocks.back()->GetBlockHash()))
+            return error("CTxIndex::Sync : failed to write transaction index");
+        {
+            LOCK(cs_txindex);
+            pindexBest = vBlocks.back();
+        }
+
+        if (GetTime() >= nLastLog + 30) {
+            LogPrintf("CTxIndex::Sync : transaction index at height %d of %d\n", vBlocks.back()->nHeight, chainActive.Height());
+            nLastLog = GetTime();
+        }
+    }
+}
+
+void CTxIndex::BlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    LOCK(cs_txindex);
+    if (!fSynced)
+        return;
+
+    vector<CTxIndexKey> vKeys;
+    vKeys.reserve(block.vtx.size());
+    unsigned int nTxOffset = GetSizeOfCompactSize(block.vtx.size());
+    for (unsigned int i = 0; i < block.vtx.size(); i++) {
+        vKeys.push_back(CTxIndexKey(block.GetTxHash(i), pindex->nHeight, nTxOffset));
+        nTxOffset += ::GetSerializeSize(block.vtx[i], SER_DISK, CLIENT_VERSION);
+    }
+    if (!pblocktree->WriteTxIndex(vKeys, pindex->GetBlockHash())) {
+        /**-5-10Stop following the chain; ThreadTxIndex catches up again from the last block written
+        fSynced = false;
+        error("CTxIndex::BlockConnected : failed to write transaction index");
+        return;
+    }
+    pindexBest = pindex;
+}
+
+bool CTxIndex::EraseLegacy()
+{
+    {
+        LOCK(cs_txindex);
+        if (!fLegacy)
+            return true;
+    }
+    LogPrintf("CTxIndex::EraseLegacy : erasing the transaction index of earlier versions\n");
+    bool fDone = false;
+    while (!fDone) {
+        boost::this_thread::interruption_point();
+        if (!pblocktree->EraseLegacyTxIndex(TXINDEX_ERASE_BATCH, fDone))
+            return error("CTxIndex::EraseLegacy : failed to erase old transaction index entries");
+    }
+    LOCK(cs_txindex);
+    fLegacy = false;
+    LogPrintf("CTxIndex::EraseLegacy : done\n");
+    return true;
+}
+
+void CTxIndex::BlockDisconnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    LOCK(cs_txindex);
+    if (fSynced)
+        pindexBest = pindex->pprev;
+}
+
+bool CTxIndex::FindTx(const uint256 &txid, CTransaction &txOut, uint256 &hashBlock) const
+{
+    AssertLockHeld(cs_main);
+    vector<CTxIndexKey> vKeys;
+    if (!pblocktree->ReadTxIndex(txid, vKeys))
+        return false;
+
+    BOOST_FOREACH(const CTxIndexKey &key, vKeys) {
+        CBlockIndex *pindex = chainActive[key.nHeight];
+        if (pindex == NULL)
+            continue;
+        CDiskTxPos postx(pindex->GetBlockPos(), key.nTxOffset);
+        CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+        if (!file)
+            continue;
+        CTransaction tx;
+        try {
+            /**-5-10Skip the block header
+            fseek(file, 80 + postx.nTxOffset, SEEK_CUR);
+            file >> tx;
+        } catch (std::exception &e) {
+            error("%s : Deserialize or I/O error - %s", __func__, e.what());
+            continue;
+        }
+        /**-5-10Another transaction with the same prefix, or an entry of a disconnected block
+        if (tx.GetHash() != txid)
+            continue;
+        txOut = tx;
+        hashBlock = pindex->GetBlockHash();
+        return true;
+    }
+
+    {
+        LOCK(cs_txindex);
+        if (fSynced || !fLegacy)
+            return false;
+    }
+    return FindLegacyTx(txid, txOut, hashBlock);
+}
+
+/**-5-10The old index points at the transaction directly, and only knows the block from its header
+bool CTxIndex::FindLegacyTx(const uint256 &txid, CTransaction &txOut, uint256 &hashBlock) const
+{
+    CDiskTxPos postx;
+    if (!pblocktree->ReadLegacyTxIndex(txid, postx))
+        return false;
+    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    if (!file)
+        return false;
+    CBlockHeader header;
+    CTransaction tx;
+    try {
+        file >> header;
+        fseek(file, postx.nTxOffset, SEEK_CUR);
+        file >> tx;
+    } catch (std::exception &e) {
+        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    if (tx.GetHash() != txid)
+        return false;
+    BlockMap::iterator mi = mapBlockIndex.find(header.GetHash());
+    if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+        return false;
+    txOut = tx;
+    hashBlock = header.GetHash();
+    return true;
+}
+
+bool CTxIndex::IsSynced() const
+{
+    LOCK(cs_txindex);
+    return fSynced;
+}
+
+int CTxIndex::GetHeight() const
+{
+    LOCK(cs_txindex);
+    return pindexBest ? pindexBest->nHeight : -1;
+}
+
+void ThreadTxIndex()
+{
+    RenameThread("ticoin-txindex");
+    int64_t nRetryMillis = TXINDEX_RETRY_MIN;
+    while (true) {
+        bool fOk = false;
+        try {
+            /**-5-10BlockConnected drops out of step when it cannot write; catch up again then
+            fOk = ptxindex->IsSynced() || ptxindex->Sync();
+            if (fOk)
+                fOk = ptxindex->EraseLegacy();
+        } catch (boost::thread_interrupted) {
+            throw;
+        } catch (std::exception& e) {
+            PrintExceptionContinue(&e, "ThreadTxIndex()");
+        } catch (...) {
+            PrintExceptionContinue(NULL, "ThreadTxIndex()");
+        }
+        if (fOk) {
+            nRetryMillis = TXINDEX_RETRY_MIN;
+            MilliSleep(1000);
+        } else {
+            LogPrintf("ThreadTxIndex : retrying in %d s\n", nRetryMillis / 1000);
+            MilliSleep(nRetryMillis);
+            nRetryMillis = min(2 * nRetryMillis, TXINDEX_RETRY_MAX);
+        }
+    }
+}
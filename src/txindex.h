@@ -0,0 +1,101 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ticoin_TXINDEX_H
+#define ticoin_TXINDEX_H
+
+#include "main.h"
+#include "serialize.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <string.h>
+
+/** Key of a transaction index entry. Only the first 8 bytes of the txid are
+ * kept, followed by where the transaction is: the height of its block in the
+ * active chain and its offset after the block header, both as varints.
+ * Transactions whose ids share the prefix get an entry each, and are told
+ * apart by reading them from disk. The entry itself has no value.
+ */
+struct CTxIndexKey
+{
+    unsigned char vchPrefix[8];
+    int nHeight;
+    unsigned int nTxOffset;
+
+    CTxIndexKey() : nHeight(0), nTxOffset(0) { memset(vchPrefix, 0, sizeof(vchPrefix)); }
+    CTxIndexKey(const uint256& txid, int nHeightIn, unsigned int nTxOffsetIn) : nHeight(nHeightIn), nTxOffset(nTxOffsetIn)
+    {
+        memcpy(vchPrefix, txid.begin(), sizeof(vchPrefix));
+    }
+
+    bool HasPrefix(const uint256& txid) const
+    {
+        return memcmp(vchPrefix, txid.begin(), sizeof(vchPrefix)) == 0;
+    }
+
+    IMPLEMENT_SERIALIZE
+    (
+        READWRITE(FLATDATA(vchPrefix));
+        READWRITE(VARINT(nHeight));
+        READWRITE(VARINT(nTxOffset));
+    )
+};
+
+/** Index from txid to the position of the transaction in the block files
+ * (-txindex). It is built by ThreadTxIndex in the background: when enabled on
+ * a node that already has a chain, it catches up from the block files, reading
+ * and hashing several blocks in parallel, and from then on follows the active
+ * chain through BlockConnected.
+ *
+ * Entries of disconnected blocks are not erased. Lookups check the transaction
+ * they find at an entry's position in the active chain, so stale ones are
+ * skipped.
+ *
+ * Nodes that ran -txindex before keep answering from the old index, keyed by
+ * full txid, until this one has caught up; it is then erased in the background.
+ */
+class CTxIndex : public CIndexInterface
+{
+private:
+    mutable CCriticalSection cs_txindex;
+    /**-5-10Last block indexed; it may have been disconnected since
+    const CBlockIndex *pindexBest;
+    /**-5-10Whether BlockConnected keeps the index in step with chainActive
+    bool fSynced;
+    /**-5-10Whether entries of the old index may be left
+    bool fLegacy;
+
+    bool FindLegacyTx(const uint256 &txid, CTransaction &txOut, uint256 &hashBlock) const;
+
+protected:
+    void BlockConnected(const CBlock &block, const CBlockIndex *pindex);
+    void BlockDisconnected(const CBlock &block, const CBlockIndex *pindex);
+
+public:
+    CTxIndex();
+
+    /** Index the active chain up to its tip. Returns false on failure, after
+     *  which the index stays where it got to. */
+    bool Sync();
+
+    /** Erase what is left of the old index, in batches. Returns false on failure. */
+    bool EraseLegacy();
+
+    /** Look up a transaction in a block of the active chain. Requires cs_main. */
+    bool FindTx(const uint256 &txid, CTransaction &txOut, uint256 &hashBlock) const;
+
+    bool IsSynced() const;
+    /** Height of the last block indexed, -1 if none */
+    int GetHeight() const;
+};
+
+/** The -txindex index, or NULL if disabled */
+extern CTxIndex *ptxindex;
+
+/** Thread that brings ptxindex up to date with the active chain, and again
+ *  whenever it falls out of step; failures are retried with backoff. */
+void ThreadTxIndex();
+
+#endif /**-5-10ticoin_TXINDEX_H
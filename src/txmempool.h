@@ -56,6 +56,7 @@ class CTxMemPool
 private:
     bool fSanityCheck; /**-5-10Normally false, true if -checkmempool or -regtest
     unsigned int nTransactionsUpdated;
+    uint64_t totalTxSize; /**-5-10sum of the serialized sizes of all transactions in mapTx
 
 public:
     mutable CCriticalSection cs;
@@ -88,6 +89,12 @@ public:
         return mapTx.size();
     }
 
+    uint64_t GetTotalTxSize()
+    {
+        LOCK(cs);
+        return totalTxSize;
+    }
+
     bool exists(uint256 hash)
     {
         LOCK(cs);
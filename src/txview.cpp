@@ -0,0 +1,190 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txview.h"
+
+#include "serialize.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace {
+
+/** Bounds-checked little-endian reads over a buffer, mirroring the serialize.h templates */
+class CBufferReader
+{
+private:
+    const unsigned char*& pc;
+    const unsigned char* pend;
+
+public:
+    CBufferReader(const unsigned char*& pcIn, const unsigned char* pendIn) : pc(pcIn), pend(pendIn) {}
+
+    size_t Remaining() const { return pend - pc; }
+
+    bool Read(void* p, size_t nSize)
+    {
+        if (Remaining() < nSize)
+            return false;
+        memcpy(p, pc, nSize);
+        pc += nSize;
+        return true;
+    }
+
+    /**-5-10Same canonical encoding and MAX_SIZE rules as ReadCompactSize()
+    bool ReadCompactSize(uint64_t& nSizeRet)
+    {
+        unsigned char chSize;
+        if (!Read(&chSize, 1))
+            return false;
+        if (chSize < 253) {
+            nSizeRet = chSize;
+        } else if (chSize == 253) {
+            unsigned short xSize;
+            if (!Read(&xSize, 2) || xSize < 253)
+                return false;
+            nSizeRet = xSize;
+        } else if (chSize == 254) {
+            unsigned int xSize;
+            if (!Read(&xSize, 4) || xSize < 0x10000u)
+                return false;
+            nSizeRet = xSize;
+        } else {
+            uint64_t xSize;
+            if (!Read(&xSize, 8) || xSize < 0x100000000ULL)
+                return false;
+            nSizeRet = xSize;
+        }
+        return nSizeRet <= (uint64_t)MAX_SIZE;
+    }
+
+    bool ReadScript(CScriptView& script)
+    {
+        uint64_t nSize;
+        if (!ReadCompactSize(nSize) || Remaining() < nSize)
+            return false;
+        script = CScriptView(pc, pc + nSize);
+        pc += nSize;
+        return true;
+    }
+};
+
+}
+
+void CTransactionView::SetNull()
+{
+    pbegin = pend = NULL;
+    nVersion = CTransaction::CURRENT_VERSION;
+    vin.clear();
+    vout.clear();
+    nLockTime = 0;
+}
+
+bool CTransactionView::Parse(const unsigned char*& pc, const unsigned char* pendBuffer)
+{
+    SetNull();
+    const unsigned char* pstart = pc;
+    CBufferReader reader(pc, pendBuffer);
+
+    if (!reader.Read(&nVersion, 4))
+        return false;
+
+    /**-5-10Every input takes at least 41 bytes and every output 9, which bounds
+    /**-5-10what a corrupt count can make us reserve.
+    uint64_t nInputs;
+    if (!reader.ReadCompactSize(nInputs))
+        return false;
+    vin.reserve(std::min(nInputs, (uint64_t)reader.Remaining() / 41));
+    for (uint64_t i = 0; i < nInputs; i++) {
+        CTxInView txin;
+        if (!reader.Read(txin.prevout.hash.begin(), 32) ||
+            !reader.Read(&txin.prevout.n, 4) ||
+            !reader.ReadScript(txin.scriptSig) ||
+            !reader.Read(&txin.nSequence, 4))
+            return false;
+        vin.push_back(txin);
+    }
+
+    uint64_t nOutputs;
+    if (!reader.ReadCompactSize(nOutputs))
+        return false;
+    vout.reserve(std::min(nOutputs, (uint64_t)reader.Remaining() / 9));
+    for (uint64_t i = 0; i < nOutputs; i++) {
+        CTxOutView txout;
+        if (!reader.Read(&txout.nValue, 8) ||
+            !reader.ReadScript(txout.scriptPubKey))
+            return false;
+        vout.push_back(txout);
+    }
+
+    if (!reader.Read(&nLockTime, 4))
+        return false;
+
+    pbegin = pstart;
+    pend = pc;
+    return true;
+}
+
+CTransaction CTransactionView::ToTransaction() const
+{
+    CTransaction tx;
+    tx.nVersion = nVersion;
+    tx.vin.reserve(vin.size());
+    for (unsigned int i = 0; i < vin.size(); i++)
+        tx.vin.push_back(vin[i].ToTxIn());
+    tx.vout.reserve(vout.size());
+    for (unsigned int i = 0; i < vout.size(); i++)
+        tx.vout.push_back(vout[i].ToTxOut());
+    tx.nLockTime = nLockTime;
+    return tx;
+}
+
+void CBlockView::SetNull()
+{
+    pbegin = pend = NULL;
+    header.SetNull();
+    vtx.clear();
+}
+
+bool CBlockView::Parse(const unsigned char* pbeginIn, const unsigned char* pendIn)
+{
+    SetNull();
+    const unsigned char* pc = pbeginIn;
+    CBufferReader reader(pc, pendIn);
+
+    if (!reader.Read(&header.nVersion, 4) ||
+        !reader.Read(header.hashPrevBlock.begin(), 32) ||
+        !reader.Read(header.hashMerkleRoot.begin(), 32) ||
+        !reader.Read(&header.nTime, 4) ||
+        !reader.Read(&header.nBits, 4) ||
+        !reader.Read(&header.nNonce, 4))
+        return false;
+
+    /**-5-10A transaction with one input and one output takes at least 60 bytes
+    uint64_t nTx;
+    if (!reader.ReadCompactSize(nTx))
+        return false;
+    vtx.reserve(std::min(nTx, (uint64_t)reader.Remaining() / 60));
+    for (uint64_t i = 0; i < nTx; i++) {
+        vtx.push_back(CTransactionView());
+        if (!vtx.back().Parse(pc, pendIn))
+            return false;
+    }
+
+    if (pc != pendIn)
+        return false;
+
+    pbegin = pbeginIn;
+    pend = pendIn;
+    return true;
+}
+
+CBlock CBlockView::ToBlock() const
+{
+    CBlock block(header);
+    block.vtx.reserve(vtx.size());
+    for (unsigned int i = 0; i < vtx.size(); i++)
+        block.vtx.push_back(vtx[i].ToTransaction());
+    return block;
+}
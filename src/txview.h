@@ -0,0 +1,151 @@
+/**-5-10Copyright (c) 2014 The ticoin developers
+/**-5-10Distributed under the MIT/X11 software license, see the accompanying
+/**-5-10file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ticoin_TXVIEW_H
+#define ticoin_TXVIEW_H
+
+#include "core.h"
+#include "hash.h"
+#include "script.h"
+#include "uint256.h"
+
+#include <stdint.h>
+#include <vector>
+
+/** Read-only views of serialized transactions and blocks.
+ *
+ * A view is parsed once over a contiguous buffer that stays owned by the
+ * caller and must outlive the view. Scripts are not copied; they are handed
+ * out as ranges of the buffer. Owned CTransaction/CBlock objects are only
+ * built on request, which makes the views cheap for code that inspects a
+ * few fields or relays the data unchanged.
+ */
+
+/** Script inside a serialized transaction */
+class CScriptView
+{
+private:
+    const unsigned char* pbegin;
+    const unsigned char* pend;
+
+public:
+    typedef const unsigned char* const_iterator;
+
+    CScriptView() : pbegin(NULL), pend(NULL) {}
+    CScriptView(const unsigned char* pbeginIn, const unsigned char* pendIn) : pbegin(pbeginIn), pend(pendIn) {}
+
+    const_iterator begin() const { return pbegin; }
+    const_iterator end() const { return pend; }
+    size_t size() const { return pend - pbegin; }
+    bool empty() const { return pend == pbegin; }
+
+    bool GetOp(const_iterator& pc, opcodetype& opcodeRet, std::vector<unsigned char>& vchRet) const
+    {
+        return GetScriptOp(pc, pend, opcodeRet, &vchRet);
+    }
+
+    CScript ToScript() const { return CScript(pbegin, pend); }
+};
+
+class CTxInView
+{
+public:
+    COutPoint prevout;
+    CScriptView scriptSig;
+    unsigned int nSequence;
+
+    CTxIn ToTxIn() const { return CTxIn(prevout, scriptSig.ToScript(), nSequence); }
+};
+
+class CTxOutView
+{
+public:
+    int64_t nValue;
+    CScriptView scriptPubKey;
+
+    CTxOut ToTxOut() const { return CTxOut(nValue, scriptPubKey.ToScript()); }
+};
+
+class CTransactionView
+{
+private:
+    const unsigned char* pbegin;
+    const unsigned char* pend;
+
+public:
+    int nVersion;
+    std::vector<CTxInView> vin;
+    std::vector<CTxOutView> vout;
+    unsigned int nLockTime;
+
+    CTransactionView() { SetNull(); }
+
+    void SetNull();
+
+    /** Parse the transaction that starts at pc and ends at or before pendBuffer.
+     * On success pc is advanced past it. Accepts exactly what unserializing a
+     * CTransaction accepts.
+     */
+    bool Parse(const unsigned char*& pc, const unsigned char* pendBuffer);
+
+    const unsigned char* begin() const { return pbegin; }
+    const unsigned char* end() const { return pend; }
+
+    /**-5-10The hash of the serialized bytes, without serializing again
+    uint256 GetHash() const { return Hash(pbegin, pend); }
+
+    bool IsCoinBase() const
+    {
+        return (vin.size() == 1 && vin[0].prevout.IsNull());
+    }
+
+    CTransaction ToTransaction() const;
+
+    /**-5-10Serializes to the bytes it was parsed from, so a view can be relayed as is
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return pend - pbegin;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        s.write((const char*)pbegin, pend - pbegin);
+    }
+};
+
+class CBlockView
+{
+private:
+    const unsigned char* pbegin;
+    const unsigned char* pend;
+
+public:
+    CBlockHeader header;
+    std::vector<CTransactionView> vtx;
+
+    CBlockView() { SetNull(); }
+
+    void SetNull();
+
+    /** Parse a serialized block that fills the whole buffer */
+    bool Parse(const unsigned char* pbeginIn, const unsigned char* pendIn);
+
+    uint256 GetHash() const { return header.GetHash(); }
+
+    CBlock ToBlock() const;
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return pend - pbegin;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        s.write((const char*)pbegin, pend - pbegin);
+    }
+};
+
+#endif /**-5-10ticoin_TXVIEW_H
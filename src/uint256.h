@@ -6,6 +6,7 @@
 #ifndef ticoin_UINT256_H
 #define ticoin_UINT256_H
 
+#include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string>
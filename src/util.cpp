@@ -96,6 +96,8 @@ bool fServer = false;
 string strMiscWarning;
 bool fNoListen = false;
 bool fLogTimestamps = false;
+bool fLogJSON = false;
+int64_t nLogRateLimit = 0;
 volatile bool fReopenDebugLog = false;
 CClientUIInterface uiInterface;
 
@@ -225,6 +227,33 @@ static boost::once_flag debugPrintInitFlag = BOOST_ONCE_INIT;
 static FILE* fileout = NULL;
 static boost::mutex* mutexDebugLog = NULL;
 
+/**-5-10A message waiting for the log writer thread, with the time it was logged at
+struct CLogEntry
+{
+    int64_t nTime;
+    const char* category;
+    std::string str;
+};
+
+/**-5-10Messages are only queued while the log writer thread runs (-logasync). The
+/**-5-10queue is bounded: when it is full, the message is written synchronously,
+/**-5-10after the queue, which slows the logging thread down instead of dropping it.
+static const unsigned int MAX_LOG_QUEUE = 10000;
+static boost::mutex* mutexLogQueue = NULL;
+static boost::condition_variable* condLogQueue = NULL;
+static std::vector<CLogEntry>* pvLogQueue = NULL;
+static bool fLogWriterRunning = false;
+
+/**-5-10-lograte: at most nLogRateLimit messages per second for each debug category.
+struct CLogRate
+{
+    int64_t nTime;
+    int64_t nCount;
+    int64_t nSuppressed;
+};
+static boost::mutex* mutexLogRate = NULL;
+static std::map<std::string, CLogRate>* pmapLogRate = NULL;
+
 static void DebugPrintInit()
 {
     assert(fileout == NULL);
@@ -232,30 +261,50 @@ static void DebugPrintInit()
 
     boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
     fileout = fopen(pathDebug.string().c_str(), "a");
-    if (fileout) setbuf(fileout, NULL); /**-5-10unbuffered
 
     mutexDebugLog = new boost::mutex();
+    mutexLogQueue = new boost::mutex();
+    condLogQueue = new boost::condition_variable();
+    pvLogQueue = new std::vector<CLogEntry>();
+    mutexLogRate = new boost::mutex();
+    pmapLogRate = new std::map<std::string, CLogRate>();
+}
+
+/**-5-10Debug categories, changeable at runtime with EnableLogCategory. Every thread
+/**-5-10keeps a copy, and refreshes it when nLogCategoriesVersion changes.
+static boost::once_flag logCategoriesInitFlag = BOOST_ONCE_INIT;
+static boost::mutex* mutexLogCategories = NULL;
+static set<string>* psetLogCategories = NULL;
+static volatile int nLogCategoriesVersion = 0;
+
+/**-5-10The categories are copied out of mapMultiArgs once, into a set that is never
+/**-5-10deleted. This also helps prevent issues debugging global destructors, where
+/**-5-10mapMultiArgs might be deleted before another global destructor calls LogPrint().
+static void LogCategoriesInit()
+{
+    const vector<string>& categories = mapMultiArgs["-debug"];
+    psetLogCategories = new set<string>(categories.begin(), categories.end());
+    /**-5-10-debug=0 or -nodebug starts with no categories, as it turns fDebug off
+    if (GetBoolArg("-nodebug", false) || psetLogCategories->count("0"))
+        psetLogCategories->clear();
+    mutexLogCategories = new boost::mutex();
 }
 
 bool LogAcceptCategory(const char* category)
 {
     if (category != NULL)
     {
-        if (!fDebug)
-            return false;
-
-        /**-5-10Give each thread quick access to -debug settings.
-        /**-5-10This helps prevent issues debugging global destructors,
-        /**-5-10where mapMultiArgs might be deleted before another
-        /**-5-10global destructor calls LogPrint()
-        static boost::thread_specific_ptr<set<string> > ptrCategory;
-        if (ptrCategory.get() == NULL)
+        /**-5-10No fDebug check: the category set starts out empty when fDebug is off, and
+        /**-5-10EnableLogCategory changes only the set, as fDebug also gates non-logging code.
+        static boost::thread_specific_ptr<pair<int, set<string> > > ptrCategory;
+        if (ptrCategory.get() == NULL || ptrCategory->first != nLogCategoriesVersion)
         {
-            const vector<string>& categories = mapMultiArgs["-debug"];
-            ptrCategory.reset(new set<string>(categories.begin(), categories.end()));
+            boost::call_once(&LogCategoriesInit, logCategoriesInitFlag);
+            boost::mutex::scoped_lock scoped_lock(*mutexLogCategories);
+            ptrCategory.reset(new pair<int, set<string> >(nLogCategoriesVersion, *psetLogCategories));
             /**-5-10thread_specific_ptr automatically deletes the set when the thread ends.
         }
-        const set<string>& setCategories = *ptrCategory.get();
+        const set<string>& setCategories = ptrCategory->second;
 
         /**-5-10if not debugging everything and not debugging specific category, LogPrint does nothing.
         if (setCategories.count(string("")) == 0 &&
@@ -265,7 +314,149 @@ bool LogAcceptCategory(const char* category)
     return true;
 }
 
-int LogPrintStr(const std::string &str)
+void EnableLogCategory(const std::string& category, bool fEnable)
+{
+    boost::call_once(&LogCategoriesInit, logCategoriesInitFlag);
+    boost::mutex::scoped_lock scoped_lock(*mutexLogCategories);
+    if (fEnable)
+        psetLogCategories->insert(category);
+    else
+        psetLogCategories->erase(category);
+    nLogCategoriesVersion++;
+}
+
+std::set<std::string> GetLogCategories()
+{
+    boost::call_once(&LogCategoriesInit, logCategoriesInitFlag);
+    boost::mutex::scoped_lock scoped_lock(*mutexLogCategories);
+    return *psetLogCategories;
+}
+
+/**-5-10Returns whether str may be logged under -lograte; when the first message of a new
+/**-5-10second is, a note about the ones suppressed in the previous second is put in front of it.
+static bool LogRateLimit(const char* category, int64_t nTime, std::string& str)
+{
+    boost::mutex::scoped_lock scoped_lock(*mutexLogRate);
+    CLogRate& rate = (*pmapLogRate)[category];
+    if (rate.nTime != nTime) {
+        if (rate.nSuppressed > 0)
+            str = strprintf("Suppressed %d messages in category %s (-lograte=%d)\n", rate.nSuppressed, category, nLogRateLimit) + str;
+        rate.nTime = nTime;
+        rate.nCount = 0;
+        rate.nSuppressed = 0;
+    }
+    if (rate.nCount >= nLogRateLimit) {
+        rate.nSuppressed++;
+        return false;
+    }
+    rate.nCount++;
+    return true;
+}
+
+static std::string JSONEscape(const std::string& str)
+{
+    std::string strRet;
+    BOOST_FOREACH(unsigned char c, str) {
+        if (c == '"' || c == '\\')
+            strRet += strprintf("\\%c", c);
+        else if (c == '\n')
+            strRet += "\\n";
+        else if (c < 0x20)
+            strRet += strprintf("\\u%04x", c);
+        else
+            strRet += c;
+    }
+    return strRet;
+}
+
+/**-5-10Write one message to debug.log. Must hold mutexDebugLog.
+static int WriteLogEntry(const CLogEntry& entry)
+{
+    static bool fStartedNewLine = true;
+
+    /**-5-10reopen the log file, if requested
+    if (fReopenDebugLog) {
+        fReopenDebugLog = false;
+        boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
+        if (freopen(pathDebug.string().c_str(), "a", fileout) == NULL)
+            return 0;
+    }
+
+    if (fLogJSON) {
+        /**-5-10one object per message, without its trailing newline
+        std::string strMsg = entry.str;
+        if (!strMsg.empty() && strMsg[strMsg.size()-1] == '\n')
+            strMsg.erase(strMsg.size()-1);
+        return fprintf(fileout, "{\"time\":\"%s\",\"category\":\"%s\",\"message\":\"%s\"}\n",
+            DateTimeStrFormat("%Y-%m-%dT%H:%M:%SZ", entry.nTime).c_str(),
+            entry.category ? JSONEscape(entry.category).c_str() : "", JSONEscape(strMsg).c_str());
+    }
+
+    int ret = 0;
+    /**-5-10Debug print useful for profiling
+    if (fLogTimestamps && fStartedNewLine)
+        ret += fprintf(fileout, "%s ", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", entry.nTime).c_str());
+    if (!entry.str.empty() && entry.str[entry.str.size()-1] == '\n')
+        fStartedNewLine = true;
+    else
+        fStartedNewLine = false;
+
+    ret += fwrite(entry.str.data(), 1, entry.str.size(), fileout);
+    return ret;
+}
+
+/**-5-10Write out the queued messages, and then pentry if given. Must hold mutexDebugLog,
+/**-5-10so that messages taken from the queue are written before later ones.
+static int FlushLogQueue(const CLogEntry* pentry)
+{
+    std::vector<CLogEntry> vEntries;
+    {
+        boost::mutex::scoped_lock scoped_lock(*mutexLogQueue);
+        vEntries.swap(*pvLogQueue);
+    }
+    int ret = 0;
+    BOOST_FOREACH(const CLogEntry& entry, vEntries)
+        WriteLogEntry(entry);
+    if (pentry)
+        ret = WriteLogEntry(*pentry);
+    fflush(fileout);
+    return ret;
+}
+
+void ThreadLogWriter()
+{
+    RenameThread("ticoin-logwriter");
+    boost::call_once(&DebugPrintInit, debugPrintInitFlag);
+    if (fileout == NULL)
+        return;
+
+    {
+        boost::mutex::scoped_lock scoped_lock(*mutexLogQueue);
+        fLogWriterRunning = true;
+    }
+    try {
+        while (true) {
+            {
+                boost::mutex::scoped_lock scoped_lock(*mutexLogQueue);
+                while (pvLogQueue->empty())
+                    condLogQueue->wait(scoped_lock);
+            }
+            boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+            FlushLogQueue(NULL);
+        }
+    } catch (boost::thread_interrupted) {
+        /**-5-10From here on messages are written synchronously again
+        {
+            boost::mutex::scoped_lock scoped_lock(*mutexLogQueue);
+            fLogWriterRunning = false;
+        }
+        boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+        FlushLogQueue(NULL);
+        throw;
+    }
+}
+
+int LogPrintStr(const std::string &str, const char* category, bool fSync)
 {
     int ret = 0; /**-5-10Returns total number of characters written
     if (fPrintToConsole)
@@ -275,31 +466,33 @@ int LogPrintStr(const std::string &str)
     }
     else if (fPrintToDebugLog)
     {
-        static bool fStartedNewLine = true;
         boost::call_once(&DebugPrintInit, debugPrintInitFlag);
 
         if (fileout == NULL)
             return ret;
 
-        boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+        CLogEntry entry;
+        entry.nTime = GetTime();
+        entry.category = category;
+        entry.str = str;
+        if (category != NULL && nLogRateLimit > 0 && !LogRateLimit(category, entry.nTime, entry.str))
+            return ret;
 
-        /**-5-10reopen the log file, if requested
-        if (fReopenDebugLog) {
-            fReopenDebugLog = false;
-            boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
-            if (freopen(pathDebug.string().c_str(),"a",fileout) != NULL)
-                setbuf(fileout, NULL); /**-5-10unbuffered
+        if (!fSync) {
+            boost::mutex::scoped_lock scoped_lock(*mutexLogQueue);
+            if (fLogWriterRunning && pvLogQueue->size() < MAX_LOG_QUEUE) {
+                pvLogQueue->push_back(CLogEntry());
+                pvLogQueue->back().nTime = entry.nTime;
+                pvLogQueue->back().category = entry.category;
+                pvLogQueue->back().str.swap(entry.str);
+                if (pvLogQueue->size() == 1)
+                    condLogQueue->notify_one();
+                return str.size();
+            }
         }
 
-        /**-5-10Debug print useful for profiling
-        if (fLogTimestamps && fStartedNewLine)
-            ret += fprintf(fileout, "%s ", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime()).c_str());
-        if (!str.empty() && str[str.size()-1] == '\n')
-            fStartedNewLine = true;
-        else
-            fStartedNewLine = false;
-
-        ret = fwrite(str.data(), 1, str.size(), fileout);
+        boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+        ret = FlushLogQueue(&entry);
     }
 
     return ret;
@@ -927,13 +1120,13 @@ static std::string FormatException(std::exception* pex, const char* pszThread)
 void LogException(std::exception* pex, const char* pszThread)
 {
     std::string message = FormatException(pex, pszThread);
-    LogPrintf("\n%s", message);
+    LogPrintStr("\n" + message, NULL, true);
 }
 
 void PrintExceptionContinue(std::exception* pex, const char* pszThread)
 {
     std::string message = FormatException(pex, pszThread);
-    LogPrintf("\n\n************************\n%s\n", message);
+    LogPrintStr("\n\n************************\n" + message + "\n", NULL, true);
     fprintf(stderr, "\n\n************************\n%s\n", message.c_str());
     strMiscWarning = message;
 }
@@ -17,6 +17,7 @@
 #include <cstdio>
 #include <exception>
 #include <map>
+#include <set>
 #include <stdarg.h>
 #include <stdint.h>
 #include <string>
@@ -102,6 +103,8 @@ extern bool fServer;
 extern std::string strMiscWarning;
 extern bool fNoListen;
 extern bool fLogTimestamps;
+extern bool fLogJSON;
+extern int64_t nLogRateLimit;
 extern volatile bool fReopenDebugLog;
 
 void RandAddSeed();
@@ -110,8 +113,15 @@ void SetupEnvironment();
 
 /* Return true if log accepts specified category */
 bool LogAcceptCategory(const char* category);
-/* Send a string to the log output */
-int LogPrintStr(const std::string &str);
+/* Turn debug logging for a category on or off at runtime ("" is every category) */
+void EnableLogCategory(const std::string& category, bool fEnable);
+/* Categories debug logging is on for ("" is every category) */
+std::set<std::string> GetLogCategories();
+/* Send a string to the log output. Unless fSync, it may be queued for the log writer thread;
+ * otherwise it is in debug.log, after everything logged before it, when this returns. */
+int LogPrintStr(const std::string &str, const char* category = NULL, bool fSync = false);
+/* Write queued log messages to debug.log until interrupted (-logasync) */
+void ThreadLogWriter();
 
 #define strprintf tfm::format
 #define LogPrintf(...) LogPrint(NULL, __VA_ARGS__)
@@ -125,7 +135,7 @@ int LogPrintStr(const std::string &str);
     static inline int LogPrint(const char* category, const char* format, TINYFORMAT_VARARGS(n))  \
     {                                                                         \
         if(!LogAcceptCategory(category)) return 0;                            \
-        return LogPrintStr(tfm::format(format, TINYFORMAT_PASSARGS(n))); \
+        return LogPrintStr(tfm::format(format, TINYFORMAT_PASSARGS(n)), category); \
     }                                                                         \
     /*   Log error and return false */                                        \
     template<TINYFORMAT_ARGTYPES(n)>                                          \
@@ -143,7 +153,7 @@ TINYFORMAT_FOREACH_ARGNUM(MAKE_ERROR_AND_LOG_FUNC)
 static inline int LogPrint(const char* category, const char* format)
 {
     if(!LogAcceptCategory(category)) return 0;
-    return LogPrintStr(format);
+    return LogPrintStr(format, category);
 }
 static inline bool error(const char* format)
 {
@@ -9,8 +9,11 @@
 #include "checkpoints.h"
 #include "coincontrol.h"
 #include "net.h"
+#include "txview.h"
 
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 #include <openssl/rand.h>
 
 using namespace std;
@@ -19,6 +22,11 @@ using namespace std;
 int64_t nTransactionFee = DEFAULT_TRANSACTION_FEE;
 bool bSpendZeroConfChange = true;
 
+/**-5-10Number of key pool entries written per wallet transaction when filling the key pool
+static const unsigned int KEYPOOL_BATCH_SIZE = 1000;
+/**-5-10Don't spawn key generation threads for less than this many keys each
+static const unsigned int KEYPOOL_MIN_KEYS_PER_THREAD = 64;
+
 //////////////////////////////////////////////////////////////////////////////
 //
 /**-5-10mapWallet
@@ -45,17 +53,254 @@ const CWalletTx* CWallet::GetWalletTx(const uint256& hash) const
 CPubKey CWallet::GenerateNewKey()
 {
     AssertLockHeld(cs_wallet); /**-5-10mapKeyMetadata
+    if (IsHDEnabled())
+    {
+        CExtKey chainKey;
+        if (!GetHDChainKey(chainKey))
+            throw std::runtime_error("CWallet::GenerateNewKey() : HD seed not available");
+        CKey secret;
+        unsigned char ccChild[32];
+        while (!chainKey.key.Derive(secret, ccChild, hdChain.nExternalChainCounter | BIP32_HARDENED_KEY_LIMIT, chainKey.vchChainCode))
+            hdChain.nExternalChainCounter++;
+
+        CWalletBatch batch(this);
+        CPubKey pubkey = AddHDKey(secret.GetPubKey(), hdChain.nExternalChainCounter++);
+        if (!WriteHDChain() || !batch.Commit())
+            throw std::runtime_error("CWallet::GenerateNewKey() : writing HD chain failed");
+        return pubkey;
+    }
+
     bool fCompressed = CanSupportFeature(FEATURE_COMPRPUBKEY); /**-5-10default to compressed public keys if we want 0.6.0 wallets
 
     RandAddSeedPerfmon();
     CKey secret;
     secret.MakeNewKey(fCompressed);
 
+    return AddGeneratedKey(secret, secret.GetPubKey(), fCompressed);
+}
+
+CPubKey CWallet::AddHDKey(const CPubKey& pubkey, uint32_t nChild)
+{
+    AssertLockHeld(cs_wallet); /**-5-10mapKeyMetadata
+
+    int64_t nCreationTime = GetTime();
+    CKeyMetadata meta(nCreationTime);
+    mapKeyMetadata[pubkey.GetID()] = meta;
+    if (!nTimeFirstKey || nCreationTime < nTimeFirstKey)
+        nTimeFirstKey = nCreationTime;
+
+    LoadHDKey(pubkey, nChild);
+    if (fFileBacked)
+    {
+        /**-5-10Only the index is stored; the secret is derived from the seed when needed
+        bool fWritten = pwalletdbBatch ? pwalletdbBatch->WriteHDKey(pubkey, nChild, meta)
+                                       : CWalletDB(strWalletFile).WriteHDKey(pubkey, nChild, meta);
+        if (!fWritten)
+            throw std::runtime_error("CWallet::AddHDKey() : writing key failed");
+    }
+    return pubkey;
+}
+
+bool CWallet::WriteHDChain()
+{
+    AssertLockHeld(cs_wallet); /**-5-10hdChain
+    if (!fFileBacked)
+        return true;
+    if (pwalletdbBatch)
+        return pwalletdbBatch->WriteHDChain(hdChain);
+    return CWalletDB(strWalletFile).WriteHDChain(hdChain);
+}
+
+bool CWallet::GenerateHDMasterKey()
+{
+    AssertLockHeld(cs_wallet); /**-5-10hdChain
+    if (IsHDEnabled() || IsLocked())
+        return false;
+
+    RandAddSeedPerfmon();
+    CKey seed;
+    seed.MakeNewKey(true);
+
+    CWalletBatch batch(this);
+    SetMinVersion(FEATURE_HD, pwalletdbBatch);
+    /**-5-10The seed is kept as an ordinary key, so it is encrypted along with the others
+    CPubKey pubkey = AddGeneratedKey(seed, seed.GetPubKey(), true);
+    hdChain.SetNull();
+    hdChain.masterKeyID = pubkey.GetID();
+    if (!WriteHDChain() || !batch.Commit())
+    {
+        hdChain.SetNull();
+        return false;
+    }
+    return true;
+}
+
+/**-5-10Replace the HD seed with a new one, keeping the keys derived from the old seed as
+/**-5-10ordinary keys. Used when encrypting the wallet, since the old seed was stored
+/**-5-10unencrypted and may survive in the database file.
+bool CWallet::RenewHDSeed()
+{
+    AssertLockHeld(cs_wallet); /**-5-10hdChain
+    CExtKey chainKey;
+    if (!GetHDChainKey(chainKey))
+        return false;
+
+    CWalletBatch batch(this);
+    /**-5-10GetKey derives under cs_KeyStore, so it never sees a key missing from both maps
+    /**-5-10or derives one from the new seed
+    LOCK(cs_KeyStore);
+    BOOST_FOREACH(const HDKeyMap::value_type& item, mapHDKeys)
+    {
+        CKey secret;
+        unsigned char ccChild[32];
+        if (!chainKey.key.Derive(secret, ccChild, item.second.second | BIP32_HARDENED_KEY_LIMIT, chainKey.vchChainCode) ||
+            !AddKeyPubKey(secret, item.second.first))
+            return false;
+        if (fFileBacked && !pwalletdbBatch->EraseHDKey(item.second.first))
+            return false;
+    }
+    mapHDKeys.clear();
+
+    RandAddSeedPerfmon();
+    CKey seed;
+    seed.MakeNewKey(true);
+    CPubKey pubkey = AddGeneratedKey(seed, seed.GetPubKey(), true);
+    hdChain.SetNull();
+    hdChain.masterKeyID = pubkey.GetID();
+    return WriteHDChain() && batch.Commit();
+}
+
+/**-5-10The external chain key m/0'/0' of the HD seed; fails while the wallet is locked.
+/**-5-10masterKeyID only changes under cs_KeyStore (RenewHDSeed), so cs_wallet is not needed.
+bool CWallet::GetHDChainKey(CExtKey& chainKey) const
+{
+    CKey seed;
+    if (!CCryptoKeyStore::GetKey(hdChain.masterKeyID, seed))
+        return false;
+    CExtKey masterKey, accountKey;
+    masterKey.SetMaster(seed.begin(), seed.size());
+    return masterKey.Derive(accountKey, BIP32_HARDENED_KEY_LIMIT) &&
+           accountKey.Derive(chainKey, BIP32_HARDENED_KEY_LIMIT);
+}
+
+bool CWallet::LoadHDKey(const CPubKey &pubkey, uint32_t nChild)
+{
+    LOCK(cs_KeyStore);
+    mapHDKeys[pubkey.GetID()] = make_pair(pubkey, nChild);
+    return true;
+}
+
+bool CWallet::HaveKey(const CKeyID &address) const
+{
+    {
+        LOCK(cs_KeyStore);
+        if (mapHDKeys.count(address))
+            return true;
+    }
+    return CCryptoKeyStore::HaveKey(address);
+}
+
+bool CWallet::GetKey(const CKeyID &address, CKey& keyOut) const
+{
+    LOCK(cs_KeyStore);
+    HDKeyMap::const_iterator mi = mapHDKeys.find(address);
+    if (mi == mapHDKeys.end())
+        return CCryptoKeyStore::GetKey(address, keyOut);
+    uint32_t nChild = mi->second.second;
+    CExtKey chainKey;
+    unsigned char ccChild[32];
+    return GetHDChainKey(chainKey) &&
+           chainKey.key.Derive(keyOut, ccChild, nChild | BIP32_HARDENED_KEY_LIMIT, chainKey.vchChainCode);
+}
+
+bool CWallet::GetPubKey(const CKeyID &address, CPubKey& vchPubKeyOut) const
+{
+    {
+        LOCK(cs_KeyStore);
+        HDKeyMap::const_iterator mi = mapHDKeys.find(address);
+        if (mi != mapHDKeys.end())
+        {
+            vchPubKeyOut = mi->second.first;
+            return true;
+        }
+    }
+    return CCryptoKeyStore::GetPubKey(address, vchPubKeyOut);
+}
+
+void CWallet::GetKeys(std::set<CKeyID> &setAddress) const
+{
+    CCryptoKeyStore::GetKeys(setAddress);
+    LOCK(cs_KeyStore);
+    BOOST_FOREACH(const HDKeyMap::value_type& item, mapHDKeys)
+        setAddress.insert(item.first);
+}
+
+/**-5-10A restored backup of an HD wallet can still have keys in its pool that were handed
+/**-5-10out after the backup was made; a payment to one of them is the first sign of that.
+/**-5-10The pool keys up to the paid one are taken out of the pool, so they are not handed
+/**-5-10out again, and the pool is topped up past it (once unlocked). This way a rescan also
+/**-5-10finds payments to keys derived after the backup, as long as no more than -keypool
+/**-5-10of them in a row went unused.
+void CWallet::MarkHDKeysUsed(const CTransaction& tx)
+{
+    AssertLockHeld(cs_wallet); /**-5-10setKeyPool
+    if (!fFileBacked || !IsHDEnabled() || setKeyPool.empty())
+        return;
+
+    bool fPaid = false;
+    uint32_t nChildPaid = 0;
+    {
+        LOCK(cs_KeyStore);
+        BOOST_FOREACH(const CTxOut& txout, tx.vout)
+        {
+            CTxDestination address;
+            if (!ExtractDestination(txout.scriptPubKey, address))
+                continue;
+            const CKeyID *keyID = boost::get<CKeyID>(&address);
+            HDKeyMap::const_iterator mi = keyID ? mapHDKeys.find(*keyID) : mapHDKeys.end();
+            if (mi != mapHDKeys.end() && (!fPaid || mi->second.second > nChildPaid))
+            {
+                fPaid = true;
+                nChildPaid = mi->second.second;
+            }
+        }
+    }
+    if (!fPaid)
+        return;
+
+    /**-5-10HD keys enter the pool in child order, and the oldest is handed out first
+    CWalletDB walletdb(strWalletFile);
+    bool fRemoved = false;
+    while (!setKeyPool.empty())
+    {
+        int64_t nIndex = *setKeyPool.begin();
+        CKeyPool keypool;
+        if (!walletdb.ReadPool(nIndex, keypool))
+            break;
+        {
+            LOCK(cs_KeyStore);
+            HDKeyMap::const_iterator mi = mapHDKeys.find(keypool.vchPubKey.GetID());
+            if (mi == mapHDKeys.end() || mi->second.second > nChildPaid)
+                break;
+        }
+        setKeyPool.erase(setKeyPool.begin());
+        KeepKey(nIndex);
+        fRemoved = true;
+    }
+    if (fRemoved)
+    {
+        LogPrintf("keypool: HD key %u was used elsewhere, keys up to it left the pool\n", nChildPaid);
+        TopUpKeyPool();
+    }
+}
+
+CPubKey CWallet::AddGeneratedKey(const CKey& secret, const CPubKey& pubkey, bool fCompressed)
+{
+    AssertLockHeld(cs_wallet); /**-5-10mapKeyMetadata
+
     /**-5-10Compressed public keys were introduced in version 0.6.0
     if (fCompressed)
-        SetMinVersion(FEATURE_COMPRPUBKEY);
-
-    CPubKey pubkey = secret.GetPubKey();
+        SetMinVersion(FEATURE_COMPRPUBKEY, pwalletdbBatch);
 
     /**-5-10Create new metadata
     int64_t nCreationTime = GetTime();
@@ -76,6 +321,10 @@ bool CWallet::AddKeyPubKey(const CKey& secret, const CPubKey &pubkey)
     if (!fFileBacked)
         return true;
     if (!IsCrypted()) {
+        if (pwalletdbBatch)
+            return pwalletdbBatch->WriteKey(pubkey,
+                                            secret.GetPrivKey(),
+                                            mapKeyMetadata[pubkey.GetID()]);
         return CWalletDB(strWalletFile).WriteKey(pubkey,
                                                  secret.GetPrivKey(),
                                                  mapKeyMetadata[pubkey.GetID()]);
@@ -96,6 +345,10 @@ bool CWallet::AddCryptedKey(const CPubKey &vchPubKey,
             return pwalletdbEncryption->WriteCryptedKey(vchPubKey,
                                                         vchCryptedSecret,
                                                         mapKeyMetadata[vchPubKey.GetID()]);
+        else if (pwalletdbBatch)
+            return pwalletdbBatch->WriteCryptedKey(vchPubKey,
+                                                   vchCryptedSecret,
+                                                   mapKeyMetadata[vchPubKey.GetID()]);
         else
             return CWalletDB(strWalletFile).WriteCryptedKey(vchPubKey,
                                                             vchCryptedSecret,
@@ -353,6 +606,23 @@ void CWallet::AddToSpends(const uint256& wtxid)
         AddToSpends(txin.prevout, wtxid);
 }
 
+void CWallet::RemoveFromSpends(const uint256& wtxid)
+{
+    assert(mapWallet.count(wtxid));
+    BOOST_FOREACH(const CTxIn& txin, mapWallet[wtxid].vin)
+    {
+        pair<TxSpends::iterator, TxSpends::iterator> range;
+        range = mapTxSpends.equal_range(txin.prevout);
+        for (TxSpends::iterator it = range.first; it != range.second; )
+        {
+            if (it->second == wtxid)
+                mapTxSpends.erase(it++);
+            else
+                ++it;
+        }
+    }
+}
+
 bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 {
     if (IsCrypted())
@@ -421,6 +691,9 @@ bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 
         Lock();
         Unlock(strWalletPassphrase);
+        /**-5-10The HD seed was stored unencrypted, so new keys must not come from it
+        if (IsHDEnabled() && !RenewHDSeed())
+            exit(1); //The wallet on disk is encrypted but still uses the old seed...die and let the user encrypt it again.
         NewKeyPool();
         Lock();
 
@@ -438,6 +711,8 @@ int64_t CWallet::IncOrderPosNext(CWalletDB *pwalletdb)
 {
     AssertLockHeld(cs_wallet); /**-5-10nOrderPosNext
     int64_t nRet = nOrderPosNext++;
+    if (!pwalletdb)
+        pwalletdb = pwalletdbBatch;
     if (pwalletdb) {
         pwalletdb->WriteOrderPosNext(nOrderPosNext);
     } else {
@@ -480,7 +755,7 @@ void CWallet::MarkDirty()
     }
 }
 
-bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet)
+bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet, bool fNotify)
 {
     uint256 hash = wtxIn.GetHash();
 
@@ -584,20 +859,25 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet)
         /**-5-10Break debit/credit balance caches:
         wtx.MarkDirty();
 
-        /**-5-10Notify UI of new or updated transaction
-        NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
+        if (fNotify)
+            NotifyWalletTransaction(hash, fInsertedNew ? CT_NEW : CT_UPDATED);
+    }
+    return true;
+}
 
-        /**-5-10notify an external script when a wallet transaction comes in or is updated
-        std::string strCmd = GetArg("-walletnotify", "");
+void CWallet::NotifyWalletTransaction(const uint256& hash, ChangeType status)
+{
+    /**-5-10Notify UI of new or updated transaction
+    NotifyTransactionChanged(this, hash, status);
 
-        if ( !strCmd.empty())
-        {
-            boost::replace_all(strCmd, "%s", wtxIn.GetHash().GetHex());
-            boost::thread t(runCommand, strCmd); /**-5-10thread runs free
-        }
+    /**-5-10notify an external script when a wallet transaction comes in or is updated
+    std::string strCmd = GetArg("-walletnotify", "");
 
+    if ( !strCmd.empty())
+    {
+        boost::replace_all(strCmd, "%s", hash.GetHex());
+        boost::thread t(runCommand, strCmd); /**-5-10thread runs free
     }
-    return true;
 }
 
 /**-5-10Add a transaction to the wallet, or update it.
@@ -611,6 +891,8 @@ bool CWallet::AddToWalletIfInvolvingMe(const uint256 &hash, const CTransaction&
         if (fExisted && !fUpdate) return false;
         if (fExisted || IsMine(tx) || IsFromMe(tx))
         {
+            if (!fExisted)
+                MarkHDKeysUsed(tx);
             CWalletTx wtx(this,tx);
             /**-5-10Get merkle branch if transaction was found in a block
             if (pblock)
@@ -621,6 +903,21 @@ bool CWallet::AddToWalletIfInvolvingMe(const uint256 &hash, const CTransaction&
     return false;
 }
 
+bool CWallet::MayBeInvolvingMe(const uint256 &hash, const CTransactionView& tx) const
+{
+    AssertLockHeld(cs_wallet);
+    if (mapWallet.count(hash))
+        return true;
+    /**-5-10IsFromMe() needs the spent output to be one of our transactions
+    BOOST_FOREACH(const CTxInView& txin, tx.vin)
+        if (mapWallet.count(txin.prevout.hash))
+            return true;
+    BOOST_FOREACH(const CTxOutView& txout, tx.vout)
+        if (::IsMine(*this, txout.scriptPubKey.ToScript()))
+            return true;
+    return false;
+}
+
 void CWallet::SyncTransaction(const uint256 &hash, const CTransaction& tx, const CBlock* pblock)
 {
     LOCK2(cs_main, cs_wallet);
@@ -838,6 +1135,10 @@ void CWalletTx::GetAccountAmounts(const string& strAccount, int64_t& nReceived,
 
 bool CWalletTx::WriteToDisk()
 {
+    LOCK(pwallet->cs_wallet);
+    CWalletDB* pwalletdb = pwallet->GetActiveBatch();
+    if (pwalletdb)
+        return pwalletdb->WriteTx(GetHash(), *this);
     return CWalletDB(pwallet->strWalletFile).WriteTx(GetHash(), *this);
 }
 
@@ -866,12 +1167,25 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
             if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
                 ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
 
-            CBlock block;
-            ReadBlockFromDisk(block, pindex);
-            BOOST_FOREACH(CTransaction& tx, block.vtx)
+            /**-5-10Scan a view of the block; it is only deserialized if one of its transactions may concern us
+            std::vector<unsigned char> vchBlock;
+            CBlockView view;
+            if (ReadRawBlockFromDisk(vchBlock, pindex) && view.Parse(&vchBlock[0], &vchBlock[0] + vchBlock.size()))
             {
-                if (AddToWalletIfInvolvingMe(tx.GetHash(), tx, &block, fUpdate))
-                    ret++;
+                CBlock block;
+                bool fHaveBlock = false;
+                for (unsigned int i = 0; i < view.vtx.size(); i++)
+                {
+                    uint256 hash = view.vtx[i].GetHash();
+                    if (!MayBeInvolvingMe(hash, view.vtx[i]))
+                        continue;
+                    if (!fHaveBlock) {
+                        block = view.ToBlock();
+                        fHaveBlock = true;
+                    }
+                    if (AddToWalletIfInvolvingMe(hash, block.vtx[i], &block, fUpdate))
+                        ret++;
+                }
             }
             pindex = chainActive.Next(pindex);
             if (GetTime() >= nNow + 60) {
@@ -1408,17 +1722,47 @@ bool CWallet::CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey)
         LOCK2(cs_main, cs_wallet);
         LogPrintf("CommitTransaction:\n%s", wtxNew.ToString());
         {
-            /**-5-10This is only to keep the database open to defeat the auto-flush for the
-            /**-5-10duration of this scope.  This is the only place where this optimization
-            /**-5-10maybe makes sense; please don't do it anywhere else.
-            CWalletDB* pwalletdb = fFileBacked ? new CWalletDB(strWalletFile,"r") : NULL;
+            /**-5-10Write the spent key pool entry and the new transaction record in a
+            /**-5-10single wallet transaction. This also keeps the database open to defeat
+            /**-5-10the auto-flush for the duration of this scope.
+            CWalletBatch batch(this);
 
-            /**-5-10Take key pair from key pool so it won't be used again
-            reservekey.KeepKey();
+            /**-5-10Take key pair from key pool so it won't be used again. The pool entry is
+            /**-5-10erased in this batch; the key stays reserved until the batch commits.
+            if (reservekey.nIndex != -1)
+                KeepKey(reservekey.nIndex);
 
             /**-5-10Add tx to wallet, because if it has change it's also ours,
             /**-5-10otherwise just for transaction history.
-            AddToWallet(wtxNew);
+            /**-5-10Notifications wait until the batch has committed.
+            uint256 hash = wtxNew.GetHash();
+            bool fNew = !mapWallet.count(hash);
+            CWalletTx wtxOld;
+            if (!fNew)
+                wtxOld = mapWallet[hash];
+            int64_t nOrderPosNextOld = nOrderPosNext;
+            if (!AddToWallet(wtxNew, false, false) || !batch.Commit())
+            {
+                /**-5-10Nothing was written, so undo the in-memory changes rather than broadcast
+                /**-5-10a payment the wallet would no longer know about after a restart.
+                LogPrintf("CommitTransaction() : Error: writing wallet transaction failed\n");
+                if (fNew)
+                {
+                    RemoveFromSpends(hash);
+                    mapWallet.erase(hash);
+                }
+                else
+                {
+                    mapWallet[hash] = wtxOld;
+                    mapWallet[hash].MarkDirty();
+                }
+                nOrderPosNext = nOrderPosNextOld;
+                reservekey.ReturnKey();
+                return false;
+            }
+            reservekey.nIndex = -1;
+            reservekey.vchPubKey = CPubKey();
+            NotifyWalletTransaction(hash, fNew ? CT_NEW : CT_UPDATED);
 
             /**-5-10Notify that old coins are spent
             set<CWalletTx*> setCoins;
@@ -1428,9 +1772,6 @@ bool CWallet::CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey)
                 coin.BindWallet(this);
                 NotifyTransactionChanged(this, coin.GetHash(), CT_UPDATED);
             }
-
-            if (fFileBacked)
-                delete pwalletdb;
         }
 
         /**-5-10Track how many getdata requests our transaction gets
@@ -1613,21 +1954,21 @@ bool CWallet::NewKeyPool()
 {
     {
         LOCK(cs_wallet);
-        CWalletDB walletdb(strWalletFile);
-        BOOST_FOREACH(int64_t nIndex, setKeyPool)
-            walletdb.ErasePool(nIndex);
+        {
+            CWalletBatch batch(this);
+            BOOST_FOREACH(int64_t nIndex, setKeyPool)
+                if (pwalletdbBatch)
+                    pwalletdbBatch->ErasePool(nIndex);
+            if (!batch.Commit())
+                return false;
+        }
         setKeyPool.clear();
 
         if (IsLocked())
             return false;
 
         int64_t nKeys = max(GetArg("-keypool", 100), (int64_t)0);
-        for (int i = 0; i < nKeys; i++)
-        {
-            int64_t nIndex = i+1;
-            walletdb.WritePool(nIndex, CKeyPool(GenerateNewKey()));
-            setKeyPool.insert(nIndex);
-        }
+        FillKeyPool(nKeys);
         LogPrintf("CWallet::NewKeyPool wrote %d new keys\n", nKeys);
     }
     return true;
@@ -1641,8 +1982,6 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
         if (IsLocked())
             return false;
 
-        CWalletDB walletdb(strWalletFile);
-
         /**-5-10Top up key pool
         unsigned int nTargetSize;
         if (kpSize > 0)
@@ -1650,16 +1989,103 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
         else
             nTargetSize = max(GetArg("-keypool", 100), (int64_t) 0);
 
-        while (setKeyPool.size() < (nTargetSize + 1))
+        if (setKeyPool.size() < (nTargetSize + 1))
+            FillKeyPool(nTargetSize + 1 - setKeyPool.size());
+    }
+    return true;
+}
+
+/**-5-10Derive keys [nBegin, nEnd) of vKeys together with their public keys. With pchainKey,
+/**-5-10key i is its hardened child nFirstChild + i, and left invalid if that child is unusable.
+static void GenerateKeyRange(std::vector<CKey>* pvKeys, std::vector<CPubKey>* pvPubKeys, size_t nBegin, size_t nEnd, bool fCompressed,
+                             const CExtKey* pchainKey, uint32_t nFirstChild)
+{
+    unsigned char ccChild[32];
+    for (size_t i = nBegin; i < nEnd; i++)
+    {
+        if (pchainKey)
         {
-            int64_t nEnd = 1;
-            if (!setKeyPool.empty())
-                nEnd = *(--setKeyPool.end()) + 1;
-            if (!walletdb.WritePool(nEnd, CKeyPool(GenerateNewKey())))
-                throw runtime_error("TopUpKeyPool() : writing generated key failed");
-            setKeyPool.insert(nEnd);
-            LogPrintf("keypool added key %d, size=%u\n", nEnd, setKeyPool.size());
+            if (!pchainKey->key.Derive((*pvKeys)[i], ccChild, (nFirstChild + i) | BIP32_HARDENED_KEY_LIMIT, pchainKey->vchChainCode))
+                continue;
         }
+        else
+            (*pvKeys)[i].MakeNewKey(fCompressed);
+        (*pvPubKeys)[i] = (*pvKeys)[i].GetPubKey();
+    }
+}
+
+/**-5-10Fill vKeys and vPubKeys with fresh key pairs, spreading the EC work over all cores.
+/**-5-10Keys are random, or children nFirstChild, nFirstChild + 1, ... of pchainKey if given.
+static void GenerateKeys(std::vector<CKey>& vKeys, std::vector<CPubKey>& vPubKeys, bool fCompressed,
+                         const CExtKey* pchainKey = NULL, uint32_t nFirstChild = 0)
+{
+    size_t nKeys = vKeys.size();
+    size_t nThreads = 1;
+    if (nKeys >= KEYPOOL_MIN_KEYS_PER_THREAD * 2)
+        nThreads = std::max(1u, std::min(boost::thread::hardware_concurrency(), (unsigned int)(nKeys / KEYPOOL_MIN_KEYS_PER_THREAD)));
+    size_t nPerThread = (nKeys + nThreads - 1) / nThreads;
+
+    boost::thread_group threadGroup;
+    for (size_t nBegin = nPerThread; nBegin < nKeys; nBegin += nPerThread)
+        threadGroup.create_thread(boost::bind(&GenerateKeyRange, &vKeys, &vPubKeys, nBegin, std::min(nBegin + nPerThread, nKeys), fCompressed, pchainKey, nFirstChild));
+    GenerateKeyRange(&vKeys, &vPubKeys, 0, std::min(nPerThread, nKeys), fCompressed, pchainKey, nFirstChild);
+    threadGroup.join_all();
+}
+
+/**-5-10Append nKeys freshly generated keys to the key pool. Keys are derived in parallel
+/**-5-10and written in chunks of KEYPOOL_BATCH_SIZE, each chunk in one wallet transaction.
+/**-5-10An HD wallet writes only the public key and child index of each key, and the
+/**-5-10chain's next index once per chunk.
+bool CWallet::FillKeyPool(unsigned int nKeys)
+{
+    AssertLockHeld(cs_wallet); /**-5-10setKeyPool
+    bool fCompressed = CanSupportFeature(FEATURE_COMPRPUBKEY); /**-5-10default to compressed public keys if we want 0.6.0 wallets
+    bool fHD = IsHDEnabled();
+
+    CExtKey chainKey;
+    if (fHD && !GetHDChainKey(chainKey))
+        throw runtime_error("TopUpKeyPool() : HD seed not available");
+
+    RandAddSeedPerfmon();
+    while (nKeys > 0)
+    {
+        unsigned int nChunk = std::min(nKeys, KEYPOOL_BATCH_SIZE);
+        std::vector<CKey> vKeys(nChunk);
+        std::vector<CPubKey> vPubKeys(nChunk);
+        GenerateKeys(vKeys, vPubKeys, fCompressed, fHD ? &chainKey : NULL, hdChain.nExternalChainCounter);
+
+        int64_t nEnd = 1;
+        if (!setKeyPool.empty())
+            nEnd = *(--setKeyPool.end()) + 1;
+
+        int64_t nIndex = nEnd;
+        {
+            CWalletBatch batch(this);
+            for (unsigned int i = 0; i < nChunk; i++)
+            {
+                /**-5-10An HD child that is not a valid key is skipped
+                if (!vPubKeys[i].IsValid())
+                    continue;
+                CPubKey pubkey = fHD ? AddHDKey(vPubKeys[i], hdChain.nExternalChainCounter + i)
+                                     : AddGeneratedKey(vKeys[i], vPubKeys[i], fCompressed);
+                if (pwalletdbBatch && !pwalletdbBatch->WritePool(nIndex, CKeyPool(pubkey)))
+                    throw runtime_error("TopUpKeyPool() : writing generated key failed");
+                nIndex++;
+            }
+            if (fHD)
+            {
+                hdChain.nExternalChainCounter += nChunk;
+                if (!WriteHDChain())
+                    throw runtime_error("TopUpKeyPool() : writing HD chain failed");
+            }
+            if (!batch.Commit())
+                throw runtime_error("TopUpKeyPool() : committing generated keys failed");
+        }
+
+        for (int64_t i = nEnd; i < nIndex; i++)
+            setKeyPool.insert(i);
+        nKeys -= nChunk;
+        LogPrintf("keypool added keys %d..%d, size=%u\n", nEnd, nIndex - 1, setKeyPool.size());
     }
     return true;
 }
@@ -1711,8 +2137,14 @@ void CWallet::KeepKey(int64_t nIndex)
     /**-5-10Remove from key pool
     if (fFileBacked)
     {
-        CWalletDB walletdb(strWalletFile);
-        walletdb.ErasePool(nIndex);
+        LOCK(cs_wallet);
+        if (pwalletdbBatch)
+            pwalletdbBatch->ErasePool(nIndex);
+        else
+        {
+            CWalletDB walletdb(strWalletFile);
+            walletdb.ErasePool(nIndex);
+        }
     }
     LogPrintf("keypool keep %d\n", nIndex);
 }
@@ -1941,6 +2373,43 @@ void CReserveKey::ReturnKey()
     vchPubKey = CPubKey();
 }
 
+CWalletBatch::CWalletBatch(CWallet* pwalletIn) : pwallet(pwalletIn), pwalletdb(NULL)
+{
+    AssertLockHeld(pwallet->cs_wallet); /**-5-10pwalletdbBatch
+    if (!pwallet->fFileBacked || pwallet->pwalletdbBatch)
+        return;
+
+    pwalletdb = new CWalletDB(pwallet->strWalletFile);
+    if (!pwalletdb->TxnBegin())
+    {
+        delete pwalletdb;
+        pwalletdb = NULL;
+        throw runtime_error("CWalletBatch() : unable to begin wallet transaction");
+    }
+    pwallet->pwalletdbBatch = pwalletdb;
+}
+
+CWalletBatch::~CWalletBatch()
+{
+    if (pwalletdb)
+    {
+        pwalletdb->TxnAbort();
+        pwallet->pwalletdbBatch = NULL;
+        delete pwalletdb;
+    }
+}
+
+bool CWalletBatch::Commit()
+{
+    if (!pwalletdb)
+        return true;
+    bool fRet = pwalletdb->TxnCommit();
+    pwallet->pwalletdbBatch = NULL;
+    delete pwalletdb;
+    pwalletdb = NULL;
+    return fRet;
+}
+
 void CWallet::GetAllReserveKeys(set<CKeyID>& setAddress) const
 {
     setAddress.clear();
@@ -2037,7 +2506,7 @@ void CWallet::GetKeyBirthTimes(std::map<CKeyID, int64_t> &mapKeyBirth) const {
     for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); it++) {
         /**-5-10iterate over all wallet transactions...
         const CWalletTx &wtx = (*it).second;
-        std::map<uint256, CBlockIndex*>::const_iterator blit = mapBlockIndex.find(wtx.hashBlock);
+        BlockMap::const_iterator blit = mapBlockIndex.find(wtx.hashBlock);
         if (blit != mapBlockIndex.end() && chainActive.Contains(blit->second)) {
             /**-5-10... which are already in a block
             int nHeight = blit->second->nHeight;
@@ -37,6 +37,7 @@ class CCoinControl;
 class COutput;
 class CReserveKey;
 class CScript;
+class CTransactionView;
 class CWalletTx;
 
 /** (client) version numbers for particular wallet features */
@@ -46,6 +47,7 @@ enum WalletFeature
 
     FEATURE_WALLETCRYPT = 40000, /**-5-10wallet encryption
     FEATURE_COMPRPUBKEY = 60000, /**-5-10compressed public keys
+    FEATURE_HD = 90600, /**-5-10hierarchical deterministic key chain (-usehd)
 
     FEATURE_LATEST = 60000
 };
@@ -104,6 +106,26 @@ private:
 
     CWalletDB *pwalletdbEncryption;
 
+    /**-5-10Database handle of the CWalletBatch currently open on this wallet, if any.
+    /**-5-10While set, all writes made through the wallet go into its transaction.
+    CWalletDB *pwalletdbBatch;
+    friend class CWalletBatch;
+
+    CPubKey AddGeneratedKey(const CKey& secret, const CPubKey& pubkey, bool fCompressed);
+    CPubKey AddHDKey(const CPubKey& pubkey, uint32_t nChild);
+    bool RenewHDSeed();
+    bool GetHDChainKey(CExtKey& chainKey) const;
+    bool WriteHDChain();
+    bool FillKeyPool(unsigned int nKeys);
+    void MarkHDKeysUsed(const CTransaction& tx);
+
+    /**-5-10HD key chain, unset (null masterKeyID) unless the wallet was created with -usehd
+    CHDChain hdChain;
+    /**-5-10Keys derived from the HD seed, with their child index; their secrets are
+    /**-5-10derived again when needed. Protected by cs_KeyStore.
+    typedef std::map<CKeyID, std::pair<CPubKey, uint32_t> > HDKeyMap;
+    HDKeyMap mapHDKeys;
+
     /**-5-10the current wallet version: clients below this version are not able to load the wallet
     int nWalletVersion;
 
@@ -120,6 +142,8 @@ private:
     TxSpends mapTxSpends;
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
+    void RemoveFromSpends(const uint256& wtxid);
+    void NotifyWalletTransaction(const uint256& hash, ChangeType status);
 
     void SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator>);
 
@@ -159,6 +183,7 @@ public:
         fFileBacked = false;
         nMasterKeyMaxID = 0;
         pwalletdbEncryption = NULL;
+        pwalletdbBatch = NULL;
         nOrderPosNext = 0;
         nNextResend = 0;
         nLastResend = 0;
@@ -197,6 +222,8 @@ public:
     /**-5-10keystore implementation
     /**-5-10Generate a new key
     CPubKey GenerateNewKey();
+    /**-5-10Returns the database handle of the open CWalletBatch, or NULL if writes auto-commit
+    CWalletDB* GetActiveBatch() const { AssertLockHeld(cs_wallet); return pwalletdbBatch; }
     /**-5-10Adds a key to the store, and saves it to disk.
     bool AddKeyPubKey(const CKey& key, const CPubKey &pubkey);
     /**-5-10Adds a key to the store, without saving it to disk (used by LoadWallet)
@@ -204,6 +231,21 @@ public:
     /**-5-10Load metadata (used by LoadWallet)
     bool LoadKeyMetadata(const CPubKey &pubkey, const CKeyMetadata &metadata);
 
+    /**-5-10Whether keys are derived from an HD seed rather than drawn at random
+    bool IsHDEnabled() const { AssertLockHeld(cs_wallet); return hdChain.masterKeyID != 0; }
+    const CHDChain& GetHDChain() const { AssertLockHeld(cs_wallet); return hdChain; }
+    /**-5-10Create the HD seed of a new wallet; the key pool is derived from it from then on
+    bool GenerateHDMasterKey();
+    /**-5-10Load the HD chain state and derived keys (used by LoadWallet)
+    bool LoadHDChain(const CHDChain &chain) { AssertLockHeld(cs_wallet); hdChain = chain; return true; }
+    bool LoadHDKey(const CPubKey &pubkey, uint32_t nChild);
+
+    /**-5-10Keys derived from the HD seed are part of the store as well
+    bool HaveKey(const CKeyID &address) const;
+    bool GetKey(const CKeyID &address, CKey& keyOut) const;
+    bool GetPubKey(const CKeyID &address, CPubKey& vchPubKeyOut) const;
+    void GetKeys(std::set<CKeyID> &setAddress) const;
+
     bool LoadMinVersion(int nVersion) { AssertLockHeld(cs_wallet); nWalletVersion = nVersion; nWalletMaxVersion = std::max(nWalletMaxVersion, nVersion); return true; }
 
     /**-5-10Adds an encrypted key to the store, and saves it to disk.
@@ -243,9 +285,11 @@ public:
     TxItems OrderedTxItems(std::list<CAccountingEntry>& acentries, std::string strAccount = "");
 
     void MarkDirty();
-    bool AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet=false);
+    bool AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet=false, bool fNotify=true);
     void SyncTransaction(const uint256 &hash, const CTransaction& tx, const CBlock* pblock);
     bool AddToWalletIfInvolvingMe(const uint256 &hash, const CTransaction& tx, const CBlock* pblock, bool fUpdate);
+    /**-5-10Cheap check on a view that is true whenever AddToWalletIfInvolvingMe could add the transaction
+    bool MayBeInvolvingMe(const uint256 &hash, const CTransactionView& tx) const;
     void EraseFromWallet(const uint256 &hash);
     int ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate = false);
     void ReacceptWalletTransactions();
@@ -401,6 +445,7 @@ public:
 /** A key allocated from the key pool. */
 class CReserveKey
 {
+    friend class CWallet;
 protected:
     CWallet* pwallet;
     int64_t nIndex;
@@ -422,6 +467,26 @@ public:
     void KeepKey();
 };
 
+/** Groups all wallet.dat writes made through a CWallet into a single Berkeley DB
+ * transaction, instead of one auto-committed transaction per record.
+ * Must be used while holding cs_wallet. Nested batches join the outermost one,
+ * and a batch that goes out of scope without Commit() is aborted.
+ */
+class CWalletBatch
+{
+private:
+    CWallet* pwallet;
+    CWalletDB* pwalletdb;
+
+    CWalletBatch(const CWalletBatch&);
+    void operator=(const CWalletBatch&);
+public:
+    CWalletBatch(CWallet* pwalletIn);
+    ~CWalletBatch();
+
+    bool Commit();
+};
+
 
 typedef std::map<std::string, std::string> mapValue_t;
 
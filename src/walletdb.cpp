@@ -106,6 +106,24 @@ bool CWalletDB::WriteMasterKey(unsigned int nID, const CMasterKey& kMasterKey)
     return Write(std::make_pair(std::string("mkey"), nID), kMasterKey, true);
 }
 
+bool CWalletDB::WriteHDKey(const CPubKey& vchPubKey, uint32_t nChild, const CKeyMetadata& keyMeta)
+{
+    nWalletDBUpdated++;
+    return Write(std::make_pair(std::string("hdkey"), vchPubKey), std::make_pair(nChild, keyMeta), false);
+}
+
+bool CWalletDB::EraseHDKey(const CPubKey& vchPubKey)
+{
+    nWalletDBUpdated++;
+    return Erase(std::make_pair(std::string("hdkey"), vchPubKey));
+}
+
+bool CWalletDB::WriteHDChain(const CHDChain& chain)
+{
+    nWalletDBUpdated++;
+    return Write(std::string("hdchain"), chain);
+}
+
 bool CWalletDB::WriteCScript(const uint160& hash, const CScript& redeemScript)
 {
     nWalletDBUpdated++;
@@ -311,13 +329,14 @@ public:
     unsigned int nKeys;
     unsigned int nCKeys;
     unsigned int nKeyMeta;
+    unsigned int nHDKeys;
     bool fIsEncrypted;
     bool fAnyUnordered;
     int nFileVersion;
     vector<uint256> vWalletUpgrade;
 
     CWalletScanState() {
-        nKeys = nCKeys = nKeyMeta = 0;
+        nKeys = nCKeys = nKeyMeta = nHDKeys = 0;
         fIsEncrypted = false;
         fAnyUnordered = false;
         nFileVersion = 0;
@@ -513,6 +532,28 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
                 (keyMeta.nCreateTime < pwallet->nTimeFirstKey))
                 pwallet->nTimeFirstKey = keyMeta.nCreateTime;
         }
+        else if (strType == "hdkey")
+        {
+            CPubKey vchPubKey;
+            ssKey >> vchPubKey;
+            uint32_t nChild;
+            CKeyMetadata keyMeta;
+            ssValue >> nChild >> keyMeta;
+            wss.nHDKeys++;
+
+            if (!pwallet->LoadHDKey(vchPubKey, nChild))
+            {
+                strErr = "Error reading wallet database: LoadHDKey failed";
+                return false;
+            }
+            pwallet->LoadKeyMetadata(vchPubKey, keyMeta);
+        }
+        else if (strType == "hdchain")
+        {
+            CHDChain chain;
+            ssValue >> chain;
+            pwallet->LoadHDChain(chain);
+        }
         else if (strType == "defaultkey")
         {
             ssValue >> pwallet->vchDefaultKey;
@@ -576,7 +617,8 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
 static bool IsKeyType(string strType)
 {
     return (strType== "key" || strType == "wkey" ||
-            strType == "mkey" || strType == "ckey");
+            strType == "mkey" || strType == "ckey" ||
+            strType == "hdkey" || strType == "hdchain");
 }
 
 DBErrors CWalletDB::LoadWallet(CWallet* pwallet)
@@ -657,8 +699,8 @@ DBErrors CWalletDB::LoadWallet(CWallet* pwallet)
 
     LogPrintf("nFileVersion = %d\n", wss.nFileVersion);
 
-    LogPrintf("Keys: %u plaintext, %u encrypted, %u w/ metadata, %u total\n",
-           wss.nKeys, wss.nCKeys, wss.nKeyMeta, wss.nKeys + wss.nCKeys);
+    LogPrintf("Keys: %u plaintext, %u encrypted, %u derived, %u w/ metadata, %u total\n",
+           wss.nKeys, wss.nCKeys, wss.nHDKeys, wss.nKeyMeta + wss.nHDKeys, wss.nKeys + wss.nCKeys + wss.nHDKeys);
 
     /**-5-10nTimeFirstKey is only reliable if all keys have metadata
     if ((wss.nKeys + wss.nCKeys) != wss.nKeyMeta)
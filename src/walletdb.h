@@ -67,6 +67,39 @@ public:
     }
 };
 
+/** State of the HD key chain (-usehd). The seed is the secret of masterKeyID,
+ * stored and encrypted like any other key; pool keys are derived from it at
+ * m/0'/0'/i' and only their public key and i are written to the wallet.
+ */
+class CHDChain
+{
+public:
+    static const int CURRENT_VERSION=1;
+    int nVersion;
+    uint32_t nExternalChainCounter; /**-5-10next child index to derive
+    CKeyID masterKeyID;
+
+    CHDChain()
+    {
+        SetNull();
+    }
+
+    IMPLEMENT_SERIALIZE
+    (
+        READWRITE(this->nVersion);
+        nVersion = this->nVersion;
+        READWRITE(nExternalChainCounter);
+        READWRITE(masterKeyID);
+    )
+
+    void SetNull()
+    {
+        nVersion = CHDChain::CURRENT_VERSION;
+        nExternalChainCounter = 0;
+        masterKeyID = CKeyID();
+    }
+};
+
 /** Access to the wallet database (wallet.dat) */
 class CWalletDB : public CDB
 {
@@ -90,6 +123,9 @@ public:
     bool WriteKey(const CPubKey& vchPubKey, const CPrivKey& vchPrivKey, const CKeyMetadata &keyMeta);
     bool WriteCryptedKey(const CPubKey& vchPubKey, const std::vector<unsigned char>& vchCryptedSecret, const CKeyMetadata &keyMeta);
     bool WriteMasterKey(unsigned int nID, const CMasterKey& kMasterKey);
+    bool WriteHDKey(const CPubKey& vchPubKey, uint32_t nChild, const CKeyMetadata &keyMeta);
+    bool EraseHDKey(const CPubKey& vchPubKey);
+    bool WriteHDChain(const CHDChain& chain);
 
     bool WriteCScript(const uint160& hash, const CScript& redeemScript);
 